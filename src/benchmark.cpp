@@ -0,0 +1,182 @@
+/*
+ * Implementation of the logic benchmark
+ */
+
+#ifdef LOGIC_BENCHMARK
+
+#include "benchmark.h"
+#include "benchmark_fixtures.h"
+#include "weather.h"
+#include "weather_provider.h"
+#include "time_manager.h"
+#include "time_zone.h"
+#include "display.h"
+#include "logging.h"
+
+#define BENCHMARK_PARSE_ROUNDS 5
+#define BENCHMARK_CALL_ROUNDS 1000
+#define BENCHMARK_DRAW_ROUNDS 20
+
+// Bytes handed to the parser at a time, about what one TCP read delivers
+#define BENCHMARK_CHUNK_SIZE 256
+
+// Screens in SCREEN_* order
+static void (*const SCREENS[])() = { drawTimeScreen, drawCurrentWeatherScreen, drawForecastScreen, drawHourlyScreen };
+static const char* const SCREEN_NAMES[] = { "time", "current", "forecast", "hourly" };
+static_assert(sizeof(SCREENS) / sizeof(SCREENS[0]) == SCREEN_COUNT, "a screen is missing from the benchmark");
+
+// Keeps results alive so the timed calls are not optimized away
+static volatile uint32_t sink;
+
+// Nanoseconds per operation for cycles spent on count operations
+static uint32_t nsPer(uint64_t cycles, uint32_t count) {
+  return (uint32_t)(cycles * 1000 / ESP.getCpuFreqMHz() / (count > 0 ? count : 1));
+}
+
+struct ParseResult {
+  uint64_t cycles;      // In onBody() and onComplete() only
+  size_t peakBytes;     // Largest parse allocation total
+  bool ok;
+};
+
+// Run the provider's next request against a fixture, streamed in chunks as
+// the network would deliver it
+static ParseResult parseFixture(Weather::WeatherProvider& provider, PGM_P fixture) {
+  ParseResult result = { 0, 0, false };
+  Weather::ProviderRequest request;
+  request.cacheable = true;
+  if (!provider.nextRequest(request)) {
+    return result;
+  }
+
+  Weather::parseAllocator.resetPeak();
+  size_t length = strlen_P(fixture);
+  char chunk[BENCHMARK_CHUNK_SIZE];
+  for (size_t offset = 0; offset < length; offset += sizeof(chunk)) {
+    size_t n = min(sizeof(chunk), length - offset);
+    memcpy_P(chunk, fixture + offset, n);
+    uint32_t start = ESP.getCycleCount();
+    provider.onBody(chunk, n);
+    result.cycles += ESP.getCycleCount() - start;
+    yield();
+  }
+
+  uint32_t start = ESP.getCycleCount();
+  result.ok = provider.onComplete(200);
+  result.cycles += ESP.getCycleCount() - start;
+  result.peakBytes = Weather::parseAllocator.peakBytes();
+  return result;
+}
+
+static void benchmarkParse() {
+  Weather::WeatherProvider& provider = Weather::openWeatherMapProvider();
+
+  // begin() only checks that a key is set; nothing is sent. Known
+  // coordinates skip the geocoding request the fixtures do not cover.
+  String savedKey = API_KEY;
+  if (API_KEY.length() < 5) {
+    API_KEY = "benchmark";
+  }
+  bool savedCoordinatesKnown = cityCoordinatesKnown;
+  cityCoordinatesKnown = true;
+
+  uint64_t currentCycles = 0;
+  uint64_t forecastCycles = 0;
+  size_t currentPeak = 0;
+  size_t forecastPeak = 0;
+  uint8_t failures = 0;
+  uint32_t heapBefore = ESP.getFreeHeap();
+
+  for (int i = 0; i < BENCHMARK_PARSE_ROUNDS; i++) {
+    if (!provider.begin()) {
+      failures++;
+      continue;
+    }
+    ParseResult currentResult = parseFixture(provider, OWM_CURRENT_FIXTURE);
+    ParseResult forecastResult = parseFixture(provider, OWM_FORECAST_FIXTURE);
+    if (!currentResult.ok || !forecastResult.ok) {
+      failures++;
+    }
+    currentCycles += currentResult.cycles;
+    forecastCycles += forecastResult.cycles;
+    currentPeak = max(currentPeak, currentResult.peakBytes);
+    forecastPeak = max(forecastPeak, forecastResult.peakBytes);
+  }
+  long heapLost = (long)heapBefore - (long)ESP.getFreeHeap();
+  API_KEY = savedKey;
+  cityCoordinatesKnown = savedCoordinatesKnown;
+
+  uint32_t currentLength = strlen_P(OWM_CURRENT_FIXTURE);
+  uint32_t forecastLength = strlen_P(OWM_FORECAST_FIXTURE);
+  LOG_INFO("Bench", "OWM current: %u bytes, %u ns/byte, %u us per parse, peak %u bytes",
+           (unsigned)currentLength, (unsigned)nsPer(currentCycles, BENCHMARK_PARSE_ROUNDS * currentLength),
+           (unsigned)(nsPer(currentCycles, BENCHMARK_PARSE_ROUNDS) / 1000), (unsigned)currentPeak);
+  LOG_INFO("Bench", "OWM forecast: %u bytes, %u ns/byte, %u us per parse, peak %u bytes",
+           (unsigned)forecastLength, (unsigned)nsPer(forecastCycles, BENCHMARK_PARSE_ROUNDS * forecastLength),
+           (unsigned)(nsPer(forecastCycles, BENCHMARK_PARSE_ROUNDS) / 1000), (unsigned)forecastPeak);
+  LOG_INFO("Bench", "Free heap after %d updates: %ld bytes lower, %u bytes still held by parse documents",
+           BENCHMARK_PARSE_ROUNDS, heapLost, (unsigned)Weather::parseAllocator.usedBytes());
+  if (failures > 0) {
+    LOG_WARN("Bench", "%u of %d parse rounds failed", failures, BENCHMARK_PARSE_ROUNDS);
+  }
+}
+
+static void benchmarkHelpers() {
+  static const char* const CONDITIONS[] = {
+    "Clear", "Clouds", "Rain", "Drizzle", "Thunderstorm", "Snow", "Mist", "Fog", "Haze", "Unknown"
+  };
+  const uint8_t conditionCount = sizeof(CONDITIONS) / sizeof(CONDITIONS[0]);
+
+  uint32_t start = ESP.getCycleCount();
+  for (int i = 0; i < BENCHMARK_CALL_ROUNDS; i++) {
+    sink = Weather::getWeatherIconType(CONDITIONS[i % conditionCount]);
+  }
+  uint32_t iconCycles = ESP.getCycleCount() - start;
+
+  char timeText[10];
+  start = ESP.getCycleCount();
+  for (int i = 0; i < BENCHMARK_CALL_ROUNDS; i++) {
+    formatTimeString(timeText, i % 24, i % 60, i & 1);
+    sink = timeText[0];
+  }
+  uint32_t formatCycles = ESP.getCycleCount() - start;
+
+  // About a year in uneven steps, so the zone's cached window is crossed
+  // at every DST change
+  const time_t base = 1717236000;
+  start = ESP.getCycleCount();
+  for (int i = 0; i < BENCHMARK_CALL_ROUNDS; i++) {
+    sink = (uint32_t)TimeZone::toLocal(base + (time_t)i * 31537);
+  }
+  uint32_t zoneCycles = ESP.getCycleCount() - start;
+
+  LOG_INFO("Bench", "getWeatherIconType(): %u ns, formatTimeString(): %u ns, TimeZone::toLocal(): %u ns",
+           (unsigned)nsPer(iconCycles, BENCHMARK_CALL_ROUNDS), (unsigned)nsPer(formatCycles, BENCHMARK_CALL_ROUNDS),
+           (unsigned)nsPer(zoneCycles, BENCHMARK_CALL_ROUNDS));
+}
+
+// Draw each screen into the frame buffer; nothing is sent to the panel
+static void benchmarkDraw() {
+  for (uint8_t screen = 0; screen < SCREEN_COUNT; screen++) {
+    uint64_t cycles = 0;
+    for (int i = 0; i < BENCHMARK_DRAW_ROUNDS; i++) {
+      u8g2.clearBuffer();
+      uint32_t start = ESP.getCycleCount();
+      SCREENS[screen]();
+      cycles += ESP.getCycleCount() - start;
+      yield();
+    }
+    LOG_INFO("Bench", "draw %s: %u us", SCREEN_NAMES[screen], (unsigned)(nsPer(cycles, BENCHMARK_DRAW_ROUNDS) / 1000));
+  }
+  invalidateDisplay();
+}
+
+void runLogicBenchmark() {
+  LOG_INFO("Bench", "Logic benchmark at %u MHz", (unsigned)ESP.getCpuFreqMHz());
+  benchmarkParse();
+  benchmarkHelpers();
+  benchmarkDraw();
+  Log::flush();
+}
+
+#endif // LOGIC_BENCHMARK
@@ -0,0 +1,20 @@
+/*
+ * Logic benchmark for ESP-01 Weather Display
+ * Built with -DLOGIC_BENCHMARK: at boot, recorded OpenWeatherMap responses
+ * are fed through the real parser, and the time, icon and draw code runs
+ * against the frame buffer without sending it. Results go to the log.
+ * The native tests run it too (test/test_benchmark), timed by the host.
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <Arduino.h>
+
+#ifdef LOGIC_BENCHMARK
+// Run every benchmark once and log the averages. The fixture's weather
+// stays on screen until the first fetch or snapshot replaces it.
+void runLogicBenchmark();
+#endif
+
+#endif // BENCHMARK_H
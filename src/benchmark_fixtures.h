@@ -0,0 +1,61 @@
+/*
+ * Weather responses for the logic benchmark
+ * OpenWeatherMap /data/2.5/weather and /data/2.5/forecast responses for
+ * New York, in the compact form the API sends. Only benchmark.cpp includes
+ * this, so it takes flash in benchmark builds only.
+ */
+
+#ifndef BENCHMARK_FIXTURES_H
+#define BENCHMARK_FIXTURES_H
+
+#include <Arduino.h>
+
+// 519 bytes
+const char OWM_CURRENT_FIXTURE[] PROGMEM = R"json({"coord":{"lon":-74.006,"lat":40.7143},"weather":[{"id":801,"main":"Clouds","description":"few clouds","icon":"02d"}],"base":"stations","main":{"temp":21.84,"feels_like":21.61,"temp_min":19.93,"temp_max":23.35,"pressure":1015,"humidity":61,"sea_level":1015,"grnd_level":1013},"visibility":10000,"wind":{"speed":3.6,"deg":210,"gust":6.17},"clouds":{"all":20},"dt":1717236412,"sys":{"type":2,"id":2008101,"country":"US","sunrise":1717233970,"sunset":1717287982},"timezone":-14400,"id":5128581,"name":"New York","cod":200})json";
+
+// 15978 bytes, 40 entries at 3 hour steps
+const char OWM_FORECAST_FIXTURE[] PROGMEM =
+  R"json({"cod":"200","message":0,"cnt":40,"list":[)json"
+  R"json({"dt":1717236000,"main":{"temp":17.76,"feels_like":17.36,"temp_min":17.16,"temp_max":17.76,"pressure":1014,"sea_level":1014,"grnd_level":1012,"humidity":55,"temp_kf":0.6},"weather":[{"id":800,"main":"Clear","description":"clear sky","icon":"01d"}],"clouds":{"all":0},"wind":{"speed":2.0,"deg":0,"gust":3.0},"visibility":10000,"pop":0,"sys":{"pod":"d"},"dt_txt":"2024-06-01 10:00:00"},)json"
+  R"json({"dt":1717246800,"main":{"temp":22.0,"feels_like":21.6,"temp_min":21.4,"temp_max":22.0,"pressure":1015,"sea_level":1015,"grnd_level":1013,"humidity":62,"temp_kf":0.6},"weather":[{"id":500,"main":"Rain","description":"light rain","icon":"10d"}],"clouds":{"all":13},"wind":{"speed":2.55,"deg":37,"gust":3.9},"visibility":10000,"pop":0.17,"sys":{"pod":"d"},"dt_txt":"2024-06-01 13:00:00","rain":{"3h":0.6}},)json"
+  R"json({"dt":1717257600,"main":{"temp":26.24,"feels_like":25.84,"temp_min":25.64,"temp_max":26.24,"pressure":1016,"sea_level":1016,"grnd_level":1014,"humidity":69,"temp_kf":0},"weather":[{"id":501,"main":"Rain","description":"moderate rain","icon":"10d"}],"clouds":{"all":26},"wind":{"speed":3.1,"deg":74,"gust":4.8},"visibility":10000,"pop":0.34,"sys":{"pod":"d"},"dt_txt":"2024-06-01 16:00:00","rain":{"3h":1.0}},)json"
+  R"json({"dt":1717268400,"main":{"temp":28.0,"feels_like":27.6,"temp_min":27.4,"temp_max":28.0,"pressure":1017,"sea_level":1017,"grnd_level":1015,"humidity":76,"temp_kf":0},"weather":[{"id":801,"main":"Clouds","description":"few clouds","icon":"02d"}],"clouds":{"all":39},"wind":{"speed":3.65,"deg":111,"gust":5.7},"visibility":10000,"pop":0,"sys":{"pod":"d"},"dt_txt":"2024-06-01 19:00:00"},)json"
+  R"json({"dt":1717279200,"main":{"temp":26.24,"feels_like":25.84,"temp_min":25.64,"temp_max":26.24,"pressure":1018,"sea_level":1018,"grnd_level":1016,"humidity":83,"temp_kf":0},"weather":[{"id":802,"main":"Clouds","description":"scattered clouds","icon":"03d"}],"clouds":{"all":52},"wind":{"speed":4.2,"deg":148,"gust":6.6},"visibility":10000,"pop":0,"sys":{"pod":"d"},"dt_txt":"2024-06-01 22:00:00"},)json"
+  R"json({"dt":1717290000,"main":{"temp":22.0,"feels_like":21.6,"temp_min":21.4,"temp_max":22.0,"pressure":1014,"sea_level":1014,"grnd_level":1012,"humidity":55,"temp_kf":0},"weather":[{"id":800,"main":"Clear","description":"clear sky","icon":"01n"}],"clouds":{"all":65},"wind":{"speed":4.75,"deg":185,"gust":3.0},"visibility":10000,"pop":0,"sys":{"pod":"n"},"dt_txt":"2024-06-02 01:00:00"},)json"
+  R"json({"dt":1717300800,"main":{"temp":17.76,"feels_like":17.36,"temp_min":17.16,"temp_max":17.76,"pressure":1015,"sea_level":1015,"grnd_level":1013,"humidity":62,"temp_kf":0},"weather":[{"id":500,"main":"Rain","description":"light rain","icon":"10n"}],"clouds":{"all":78},"wind":{"speed":5.3,"deg":222,"gust":3.9},"visibility":10000,"pop":0.02,"sys":{"pod":"n"},"dt_txt":"2024-06-02 04:00:00","rain":{"3h":1.0}},)json"
+  R"json({"dt":1717311600,"main":{"temp":16.0,"feels_like":15.6,"temp_min":15.4,"temp_max":16.0,"pressure":1016,"sea_level":1016,"grnd_level":1014,"humidity":69,"temp_kf":0},"weather":[{"id":501,"main":"Rain","description":"moderate rain","icon":"10n"}],"clouds":{"all":91},"wind":{"speed":2.0,"deg":259,"gust":4.8},"visibility":10000,"pop":0.19,"sys":{"pod":"n"},"dt_txt":"2024-06-02 07:00:00","rain":{"3h":1.4}},)json"
+  R"json({"dt":1717322400,"main":{"temp":18.46,"feels_like":18.06,"temp_min":17.86,"temp_max":18.46,"pressure":1017,"sea_level":1017,"grnd_level":1015,"humidity":76,"temp_kf":0},"weather":[{"id":801,"main":"Clouds","description":"few clouds","icon":"02d"}],"clouds":{"all":4},"wind":{"speed":2.55,"deg":296,"gust":5.7},"visibility":10000,"pop":0,"sys":{"pod":"d"},"dt_txt":"2024-06-02 10:00:00"},)json"
+  R"json({"dt":1717333200,"main":{"temp":22.7,"feels_like":22.3,"temp_min":22.1,"temp_max":22.7,"pressure":1018,"sea_level":1018,"grnd_level":1016,"humidity":83,"temp_kf":0},"weather":[{"id":802,"main":"Clouds","description":"scattered clouds","icon":"03d"}],"clouds":{"all":17},"wind":{"speed":3.1,"deg":333,"gust":6.6},"visibility":10000,"pop":0,"sys":{"pod":"d"},"dt_txt":"2024-06-02 13:00:00"},)json"
+  R"json({"dt":1717344000,"main":{"temp":26.94,"feels_like":26.54,"temp_min":26.34,"temp_max":26.94,"pressure":1014,"sea_level":1014,"grnd_level":1012,"humidity":55,"temp_kf":0},"weather":[{"id":800,"main":"Clear","description":"clear sky","icon":"01d"}],"clouds":{"all":30},"wind":{"speed":3.65,"deg":10,"gust":3.0},"visibility":10000,"pop":0,"sys":{"pod":"d"},"dt_txt":"2024-06-02 16:00:00"},)json"
+  R"json({"dt":1717354800,"main":{"temp":28.7,"feels_like":28.3,"temp_min":28.1,"temp_max":28.7,"pressure":1015,"sea_level":1015,"grnd_level":1013,"humidity":62,"temp_kf":0},"weather":[{"id":500,"main":"Rain","description":"light rain","icon":"10d"}],"clouds":{"all":43},"wind":{"speed":4.2,"deg":47,"gust":3.9},"visibility":10000,"pop":0.87,"sys":{"pod":"d"},"dt_txt":"2024-06-02 19:00:00","rain":{"3h":1.4}},)json"
+  R"json({"dt":1717365600,"main":{"temp":26.94,"feels_like":26.54,"temp_min":26.34,"temp_max":26.94,"pressure":1016,"sea_level":1016,"grnd_level":1014,"humidity":69,"temp_kf":0},"weather":[{"id":501,"main":"Rain","description":"moderate rain","icon":"10d"}],"clouds":{"all":56},"wind":{"speed":4.75,"deg":84,"gust":4.8},"visibility":10000,"pop":0.04,"sys":{"pod":"d"},"dt_txt":"2024-06-02 22:00:00","rain":{"3h":0.2}},)json"
+  R"json({"dt":1717376400,"main":{"temp":22.7,"feels_like":22.3,"temp_min":22.1,"temp_max":22.7,"pressure":1017,"sea_level":1017,"grnd_level":1015,"humidity":76,"temp_kf":0},"weather":[{"id":801,"main":"Clouds","description":"few clouds","icon":"02n"}],"clouds":{"all":69},"wind":{"speed":5.3,"deg":121,"gust":5.7},"visibility":10000,"pop":0,"sys":{"pod":"n"},"dt_txt":"2024-06-03 01:00:00"},)json"
+  R"json({"dt":1717387200,"main":{"temp":18.46,"feels_like":18.06,"temp_min":17.86,"temp_max":18.46,"pressure":1018,"sea_level":1018,"grnd_level":1016,"humidity":83,"temp_kf":0},"weather":[{"id":802,"main":"Clouds","description":"scattered clouds","icon":"03n"}],"clouds":{"all":82},"wind":{"speed":2.0,"deg":158,"gust":6.6},"visibility":10000,"pop":0,"sys":{"pod":"n"},"dt_txt":"2024-06-03 04:00:00"},)json"
+  R"json({"dt":1717398000,"main":{"temp":16.7,"feels_like":16.3,"temp_min":16.1,"temp_max":16.7,"pressure":1014,"sea_level":1014,"grnd_level":1012,"humidity":55,"temp_kf":0},"weather":[{"id":800,"main":"Clear","description":"clear sky","icon":"01n"}],"clouds":{"all":95},"wind":{"speed":2.55,"deg":195,"gust":3.0},"visibility":10000,"pop":0,"sys":{"pod":"n"},"dt_txt":"2024-06-03 07:00:00"},)json"
+  R"json({"dt":1717408800,"main":{"temp":19.16,"feels_like":18.76,"temp_min":18.56,"temp_max":19.16,"pressure":1015,"sea_level":1015,"grnd_level":1013,"humidity":62,"temp_kf":0},"weather":[{"id":500,"main":"Rain","description":"light rain","icon":"10d"}],"clouds":{"all":8},"wind":{"speed":3.1,"deg":232,"gust":3.9},"visibility":10000,"pop":0.72,"sys":{"pod":"d"},"dt_txt":"2024-06-03 10:00:00","rain":{"3h":0.2}},)json"
+  R"json({"dt":1717419600,"main":{"temp":23.4,"feels_like":23.0,"temp_min":22.8,"temp_max":23.4,"pressure":1016,"sea_level":1016,"grnd_level":1014,"humidity":69,"temp_kf":0},"weather":[{"id":501,"main":"Rain","description":"moderate rain","icon":"10d"}],"clouds":{"all":21},"wind":{"speed":3.65,"deg":269,"gust":4.8},"visibility":10000,"pop":0.89,"sys":{"pod":"d"},"dt_txt":"2024-06-03 13:00:00","rain":{"3h":0.6}},)json"
+  R"json({"dt":1717430400,"main":{"temp":27.64,"feels_like":27.24,"temp_min":27.04,"temp_max":27.64,"pressure":1017,"sea_level":1017,"grnd_level":1015,"humidity":76,"temp_kf":0},"weather":[{"id":801,"main":"Clouds","description":"few clouds","icon":"02d"}],"clouds":{"all":34},"wind":{"speed":4.2,"deg":306,"gust":5.7},"visibility":10000,"pop":0,"sys":{"pod":"d"},"dt_txt":"2024-06-03 16:00:00"},)json"
+  R"json({"dt":1717441200,"main":{"temp":29.4,"feels_like":29.0,"temp_min":28.8,"temp_max":29.4,"pressure":1018,"sea_level":1018,"grnd_level":1016,"humidity":83,"temp_kf":0},"weather":[{"id":802,"main":"Clouds","description":"scattered clouds","icon":"03d"}],"clouds":{"all":47},"wind":{"speed":4.75,"deg":343,"gust":6.6},"visibility":10000,"pop":0,"sys":{"pod":"d"},"dt_txt":"2024-06-03 19:00:00"},)json"
+  R"json({"dt":1717452000,"main":{"temp":27.64,"feels_like":27.24,"temp_min":27.04,"temp_max":27.64,"pressure":1014,"sea_level":1014,"grnd_level":1012,"humidity":55,"temp_kf":0},"weather":[{"id":800,"main":"Clear","description":"clear sky","icon":"01d"}],"clouds":{"all":60},"wind":{"speed":5.3,"deg":20,"gust":3.0},"visibility":10000,"pop":0,"sys":{"pod":"d"},"dt_txt":"2024-06-03 22:00:00"},)json"
+  R"json({"dt":1717462800,"main":{"temp":23.4,"feels_like":23.0,"temp_min":22.8,"temp_max":23.4,"pressure":1015,"sea_level":1015,"grnd_level":1013,"humidity":62,"temp_kf":0},"weather":[{"id":500,"main":"Rain","description":"light rain","icon":"10n"}],"clouds":{"all":73},"wind":{"speed":2.0,"deg":57,"gust":3.9},"visibility":10000,"pop":0.57,"sys":{"pod":"n"},"dt_txt":"2024-06-04 01:00:00","rain":{"3h":0.6}},)json"
+  R"json({"dt":1717473600,"main":{"temp":19.16,"feels_like":18.76,"temp_min":18.56,"temp_max":19.16,"pressure":1016,"sea_level":1016,"grnd_level":1014,"humidity":69,"temp_kf":0},"weather":[{"id":501,"main":"Rain","description":"moderate rain","icon":"10n"}],"clouds":{"all":86},"wind":{"speed":2.55,"deg":94,"gust":4.8},"visibility":10000,"pop":0.74,"sys":{"pod":"n"},"dt_txt":"2024-06-04 04:00:00","rain":{"3h":1.0}},)json"
+  R"json({"dt":1717484400,"main":{"temp":17.4,"feels_like":17.0,"temp_min":16.8,"temp_max":17.4,"pressure":1017,"sea_level":1017,"grnd_level":1015,"humidity":76,"temp_kf":0},"weather":[{"id":801,"main":"Clouds","description":"few clouds","icon":"02n"}],"clouds":{"all":99},"wind":{"speed":3.1,"deg":131,"gust":5.7},"visibility":10000,"pop":0,"sys":{"pod":"n"},"dt_txt":"2024-06-04 07:00:00"},)json"
+  R"json({"dt":1717495200,"main":{"temp":19.86,"feels_like":19.46,"temp_min":19.26,"temp_max":19.86,"pressure":1018,"sea_level":1018,"grnd_level":1016,"humidity":83,"temp_kf":0},"weather":[{"id":802,"main":"Clouds","description":"scattered clouds","icon":"03d"}],"clouds":{"all":12},"wind":{"speed":3.65,"deg":168,"gust":6.6},"visibility":10000,"pop":0,"sys":{"pod":"d"},"dt_txt":"2024-06-04 10:00:00"},)json"
+  R"json({"dt":1717506000,"main":{"temp":24.1,"feels_like":23.7,"temp_min":23.5,"temp_max":24.1,"pressure":1014,"sea_level":1014,"grnd_level":1012,"humidity":55,"temp_kf":0},"weather":[{"id":800,"main":"Clear","description":"clear sky","icon":"01d"}],"clouds":{"all":25},"wind":{"speed":4.2,"deg":205,"gust":3.0},"visibility":10000,"pop":0,"sys":{"pod":"d"},"dt_txt":"2024-06-04 13:00:00"},)json"
+  R"json({"dt":1717516800,"main":{"temp":28.34,"feels_like":27.94,"temp_min":27.74,"temp_max":28.34,"pressure":1015,"sea_level":1015,"grnd_level":1013,"humidity":62,"temp_kf":0},"weather":[{"id":500,"main":"Rain","description":"light rain","icon":"10d"}],"clouds":{"all":38},"wind":{"speed":4.75,"deg":242,"gust":3.9},"visibility":10000,"pop":0.42,"sys":{"pod":"d"},"dt_txt":"2024-06-04 16:00:00","rain":{"3h":1.0}},)json"
+  R"json({"dt":1717527600,"main":{"temp":30.1,"feels_like":29.7,"temp_min":29.5,"temp_max":30.1,"pressure":1016,"sea_level":1016,"grnd_level":1014,"humidity":69,"temp_kf":0},"weather":[{"id":501,"main":"Rain","description":"moderate rain","icon":"10d"}],"clouds":{"all":51},"wind":{"speed":5.3,"deg":279,"gust":4.8},"visibility":10000,"pop":0.59,"sys":{"pod":"d"},"dt_txt":"2024-06-04 19:00:00","rain":{"3h":1.4}},)json"
+  R"json({"dt":1717538400,"main":{"temp":28.34,"feels_like":27.94,"temp_min":27.74,"temp_max":28.34,"pressure":1017,"sea_level":1017,"grnd_level":1015,"humidity":76,"temp_kf":0},"weather":[{"id":801,"main":"Clouds","description":"few clouds","icon":"02d"}],"clouds":{"all":64},"wind":{"speed":2.0,"deg":316,"gust":5.7},"visibility":10000,"pop":0,"sys":{"pod":"d"},"dt_txt":"2024-06-04 22:00:00"},)json"
+  R"json({"dt":1717549200,"main":{"temp":24.1,"feels_like":23.7,"temp_min":23.5,"temp_max":24.1,"pressure":1018,"sea_level":1018,"grnd_level":1016,"humidity":83,"temp_kf":0},"weather":[{"id":802,"main":"Clouds","description":"scattered clouds","icon":"03n"}],"clouds":{"all":77},"wind":{"speed":2.55,"deg":353,"gust":6.6},"visibility":10000,"pop":0,"sys":{"pod":"n"},"dt_txt":"2024-06-05 01:00:00"},)json"
+  R"json({"dt":1717560000,"main":{"temp":19.86,"feels_like":19.46,"temp_min":19.26,"temp_max":19.86,"pressure":1014,"sea_level":1014,"grnd_level":1012,"humidity":55,"temp_kf":0},"weather":[{"id":800,"main":"Clear","description":"clear sky","icon":"01n"}],"clouds":{"all":90},"wind":{"speed":3.1,"deg":30,"gust":3.0},"visibility":10000,"pop":0,"sys":{"pod":"n"},"dt_txt":"2024-06-05 04:00:00"},)json"
+  R"json({"dt":1717570800,"main":{"temp":18.1,"feels_like":17.7,"temp_min":17.5,"temp_max":18.1,"pressure":1015,"sea_level":1015,"grnd_level":1013,"humidity":62,"temp_kf":0},"weather":[{"id":500,"main":"Rain","description":"light rain","icon":"10n"}],"clouds":{"all":3},"wind":{"speed":3.65,"deg":67,"gust":3.9},"visibility":10000,"pop":0.27,"sys":{"pod":"n"},"dt_txt":"2024-06-05 07:00:00","rain":{"3h":1.4}},)json"
+  R"json({"dt":1717581600,"main":{"temp":20.56,"feels_like":20.16,"temp_min":19.96,"temp_max":20.56,"pressure":1016,"sea_level":1016,"grnd_level":1014,"humidity":69,"temp_kf":0},"weather":[{"id":501,"main":"Rain","description":"moderate rain","icon":"10d"}],"clouds":{"all":16},"wind":{"speed":4.2,"deg":104,"gust":4.8},"visibility":10000,"pop":0.44,"sys":{"pod":"d"},"dt_txt":"2024-06-05 10:00:00","rain":{"3h":0.2}},)json"
+  R"json({"dt":1717592400,"main":{"temp":24.8,"feels_like":24.4,"temp_min":24.2,"temp_max":24.8,"pressure":1017,"sea_level":1017,"grnd_level":1015,"humidity":76,"temp_kf":0},"weather":[{"id":801,"main":"Clouds","description":"few clouds","icon":"02d"}],"clouds":{"all":29},"wind":{"speed":4.75,"deg":141,"gust":5.7},"visibility":10000,"pop":0,"sys":{"pod":"d"},"dt_txt":"2024-06-05 13:00:00"},)json"
+  R"json({"dt":1717603200,"main":{"temp":29.04,"feels_like":28.64,"temp_min":28.44,"temp_max":29.04,"pressure":1018,"sea_level":1018,"grnd_level":1016,"humidity":83,"temp_kf":0},"weather":[{"id":802,"main":"Clouds","description":"scattered clouds","icon":"03d"}],"clouds":{"all":42},"wind":{"speed":5.3,"deg":178,"gust":6.6},"visibility":10000,"pop":0,"sys":{"pod":"d"},"dt_txt":"2024-06-05 16:00:00"},)json"
+  R"json({"dt":1717614000,"main":{"temp":30.8,"feels_like":30.4,"temp_min":30.2,"temp_max":30.8,"pressure":1014,"sea_level":1014,"grnd_level":1012,"humidity":55,"temp_kf":0},"weather":[{"id":800,"main":"Clear","description":"clear sky","icon":"01d"}],"clouds":{"all":55},"wind":{"speed":2.0,"deg":215,"gust":3.0},"visibility":10000,"pop":0,"sys":{"pod":"d"},"dt_txt":"2024-06-05 19:00:00"},)json"
+  R"json({"dt":1717624800,"main":{"temp":29.04,"feels_like":28.64,"temp_min":28.44,"temp_max":29.04,"pressure":1015,"sea_level":1015,"grnd_level":1013,"humidity":62,"temp_kf":0},"weather":[{"id":500,"main":"Rain","description":"light rain","icon":"10d"}],"clouds":{"all":68},"wind":{"speed":2.55,"deg":252,"gust":3.9},"visibility":10000,"pop":0.12,"sys":{"pod":"d"},"dt_txt":"2024-06-05 22:00:00","rain":{"3h":0.2}},)json"
+  R"json({"dt":1717635600,"main":{"temp":24.8,"feels_like":24.4,"temp_min":24.2,"temp_max":24.8,"pressure":1016,"sea_level":1016,"grnd_level":1014,"humidity":69,"temp_kf":0},"weather":[{"id":501,"main":"Rain","description":"moderate rain","icon":"10n"}],"clouds":{"all":81},"wind":{"speed":3.1,"deg":289,"gust":4.8},"visibility":10000,"pop":0.29,"sys":{"pod":"n"},"dt_txt":"2024-06-06 01:00:00","rain":{"3h":0.6}},)json"
+  R"json({"dt":1717646400,"main":{"temp":20.56,"feels_like":20.16,"temp_min":19.96,"temp_max":20.56,"pressure":1017,"sea_level":1017,"grnd_level":1015,"humidity":76,"temp_kf":0},"weather":[{"id":801,"main":"Clouds","description":"few clouds","icon":"02n"}],"clouds":{"all":94},"wind":{"speed":3.65,"deg":326,"gust":5.7},"visibility":10000,"pop":0,"sys":{"pod":"n"},"dt_txt":"2024-06-06 04:00:00"},)json"
+  R"json({"dt":1717657200,"main":{"temp":18.8,"feels_like":18.4,"temp_min":18.2,"temp_max":18.8,"pressure":1018,"sea_level":1018,"grnd_level":1016,"humidity":83,"temp_kf":0},"weather":[{"id":802,"main":"Clouds","description":"scattered clouds","icon":"03n"}],"clouds":{"all":7},"wind":{"speed":4.2,"deg":3,"gust":6.6},"visibility":10000,"pop":0,"sys":{"pod":"n"},"dt_txt":"2024-06-06 07:00:00"}])json"
+  R"json(,"city":{"id":5128581,"name":"New York","coord":{"lat":40.7143,"lon":-74.006},"country":"US","population":8175133,"timezone":-14400,"sunrise":1717233970,"sunset":1717287982}})json";
+
+#endif // BENCHMARK_FIXTURES_H
@@ -11,22 +11,26 @@ const byte DNS_PORT = 53;  // DNS server port
 IPAddress apIP(192, 168, 4, 1);  // IP address for AP mode
 
 // Display instance
-U8G2_SSD1306_128X64_NONAME_F_SW_I2C u8g2(U8G2_R2, SCL_PIN, SDA_PIN, U8X8_PIN_NONE);
+#ifdef DISPLAY_HW_I2C
+DisplayDriver u8g2(U8G2_R2, U8X8_PIN_NONE, SCL_PIN, SDA_PIN);
+#else
+DisplayDriver u8g2(U8G2_R2, SCL_PIN, SDA_PIN, U8X8_PIN_NONE);
+#endif
 
 // Web server and DNS server
 ESP8266WebServer server(80);
 DNSServer dnsServer;
 
-// NTP Client
-WiFiUDP ntpUDP;
-NTPClient timeClient(ntpUDP, "pool.ntp.org");
-
 // OpenWeatherMap settings
 String API_KEY = "";
 String UNITS = "imperial";  // Will be set dynamically based on useMetricUnits
 String cityName = "New York";   // Default city, configurable
 String stateName = "NY";        // Default state, configurable
+float cityLatitude = 0;
+float cityLongitude = 0;
+bool cityCoordinatesKnown = false; // Geocoded by the next weather update
 bool useMetricUnits = false;    // Default to Fahrenheit
+uint8_t weatherProvider = WEATHER_PROVIDER_OPENWEATHERMAP; // Default to OpenWeatherMap
 
 // Screen switching timing
 const unsigned long SCREEN_SWITCH_INTERVAL = 30000;
@@ -43,8 +47,8 @@ int seconds = 0;
 int dayOfMonth = 1;
 int month = 1;
 int year = 2025;
-String dayOfWeekStr = "MON";
-String monthStr = "JAN";
+char dayOfWeekStr[4] = "MON";
+char monthStr[4] = "JAN";
 int currentHour = 12;
 int currentMinute = 0;
 int currentSecond = 0;
@@ -58,24 +62,20 @@ String timezoneString = "UTC-5.00";
 bool timeInitialized = false;
 unsigned long lastTimeUpdate = 0;
 unsigned long lastSecondUpdate = 0;
-float timezone = -5.0; // Default to Eastern Time (UTC-5)
 bool use12HourFormat = false; // Default to 24-hour format
-bool useDST = true; // Default to using DST calculations
-long driftCorrection = 0; // No drift correction by default
-unsigned long lastNtpTimestamp = 0; // Last NTP time in seconds
-unsigned long lastNtpMillis = 0; // millis() value at last NTP sync
 
 // Weather variables
 int currentTemp = 0;
 int lowTemp = 0;
 int highTemp = 0;
-String currentCondition = "Unknown";
+char currentCondition[16] = "Unknown";
 int humidity = 0;
 int sunriseHour = 6;
 int sunriseMinute = 0;
 int sunsetHour = 18;
 int sunsetMinute = 0;
 unsigned long lastWeatherUpdate = 0;
+bool weatherDataStale = false;
 
 // Weather forecast data
 WeatherDay forecast[5] = {
@@ -85,28 +85,3 @@ WeatherDay forecast[5] = {
   {"???", 0, 0, 0},
   {"???", 0, 0, 0}
 };
-
-// Weather icon bitmaps
-const uint8_t sunny_icon[8] = {
-  0x10, 0x54, 0x38, 0xFE, 0x38, 0x54, 0x10, 0x00
-};
-
-const uint8_t partly_cloudy_icon[8] = {
-  0x08, 0x54, 0x38, 0x44, 0x3E, 0x00, 0x00, 0x00
-};
-
-const uint8_t cloudy_icon[8] = {
-  0x00, 0x00, 0x78, 0x84, 0xFE, 0x00, 0x00, 0x00
-};
-
-const uint8_t foggy_icon[8] = {
-  0x00, 0xEE, 0x00, 0xFE, 0x00, 0x7C, 0x00, 0x00
-};
-
-const uint8_t rainy_icon[8] = {
-  0x78, 0xFC, 0x00, 0x28, 0x28, 0x00, 0x00, 0x00
-};
-
-const uint8_t snowy_icon[8] = {
-  0x78, 0xFC, 0x00, 0x10, 0x38, 0x10, 0x00, 0x00
-};
@@ -13,28 +13,67 @@
 #include <EEPROM.h>
 #include <U8g2lib.h>
 #include <Wire.h>
-#include <WiFiUdp.h>
-#include <NTPClient.h>
 
 // Define pins for I2C on ESP-01
 #define SDA_PIN 0  // GPIO0
 #define SCL_PIN 2  // GPIO2
 
-// EEPROM size and offset
-#define EEPROM_SIZE 512
-#define WIFI_SSID_OFFSET 0
-#define WIFI_PASS_OFFSET 32
-#define CONFIG_FLAG_OFFSET 128
-#define CONFIG_FLAG 1  // Value indicating valid WiFi configuration
-// CONFIG_FLAG_OFFSET+1 and +2 are reserved for SSID and password lengths
-#define CITY_OFFSET 132
-#define STATE_OFFSET 182
-#define UPDATE_INTERVAL_OFFSET 200
-#define TIMEZONE_OFFSET 210
-#define API_KEY_OFFSET 220
-#define TIME_FORMAT_OFFSET 270  // New offset for time format preference
-#define TEMP_UNIT_OFFSET 271  // Offset for temperature unit preference (C/F)
-#define USE_DST_OFFSET 255 // New offset for DST setting
+// Display transport, chosen at build time:
+//   default         software I2C, u8g2 bit-bangs the bus itself
+//   DISPLAY_HW_I2C  u8g2 talks through the Wire library at DISPLAY_I2C_CLOCK
+// The ESP8266 has no I2C peripheral, so Wire is also bit-banged, but its
+// tuned loop runs the bus several times faster than u8g2's generic one.
+#ifndef DISPLAY_I2C_CLOCK
+#define DISPLAY_I2C_CLOCK 400000  // Hz, SSD1306 fast mode; many panels accept more
+#endif
+
+// Frame buffer, chosen at build time:
+//   default                 full frame, 1 KB; drawn once per change
+//   DISPLAY_PAGE_BUFFER=1   one tile row, 128 bytes; the screen is drawn once per row
+//   DISPLAY_PAGE_BUFFER=2   two tile rows, 256 bytes; drawn once per pair of rows
+// Screen transitions (see display.h) need the full frame.
+#ifndef DISPLAY_PAGE_BUFFER
+#define DISPLAY_PAGE_BUFFER 0
+#endif
+
+#ifdef DISPLAY_HW_I2C
+#if DISPLAY_PAGE_BUFFER == 1
+typedef U8G2_SSD1306_128X64_NONAME_1_HW_I2C DisplayDriver;
+#elif DISPLAY_PAGE_BUFFER == 2
+typedef U8G2_SSD1306_128X64_NONAME_2_HW_I2C DisplayDriver;
+#else
+typedef U8G2_SSD1306_128X64_NONAME_F_HW_I2C DisplayDriver;
+#endif
+#define DISPLAY_TRANSPORT_NAME "HW_I2C (Wire)"
+#else
+#if DISPLAY_PAGE_BUFFER == 1
+typedef U8G2_SSD1306_128X64_NONAME_1_SW_I2C DisplayDriver;
+#elif DISPLAY_PAGE_BUFFER == 2
+typedef U8G2_SSD1306_128X64_NONAME_2_SW_I2C DisplayDriver;
+#else
+typedef U8G2_SSD1306_128X64_NONAME_F_SW_I2C DisplayDriver;
+#endif
+#define DISPLAY_TRANSPORT_NAME "SW_I2C"
+#endif
+
+#if DISPLAY_PAGE_BUFFER == 1
+#define DISPLAY_BUFFER_NAME "page, 1 tile row"
+#elif DISPLAY_PAGE_BUFFER == 2
+#define DISPLAY_BUFFER_NAME "page, 2 tile rows"
+#else
+#define DISPLAY_BUFFER_NAME "full frame"
+#endif
+
+// EEPROM size and offsets
+#define EEPROM_SIZE 768
+#define SETTINGS_OFFSET 0  // Settings record, see settings.h
+#define WEATHER_SNAPSHOT_OFFSET 320  // Last good weather data, see weather_snapshot.h
+#define WIFI_CACHE_OFFSET 420  // Last access point BSSID and channel, see wifi_connection.h
+#define LOCATIONS_OFFSET 512  // Further weather locations, see locations.h
+
+// Weather providers selectable on the settings page
+#define WEATHER_PROVIDER_OPENWEATHERMAP 0
+#define WEATHER_PROVIDER_OPENMETEO 1
 
 // Configuration portal constants
 extern const char* AP_NAME;
@@ -43,22 +82,22 @@ extern const byte DNS_PORT;
 extern IPAddress apIP;
 
 // Display instance
-extern U8G2_SSD1306_128X64_NONAME_F_SW_I2C u8g2;
+extern DisplayDriver u8g2;
 
 // Web server and DNS server
 extern ESP8266WebServer server;
 extern DNSServer dnsServer;
 
-// NTP Client
-extern WiFiUDP ntpUDP;
-extern NTPClient timeClient;
-
 // OpenWeatherMap settings
 extern String API_KEY;
 extern String UNITS;  // Changed from const to allow dynamic switching
 extern String cityName;
 extern String stateName;
+extern float cityLatitude;  // Where cityName and stateName geocode to,
+extern float cityLongitude; // valid while cityCoordinatesKnown
+extern bool cityCoordinatesKnown;
 extern bool useMetricUnits; // true for Celsius, false for Fahrenheit
+extern uint8_t weatherProvider; // WEATHER_PROVIDER_OPENWEATHERMAP or WEATHER_PROVIDER_OPENMETEO
 
 // Screen switching timing
 extern const unsigned long SCREEN_SWITCH_INTERVAL;
@@ -75,8 +114,8 @@ extern int seconds;
 extern int dayOfMonth;
 extern int month;
 extern int year;
-extern String dayOfWeekStr;
-extern String monthStr;
+extern char dayOfWeekStr[4]; // Short names, see getDayOfWeekShort()
+extern char monthStr[4];
 extern int currentHour;
 extern int currentMinute;
 extern int currentSecond;
@@ -90,28 +129,24 @@ extern String timezoneString;
 extern bool timeInitialized;
 extern unsigned long lastTimeUpdate;
 extern unsigned long lastSecondUpdate;
-extern float timezone; // UTC offset in hours (e.g., -5 for EST)
 extern bool use12HourFormat; // true for 12-hour format with AM/PM, false for 24-hour format
-extern bool useDST; // Flag to enable/disable DST calculations
-extern long driftCorrection; // Milliseconds of drift correction per hour
-extern unsigned long lastNtpTimestamp; // Last NTP time in seconds
-extern unsigned long lastNtpMillis; // millis() value at last NTP sync
 
 // Weather variables
 extern int currentTemp;
 extern int lowTemp;
 extern int highTemp;
-extern String currentCondition;
+extern char currentCondition[16];
 extern int humidity;
 extern int sunriseHour;
 extern int sunriseMinute;
 extern int sunsetHour;
 extern int sunsetMinute;
 extern unsigned long lastWeatherUpdate;
+extern bool weatherDataStale; // true while showing the snapshot restored at boot
 
-// Weather forecast data structure
+// Weather forecast data structure; fixed-size so the draw code never allocates
 struct WeatherDay {
-  String day;
+  char day[4];
   int temp;
   int lowTemp;
   byte iconType; // 0=sunny, 1=partly cloudy, 2=cloudy, 3=foggy, 4=rainy, 5=snowy
@@ -120,12 +155,4 @@ struct WeatherDay {
 // Weather forecast data
 extern WeatherDay forecast[5];
 
-// Weather icon bitmaps
-extern const uint8_t sunny_icon[8];
-extern const uint8_t partly_cloudy_icon[8];
-extern const uint8_t cloudy_icon[8];
-extern const uint8_t foggy_icon[8];
-extern const uint8_t rainy_icon[8];
-extern const uint8_t snowy_icon[8];
-
 #endif // CONFIG_H
@@ -5,72 +5,39 @@
 #include "display.h"
 #include "weather.h"
 #include "time_manager.h"
+#include "icons.h"
+#include "hourly_forecast.h"
+#include "locations.h"
+#include "solar.h"
+#include "metrics.h"
+#include "logging.h"
+#include <coredecls.h> // crc32()
 
-// Draw weather icon based on type
+// Draw weather icon based on type, centered on (x, y)
 void drawWeatherIcon(int x, int y, byte iconType, byte size) {
-  const uint8_t* icon;
-  
-  // Select icon based on type
-  switch(iconType) {
-    case 0: icon = sunny_icon; break;
-    case 1: icon = partly_cloudy_icon; break;
-    case 2: icon = cloudy_icon; break;
-    case 3: icon = foggy_icon; break;
-    case 4: icon = rainy_icon; break;
-    case 5: icon = snowy_icon; break;
-    default: icon = sunny_icon;
+  if (iconType >= WEATHER_ICON_COUNT) {
+    iconType = 0; // Default to sunny
   }
   
-  // Draw the icon scaled to size
   if (size == 1) {
     // Small 8x8 icon
-    u8g2.drawXBM(x - 4, y - 4, 8, 8, icon);
+    u8g2.drawXBMP(x - 4, y - 4, 8, 8, weatherIcons8[iconType].bits);
   } else if (size == 2) {
-    // Medium 16x16 icon (scaled version of 8x8)
-    for (int i = 0; i < 8; i++) {
-      for (int j = 0; j < 8; j++) {
-        if (icon[i] & (1 << j)) {
-          u8g2.drawBox(x - 8 + j*2, y - 8 + i*2, 2, 2);
-        }
-      }
-    }
+    // Medium 16x16 icon
+    u8g2.drawXBMP(x - 8, y - 8, 16, 16, weatherIcons16[iconType].bits);
   } else {
-    // Large icon (size 3 or more - scaled version of 8x8)
-    int pixelSize = size - 2; // 1 for size 3, 2 for size 4, etc.
-    for (int i = 0; i < 8; i++) {
-      for (int j = 0; j < 8; j++) {
-        if (icon[i] & (1 << j)) {
-          u8g2.drawBox(x - 12 + j*3, y - 12 + i*3, pixelSize + 2, pixelSize + 2);
-        }
-      }
-    }
+    // Large 32x32 icon
+    u8g2.drawXBMP(x - 16, y - 16, 32, 32, weatherIcons32[iconType].bits);
   }
 }
 
-// Draw extra large weather icon (custom function for current weather)
+// Draw extra large weather icon (32x32, for current weather)
 void drawExtraLargeWeatherIcon(int x, int y, byte iconType) {
-  const uint8_t* icon;
-  
-  // Select icon based on type
-  switch(iconType) {
-    case 0: icon = sunny_icon; break;
-    case 1: icon = partly_cloudy_icon; break;
-    case 2: icon = cloudy_icon; break;
-    case 3: icon = foggy_icon; break;
-    case 4: icon = rainy_icon; break;
-    case 5: icon = snowy_icon; break;
-    default: icon = sunny_icon;
-  }
-  
-  // Draw ultra-large icon (much bigger than regular scaling)
-  int pixelSize = 4; // Each bit becomes a 4x4 pixel block
-  for (int i = 0; i < 8; i++) {
-    for (int j = 0; j < 8; j++) {
-      if (icon[i] & (1 << j)) {
-        u8g2.drawBox(x - 16 + j*4, y - 16 + i*4, pixelSize, pixelSize);
-      }
-    }
-  }
+  drawWeatherIcon(x, y, iconType, 3);
+}
+
+bool isDaytimeNow() {
+  return Solar::phaseAt(currentHour * 60 + minutes).daytime;
 }
 
 // Draw the time screen with sun position indicator
@@ -81,7 +48,7 @@ void drawTimeScreen() {
   
   // Format date with buffer size control
   char dateStr[32]; // Increased buffer size to 32 to ensure sufficient space
-  snprintf(dateStr, sizeof(dateStr), "%s %s %d", dayOfWeekStr.c_str(), monthStr.c_str(), dayOfMonth);
+  snprintf(dateStr, sizeof(dateStr), "%s %s %d", dayOfWeekStr, monthStr, dayOfMonth);
   
   // Draw time in large font
   u8g2.setFont(u8g2_font_logisoso24_tn);
@@ -122,23 +89,9 @@ void drawTimeScreen() {
     u8g2.drawPixel(x + 1, barY);
   }
   
-  // Calculate minutes for sunrise, sunset, and current time
-  int sunriseMinutes = sunriseHour * 60 + sunriseMinute;
-  int sunsetMinutes = sunsetHour * 60 + sunsetMinute;
-  int currentMinutes = currentHour * 60 + minutes;
-  
-  // Simple day/night detection
-  bool isDaytime = false;
-  
-  // Handle case where day spans midnight
-  if (sunsetMinutes < sunriseMinutes) {
-    // If sunset is before sunrise, we're in a location where the day might span midnight
-    // In this case, it's day if current time is after sunrise OR before sunset
-    isDaytime = (currentMinutes >= sunriseMinutes) || (currentMinutes <= sunsetMinutes);
-  } else {
-    // Normal case: it's day if current time is between sunrise and sunset
-    isDaytime = (currentMinutes >= sunriseMinutes) && (currentMinutes <= sunsetMinutes);
-  }
+  // Day or night, and how far through it; sunrise and sunset come from the ephemeris
+  Solar::Phase phase = Solar::phaseAt(currentHour * 60 + minutes);
+  bool isDaytime = phase.daytime;
   
   // Draw sunrise and sunset icons
   // Sunrise icon (circle with rays)
@@ -153,93 +106,8 @@ void drawTimeScreen() {
   u8g2.drawLine(barEnd + 3, barY, barEnd + 5, barY);
   u8g2.drawLine(barEnd + 2, barY - 2, barEnd + 3, barY - 3);
   
-  // Calculate sun position (simplified and more robust)
-  int sunX = barStart;
-  int barLength = barEnd - barStart;
-  float progressPercent = 0.0;
-  
-  if (isDaytime) {
-    // For daytime, calculate percentage through the day
-    if (sunsetMinutes >= sunriseMinutes) {
-      // Normal case
-      int dayLength = sunsetMinutes - sunriseMinutes;
-      int minutesSinceSunrise = currentMinutes - sunriseMinutes;
-      
-      // Ensure values are valid
-      dayLength = max(1, dayLength);
-      minutesSinceSunrise = max(0, min(minutesSinceSunrise, dayLength));
-      
-      progressPercent = (float)minutesSinceSunrise / dayLength;
-    } else {
-      // Day spans midnight (unusual case)
-      int dayLength = (24 * 60) - sunriseMinutes + sunsetMinutes;
-      int minutesSinceSunrise;
-      
-      if (currentMinutes >= sunriseMinutes) {
-        minutesSinceSunrise = currentMinutes - sunriseMinutes;
-      } else {
-        minutesSinceSunrise = (24 * 60) - sunriseMinutes + currentMinutes;
-      }
-      
-      // Ensure values are valid
-      dayLength = max(1, dayLength);
-      minutesSinceSunrise = max(0, min(minutesSinceSunrise, dayLength));
-      
-      progressPercent = (float)minutesSinceSunrise / dayLength;
-    }
-  } else {
-    // For nighttime, calculate percentage through the night
-    // Rethinking this part completely for correct nighttime tracking
-    
-    // Night has two parts:
-    // 1. From sunset to midnight
-    // 2. From midnight to sunrise
-    
-    int totalNightMinutes;
-    int minutesThroughNight;
-    
-    if (sunsetMinutes < sunriseMinutes) {
-      // Normal case: sunset today -> sunrise tomorrow
-      totalNightMinutes = sunriseMinutes - sunsetMinutes;
-      
-      if (currentMinutes >= sunsetMinutes) {
-        // Evening: after sunset, before midnight
-        minutesThroughNight = currentMinutes - sunsetMinutes;
-      } else {
-        // Morning: after midnight, before sunrise
-        minutesThroughNight = (24 * 60 - sunsetMinutes) + currentMinutes;
-      }
-    } else {
-      // Edge case: sunset tomorrow -> sunrise today (e.g., near polar region)
-      totalNightMinutes = (24 * 60) - sunsetMinutes + sunriseMinutes;
-      
-      if (currentMinutes <= sunriseMinutes) {
-        // Morning: after midnight, before sunrise
-        minutesThroughNight = currentMinutes + (24 * 60 - sunsetMinutes);
-      } else if (currentMinutes >= sunsetMinutes) {
-        // Evening: after sunset, before midnight
-        minutesThroughNight = currentMinutes - sunsetMinutes;
-      } else {
-        // Middle of the day - should be daytime, but if we're here, use 0
-        minutesThroughNight = 0;
-      }
-    }
-    
-    // Safety check for division by zero
-    totalNightMinutes = max(1, totalNightMinutes);
-    minutesThroughNight = max(0, min(minutesThroughNight, totalNightMinutes));
-    
-    progressPercent = (float)minutesThroughNight / totalNightMinutes;
-  }
-  
-  // Constrain progress to valid range
-  progressPercent = constrain(progressPercent, 0.0, 1.0);
-  
-  // Calculate position based on percentage
-  sunX = barStart + (int)(progressPercent * barLength);
-  
-  // Ensure sunX is within valid range
-  sunX = constrain(sunX, barStart, barEnd);
+  // Sun position along the bar
+  int sunX = barStart + phase.progress * (barEnd - barStart) / 255;
   
   // Draw sun position indicator (enhanced)
   if (isDaytime) {
@@ -252,12 +120,27 @@ void drawTimeScreen() {
   }
 }
 
+// Mark weather restored from the boot snapshot until a fresh fetch lands
+static void drawStaleMarker() {
+  if (!weatherDataStale) {
+    return;
+  }
+  u8g2.setFont(u8g2_font_4x6_tf);
+  u8g2.drawStr(0, 6, "OLD");
+}
+
+// Title of a weather screen; the city instead when several locations rotate
+static void drawWeatherTitle(const char* title) {
+  u8g2.setFont(u8g2_font_t0_11_tf);
+  const char* text = Locations::count() > 1 ? cityName.c_str() : title;
+  int width = u8g2.getStrWidth(text);
+  u8g2.drawStr(max(64 - width / 2, 0), 10, text);
+}
+
 // Draw the current weather screen
 void drawCurrentWeatherScreen() {
   // Draw "TODAY" label at the top
-  u8g2.setFont(u8g2_font_t0_11_tf);
-  int todayWidth = u8g2.getStrWidth("TODAY");
-  u8g2.drawStr(64 - todayWidth / 2, 10, "TODAY");
+  drawWeatherTitle("TODAY");
   
   // Draw current temperature in large font on the left
   u8g2.setFont(u8g2_font_logisoso24_tn);  // Larger font for temperature
@@ -291,14 +174,14 @@ void drawCurrentWeatherScreen() {
   
   u8g2.drawStr(96 - lowWidth / 2, 55, lowStr);
   u8g2.drawCircle(96 + lowWidth / 2 + 2, 47, 1, U8G2_DRAW_ALL);  // Raised higher and moved right by 1 pixel
+  
+  drawStaleMarker();
 }
 
 // Draw the forecast screen
 void drawForecastScreen() {
   // Draw title
-  u8g2.setFont(u8g2_font_t0_11_tf);
-  int forecastWidth = u8g2.getStrWidth("FORECAST");
-  u8g2.drawStr(64 - forecastWidth / 2, 10, "FORECAST");
+  drawWeatherTitle("FORECAST");
   
   // Draw 3-day forecast
   int startY = 18;
@@ -308,8 +191,8 @@ void drawForecastScreen() {
     int x = i * colWidth + colWidth/2;  // Center of each column
     
     // Draw day name
-    int dayWidth = u8g2.getStrWidth(forecast[i].day.c_str());
-    u8g2.drawStr(x - dayWidth / 2, startY, forecast[i].day.c_str());
+    int dayWidth = u8g2.getStrWidth(forecast[i].day);
+    u8g2.drawStr(x - dayWidth / 2, startY, forecast[i].day);
     
     // Draw weather icon
     drawWeatherIcon(x, startY + 12, forecast[i].iconType, 2);
@@ -336,4 +219,492 @@ void drawForecastScreen() {
       u8g2.drawCircle(x + lowWidth / 2 + 2, startY + 27, 1, U8G2_DRAW_ALL);
     }
   }
-}
\ No newline at end of file
+  
+  drawStaleMarker();
+}
+
+// Points on the hourly screen: 24 hours at the 3 hour step, both ends included
+#define HOURLY_SCREEN_POINTS (24 * 3600 / HOURLY_STEP_S + 1)
+
+// Draw the hourly screen
+void drawHourlyScreen() {
+  u8g2.setFont(u8g2_font_t0_11_tf);
+  int titleWidth = u8g2.getStrWidth("NEXT 24H");
+  u8g2.drawStr(64 - titleWidth / 2, 10, "NEXT 24H");
+  
+  uint8_t count = min(HourlyForecast::count(), (uint8_t)HOURLY_SCREEN_POINTS);
+  if (count < 2) {
+    u8g2.setFont(u8g2_font_4x6_tf);
+    const char* message = "No hourly data yet";
+    u8g2.drawStr(64 - u8g2.getStrWidth(message) / 2, 36, message);
+    drawStaleMarker();
+    return;
+  }
+  
+  // Scale the sparkline to the range shown
+  int lowest = 127, highest = -128;
+  uint8_t lowestIndex = 0, highestIndex = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    int temp = HourlyForecast::point(i).temp;
+    if (temp < lowest) {
+      lowest = temp;
+      lowestIndex = i;
+    }
+    if (temp > highest) {
+      highest = temp;
+      highestIndex = i;
+    }
+  }
+  int range = max(highest - lowest, 1);
+  
+  // Plot area, with room for the labels above and below
+  const int left = 8, right = 119, top = 20, bottom = 40;
+  u8g2.setFont(u8g2_font_4x6_tf);
+  int previousX = 0, previousY = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    const HourlyPoint& point = HourlyForecast::point(i);
+    int x = left + i * (right - left) / (count - 1);
+    int y = bottom - (point.temp - lowest) * (bottom - top) / range;
+    
+    if (i > 0) {
+      u8g2.drawLine(previousX, previousY, x, y);
+    }
+    u8g2.drawDisc(x, y, 1, U8G2_DRAW_ALL);
+    previousX = x;
+    previousY = y;
+    
+    // Extremes get their temperature
+    char label[5];
+    if (i == highestIndex || i == lowestIndex) {
+      snprintf(label, sizeof(label), "%d", point.temp);
+      int labelX = constrain(x - (int)u8g2.getStrWidth(label) / 2, 0, 127 - (int)u8g2.getStrWidth(label));
+      u8g2.drawStr(labelX, i == highestIndex ? y - 3 : y + 8, label);
+    }
+    
+    // Precipitation chance as a bar, up to 6 pixels
+    if (point.precipPct != HOURLY_PRECIP_UNKNOWN && point.precipPct > 0) {
+      int height = max(1, point.precipPct * 6 / 100);
+      u8g2.drawBox(x - 1, 56 - height, 3, height);
+    }
+    
+    // Hour of every other point along the bottom
+    if (i % 2 == 0) {
+      snprintf(label, sizeof(label), "%02u", point.localHour);
+      u8g2.drawStr(constrain(x - 4, 0, 120), 63, label);
+    }
+  }
+  
+  drawStaleMarker();
+}
+
+// Render scheduler state: what the panel currently shows
+static byte shownScreen = 0xFF;       // 0xFF = unknown, next frame is sent in full
+static uint32_t shownSignature = 0;
+static uint32_t shownRowCrc[8];       // One checksum per tile row of the frame
+
+// Frame statistics, counted per minute
+static unsigned long statsMinuteStart = 0;
+static uint16_t framesThisMinute = 0;
+static uint16_t tileRowsThisMinute = 0;
+static uint16_t framesLastMinute = 0;
+static uint16_t tileRowsLastMinute = 0;
+
+static DisplayHeapStats heapStats = { 0, 0, UINT32_MAX, 0 };
+
+static uint32_t mixSignature(uint32_t crc, const void* data, size_t len) {
+  return crc32(data, len, crc);
+}
+
+static uint32_t mixSignature(uint32_t crc, const char* str) {
+  return crc32(str, strlen(str), crc);
+}
+
+// Checksum of every value the given screen draws
+static uint32_t screenSignature(byte screen) {
+  uint32_t crc = mixSignature(0xFFFFFFFF, &screen, sizeof(screen));
+  
+  switch (screen) {
+    case SCREEN_TIME:
+      // Time digits and AM/PM
+      crc = mixSignature(crc, &hours, sizeof(hours));
+      crc = mixSignature(crc, &minutes, sizeof(minutes));
+      crc = mixSignature(crc, &use12HourFormat, sizeof(use12HourFormat));
+      // Date line
+      crc = mixSignature(crc, dayOfWeekStr);
+      crc = mixSignature(crc, monthStr);
+      crc = mixSignature(crc, &dayOfMonth, sizeof(dayOfMonth));
+      // Sun position
+      crc = mixSignature(crc, &currentHour, sizeof(currentHour));
+      crc = mixSignature(crc, &sunriseHour, sizeof(sunriseHour));
+      crc = mixSignature(crc, &sunriseMinute, sizeof(sunriseMinute));
+      crc = mixSignature(crc, &sunsetHour, sizeof(sunsetHour));
+      crc = mixSignature(crc, &sunsetMinute, sizeof(sunsetMinute));
+      break;
+      
+    case SCREEN_CURRENT_WEATHER:
+      crc = mixSignature(crc, Locations::count() > 1 ? cityName.c_str() : "");
+      crc = mixSignature(crc, &currentTemp, sizeof(currentTemp));
+      crc = mixSignature(crc, &highTemp, sizeof(highTemp));
+      crc = mixSignature(crc, &lowTemp, sizeof(lowTemp));
+      crc = mixSignature(crc, currentCondition);
+      crc = mixSignature(crc, &weatherDataStale, sizeof(weatherDataStale));
+      break;
+      
+    case SCREEN_FORECAST:
+      crc = mixSignature(crc, Locations::count() > 1 ? cityName.c_str() : "");
+      for (int i = 0; i < 3; i++) {
+        crc = mixSignature(crc, forecast[i].day);
+        crc = mixSignature(crc, &forecast[i].temp, sizeof(forecast[i].temp));
+        crc = mixSignature(crc, &forecast[i].lowTemp, sizeof(forecast[i].lowTemp));
+        crc = mixSignature(crc, &forecast[i].iconType, sizeof(forecast[i].iconType));
+      }
+      crc = mixSignature(crc, &weatherDataStale, sizeof(weatherDataStale));
+      break;
+      
+    case SCREEN_HOURLY: {
+      uint8_t count = min(HourlyForecast::count(), (uint8_t)HOURLY_SCREEN_POINTS);
+      crc = mixSignature(crc, &count, sizeof(count));
+      for (uint8_t i = 0; i < count; i++) {
+        crc = mixSignature(crc, &HourlyForecast::point(i), sizeof(HourlyPoint));
+      }
+      crc = mixSignature(crc, &weatherDataStale, sizeof(weatherDataStale));
+      break;
+    }
+  }
+  return crc;
+}
+
+static void countFrame(uint8_t tileRows) {
+  framesThisMinute++;
+  tileRowsThisMinute += tileRows;
+}
+
+// Draw histogram of each screen, in SCREEN_* order
+static const uint8_t DRAW_METRICS[] = { METRIC_DRAW_TIME, METRIC_DRAW_CURRENT, METRIC_DRAW_FORECAST, METRIC_DRAW_HOURLY };
+static_assert(sizeof(DRAW_METRICS) == SCREEN_COUNT, "every screen needs a draw metric");
+
+static void drawScreen(byte screen) {
+  switch (screen) {
+    case SCREEN_TIME: drawTimeScreen(); break;
+    case SCREEN_CURRENT_WEATHER: drawCurrentWeatherScreen(); break;
+    case SCREEN_FORECAST: drawForecastScreen(); break;
+    case SCREEN_HOURLY: drawHourlyScreen(); break;
+  }
+}
+
+static uint32_t tileRowCrc(const uint8_t* row, size_t rowBytes) {
+  return crc32(row, rowBytes, 0xFFFFFFFF);
+}
+
+#if DISPLAY_PAGE_BUFFER
+// Draw the screen once per page, u8g2 clipping to the rows in the buffer,
+// and send the pages whose rows changed. Returns the tile rows sent.
+static uint8_t drawAndPushPages(byte screen, bool fullFrame) {
+  uint8_t pageRows = u8g2.getBufferTileHeight();
+  size_t rowBytes = u8g2.getBufferTileWidth() * 8;
+  uint8_t* buffer = u8g2.getBufferPtr();
+  uint32_t drawUs = 0;
+  uint32_t sendUs = 0;
+  uint8_t pushed = 0;
+  
+  for (uint8_t page = 0; page < 8; page += pageRows) {
+    uint32_t start = micros();
+    u8g2.setBufferCurrTileRow(page);
+    u8g2.clearBuffer();
+    drawScreen(screen);
+    uint32_t drawn = micros();
+    drawUs += drawn - start;
+    
+    bool changed = fullFrame;
+    for (uint8_t row = 0; row < pageRows && page + row < 8; row++) {
+      uint32_t crc = tileRowCrc(buffer + row * rowBytes, rowBytes);
+      changed = changed || crc != shownRowCrc[page + row];
+      shownRowCrc[page + row] = crc;
+    }
+    if (changed) {
+      u8g2.sendBuffer();
+      pushed += pageRows;
+    }
+    sendUs += micros() - drawn;
+  }
+  u8g2.setBufferCurrTileRow(0);
+  
+  Metrics::observe(DRAW_METRICS[screen], drawUs);
+  Metrics::observe(METRIC_DISPLAY_SEND, sendUs);
+  return pushed;
+}
+#else
+// Draw the whole screen into the frame buffer
+static void drawFrame(byte screen) {
+  Metrics::ScopedTimer timer(DRAW_METRICS[screen]);
+  u8g2.clearBuffer();
+  drawScreen(screen);
+}
+
+// Send the frame buffer, in full or as the runs of tile rows that changed.
+// Returns the tile rows sent.
+static uint8_t pushFrame(bool fullFrame) {
+  Metrics::ScopedTimer timer(METRIC_DISPLAY_SEND);
+  uint8_t tileWidth = u8g2.getBufferTileWidth();
+  uint8_t tileRows = min((int)u8g2.getBufferTileHeight(), 8);
+  size_t rowBytes = tileWidth * 8;
+  uint8_t* buffer = u8g2.getBufferPtr();
+  
+  if (fullFrame) {
+    for (uint8_t row = 0; row < tileRows; row++) {
+      shownRowCrc[row] = tileRowCrc(buffer + row * rowBytes, rowBytes);
+    }
+    u8g2.sendBuffer();
+    return tileRows;
+  }
+  
+  // Send each run of changed tile rows as one area
+  uint8_t pushed = 0;
+  int runStart = -1;
+  for (uint8_t row = 0; row <= tileRows; row++) {
+    bool changed = false;
+    if (row < tileRows) {
+      uint32_t crc = tileRowCrc(buffer + row * rowBytes, rowBytes);
+      changed = (crc != shownRowCrc[row]);
+      shownRowCrc[row] = crc;
+    }
+    if (changed && runStart < 0) {
+      runStart = row;
+    } else if (!changed && runStart >= 0) {
+      u8g2.updateDisplayArea(0, runStart, tileWidth, row - runStart);
+      pushed += row - runStart;
+      runStart = -1;
+    }
+  }
+  return pushed;
+}
+#endif
+
+#if DISPLAY_TRANSITION != DISPLAY_TRANSITION_NONE
+#define FRAME_ROW_BYTES 128  // One byte per column, 8 pixel lines each
+#define FRAME_TILE_ROWS 8
+
+// The screen coming in; the frame buffer holds what the panel shows and is
+// moved towards this one frame at a time
+static uint8_t incomingFrame[FRAME_ROW_BYTES * FRAME_TILE_ROWS];
+static byte transitionScreen = 0xFF;   // 0xFF = no transition running
+static uint32_t transitionSignature = 0;
+static uint8_t transitionStep = 0;
+static unsigned long transitionStepAt = 0;
+
+// Draw the new screen into incomingFrame, keeping the shown frame in the buffer
+static void beginTransition(byte screen, uint32_t signature) {
+  uint8_t* buffer = u8g2.getBufferPtr();
+  memcpy(incomingFrame, buffer, sizeof(incomingFrame));
+  drawFrame(screen);
+  
+  // Swap the two frames a tile row at a time
+  uint8_t row[FRAME_ROW_BYTES];
+  for (uint8_t r = 0; r < FRAME_TILE_ROWS; r++) {
+    uint8_t* shown = incomingFrame + r * FRAME_ROW_BYTES;
+    uint8_t* drawn = buffer + r * FRAME_ROW_BYTES;
+    memcpy(row, drawn, FRAME_ROW_BYTES);
+    memcpy(drawn, shown, FRAME_ROW_BYTES);
+    memcpy(shown, row, FRAME_ROW_BYTES);
+  }
+  
+  transitionScreen = screen;
+  transitionSignature = signature;
+  transitionStep = 0;
+  transitionStepAt = millis() - DISPLAY_TRANSITION_FRAME_MS;
+}
+
+#if DISPLAY_TRANSITION == DISPLAY_TRANSITION_DISSOLVE
+// 4x4 ordered dither thresholds, [y % 4][x % 4]
+static const uint8_t DISSOLVE_ORDER[4][4] = {
+  { 0, 8, 2, 10 }, { 12, 4, 14, 6 }, { 3, 11, 1, 9 }, { 15, 7, 13, 5 }
+};
+
+// Pixels of a column byte (bit n = pixel line n) whose threshold is in [low, high)
+static uint8_t dissolveMask(uint8_t column, uint8_t low, uint8_t high) {
+  uint8_t mask = 0;
+  for (uint8_t bit = 0; bit < 8; bit++) {
+    uint8_t threshold = DISSOLVE_ORDER[bit % 4][column % 4];
+    if (threshold >= low && threshold < high) {
+      mask |= 1 << bit;
+    }
+  }
+  return mask;
+}
+#endif
+
+// Move the buffer one step towards incomingFrame and send it
+static void stepTransition() {
+  uint8_t* buffer = u8g2.getBufferPtr();
+  uint8_t step = ++transitionStep;
+  
+#if DISPLAY_TRANSITION == DISPLAY_TRANSITION_SLIDE
+  // Once the buffer is old[from..] + new[..from], dropping the first
+  // columns and appending the next ones makes it old[to..] + new[..to].
+  // Under U8G2_R2 the buffer's first column is the panel's right edge, so
+  // the picture moves to the right.
+  uint8_t from = (step - 1) * FRAME_ROW_BYTES / DISPLAY_TRANSITION_FRAMES;
+  uint8_t to = step * FRAME_ROW_BYTES / DISPLAY_TRANSITION_FRAMES;
+  uint8_t shift = to - from;
+  for (uint8_t r = 0; r < FRAME_TILE_ROWS; r++) {
+    uint8_t* line = buffer + r * FRAME_ROW_BYTES;
+    memmove(line, line + shift, FRAME_ROW_BYTES - shift);
+    memcpy(line + FRAME_ROW_BYTES - shift, incomingFrame + r * FRAME_ROW_BYTES + from, shift);
+  }
+#else
+  // Every step switches the pixels of the next thresholds over; each pixel
+  // switches once, so the last step leaves exactly the new frame
+  uint8_t low = (step - 1) * 16 / DISPLAY_TRANSITION_FRAMES;
+  uint8_t high = step * 16 / DISPLAY_TRANSITION_FRAMES;
+  uint8_t masks[4];
+  for (uint8_t column = 0; column < 4; column++) {
+    masks[column] = dissolveMask(column, low, high);
+  }
+  for (size_t i = 0; i < sizeof(incomingFrame); i++) {
+    uint8_t mask = masks[i % 4];
+    buffer[i] = (buffer[i] & ~mask) | (incomingFrame[i] & mask);
+  }
+#endif
+  
+  pushFrame(true);
+  countFrame(FRAME_TILE_ROWS);
+}
+
+// Play the running transition; false if there is none for this screen
+static bool serviceTransition(byte screen) {
+  if (transitionScreen == 0xFF) {
+    return false;
+  }
+  if (screen != transitionScreen || shownScreen == 0xFF) {
+    // The screen changed again or something else drew; start over in full
+    transitionScreen = 0xFF;
+    shownScreen = 0xFF;
+    return false;
+  }
+  
+  if (millis() - transitionStepAt < DISPLAY_TRANSITION_FRAME_MS) {
+    return true;
+  }
+  transitionStepAt = millis();
+  stepTransition();
+  
+  if (transitionStep >= DISPLAY_TRANSITION_FRAMES) {
+    // The buffer now holds the new screen; a change drawn meanwhile is
+    // caught by the signature on the next call
+    shownScreen = transitionScreen;
+    shownSignature = transitionSignature;
+    transitionScreen = 0xFF;
+  }
+  return true;
+}
+#endif
+
+void renderScreen(byte screen, bool animate) {
+  if (millis() - statsMinuteStart >= 60000) {
+    framesLastMinute = framesThisMinute;
+    tileRowsLastMinute = tileRowsThisMinute;
+    framesThisMinute = 0;
+    tileRowsThisMinute = 0;
+    statsMinuteStart = millis();
+  }
+  
+#if DISPLAY_TRANSITION != DISPLAY_TRANSITION_NONE
+  if (serviceTransition(screen)) {
+    return;
+  }
+#endif
+  
+  uint32_t signature = screenSignature(screen);
+  if (screen == shownScreen && signature == shownSignature) {
+    return;
+  }
+  
+  uint32_t heapBefore = ESP.getFreeHeap();
+  bool fullFrame = (screen != shownScreen);
+  
+#if DISPLAY_TRANSITION != DISPLAY_TRANSITION_NONE
+  // Animate from what the panel shows when it shows one of our screens
+  if (animate && fullFrame && shownScreen != 0xFF) {
+    beginTransition(screen, signature);
+    serviceTransition(screen);
+    return;
+  }
+#else
+  (void)animate;
+#endif
+  
+#if DISPLAY_PAGE_BUFFER
+  uint8_t pushed = drawAndPushPages(screen, fullFrame);
+#else
+  drawFrame(screen);
+  uint8_t pushed = pushFrame(fullFrame);
+#endif
+  if (pushed > 0) {
+    countFrame(pushed);
+  }
+  
+  shownScreen = screen;
+  shownSignature = signature;
+  
+  uint32_t heapAfter = ESP.getFreeHeap();
+  heapStats.frames++;
+  if (heapAfter != heapBefore) {
+    heapStats.framesChangingHeap++;
+  }
+  heapStats.minFreeHeap = min(heapStats.minFreeHeap, min(heapBefore, heapAfter));
+  heapStats.fragmentation = ESP.getHeapFragmentation();
+}
+
+void invalidateDisplay() {
+  shownScreen = 0xFF;
+}
+
+uint16_t framesPushedPerMinute() {
+  return framesLastMinute;
+}
+
+uint16_t tileRowsPushedPerMinute() {
+  return tileRowsLastMinute;
+}
+
+DisplayHeapStats displayHeapStats() {
+  return heapStats;
+}
+
+#ifdef DISPLAY_BENCHMARK
+// Number of pushes averaged per measurement
+#define DISPLAY_BENCHMARK_ROUNDS 50
+
+void runDisplayBenchmark() {
+  LOG_INFO("Display", "Benchmark, transport " DISPLAY_TRANSPORT_NAME ", " DISPLAY_BUFFER_NAME " buffer");
+#ifdef DISPLAY_HW_I2C
+  LOG_INFO("Display", "Bus clock: %lu Hz", (unsigned long)DISPLAY_I2C_CLOCK);
+#endif
+  
+  // A busy test pattern, so no transfer is shortened by blank data
+  u8g2.clearBuffer();
+  u8g2.setFont(u8g2_font_6x10_tf);
+  for (int y = 10; y <= 60; y += 10) {
+    u8g2.drawStr(0, y, "Display benchmark 0123456789");
+  }
+  
+  unsigned long start = micros();
+  for (int i = 0; i < DISPLAY_BENCHMARK_ROUNDS; i++) {
+    u8g2.sendBuffer();
+    yield();
+  }
+  unsigned long fullFrameUs = (micros() - start) / DISPLAY_BENCHMARK_ROUNDS;
+  
+  start = micros();
+  for (int i = 0; i < DISPLAY_BENCHMARK_ROUNDS; i++) {
+    u8g2.updateDisplayArea(0, i % 8, u8g2.getBufferTileWidth(), 1);
+    yield();
+  }
+  unsigned long tileRowUs = (micros() - start) / DISPLAY_BENCHMARK_ROUNDS;
+  
+  LOG_INFO("Display", "sendBuffer(): %lu us average over %d frames", fullFrameUs, DISPLAY_BENCHMARK_ROUNDS);
+  LOG_INFO("Display", "updateDisplayArea() one tile row: %lu us average", tileRowUs);
+  
+  invalidateDisplay();
+}
+#endif
@@ -9,12 +9,15 @@
 #include <Arduino.h>
 #include "config.h"
 
-// Draw weather icon based on type
+// Draw weather icon based on type; size 1 = 8x8, 2 = 16x16, 3 or more = 32x32
 void drawWeatherIcon(int x, int y, byte iconType, byte size);
 
 // Draw extra large weather icon (custom function for current weather)
 void drawExtraLargeWeatherIcon(int x, int y, byte iconType);
 
+// True between today's sunrise and sunset by the local clock
+bool isDaytimeNow();
+
 // Draw the time screen with sun position indicator
 void drawTimeScreen();
 
@@ -24,4 +27,65 @@ void drawCurrentWeatherScreen();
 // Draw forecast screen
 void drawForecastScreen();
 
+// Draw the next 24 hours as a temperature sparkline with precipitation bars
+void drawHourlyScreen();
+
+// Screens rotated by loop()
+#define SCREEN_TIME 0
+#define SCREEN_CURRENT_WEATHER 1
+#define SCREEN_FORECAST 2
+#define SCREEN_HOURLY 3
+#define SCREEN_COUNT 4
+
+// Animation when renderScreen() moves to another screen, chosen at build
+// time with -DDISPLAY_TRANSITION=...; frames are made by moving bytes of the
+// two finished frames, not by drawing the screens again
+#define DISPLAY_TRANSITION_NONE 0
+#define DISPLAY_TRANSITION_SLIDE 1     // The new screen pushes the old one out to the right
+#define DISPLAY_TRANSITION_DISSOLVE 2  // Pixels change over in an ordered dither pattern
+
+// Off unless asked for: either animation keeps a second 1 KB frame in RAM
+#ifndef DISPLAY_TRANSITION
+#define DISPLAY_TRANSITION DISPLAY_TRANSITION_NONE
+#endif
+
+#if DISPLAY_PAGE_BUFFER && DISPLAY_TRANSITION != DISPLAY_TRANSITION_NONE
+#error "Screen transitions need the full frame buffer; drop DISPLAY_PAGE_BUFFER or set DISPLAY_TRANSITION to 0"
+#endif
+
+// Transition length; one frame per display task run
+#define DISPLAY_TRANSITION_FRAMES 8
+#define DISPLAY_TRANSITION_FRAME_MS 50
+
+// Redraw the screen only if a value it shows changed, and push only the
+// tile rows (8 pixel lines) whose content differs from what the panel shows.
+// With animate, a change of screen plays the transition over the next
+// calls; the caller should come back every DISPLAY_TRANSITION_FRAME_MS.
+void renderScreen(byte screen, bool animate = false);
+
+// Force a full redraw on the next renderScreen(), after something else drew
+// on the display (status screens, error messages, config mode)
+void invalidateDisplay();
+
+#ifdef DISPLAY_BENCHMARK
+// Time full-frame and single-row pushes on the configured transport and
+// print the averages to the serial console
+void runDisplayBenchmark();
+#endif
+
+// Display statistics for the last complete minute
+uint16_t framesPushedPerMinute();   // renderScreen() calls that sent anything
+uint16_t tileRowsPushedPerMinute(); // Tile rows sent, 8 per full frame
+
+// Heap use of the draw path since boot. The draw code is meant to allocate
+// nothing, so framesChangingHeap should stay 0; it counts frames after which
+// the free heap differed from before, i.e. allocations that outlive the frame.
+struct DisplayHeapStats {
+  uint32_t frames;              // Frames drawn
+  uint32_t framesChangingHeap;
+  uint32_t minFreeHeap;         // Lowest free heap seen when drawing
+  uint8_t fragmentation;        // Heap fragmentation in percent at the last frame
+};
+DisplayHeapStats displayHeapStats();
+
 #endif // DISPLAY_H
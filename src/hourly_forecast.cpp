@@ -0,0 +1,85 @@
+/*
+ * Implementation of the hourly forecast ring
+ */
+
+#include "hourly_forecast.h"
+#include "time_zone.h"
+
+namespace HourlyForecast {
+    static HourlyPoint points[HOURLY_POINTS];
+    static uint8_t head = 0;         // Index of the oldest point
+    static uint8_t held = 0;
+    static time_t headTime = 0;      // UTC start of the oldest point
+    static uint32_t changes = 0;
+
+    static HourlyPoint& slot(uint8_t index) {
+        return points[(head + index) % HOURLY_POINTS];
+    }
+
+    static void dropOldest() {
+        head = (head + 1) % HOURLY_POINTS;
+        headTime += HOURLY_STEP_S;
+        held--;
+    }
+
+    void store(time_t utc, float temp, uint8_t iconType, uint8_t precipPct) {
+        if (held == 0) {
+            head = 0;
+            headTime = utc;
+        }
+        if (utc < headTime) {
+            return;
+        }
+
+        long index = (utc - headTime) / HOURLY_STEP_S;
+        bool onGrid = (utc - headTime) % HOURLY_STEP_S == 0;
+        if (onGrid && index >= HOURLY_POINTS && held == HOURLY_POINTS) {
+            return; // Full; the far end fills in as points expire
+        }
+        if (index > held || !onGrid) {
+            // A gap, or a provider with another grid; start over from this point
+            held = 0;
+            head = 0;
+            headTime = utc;
+            index = 0;
+        }
+        if (index == held) {
+            held++;
+        }
+
+        HourlyPoint& point = slot(index);
+        long rounded = lroundf(temp);
+        point.temp = (int8_t)constrain(rounded, -128L, 127L);
+        point.iconType = iconType;
+        point.precipPct = precipPct;
+        point.localHour = (TimeZone::toLocal(utc) % 86400) / 3600;
+        changes++;
+    }
+
+    void expire(time_t utc) {
+        bool dropped = false;
+        while (held > 0 && headTime + HOURLY_STEP_S <= utc) {
+            dropOldest();
+            dropped = true;
+        }
+        if (dropped) {
+            changes++;
+        }
+    }
+
+    uint8_t count() {
+        return held;
+    }
+
+    const HourlyPoint& point(uint8_t index) {
+        return slot(index);
+    }
+
+    time_t firstTime() {
+        return headTime;
+    }
+
+    uint32_t generation() {
+        return changes;
+    }
+}
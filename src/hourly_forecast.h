@@ -0,0 +1,47 @@
+/*
+ * Hourly forecast for ESP-01 Weather Display
+ * A fixed ring of 3-hour forecast points, 4 bytes each, filled by the
+ * streaming forecast parsers. A new fetch overwrites the points it covers
+ * and appends the rest up to the ring's size; points whose period has
+ * passed drop out.
+ */
+
+#ifndef HOURLY_FORECAST_H
+#define HOURLY_FORECAST_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Points kept, 48 hours at the 3 hour step
+#define HOURLY_POINTS 16
+#define HOURLY_STEP_S (3 * 3600)
+
+// precipPct when the provider gave no probability
+#define HOURLY_PRECIP_UNKNOWN 0xFF
+
+struct HourlyPoint {
+  int8_t temp;         // Rounded, in the display units
+  uint8_t iconType;    // As WeatherDay::iconType
+  uint8_t precipPct;   // Probability of precipitation, 0-100
+  uint8_t localHour;   // Hour the point starts at, local time
+};
+static_assert(sizeof(HourlyPoint) == 4, "HourlyPoint should stay packed");
+
+namespace HourlyForecast {
+    // Store the point that starts at utc. Points must arrive oldest first;
+    // one off the 3 hour grid of the points held starts the ring over.
+    void store(time_t utc, float temp, uint8_t iconType, uint8_t precipPct);
+
+    // Drop the points whose period ended before utc
+    void expire(time_t utc);
+
+    // Points held, oldest first; point 0 is the one covering now after expire()
+    uint8_t count();
+    const HourlyPoint& point(uint8_t index);
+    time_t firstTime();
+
+    // Bumped on every change, for the display's redraw check
+    uint32_t generation();
+}
+
+#endif // HOURLY_FORECAST_H
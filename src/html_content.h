@@ -7,98 +7,51 @@
 
 #include <Arduino.h>
 
-// Common HTML header with styles
+// Common HTML header; the stylesheet is served gzipped from web_assets.h
 const char HTML_HEADER[] PROGMEM = R"rawliteral(
 <!DOCTYPE html>
 <html>
 <head>
   <meta name='viewport' content='width=device-width, initial-scale=1'>
   <title>ESP Weather Display</title>
-  <style>
-    body { 
-      font-family: Arial, sans-serif; 
-      margin: 0; 
-      padding: 20px; 
-      background: #f5f5f5; 
-      color: #333; 
-    }
-    h1 { color: #2c3e50; }
-    .container { 
-      max-width: 500px; 
-      margin: 0 auto; 
-      background: white; 
-      padding: 20px; 
-      border-radius: 5px; 
-      box-shadow: 0 2px 5px rgba(0,0,0,0.1); 
-    }
-    label { 
-      display: block; 
-      margin-top: 10px; 
-      font-weight: bold; 
-    }
-    select, input { 
-      width: 100%; 
-      padding: 8px; 
-      margin-top: 5px; 
-      margin-bottom: 15px; 
-      border: 1px solid #ddd; 
-      border-radius: 3px; 
-    }
-    button { 
-      background: #3498db; 
-      color: white; 
-      border: none; 
-      padding: 10px 15px; 
-      border-radius: 3px; 
-      cursor: pointer; 
-    }
-    button:hover { 
-      background: #2980b9; 
-    }
-    #networks { 
-      max-height: 150px; 
-      overflow-y: auto; 
-    }
-    .nav-link { 
-      display: inline-block; 
-      margin-top: 20px; 
-      color: #3498db; 
-      text-decoration: none; 
-    }
-    .nav-link:hover { 
-      text-decoration: underline; 
-    }
-  </style>
+  <link rel='stylesheet' href='/style.css'>
 )rawliteral";
 
 // WiFi Configuration page
 const char WIFI_CONFIG_HTML[] PROGMEM = R"rawliteral(
   <script>
-  function scanWifi() {
+  // Shows the cached list at once and polls while a background scan runs
+  function scanWifi(refresh) {
     document.getElementById('scanBtn').disabled = true;
     document.getElementById('scanBtn').innerText = 'Scanning...';
-    fetch('/scan')
+    fetch(refresh ? '/scan?refresh=1' : '/scan')
       .then(response => response.json())
       .then(data => {
         const select = document.getElementById('ssid');
-        select.innerHTML = '';
         const currentSSID = '%CURRENT_SSID%';
-        data.forEach(network => {
+        if (data.networks.length > 0 || !data.scanning) {
+          select.innerHTML = '';
+        }
+        data.networks.forEach(network => {
           const option = document.createElement('option');
           option.value = network.ssid;
-          option.text = network.ssid + ' (' + network.rssi + ' dBm)';
+          option.text = network.ssid + ' (' + network.rssi + ' dBm' + (network.open ? ', open' : '') + ')';
           if (network.ssid === currentSSID) {
             option.selected = true;
           }
           select.appendChild(option);
         });
-        document.getElementById('scanBtn').disabled = false;
-        document.getElementById('scanBtn').innerText = 'Scan';
+        if (data.scanning) {
+          setTimeout(() => scanWifi(false), 1000);
+        } else {
+          document.getElementById('scanBtn').disabled = false;
+          document.getElementById('scanBtn').innerText = 'Scan';
+        }
       });
   }
   
   window.onload = function() {
-    scanWifi();
+    scanWifi(false);
   };
   </script>
 </head>
@@ -116,7 +69,7 @@ const char WIFI_CONFIG_HTML[] PROGMEM = R"rawliteral(
             <option value=''>Scanning...</option>
           </select>
         </div>
-        <button type='button' id='scanBtn' onclick='scanWifi()'>Scan</button><br>
+        <button type='button' id='scanBtn' onclick='scanWifi(true)'>Scan</button><br>
         
         <label for='password'>WiFi Password:</label>
         <input type='password' id='password' name='password' value=''><br>
@@ -134,96 +87,10 @@ const char WIFI_CONFIG_HTML[] PROGMEM = R"rawliteral(
 // Weather Settings page
 const char WEATHER_SETTINGS_HTML[] PROGMEM = R"rawliteral(
   <script>
-  function populateStates() {
-    const states = [
-      'AL', 'AK', 'AZ', 'AR', 'CA', 'CO', 'CT', 'DE', 'FL', 'GA',
-      'HI', 'ID', 'IL', 'IN', 'IA', 'KS', 'KY', 'LA', 'ME', 'MD',
-      'MA', 'MI', 'MN', 'MS', 'MO', 'MT', 'NE', 'NV', 'NH', 'NJ',
-      'NM', 'NY', 'NC', 'ND', 'OH', 'OK', 'OR', 'PA', 'RI', 'SC',
-      'SD', 'TN', 'TX', 'UT', 'VT', 'VA', 'WA', 'WV', 'WI', 'WY'
-    ];
-    const stateSelect = document.getElementById('state');
-    const currentState = '%STATE%'; // Will be replaced with actual state
-    states.forEach(state => {
-      const option = document.createElement('option');
-      option.value = state;
-      option.text = state;
-      if (state === currentState) {
-        option.selected = true;
-      }
-      stateSelect.appendChild(option);
-    });
-  }
-  
-  function populateTimezones() {
-    const timezones = [
-      {value: '-12', text: '(UTC-12:00) International Date Line West'},
-      {value: '-11', text: '(UTC-11:00) Coordinated Universal Time-11'},
-      {value: '-10', text: '(UTC-10:00) Hawaii'},
-      {value: '-9', text: '(UTC-09:00) Alaska'},
-      {value: '-8', text: '(UTC-08:00) Pacific Time (US & Canada)'},
-      {value: '-7', text: '(UTC-07:00) Mountain Time (US & Canada)'},
-      {value: '-6', text: '(UTC-06:00) Central Time (US & Canada)'},
-      {value: '-5', text: '(UTC-05:00) Eastern Time (US & Canada)'},
-      {value: '-4', text: '(UTC-04:00) Atlantic Time (Canada)'},
-      {value: '-3.5', text: '(UTC-03:30) Newfoundland'},
-      {value: '-3', text: '(UTC-03:00) Brasilia'},
-      {value: '-2', text: '(UTC-02:00) Mid-Atlantic'},
-      {value: '-1', text: '(UTC-01:00) Azores'},
-      {value: '0', text: '(UTC+00:00) London, Dublin'},
-      {value: '1', text: '(UTC+01:00) Paris, Berlin, Rome'},
-      {value: '2', text: '(UTC+02:00) Athens, Istanbul'},
-      {value: '3', text: '(UTC+03:00) Moscow'},
-      {value: '3.5', text: '(UTC+03:30) Tehran'},
-      {value: '4', text: '(UTC+04:00) Dubai'},
-      {value: '4.5', text: '(UTC+04:30) Kabul'},
-      {value: '5', text: '(UTC+05:00) Karachi'},
-      {value: '5.5', text: '(UTC+05:30) New Delhi'},
-      {value: '5.75', text: '(UTC+05:45) Kathmandu'},
-      {value: '6', text: '(UTC+06:00) Dhaka'},
-      {value: '6.5', text: '(UTC+06:30) Yangon'},
-      {value: '7', text: '(UTC+07:00) Bangkok'},
-      {value: '8', text: '(UTC+08:00) Singapore, Beijing'},
-      {value: '9', text: '(UTC+09:00) Tokyo'},
-      {value: '9.5', text: '(UTC+09:30) Adelaide'},
-      {value: '10', text: '(UTC+10:00) Sydney'},
-      {value: '11', text: '(UTC+11:00) Solomon Islands'},
-      {value: '12', text: '(UTC+12:00) Auckland'},
-      {value: '13', text: '(UTC+13:00) Samoa'},
-      {value: '14', text: '(UTC+14:00) Line Islands'}
-    ];
-    
-    const tzSelect = document.getElementById('timezone');
-    const currentTz = '%TIMEZONE%';
-    
-    // Find the closest match for the current timezone
-    let bestMatchIndex = 0;
-    let smallestDiff = 100;
-    
-    timezones.forEach((tz, index) => {
-      const diff = Math.abs(parseFloat(tz.value) - parseFloat(currentTz));
-      if (diff < smallestDiff) {
-        smallestDiff = diff;
-        bestMatchIndex = index;
-      }
-    });
-    
-    timezones.forEach((tz, index) => {
-      const option = document.createElement('option');
-      option.value = tz.value;
-      option.text = tz.text;
-      if (index === bestMatchIndex) {
-        option.selected = true;
-      }
-      tzSelect.appendChild(option);
-    });
-  }
-  
-  window.onload = function() {
-    populateStates();
-    populateTimezones();
-  };
+  const currentState = '%STATE%';
+  const currentTz = '%TIMEZONE%';
   </script>
+  <script src='/settings.js'></script>
 </head>
 <body>
   <div class='container'>
@@ -250,6 +117,19 @@ const char WEATHER_SETTINGS_HTML[] PROGMEM = R"rawliteral(
         <select id='state' name='state'>
         </select><br>
         
+        <p style='font-size: 0.8em; color: #666;'>
+          Up to two more locations take turns with the first on the display.
+          Leave a city empty to leave it out.
+        </p>
+        <label for='city2'>Second City:</label>
+        <input type='text' id='city2' name='city2' maxlength='49' value='%CITY2%'><br>
+        <label for='state2'>Second State (two letters):</label>
+        <input type='text' id='state2' name='state2' maxlength='2' value='%STATE2%'><br>
+        <label for='city3'>Third City:</label>
+        <input type='text' id='city3' name='city3' maxlength='49' value='%CITY3%'><br>
+        <label for='state3'>Third State (two letters):</label>
+        <input type='text' id='state3' name='state3' maxlength='2' value='%STATE3%'><br>
+        
         <label for='tempUnit'>Temperature Unit:</label>
         <select id='tempUnit' name='tempUnit'>
           <option value='0' %FAHRENHEIT_SELECTED%>Fahrenheit (°F)</option>
@@ -257,15 +137,12 @@ const char WEATHER_SETTINGS_HTML[] PROGMEM = R"rawliteral(
         </select><br>
         
         <h2>Time Settings</h2>
-        <label for='timezone'>Timezone:</label>
-        <select id='timezone' name='timezone'>
+        <label for='tzPreset'>Timezone:</label>
+        <select id='tzPreset'>
         </select><br>
         
-        <label for='dst'>Daylight Saving Time:</label>
-        <select id='dst' name='dst'>
-          <option value='0' %DST_OFF_SELECTED%>Disabled (Manual timezone only)</option>
-          <option value='1' %DST_ON_SELECTED%>Enabled (Automatic DST adjustment)</option>
-        </select><br>
+        <label for='timezone'>Time Zone Rule (POSIX TZ, includes daylight saving time):</label>
+        <input type='text' id='timezone' name='timezone' maxlength='47' value='%TIMEZONE%'><br>
         
         <label for='timeFormat'>Time Format:</label>
         <select id='timeFormat' name='timeFormat'>
@@ -278,10 +155,31 @@ const char WEATHER_SETTINGS_HTML[] PROGMEM = R"rawliteral(
         <select id='interval' name='interval'>
           %INTERVALS%
         </select><br>
+        
+        <h2>Power Settings</h2>
+        <label for='powerMode'>Power Saving:</label>
+        <select id='powerMode' name='powerMode'>
+          <option value='0' %POWER_FULL_SELECTED%>Off (always fully on)</option>
+          <option value='1' %POWER_MODEM_SELECTED%>Modem sleep (radio sleeps between fetches)</option>
+          <option value='2' %POWER_LIGHT_SELECTED%>Light sleep (radio and CPU sleep)</option>
+        </select><br>
+        
+        <label for='nightDisplay'>Display at Night:</label>
+        <select id='nightDisplay' name='nightDisplay'>
+          <option value='0' %NIGHT_ON_SELECTED%>Normal</option>
+          <option value='1' %NIGHT_DIM_SELECTED%>Dimmed</option>
+          <option value='2' %NIGHT_OFF_SELECTED%>Off</option>
+        </select><br>
       </div>
       
       <div id='api-config'>
         <h2>API Settings</h2>
+        <label for='provider'>Weather Provider:</label>
+        <select id='provider' name='provider'>
+          <option value='0' %PROVIDER_OWM_SELECTED%>OpenWeatherMap (API key required)</option>
+          <option value='1' %PROVIDER_OPENMETEO_SELECTED%>Open-Meteo (no API key)</option>
+        </select><br>
+        
         <label for='apikey'>OpenWeatherMap API Key:</label>
         <input type='text' id='apikey' name='apikey' value='%API_KEY%'><br>
         <p style='font-size: 0.8em; color: #666;'>
@@ -302,6 +200,7 @@ const char WEATHER_SETTINGS_HTML[] PROGMEM = R"rawliteral(
 
 // Success message for WiFi save
 const char WIFI_SAVE_SUCCESS_HTML[] PROGMEM = R"rawliteral(
+  <meta http-equiv='refresh' content='5;url=/'>
 </head>
 <body>
   <div class='container'>
@@ -325,11 +224,13 @@ const char SETTINGS_SAVE_SUCCESS_HTML[] PROGMEM = R"rawliteral(
   <div class='container'>
     <h1>Settings Saved!</h1>
     <p>Your weather display settings have been updated.</p>
-    <p>Location: %CITY%, %STATE%</p>
+    <p>Location: %CITY%, %STATE%%MORE_LOCATIONS%</p>
     <p>Timezone: %TIMEZONE_TEXT%</p>
     <p>Time format: %TIME_FORMAT%</p>
     <p>Temperature unit: %TEMP_UNIT%</p>
     <p>Update interval: %INTERVAL% minutes</p>
+    <p>Power saving: %POWER_MODE%</p>
+    <p>Weather provider: %PROVIDER%</p>
     <p>API Key: %API_KEY_MASKED%</p>
     <p>Weather data will be updated with new settings.</p>
     <p>Redirecting back to settings page...</p>
@@ -0,0 +1,98 @@
+/*
+ * Implementation of the streaming HTML templates
+ */
+
+#include "html_template.h"
+
+void TemplateWriter::write(char c) {
+  if (used == sizeof(buffer)) {
+    flush();
+  }
+  buffer[used++] = c;
+}
+
+void TemplateWriter::print(const char* text) {
+  while (*text) {
+    write(*text++);
+  }
+}
+
+void TemplateWriter::print(long value) {
+  char digits[12];
+  snprintf(digits, sizeof(digits), "%ld", value);
+  print(digits);
+}
+
+void TemplateWriter::print(float value, uint8_t decimals) {
+  char digits[16];
+  dtostrf(value, 1, decimals, digits);
+  print(digits);
+}
+
+void TemplateWriter::print_P(PGM_P text) {
+  char c;
+  while ((c = pgm_read_byte(text++)) != '\0') {
+    write(c);
+  }
+}
+
+void TemplateWriter::flush() {
+  if (used > 0) {
+    server.sendContent(buffer, used);
+    used = 0;
+  }
+}
+
+static bool isTokenChar(char c) {
+  return (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// If a placeholder starts at text (just after a %), return its handler and
+// set length to the name length; otherwise return nullptr
+static TemplateTokenHandler findToken(PGM_P text, const TemplateToken* tokens, size_t tokenCount, size_t& length) {
+  char name[TEMPLATE_MAX_TOKEN + 1];
+  size_t n = 0;
+  char c;
+  while (n < TEMPLATE_MAX_TOKEN && isTokenChar(c = pgm_read_byte(text + n))) {
+    name[n++] = c;
+  }
+  if (n == 0 || pgm_read_byte(text + n) != '%') {
+    return nullptr;
+  }
+  name[n] = '\0';
+
+  for (size_t i = 0; i < tokenCount; i++) {
+    if (strcmp(tokens[i].name, name) == 0) {
+      length = n;
+      return tokens[i].handler;
+    }
+  }
+  return nullptr;
+}
+
+void sendTemplate(ESP8266WebServer& server, int code, const char* contentType,
+                  const char* const* parts, size_t partCount,
+                  const TemplateToken* tokens, size_t tokenCount) {
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(code, contentType, "");
+
+  TemplateWriter out(server);
+  for (size_t part = 0; part < partCount; part++) {
+    PGM_P text = parts[part];
+    char c;
+    while ((c = pgm_read_byte(text++)) != '\0') {
+      size_t length;
+      TemplateTokenHandler handler;
+      if (c == '%' && (handler = findToken(text, tokens, tokenCount, length)) != nullptr) {
+        handler(out);
+        text += length + 1; // The name and the closing %
+      } else {
+        out.write(c);
+      }
+    }
+  }
+  out.flush();
+
+  // An empty chunk ends the response
+  server.sendContent("");
+}
@@ -0,0 +1,54 @@
+/*
+ * Streaming HTML templates for ESP-01 Weather Display
+ * Sends PROGMEM pages as a chunked response and fills in %TOKEN%
+ * placeholders on the fly, so a page never has to fit in RAM
+ */
+
+#ifndef HTML_TEMPLATE_H
+#define HTML_TEMPLATE_H
+
+#include <Arduino.h>
+#include <ESP8266WebServer.h>
+
+// Bytes collected before a chunk goes out; this is all a response buffers
+#define TEMPLATE_CHUNK_SIZE 256
+
+// Longest token name between the two % signs
+#define TEMPLATE_MAX_TOKEN 24
+
+// Buffered writer for the body of a chunked response
+class TemplateWriter {
+public:
+  explicit TemplateWriter(ESP8266WebServer& server) : server(server), used(0) {}
+
+  void write(char c);
+  void print(const char* text);
+  void print(long value);
+  void print(float value, uint8_t decimals);
+  void print_P(PGM_P text);
+
+  // Send what is buffered as one chunk
+  void flush();
+
+private:
+  ESP8266WebServer& server;
+  char buffer[TEMPLATE_CHUNK_SIZE];
+  size_t used;
+};
+
+// Writes the value of one placeholder
+typedef void (*TemplateTokenHandler)(TemplateWriter& out);
+
+struct TemplateToken {
+  const char* name;             // Without the % signs
+  TemplateTokenHandler handler;
+};
+
+// Send the PROGMEM parts one after the other as a single chunked response.
+// Every %NAME% found in tokens is replaced by its handler's output; any
+// other % is sent as it is.
+void sendTemplate(ESP8266WebServer& server, int code, const char* contentType,
+                  const char* const* parts, size_t partCount,
+                  const TemplateToken* tokens, size_t tokenCount);
+
+#endif // HTML_TEMPLATE_H
@@ -0,0 +1,549 @@
+/*
+ * Implementation of the non-blocking HTTP client
+ */
+
+#include "http_fetch.h"
+#include "logging.h"
+#include <lwip/dns.h>
+
+// Give up on a request that has not finished after this long
+#define HTTP_FETCH_TIMEOUT_MS 15000
+
+// Upper bound for the TCP handshake, the only step that waits on the network
+#define HTTP_CONNECT_TIMEOUT_MS 2000
+
+// Size of the chunks handed to the body handler
+#define HTTP_BODY_CHUNK_SIZE 128
+
+namespace HttpFetch {
+    static WiFiClient client;
+    static State currentState = IDLE;
+
+    // Request parameters
+    static char host[48];
+    static uint16_t port = 80;
+    static String path;
+    static BodyHandler bodyHandler = nullptr;
+    static void* bodyContext = nullptr;
+    static long rangeStart = -1;
+    static unsigned long timeoutMs = HTTP_FETCH_TIMEOUT_MS;
+
+    // Response state
+    static int httpStatus = 0;
+    static long contentLength = -1;
+    static long bodyReceived = 0;
+    static char headerLine[96];
+    static size_t headerLineLen = 0;
+    static bool statusLineParsed = false;
+
+    // Cache validators: sent with the request, and captured from the response
+    static char requestEtag[48];
+    static char requestLastModified[32];
+    static char responseEtag[48];
+    static char responseLastModified[32];
+    static long responseMaxAge = -1;
+
+    // Keep-alive: a response whose end is known from its framing leaves the
+    // connection open for the next request to the same server
+    static bool connectionReusable = false;
+    static bool reusingConnection = false;
+    static bool serverCloses = false;
+    static uint32_t connectionsOpened = 0;
+    static uint32_t requestsReused = 0;
+
+    // Chunked transfer coding of the body
+    enum ChunkPhase {
+        CHUNK_SIZE,     // Reading the hex size line
+        CHUNK_DATA,
+        CHUNK_DATA_END, // The CRLF after the data
+        CHUNK_TRAILER   // Trailer lines after the last chunk, up to a blank one
+    };
+    static bool chunked = false;
+    static ChunkPhase chunkPhase = CHUNK_SIZE;
+    static long chunkLeft = 0;
+    static char chunkLine[12];
+    static size_t chunkLineLen = 0;
+
+    // Address resolution (filled in by the lwIP DNS callback)
+    static IPAddress serverIP;
+    static volatile bool dnsDone = false;
+    static volatile bool dnsFailed = false;
+    static uint32_t dnsGeneration = 0;
+
+    // Timing
+    static unsigned long requestStart = 0;
+    static unsigned long longestSlice = 0;
+    static unsigned long lastDuration = 0;
+
+    static void fail(const char* reason) {
+        LOG_WARN("HTTP", "Request failed: %s", reason);
+        connectionReusable = false;
+        client.stop();
+        lastDuration = millis() - requestStart;
+        currentState = FAILED;
+    }
+
+    // Called from the lwIP context once the name lookup completes
+    static void onDnsFound(const char* name, const ip_addr_t* ipaddr, void* arg) {
+        // Ignore answers for a request that has since been reset
+        if ((uint32_t)(uintptr_t)arg != dnsGeneration) {
+            return;
+        }
+        if (ipaddr) {
+            serverIP = IPAddress(ipaddr);
+            dnsDone = true;
+        } else {
+            dnsFailed = true;
+        }
+    }
+
+    // Copy a header value, dropping leading spaces; overlong values are left empty
+    // rather than truncated, since a cut validator would never match
+    static void copyHeaderValue(char* dest, size_t size, const char* value) {
+        while (*value == ' ') {
+            value++;
+        }
+        if (strlen(value) >= size) {
+            dest[0] = '\0';
+            return;
+        }
+        strcpy(dest, value);
+    }
+
+    bool begin(const char* hostName, uint16_t portNum, const String& requestPath, BodyHandler onBody, void* context,
+               const char* ifNoneMatch, const char* ifModifiedSince) {
+        if (currentState != IDLE && currentState != DONE && currentState != FAILED) {
+            return false;
+        }
+        bool sameServer = connectionReusable && client.connected() && port == portNum && strcmp(host, hostName) == 0;
+
+        strncpy(host, hostName, sizeof(host) - 1);
+        host[sizeof(host) - 1] = '\0';
+        port = portNum;
+        path = requestPath;
+        bodyHandler = onBody;
+        bodyContext = context;
+        rangeStart = -1;
+        timeoutMs = HTTP_FETCH_TIMEOUT_MS;
+
+        httpStatus = 0;
+        contentLength = -1;
+        bodyReceived = 0;
+        headerLineLen = 0;
+        statusLineParsed = false;
+        serverCloses = false;
+        chunked = false;
+
+        copyHeaderValue(requestEtag, sizeof(requestEtag), ifNoneMatch ? ifNoneMatch : "");
+        copyHeaderValue(requestLastModified, sizeof(requestLastModified), ifModifiedSince ? ifModifiedSince : "");
+        responseEtag[0] = '\0';
+        responseLastModified[0] = '\0';
+        responseMaxAge = -1;
+
+        dnsDone = false;
+        dnsFailed = false;
+        dnsGeneration++;
+
+        requestStart = millis();
+
+        // The server and its address are known; skip DNS and the handshake
+        if (sameServer) {
+            reusingConnection = true;
+            requestsReused++;
+            currentState = SENDING;
+            return true;
+        }
+        reusingConnection = false;
+        connectionReusable = false;
+        client.stop();
+        currentState = RESOLVING;
+
+        // Start the lookup; cached names resolve immediately
+        ip_addr_t addr;
+        err_t err = dns_gethostbyname(host, &addr, onDnsFound, (void*)(uintptr_t)dnsGeneration);
+        if (err == ERR_OK) {
+            serverIP = IPAddress(&addr);
+            dnsDone = true;
+        } else if (err != ERR_INPROGRESS) {
+            fail("DNS lookup could not be started");
+        }
+
+        return currentState != FAILED;
+    }
+
+    void setRangeStart(long offset) {
+        rangeStart = offset;
+    }
+
+    void setTimeout(unsigned long ms) {
+        timeoutMs = ms;
+    }
+
+    void reset() {
+        // Only a finished exchange leaves the connection usable
+        if (currentState != DONE && currentState != IDLE) {
+            connectionReusable = false;
+        }
+        if (!connectionReusable) {
+            client.stop();
+        }
+        dnsGeneration++;
+        currentState = IDLE;
+    }
+
+    void close() {
+        connectionReusable = false;
+        reset();
+    }
+
+    // The request is complete. framed: its end was known from Content-Length,
+    // the chunked coding or the status, so the connection can carry another.
+    static void finishResponse(bool framed) {
+        connectionReusable = framed && !serverCloses;
+        if (!connectionReusable) {
+            client.stop();
+        }
+        lastDuration = millis() - requestStart;
+        currentState = DONE;
+    }
+
+    // A kept-alive connection the server closed while it sat idle fails
+    // before any of the response arrives; open a new one instead
+    static bool reconnectStale() {
+        if (!reusingConnection || statusLineParsed || headerLineLen > 0) {
+            return false;
+        }
+        LOG_DEBUG("HTTP", "Kept-alive connection was closed by %s, reconnecting", host);
+        client.stop();
+        reusingConnection = false;
+        connectionReusable = false;
+        currentState = CONNECTING;
+        return true;
+    }
+
+    // Case-insensitive search for a token in a header value
+    static bool headerContains(const char* value, const char* token) {
+        size_t length = strlen(token);
+        for (; *value; value++) {
+            if (strncasecmp(value, token, length) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Parse one complete header line; returns false on a malformed status line
+    static bool handleHeaderLine() {
+        headerLine[headerLineLen] = '\0';
+
+        if (!statusLineParsed) {
+            // Status line, e.g. "HTTP/1.0 200 OK"
+            const char* space = strchr(headerLine, ' ');
+            if (strncmp(headerLine, "HTTP/", 5) != 0 || space == nullptr) {
+                return false;
+            }
+            httpStatus = atoi(space + 1);
+            statusLineParsed = true;
+            // HTTP/1.0 servers close after every response
+            serverCloses = strncmp(headerLine, "HTTP/1.0", 8) == 0;
+            return true;
+        }
+
+        if (strncasecmp(headerLine, "Content-Length:", 15) == 0) {
+            contentLength = strtol(headerLine + 15, nullptr, 10);
+        } else if (strncasecmp(headerLine, "ETag:", 5) == 0) {
+            copyHeaderValue(responseEtag, sizeof(responseEtag), headerLine + 5);
+        } else if (strncasecmp(headerLine, "Last-Modified:", 14) == 0) {
+            copyHeaderValue(responseLastModified, sizeof(responseLastModified), headerLine + 14);
+        } else if (strncasecmp(headerLine, "Connection:", 11) == 0) {
+            serverCloses = headerContains(headerLine + 11, "close");
+        } else if (strncasecmp(headerLine, "Transfer-Encoding:", 18) == 0) {
+            chunked = headerContains(headerLine + 18, "chunked");
+        } else if (strncasecmp(headerLine, "Cache-Control:", 14) == 0) {
+            const char* maxAge = strstr(headerLine + 14, "max-age=");
+            if (strstr(headerLine + 14, "no-cache") || strstr(headerLine + 14, "no-store")) {
+                responseMaxAge = 0;
+            } else if (maxAge) {
+                responseMaxAge = strtol(maxAge + 8, nullptr, 10);
+            }
+        }
+        return true;
+    }
+
+    // Each step returns true if it made progress and can be run again right away
+    static bool stepResolve() {
+        if (dnsFailed) {
+            fail("DNS lookup failed");
+            return false;
+        }
+        if (!dnsDone) {
+            return false;
+        }
+        currentState = CONNECTING;
+        return true;
+    }
+
+    static bool stepConnect() {
+        client.setTimeout(HTTP_CONNECT_TIMEOUT_MS);
+        client.setNoDelay(true);
+        if (!client.connect(serverIP, port)) {
+            fail("connection refused or timed out");
+            return false;
+        }
+        connectionsOpened++;
+        currentState = SENDING;
+        return true;
+    }
+
+    static bool stepSend() {
+        String request;
+        request.reserve(path.length() + strlen(host) + 80 + sizeof(requestEtag) + sizeof(requestLastModified) + 72);
+        request += "GET ";
+        request += path;
+        request += " HTTP/1.1\r\nHost: ";
+        request += host;
+        request += "\r\nUser-Agent: ESP-Weather\r\nConnection: keep-alive\r\n";
+        if (requestEtag[0]) {
+            request += "If-None-Match: ";
+            request += requestEtag;
+            request += "\r\n";
+        }
+        if (requestLastModified[0]) {
+            request += "If-Modified-Since: ";
+            request += requestLastModified;
+            request += "\r\n";
+        }
+        if (rangeStart >= 0) {
+            request += "Range: bytes=";
+            request += rangeStart;
+            request += "-\r\n";
+        }
+        request += "\r\n";
+
+        if (client.write((const uint8_t*)request.c_str(), request.length()) != request.length()) {
+            if (reconnectStale()) {
+                return true;
+            }
+            fail("could not send request");
+            return false;
+        }
+        currentState = READING_HEADERS;
+        return true;
+    }
+
+    static bool stepReadHeaders() {
+        if (!client.available()) {
+            if (!client.connected() && !reconnectStale()) {
+                fail("connection closed before headers");
+            }
+            return false;
+        }
+
+        // Header lines are short, so read them byte by byte
+        while (client.available()) {
+            char c = client.read();
+            if (c == '\r') {
+                continue;
+            }
+            if (c != '\n') {
+                // Overlong lines are truncated; we only look at the start of each
+                if (headerLineLen < sizeof(headerLine) - 1) {
+                    headerLine[headerLineLen++] = c;
+                }
+                continue;
+            }
+
+            // Blank line ends the header block
+            if (headerLineLen == 0 && statusLineParsed) {
+                if (httpStatus == 204 || httpStatus == 304) {
+                    // These never have a body
+                    finishResponse(true);
+                    return false;
+                }
+                chunkPhase = CHUNK_SIZE;
+                chunkLineLen = 0;
+                currentState = READING_BODY;
+                return true;
+            }
+            if (!handleHeaderLine()) {
+                fail("malformed status line");
+                return false;
+            }
+            headerLineLen = 0;
+        }
+        return true;
+    }
+
+    static void deliverBody(const char* data, size_t len) {
+        bodyReceived += len;
+        if (bodyHandler) {
+            bodyHandler(data, len, bodyContext);
+        }
+    }
+
+    // Chunk size lines, the CRLF after each chunk and the trailer, byte by byte
+    static bool stepChunkFraming() {
+        while (client.available()) {
+            char c = client.read();
+            if (c == '\r') {
+                continue;
+            }
+            if (c != '\n') {
+                if (chunkLineLen < sizeof(chunkLine) - 1) {
+                    chunkLine[chunkLineLen++] = c;
+                }
+                continue;
+            }
+
+            chunkLine[chunkLineLen] = '\0';
+            bool blank = chunkLineLen == 0;
+            chunkLineLen = 0;
+            if (chunkPhase == CHUNK_DATA_END) {
+                chunkPhase = CHUNK_SIZE;
+            } else if (chunkPhase == CHUNK_SIZE) {
+                // Hex size, possibly followed by ";extensions"
+                chunkLeft = strtol(chunkLine, nullptr, 16);
+                chunkPhase = chunkLeft > 0 ? CHUNK_DATA : CHUNK_TRAILER;
+                if (chunkPhase == CHUNK_DATA) {
+                    return true;
+                }
+            } else if (blank) {
+                finishResponse(true);
+                return false;
+            }
+        }
+        if (!client.connected()) {
+            fail("connection closed inside a chunked body");
+        }
+        return false;
+    }
+
+    static bool stepReadBody() {
+        if (!chunked && contentLength >= 0 && bodyReceived >= contentLength) {
+            finishResponse(true);
+            return false;
+        }
+        if (chunked && chunkPhase != CHUNK_DATA) {
+            return stepChunkFraming();
+        }
+
+        int available = client.available();
+        if (available <= 0) {
+            if (client.connected()) {
+                return false;
+            }
+            // Without a length or chunks the body ends when the server closes
+            if (chunked || contentLength >= 0) {
+                fail("connection closed before the body was complete");
+            } else {
+                finishResponse(false);
+            }
+            return false;
+        }
+
+        size_t wanted = min(available, (int)HTTP_BODY_CHUNK_SIZE);
+        if (chunked) {
+            wanted = min(wanted, (size_t)chunkLeft);
+        } else if (contentLength >= 0) {
+            wanted = min(wanted, (size_t)(contentLength - bodyReceived));
+        }
+        char chunk[HTTP_BODY_CHUNK_SIZE];
+        int len = client.read((uint8_t*)chunk, wanted);
+        if (len <= 0) {
+            return false;
+        }
+        deliverBody(chunk, len);
+        if (chunked) {
+            chunkLeft -= len;
+            if (chunkLeft == 0) {
+                chunkPhase = CHUNK_DATA_END;
+            }
+        }
+        return true;
+    }
+
+    State service(unsigned long sliceMs) {
+        if (currentState == IDLE || currentState == DONE || currentState == FAILED) {
+            return currentState;
+        }
+
+        unsigned long sliceStart = millis();
+        bool progress = true;
+
+        while (progress && millis() - sliceStart < sliceMs) {
+            if (millis() - requestStart >= timeoutMs) {
+                fail("timed out");
+                break;
+            }
+
+            switch (currentState) {
+                case RESOLVING: progress = stepResolve(); break;
+                case CONNECTING: progress = stepConnect(); break;
+                case SENDING: progress = stepSend(); break;
+                case READING_HEADERS: progress = stepReadHeaders(); break;
+                case READING_BODY: progress = stepReadBody(); break;
+                default: progress = false; break;
+            }
+        }
+
+        unsigned long sliceTime = millis() - sliceStart;
+        if (sliceTime > longestSlice) {
+            longestSlice = sliceTime;
+        }
+        return currentState;
+    }
+
+    State state() {
+        return currentState;
+    }
+
+    int statusCode() {
+        return httpStatus;
+    }
+
+    const char* stateName(State s) {
+        switch (s) {
+            case IDLE: return "IDLE";
+            case RESOLVING: return "RESOLVING";
+            case CONNECTING: return "CONNECTING";
+            case SENDING: return "SENDING";
+            case READING_HEADERS: return "READING_HEADERS";
+            case READING_BODY: return "READING_BODY";
+            case DONE: return "DONE";
+            case FAILED: return "FAILED";
+            default: return "UNKNOWN";
+        }
+    }
+
+    const char* etag() {
+        return responseEtag;
+    }
+
+    const char* lastModified() {
+        return responseLastModified;
+    }
+
+    long maxAgeSeconds() {
+        return responseMaxAge;
+    }
+
+    long bodyBytes() {
+        return bodyReceived;
+    }
+
+    unsigned long maxSliceMs() {
+        return longestSlice;
+    }
+
+    unsigned long lastDurationMs() {
+        return lastDuration;
+    }
+
+    uint32_t connectionCount() {
+        return connectionsOpened;
+    }
+
+    uint32_t reusedCount() {
+        return requestsReused;
+    }
+}
@@ -0,0 +1,75 @@
+/*
+ * Non-blocking HTTP client for ESP-01 Weather Display
+ * Runs a GET request as a small state machine that loop() advances in time slices.
+ * Requests are HTTP/1.1; the connection is kept open between requests to the
+ * same server, so a run of requests pays for DNS and the handshake once.
+ */
+
+#ifndef HTTP_FETCH_H
+#define HTTP_FETCH_H
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <WiFiClient.h>
+
+namespace HttpFetch {
+    // Request states, in the order a successful request walks through them
+    enum State {
+        IDLE,
+        RESOLVING,
+        CONNECTING,
+        SENDING,
+        READING_HEADERS,
+        READING_BODY,
+        DONE,
+        FAILED
+    };
+
+    // Called with each chunk of the response body as it arrives
+    typedef void (*BodyHandler)(const char* data, size_t len, void* context);
+
+    // Start a GET request; returns false if another request is still running.
+    // Non-empty validators are sent as If-None-Match / If-Modified-Since.
+    bool begin(const char* host, uint16_t port, const String& path, BodyHandler onBody, void* context,
+               const char* ifNoneMatch = nullptr, const char* ifModifiedSince = nullptr);
+
+    // Ask for the body from byte offset on (Range request); call right after begin()
+    void setRangeStart(long offset);
+
+    // Limit for the running request, instead of the default that suits small
+    // responses; call right after begin()
+    void setTimeout(unsigned long ms);
+
+    // Advance the running request, spending at most sliceMs milliseconds
+    State service(unsigned long sliceMs);
+
+    // Abort any running request and return to IDLE. A connection left open
+    // by a finished request stays open for the next begin() to the same server.
+    void reset();
+
+    // reset() and close the kept-alive connection, once no more requests follow
+    void close();
+
+    // Request status
+    State state();
+    int statusCode();
+    const char* stateName(State s);
+
+    // Cache validators of the last response ("" when the server sent none)
+    const char* etag();
+    const char* lastModified();
+    long maxAgeSeconds(); // Cache-Control max-age, -1 if absent, 0 for no-cache/no-store
+
+    // Body bytes received for the last request
+    long bodyBytes();
+
+    // Timing statistics (milliseconds)
+    unsigned long maxSliceMs();    // Longest single service() call
+    unsigned long lastDurationMs(); // Wall time of the last finished request
+
+    // Connection statistics since boot
+    uint32_t connectionCount();    // TCP connections opened
+    uint32_t reusedCount();        // Requests sent on a kept-alive connection
+}
+
+#endif // HTTP_FETCH_H
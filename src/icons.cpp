@@ -0,0 +1,68 @@
+/*
+ * Weather icon atlas, expanded from the 8x8 artwork at compile time
+ */
+
+#include "icons.h"
+
+namespace {
+  // 8x8 source artwork, one byte per row, bit 0 = leftmost pixel.
+  // Only read by the constexpr expander below, so it never takes up RAM.
+  constexpr uint8_t ICON_SOURCE[WEATHER_ICON_COUNT][8] = {
+    { 0x10, 0x54, 0x38, 0xFE, 0x38, 0x54, 0x10, 0x00 }, // Sunny
+    { 0x08, 0x54, 0x38, 0x44, 0x3E, 0x00, 0x00, 0x00 }, // Partly cloudy
+    { 0x00, 0x00, 0x78, 0x84, 0xFE, 0x00, 0x00, 0x00 }, // Cloudy
+    { 0x00, 0xEE, 0x00, 0xFE, 0x00, 0x7C, 0x00, 0x00 }, // Foggy
+    { 0x78, 0xFC, 0x00, 0x28, 0x28, 0x00, 0x00, 0x00 }, // Rainy
+    { 0x78, 0xFC, 0x00, 0x10, 0x38, 0x10, 0x00, 0x00 }  // Snowy
+  };
+
+  // Compile-time list 0, 1, ..., N-1 (std::make_index_sequence is C++14)
+  template<int... I> struct IndexList {};
+  template<int N, int... I> struct MakeIndexList : MakeIndexList<N - 1, N - 1, I...> {};
+  template<int... I> struct MakeIndexList<0, I...> { typedef IndexList<I...> type; };
+
+  // Bit k of output byte `column` of a source row scaled up by `scale`
+  constexpr uint8_t scaledBit(uint8_t row, int scale, int column, int k) {
+    return ((row >> ((column * 8 + k) / scale)) & 1) << k;
+  }
+
+  constexpr uint8_t scaledByte(uint8_t row, int scale, int column) {
+    return scaledBit(row, scale, column, 0) | scaledBit(row, scale, column, 1) |
+           scaledBit(row, scale, column, 2) | scaledBit(row, scale, column, 3) |
+           scaledBit(row, scale, column, 4) | scaledBit(row, scale, column, 5) |
+           scaledBit(row, scale, column, 6) | scaledBit(row, scale, column, 7);
+  }
+
+  // Byte n of an icon scaled up by `scale`; each output row is `scale` bytes wide
+  constexpr uint8_t scaledIconByte(int icon, int scale, int n) {
+    return scaledByte(ICON_SOURCE[icon][n / scale / scale], scale, n % scale);
+  }
+
+  template<int Size, int... I>
+  constexpr IconBitmap<Size> expandIcon(int icon, IndexList<I...>) {
+    return IconBitmap<Size>{{ scaledIconByte(icon, Size / 8, I)... }};
+  }
+
+  // Nearest-neighbour upscale of a source icon to Size x Size pixels
+  template<int Size>
+  constexpr IconBitmap<Size> expandIcon(int icon) {
+    return expandIcon<Size>(icon, typename MakeIndexList<Size * Size / 8>::type());
+  }
+}
+
+// Hand-drawn artwork for a size can replace an expandIcon() entry with a
+// plain {{ ... }} bitmap of the same dimensions
+const IconBitmap<8> weatherIcons8[WEATHER_ICON_COUNT] PROGMEM = {
+  expandIcon<8>(0), expandIcon<8>(1), expandIcon<8>(2),
+  expandIcon<8>(3), expandIcon<8>(4), expandIcon<8>(5)
+};
+
+const IconBitmap<16> weatherIcons16[WEATHER_ICON_COUNT] PROGMEM = {
+  expandIcon<16>(0), expandIcon<16>(1), expandIcon<16>(2),
+  expandIcon<16>(3), expandIcon<16>(4), expandIcon<16>(5)
+};
+
+const IconBitmap<32> weatherIcons32[WEATHER_ICON_COUNT] PROGMEM = {
+  expandIcon<32>(0), expandIcon<32>(1), expandIcon<32>(2),
+  expandIcon<32>(3), expandIcon<32>(4), expandIcon<32>(5)
+};
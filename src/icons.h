@@ -0,0 +1,25 @@
+/*
+ * Weather icon atlas for ESP-01 Weather Display
+ * Every icon is stored in PROGMEM at each size the screens use, so drawing
+ * one is a single drawXBMP() call instead of scaling pixels at runtime
+ */
+
+#ifndef ICONS_H
+#define ICONS_H
+
+#include <Arduino.h>
+
+// Icon types: 0=sunny, 1=partly cloudy, 2=cloudy, 3=foggy, 4=rainy, 5=snowy
+#define WEATHER_ICON_COUNT 6
+
+// Square XBM bitmap: rows top to bottom, Size / 8 bytes per row, bit 0 = leftmost pixel
+template<int Size>
+struct IconBitmap {
+  uint8_t bits[Size * Size / 8];
+};
+
+extern const IconBitmap<8> weatherIcons8[WEATHER_ICON_COUNT];   // Source artwork
+extern const IconBitmap<16> weatherIcons16[WEATHER_ICON_COUNT]; // Forecast screen
+extern const IconBitmap<32> weatherIcons32[WEATHER_ICON_COUNT]; // Current weather screen
+
+#endif // ICONS_H
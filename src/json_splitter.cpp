@@ -0,0 +1,176 @@
+/*
+ * Implementation of the incremental JSON splitter
+ */
+
+#include "json_splitter.h"
+
+void JsonSplitter::begin(uint8_t unitDepth, char* buffer, size_t capacity, UnitHandler onUnit, void* context) {
+  targetDepth = unitDepth;
+  buf = buffer;
+  cap = capacity;
+  len = 0;
+  handler = onUnit;
+  handlerContext = context;
+
+  depth = 0;
+  arrayMask = 0;
+  inString = false;
+  escaped = false;
+  capturing = false;
+  wrapped = false;
+  overflow = false;
+
+  expectKey = false;
+  readingKey = false;
+  topKey[0] = '\0';
+  topKeyLen = 0;
+
+  droppedUnits = 0;
+  elementIndex = 0;
+}
+
+bool JsonSplitter::containerIsArray(uint8_t level) const {
+  return level < 32 && (arrayMask & (1UL << level));
+}
+
+void JsonSplitter::append(char c) {
+  // Keep room for the closing brace of a wrapped member and the terminator
+  if (len + 2 >= cap) {
+    overflow = true;
+    return;
+  }
+  buf[len++] = c;
+}
+
+void JsonSplitter::startUnit() {
+  capturing = true;
+  overflow = false;
+  len = 0;
+
+  // Object members ("key":value) are wrapped so they parse as a document
+  wrapped = depth > 0 && !containerIsArray(depth);
+  if (wrapped) {
+    append('{');
+  }
+}
+
+void JsonSplitter::emitUnit() {
+  capturing = false;
+
+  if (overflow) {
+    droppedUnits++;
+    return;
+  }
+
+  if (wrapped) {
+    buf[len++] = '}';
+  }
+  buf[len] = '\0';
+
+  if (handler) {
+    handler(targetDepth == 0 ? "" : topKey, buf, len, handlerContext);
+  }
+}
+
+void JsonSplitter::feed(const char* data, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    char c = data[i];
+
+    // Inside a string only quotes and escapes matter
+    if (inString) {
+      if (capturing) {
+        append(c);
+      }
+      if (escaped) {
+        escaped = false;
+      } else if (c == '\\') {
+        escaped = true;
+      } else if (c == '"') {
+        inString = false;
+        readingKey = false;
+        topKey[topKeyLen] = '\0';
+        continue;
+      }
+      if (readingKey && topKeyLen < sizeof(topKey) - 1) {
+        topKey[topKeyLen++] = c;
+      }
+      continue;
+    }
+
+    // Whitespace between tokens carries no information
+    if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+      continue;
+    }
+
+    bool closesContainer = (c == '}' || c == ']');
+
+    if (depth == targetDepth) {
+      if (capturing && (c == ',' || closesContainer)) {
+        // A scalar value ends at the separator or the parent's closing bracket
+        emitUnit();
+      } else if (!capturing && c != ',' && !closesContainer) {
+        startUnit();
+      }
+    }
+
+    if (capturing) {
+      append(c);
+    }
+
+    switch (c) {
+      case '"':
+        inString = true;
+        if (depth == 1 && expectKey) {
+          readingKey = true;
+          topKeyLen = 0;
+        }
+        break;
+      case ':':
+        if (depth == 1) {
+          expectKey = false;
+        }
+        break;
+      case ',':
+        if (depth == 1) {
+          expectKey = !containerIsArray(1);
+        }
+        if (depth + 1 == targetDepth) {
+          elementIndex++;
+        }
+        break;
+      case '{':
+      case '[':
+        if (depth < JSON_SPLITTER_MAX_DEPTH) {
+          depth++;
+          if (c == '[') {
+            arrayMask |= (1UL << depth);
+          } else {
+            arrayMask &= ~(1UL << depth);
+          }
+        }
+        if (depth == 1) {
+          expectKey = (c == '{');
+        }
+        if (depth + 1 == targetDepth) {
+          elementIndex = 0;
+        }
+        break;
+      case '}':
+      case ']':
+        if (depth > 0) {
+          depth--;
+        }
+        // A container value ends with its own closing bracket
+        if (capturing && depth == targetDepth) {
+          emitUnit();
+        }
+        break;
+    }
+  }
+}
+
+void JsonSplitter::finish() {
+  if (capturing) {
+    emitUnit();
+  }
+}
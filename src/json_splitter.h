@@ -0,0 +1,66 @@
+/*
+ * Incremental JSON splitter for ESP-01 Weather Display
+ * Cuts a streamed JSON document into small self-contained pieces so each one
+ * can be parsed on its own from a fixed buffer, without holding the whole response
+ */
+
+#ifndef JSON_SPLITTER_H
+#define JSON_SPLITTER_H
+
+#include <Arduino.h>
+
+// Deepest nesting the splitter keeps track of
+#define JSON_SPLITTER_MAX_DEPTH 16
+
+struct JsonSplitter {
+  // Called for every complete unit. topKey is the root member the unit sits
+  // under ("" for the root itself). Object members are wrapped in braces, so
+  // json always holds a complete document.
+  typedef void (*UnitHandler)(const char* topKey, const char* json, size_t len, void* context);
+
+  // Emit every value found at unitDepth: 0 = the whole document,
+  // 1 = each member of the root object, 2 = each element one level below, etc.
+  void begin(uint8_t unitDepth, char* buffer, size_t capacity, UnitHandler onUnit, void* context);
+
+  // Feed the next chunk of the stream
+  void feed(const char* data, size_t len);
+
+  // Flush a unit still pending at the end of the stream
+  void finish();
+
+  // Units that did not fit in the buffer and were dropped
+  uint16_t droppedUnits;
+
+  // Position of the current unit's container within its own parent, e.g. which
+  // array element the members at unitDepth belong to
+  uint16_t elementIndex;
+
+private:
+  void append(char c);
+  void startUnit();
+  void emitUnit();
+  bool containerIsArray(uint8_t level) const;
+
+  uint8_t targetDepth;
+  char* buf;
+  size_t cap;
+  size_t len;
+  UnitHandler handler;
+  void* handlerContext;
+
+  uint8_t depth;
+  uint32_t arrayMask; // Bit n set when the container at depth n is an array
+  bool inString;
+  bool escaped;
+  bool capturing;
+  bool wrapped;
+  bool overflow;
+
+  // Key of the root member currently being walked
+  bool expectKey;
+  bool readingKey;
+  char topKey[24];
+  uint8_t topKeyLen;
+};
+
+#endif // JSON_SPLITTER_H
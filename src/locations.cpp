@@ -0,0 +1,252 @@
+/*
+ * Implementation of the weather locations
+ */
+
+#include "locations.h"
+#include "logging.h"
+#include <coredecls.h> // crc32()
+#include <EEPROM.h>
+#include <utility>
+
+// Bump when the record layout changes; older records are then ignored
+#define LOCATIONS_VERSION 2
+
+#define LOCATION_CITY_SIZE 50 // As in the settings record
+#define LOCATION_STATE_SIZE 3
+
+namespace Locations {
+    // Fixed-size record written as-is to EEPROM; location 0 is not in it
+    struct Record {
+        uint8_t version;
+        uint8_t count;          // Extra locations stored
+        char city[LOCATIONS_MAX - 1][LOCATION_CITY_SIZE];
+        char state[LOCATIONS_MAX - 1][LOCATION_STATE_SIZE];
+        uint8_t coordinatesKnown[LOCATIONS_MAX - 1];
+        float latitude[LOCATIONS_MAX - 1];
+        float longitude[LOCATIONS_MAX - 1];
+        uint32_t crc;           // Core crc32() of everything above
+    };
+
+    // Version 1 record, without coordinates
+    struct RecordV1 {
+        uint8_t version;
+        uint8_t count;
+        char city[LOCATIONS_MAX - 1][LOCATION_CITY_SIZE];
+        char state[LOCATIONS_MAX - 1][LOCATION_STATE_SIZE];
+        uint32_t crc;
+    };
+
+    static_assert(LOCATIONS_OFFSET + sizeof(Record) <= EEPROM_SIZE, "locations record does not fit in EEPROM");
+
+    // An extra location and its copy of the weather globals
+    struct Entry {
+        String city;
+        String state;
+        float latitude;
+        float longitude;
+        bool coordinatesKnown;
+        int currentTemp;
+        int lowTemp;
+        int highTemp;
+        char condition[16];
+        int humidity;
+        bool stale;
+        WeatherDay forecast[5];
+        bool fetched;
+    };
+
+    static Entry entries[LOCATIONS_MAX]; // Entry 0 is unused, location 0 lives in the globals
+    static uint8_t locationCount = 1;
+    static Record stored;
+    static uint8_t swappedIn = 0;        // Location whose copy is in the globals, 0 for none
+
+    static uint32_t recordCrc(const Record& record) {
+        return crc32(&record, offsetof(Record, crc));
+    }
+
+    // Forget the coordinates and weather of a slot whose location changed
+    static void resetWeather(Entry& entry) {
+        entry.latitude = 0;
+        entry.longitude = 0;
+        entry.coordinatesKnown = false;
+        entry.currentTemp = 0;
+        entry.lowTemp = 0;
+        entry.highTemp = 0;
+        strcpy(entry.condition, "Unknown");
+        entry.humidity = 0;
+        entry.stale = false;
+        for (int i = 0; i < 5; i++) {
+            strcpy(entry.forecast[i].day, "???");
+            entry.forecast[i].temp = -999;
+            entry.forecast[i].lowTemp = -999;
+            entry.forecast[i].iconType = 0;
+        }
+        entry.fetched = false;
+    }
+
+    // Build the record from the table. The location swapped in, if any, is
+    // taken from the globals, so a save() inside a Scope stores the same.
+    static void capture(Record& record) {
+        memset(&record, 0, sizeof(record));
+        record.version = LOCATIONS_VERSION;
+        record.count = locationCount - 1;
+        for (uint8_t i = 1; i < locationCount; i++) {
+            bool inGlobals = i == swappedIn;
+            const String& city = inGlobals ? cityName : entries[i].city;
+            const String& state = inGlobals ? stateName : entries[i].state;
+            strncpy(record.city[i - 1], city.c_str(), LOCATION_CITY_SIZE - 1);
+            strncpy(record.state[i - 1], state.c_str(), LOCATION_STATE_SIZE - 1);
+            if (inGlobals ? cityCoordinatesKnown : entries[i].coordinatesKnown) {
+                record.coordinatesKnown[i - 1] = 1;
+                record.latitude[i - 1] = inGlobals ? cityLatitude : entries[i].latitude;
+                record.longitude[i - 1] = inGlobals ? cityLongitude : entries[i].longitude;
+            }
+        }
+        record.crc = recordCrc(record);
+    }
+
+    void begin() {
+        for (uint8_t i = 1; i < LOCATIONS_MAX; i++) {
+            resetWeather(entries[i]);
+        }
+
+        Record record;
+        RecordV1 old;
+        EEPROM.begin(EEPROM_SIZE);
+        EEPROM.get(LOCATIONS_OFFSET, record);
+        EEPROM.get(LOCATIONS_OFFSET, old);
+        EEPROM.end();
+
+        bool valid = record.version == LOCATIONS_VERSION && record.crc == recordCrc(record);
+        if (!valid && old.version == 1 && old.crc == crc32(&old, offsetof(RecordV1, crc))) {
+            // Same cities; their coordinates are looked up by the next update
+            LOG_INFO("Locations", "Migrating version 1 locations record");
+            memset(&record, 0, sizeof(record));
+            record.count = old.count;
+            memcpy(record.city, old.city, sizeof(record.city));
+            memcpy(record.state, old.state, sizeof(record.state));
+            valid = true;
+        }
+        if (!valid || record.count >= LOCATIONS_MAX) {
+            LOG_INFO("Locations", "No extra locations stored");
+            capture(stored);
+            return;
+        }
+
+        clear();
+        for (uint8_t i = 0; i < record.count; i++) {
+            record.city[i][LOCATION_CITY_SIZE - 1] = '\0';
+            record.state[i][LOCATION_STATE_SIZE - 1] = '\0';
+            if (add(record.city[i], record.state[i]) && record.coordinatesKnown[i] == 1) {
+                Entry& entry = entries[locationCount - 1];
+                entry.latitude = record.latitude[i];
+                entry.longitude = record.longitude[i];
+                entry.coordinatesKnown = true;
+            }
+        }
+        // A migrated record differs from this, so the next save() writes it
+        if (record.version == LOCATIONS_VERSION) {
+            capture(stored);
+        } else {
+            memset(&stored, 0, sizeof(stored));
+        }
+        LOG_INFO("Locations", "%u locations", locationCount);
+    }
+
+    uint8_t count() {
+        return locationCount;
+    }
+
+    const String& city(uint8_t index) {
+        return index == 0 || index >= locationCount ? cityName : entries[index].city;
+    }
+
+    const String& state(uint8_t index) {
+        return index == 0 || index >= locationCount ? stateName : entries[index].state;
+    }
+
+    void clear() {
+        locationCount = 1;
+    }
+
+    bool add(const String& city, const String& state) {
+        if (locationCount >= LOCATIONS_MAX) {
+            return false;
+        }
+
+        String cleanCity = city;
+        String cleanState = state;
+        cleanCity.trim();
+        cleanState.trim();
+        cleanState.toUpperCase();
+
+        // Same rule as for the settings city: something alphanumeric, not "_"
+        bool usable = false;
+        for (size_t i = 0; i < cleanCity.length() && !usable; i++) {
+            usable = isAlphaNumeric(cleanCity[i]);
+        }
+        if (!usable || cleanCity.length() >= LOCATION_CITY_SIZE ||
+            (cleanState.length() != 0 && cleanState.length() != 2)) {
+            return false;
+        }
+
+        Entry& entry = entries[locationCount++];
+        if (entry.city != cleanCity || entry.state != cleanState) {
+            resetWeather(entry);
+            entry.city = cleanCity;
+            entry.state = cleanState;
+        }
+        return true;
+    }
+
+    bool save() {
+        Record record;
+        capture(record);
+        if (memcmp(&record, &stored, sizeof(Record)) == 0) {
+            return true;
+        }
+
+        EEPROM.begin(EEPROM_SIZE);
+        EEPROM.put(LOCATIONS_OFFSET, record);
+        bool ok = EEPROM.commit();
+        EEPROM.end();
+
+        if (!ok) {
+            LOG_ERROR("Locations", "EEPROM commit failed");
+            return false;
+        }
+        stored = record;
+        LOG_INFO("Locations", "Locations saved");
+        return true;
+    }
+
+    bool hasWeather(uint8_t index) {
+        return index == 0 || (index < locationCount && entries[index].fetched);
+    }
+
+    void markFetched(uint8_t index) {
+        if (index > 0 && index < locationCount) {
+            entries[index].fetched = true;
+        }
+    }
+
+    void swap(uint8_t index) {
+        if (index == 0 || index >= locationCount) {
+            return;
+        }
+        swappedIn = swappedIn == index ? 0 : index;
+        Entry& entry = entries[index];
+        std::swap(entry.city, cityName);
+        std::swap(entry.state, stateName);
+        std::swap(entry.latitude, cityLatitude);
+        std::swap(entry.longitude, cityLongitude);
+        std::swap(entry.coordinatesKnown, cityCoordinatesKnown);
+        std::swap(entry.currentTemp, currentTemp);
+        std::swap(entry.lowTemp, lowTemp);
+        std::swap(entry.highTemp, highTemp);
+        std::swap(entry.condition, currentCondition);
+        std::swap(entry.humidity, humidity);
+        std::swap(entry.stale, weatherDataStale);
+        std::swap(entry.forecast, forecast);
+    }
+}
@@ -0,0 +1,65 @@
+/*
+ * Weather locations for ESP-01 Weather Display
+ * Location 0 is the city and state of the settings record; up to
+ * LOCATIONS_MAX - 1 more are kept in a record of their own. Every location
+ * has its own copy of the weather globals. The fetch and draw code only know
+ * the globals, so they work on another location by swapping its copy in for
+ * the length of a call, with a Locations::Scope.
+ */
+
+#ifndef LOCATIONS_H
+#define LOCATIONS_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Locations fetched and rotated on the display, the settings location included
+#define LOCATIONS_MAX 3
+
+namespace Locations {
+    // Read the stored extra locations. Call once at boot, before the settings
+    // page can be served.
+    void begin();
+
+    // Configured locations, at least 1
+    uint8_t count();
+
+    // City and state of a location; not valid while that location is swapped in
+    const String& city(uint8_t index);
+    const String& state(uint8_t index);
+
+    // Rebuild the extra locations: clear(), then add() each one in order.
+    // add() returns false if the table is full or the city is not usable.
+    // Weather already fetched for an unchanged slot is kept.
+    void clear();
+    bool add(const String& city, const String& state);
+
+    // Store the extra locations and their coordinates; flash is only written
+    // if they changed.
+    // Returns false if the commit failed.
+    bool save();
+
+    // True once a location has weather to show; location 0 always has
+    bool hasWeather(uint8_t index);
+
+    // Record that the weather swapped in for a location is its own now
+    void markFetched(uint8_t index);
+
+    // Exchange a location's weather, city, state and coordinates with the globals.
+    // Calling it again swaps back; location 0 is the globals themselves.
+    void swap(uint8_t index);
+
+    // Swaps a location in for as long as it lives
+    class Scope {
+    public:
+        explicit Scope(uint8_t index) : index(index) { swap(index); }
+        ~Scope() { swap(index); }
+
+    private:
+        Scope(const Scope&);
+        Scope& operator=(const Scope&);
+        uint8_t index;
+    };
+}
+
+#endif // LOCATIONS_H
@@ -0,0 +1,105 @@
+/*
+ * Implementation of the ring-buffered log
+ */
+
+#include "logging.h"
+#include <stdarg.h>
+
+namespace Log {
+    static char ring[LOG_BUFFER_SIZE];
+
+    // Positions count every byte ever written, so they only grow; the ring
+    // index is the position modulo the buffer size
+    static uint32_t head = 0;       // Next byte to write
+    static uint32_t uartPos = 0;    // Next byte for the UART
+    static uint32_t dropped = 0;
+
+    static const char LEVEL_LETTERS[] = "-EWID";
+
+    static void append(const char* data, size_t length) {
+        for (size_t i = 0; i < length; i++) {
+            ring[(head + i) % LOG_BUFFER_SIZE] = data[i];
+        }
+        head += length;
+
+        // The UART fell a whole buffer behind; what it missed is gone
+        if (head - uartPos > LOG_BUFFER_SIZE) {
+            dropped += head - LOG_BUFFER_SIZE - uartPos;
+            uartPos = head - LOG_BUFFER_SIZE;
+        }
+    }
+
+    void write(uint8_t level, PGM_P format, ...) {
+        char line[LOG_LINE_MAX + 1];
+        unsigned long now = millis();
+        int length = snprintf(line, sizeof(line), "%5lu.%03lu %c ", now / 1000, now % 1000,
+                              LEVEL_LETTERS[level < sizeof(LEVEL_LETTERS) - 1 ? level : 0]);
+
+        va_list args;
+        va_start(args, format);
+        int message = vsnprintf_P(line + length, sizeof(line) - length, format, args);
+        va_end(args);
+        if (message > 0) {
+            length = min(length + message, (int)sizeof(line) - 1);
+        }
+
+        // Messages end with one newline whether or not the format had it
+        if (length > 0 && line[length - 1] == '\n') {
+            length--;
+        }
+        append(line, length);
+        append("\n", 1);
+        service();
+    }
+
+    void service() {
+        while (uartPos != head) {
+            int room = Serial.availableForWrite();
+            if (room <= 0) {
+                return;
+            }
+            // Up to the end of the ring or of the pending bytes, whichever is first
+            size_t index = uartPos % LOG_BUFFER_SIZE;
+            size_t length = min((size_t)(head - uartPos), (size_t)(LOG_BUFFER_SIZE - index));
+            length = min(length, (size_t)room);
+            Serial.write((const uint8_t*)ring + index, length);
+            uartPos += length;
+        }
+    }
+
+    void flush() {
+        while (uartPos != head) {
+            service();
+            yield();
+        }
+        Serial.flush();
+    }
+
+    void read(Reader out, void* context) {
+        uint32_t end = head;
+        uint32_t position = end > LOG_BUFFER_SIZE ? end - LOG_BUFFER_SIZE : 0;
+        if (position > 0) {
+            // The oldest line was partly overwritten; start at the next one
+            while (position != end && ring[position % LOG_BUFFER_SIZE] != '\n') {
+                position++;
+            }
+            if (position != end) {
+                position++;
+            }
+        }
+        while (position != end) {
+            size_t index = position % LOG_BUFFER_SIZE;
+            size_t length = min((size_t)(end - position), (size_t)(LOG_BUFFER_SIZE - index));
+            out(ring + index, length, context);
+            position += length;
+        }
+    }
+
+    uint32_t bytesLogged() {
+        return head;
+    }
+
+    uint32_t bytesDropped() {
+        return dropped;
+    }
+}
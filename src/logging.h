@@ -0,0 +1,88 @@
+/*
+ * Logging for ESP-01 Weather Display
+ * LOG_ERROR() .. LOG_DEBUG() format into a fixed RAM ring buffer that is
+ * drained to the UART only as fast as its FIFO takes bytes, so a message
+ * never blocks or allocates. Levels above LOG_LEVEL compile to nothing.
+ * The buffer can be read over HTTP at /log.
+ */
+
+#ifndef LOGGING_H
+#define LOGGING_H
+
+#include <Arduino.h>
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+// Release builds (-DNDEBUG) leave out debug messages; -DLOG_LEVEL=... overrides
+#ifndef LOG_LEVEL
+#ifdef NDEBUG
+#define LOG_LEVEL LOG_LEVEL_INFO
+#else
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#endif
+#endif
+
+// Size of the ring buffer, the most of recent log /log can show
+#define LOG_BUFFER_SIZE 2048
+
+// Longest message; longer ones are cut
+#define LOG_LINE_MAX 160
+
+// tag and format must be string literals; the format stays in flash
+#define LOG_AT(level, tag, format, ...) Log::write(level, PSTR("[" tag "] " format), ##__VA_ARGS__)
+
+// A disabled level: still type-checked, but dead code the compiler drops
+#define LOG_NOTHING(level, tag, format, ...) do { if (0) LOG_AT(level, tag, format, ##__VA_ARGS__); } while (0)
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(tag, format, ...) LOG_AT(LOG_LEVEL_ERROR, tag, format, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(tag, format, ...) LOG_NOTHING(LOG_LEVEL_ERROR, tag, format, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(tag, format, ...) LOG_AT(LOG_LEVEL_WARN, tag, format, ##__VA_ARGS__)
+#else
+#define LOG_WARN(tag, format, ...) LOG_NOTHING(LOG_LEVEL_WARN, tag, format, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(tag, format, ...) LOG_AT(LOG_LEVEL_INFO, tag, format, ##__VA_ARGS__)
+#else
+#define LOG_INFO(tag, format, ...) LOG_NOTHING(LOG_LEVEL_INFO, tag, format, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(tag, format, ...) LOG_AT(LOG_LEVEL_DEBUG, tag, format, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(tag, format, ...) LOG_NOTHING(LOG_LEVEL_DEBUG, tag, format, ##__VA_ARGS__)
+#endif
+
+namespace Log {
+    // Append one message, formatted with a PROGMEM printf format; use the
+    // LOG_* macros rather than calling this
+    void write(uint8_t level, PGM_P format, ...) __attribute__((format(printf, 2, 3)));
+
+    // Move buffered bytes to the UART as far as its FIFO has room. Call from
+    // the loop, often.
+    void service();
+
+    // Wait until the UART took everything buffered. Blocks; only for boot
+    // diagnostics such as the benchmarks.
+    void flush();
+
+    // Buffered text, oldest first, for /log. Calls out with each contiguous
+    // piece of the ring.
+    typedef void (*Reader)(const char* data, size_t length, void* context);
+    void read(Reader out, void* context);
+
+    // Statistics since boot
+    uint32_t bytesLogged();
+    uint32_t bytesDropped();        // Overwritten before the UART took them
+}
+
+#endif // LOGGING_H
@@ -7,7 +7,6 @@
 #include <Arduino.h>
 #include <U8g2lib.h>
 #include <ESP8266WiFi.h>
-#include <EEPROM.h>
 #include <DNSServer.h>
 #include <ESP8266WebServer.h>
 #include "config.h"  // Include the main configuration that has all necessary declarations
@@ -15,353 +14,310 @@
 #include "wifi_manager.h" // Include WiFi manager functions
 #include "time_manager.h"
 #include "display.h"
+#include "weather_snapshot.h"
+#include "scheduler.h"
+#include "wifi_connection.h"
+#include "wifi_scan.h"
+#include "settings.h"
+#include "time_zone.h"
+#include "hourly_forecast.h"
+#include "power.h"
+#include "metrics.h"
+#include "logging.h"
+#include "benchmark.h"
+#include "ota.h"
+#include "locations.h"
+#include "solar.h"
 
-// Define EEPROM test offset (not used in main program)
-#define TEST_OFFSET 0
+// Display state
+static byte currentScreen = SCREEN_TIME;
+static uint8_t currentLocation = 0; // Whose weather the weather screens show
+
+// Progress dots shown until the first WiFi connection
+static byte connectingDots = 0xFF;
+
+// Set when a fresh weather update should run regardless of data age
+static bool weatherWanted = true;
+
+// Task ids, for tasks that are rescheduled from elsewhere
+static int weatherTaskId = -1;
+
+static void setupTasks();
 
 void setup() {
   Serial.begin(115200);
   delay(1000);  // Give serial time to initialize
   
-  Serial.println("Starting ESP Weather Display");
+  LOG_INFO("Boot", "Starting ESP Weather Display");
   
-  // Initialize EEPROM
-  EEPROM.begin(EEPROM_SIZE);
+  // Register the loop() tasks first; setup() may return early into the config portal
+  setupTasks();
+  
+  // Read all settings in one go
+  SettingsStore::begin();
+  Locations::begin();
   
   // Initialize display
+#ifdef DISPLAY_HW_I2C
+  u8g2.setBusClock(DISPLAY_I2C_CLOCK);
+#endif
   u8g2.begin();
   u8g2.setFont(u8g2_font_6x10_tr);
   
-  // Check if WiFi credentials exist
-  uint8_t configFlag = EEPROM.read(CONFIG_FLAG_OFFSET);
+#ifdef DISPLAY_BENCHMARK
+  runDisplayBenchmark();
+#endif
+#ifdef LOGIC_BENCHMARK
+  runLogicBenchmark();
+#endif
   
-  if (configFlag != CONFIG_FLAG) {
-    Serial.println("No valid WiFi configuration found");
+  // Check if WiFi credentials exist
+  if (!SettingsStore::hasCredentials()) {
+    LOG_INFO("Boot", "No valid WiFi configuration found");
     startConfigPortal();
     return;
   }
   
-  // Try to connect with stored credentials
-  if (!loadWiFiConfig()) {
-    Serial.println("Failed to connect with stored credentials");
-    startConfigPortal();
+  // Start connecting with stored credentials; association runs in the
+  // background while the rest of setup() loads settings
+  LOG_INFO("Boot", "WiFi connection");
+  if (!connectToWifi()) {
+    LOG_WARN("Boot", "Failed to connect with stored credentials");
     return;
   }
   
   // Show startup message
   drawConnectingScreen("Starting up...", "Initializing");
-  delay(1000);
-  
-  // Debug EEPROM WiFi credentials storage
-  Serial.println("\n----- WiFi Credentials Debug -----");
-  Serial.println("Reading WiFi configuration...");
-  
-  // Initialize EEPROM
-  EEPROM.begin(EEPROM_SIZE);
-  
-  // Debug info about EEPROM config
-  bool isConfigured = (EEPROM.read(CONFIG_FLAG_OFFSET) == CONFIG_FLAG);
-  Serial.print("EEPROM Config Flag: ");
-  Serial.println(isConfigured ? "SET (1)" : "NOT SET (0)");
-  
-  EEPROM.end();
   
   // Load saved settings for city/state
-  Serial.println("\n----- Loading Settings -----");
+  LOG_INFO("Boot", "Loading settings");
   drawConnectingScreen("Starting up...", "Loading settings");
   loadSettings();
   
+  // Show the last good weather until the first fetch lands
+  WeatherSnapshot::load();
+  
   // Check if city name is valid, if not reset it
   if (cityName.length() == 0 || cityName == "_") {
-    Serial.println("City name is invalid, resetting to default and saving");
+    LOG_WARN("Boot", "City name is invalid, resetting to default and saving");
     cityName = "New York";
     stateName = "NY";
-    timezone = -5.0f; // Set default timezone to Eastern Time
-    
-    // Save settings to EEPROM directly
-    EEPROM.begin(EEPROM_SIZE);
+    cityCoordinatesKnown = false;
+    TimeZone::set(TZ_DEFAULT); // Eastern Time
     
-    // Save city name
-    for (size_t i = 0; i < 50; i++) {
-      if (i < cityName.length()) {
-        EEPROM.write(CITY_OFFSET + i, cityName[i]);
-      } else {
-        EEPROM.write(CITY_OFFSET + i, 0);
-      }
-    }
-    
-    // Save state code
-    for (size_t i = 0; i < 2; i++) {
-      if (i < stateName.length()) {
-        EEPROM.write(STATE_OFFSET + i, stateName[i]);
-      } else {
-        EEPROM.write(STATE_OFFSET + i, 0);
-      }
-    }
-    
-    // Save update interval
-    byte intervalBytes[4];
-    memcpy(intervalBytes, &WEATHER_UPDATE_INTERVAL, 4);
-    for (int i = 0; i < 4; i++) {
-      EEPROM.write(UPDATE_INTERVAL_OFFSET + i, intervalBytes[i]);
-    }
-    
-    // Save timezone
-    byte timezoneBytes[4];
-    memcpy(timezoneBytes, &timezone, 4);
-    for (int i = 0; i < 4; i++) {
-      EEPROM.write(TIMEZONE_OFFSET + i, timezoneBytes[i]);
-    }
+    saveSettings();
     
-    // Save API key
-    for (size_t i = 0; i < 50; i++) {
-      if (i < API_KEY.length()) {
-        EEPROM.write(API_KEY_OFFSET + i, API_KEY[i]);
-      } else {
-        EEPROM.write(API_KEY_OFFSET + i, 0);
-      }
-    }
-    
-    EEPROM.commit();
-    EEPROM.end();
-    
-    Serial.println("Default settings saved to EEPROM");
+    LOG_INFO("Boot", "Default settings saved to EEPROM");
     delay(1000);
   }
   
-  // Display current credentials status
-  if (isConfigured) {
-    drawConnectingScreen("WiFi configuration", "found");
-  } else {
-    drawConnectingScreen("No WiFi config", "Will start portal");
-  }
-  delay(1000);
-  
-  // Try to connect to saved WiFi with more detailed output
-  Serial.println("\n----- WiFi Connection -----");
-  Serial.println("Starting WiFi connection process...");
-  connectToWifi();
-  
-  // After WiFi connection, setup NTP
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println("WiFi connected successfully, setting up services");
-    
-    // Setup NTP client
-    Serial.println("\n----- Time Synchronization -----");
-    drawConnectingScreen("Setting up", "NTP time sync");
-    setupNTP();
-    
-    // Get current time
-    drawConnectingScreen("Updating", "time & date");
-    bool timeSuccess = updateTimeAndDate();
-    if (!timeSuccess) {
-      Serial.println("[Time] Initial time update failed, will retry later");
-    } else {
-      Serial.println("[Time] Initial time update successful");
-      timeInitialized = true;
-      lastSecondUpdate = millis();
-    }
-    
-    // Force a second NTP sync to improve initial accuracy
-    delay(1000);
-    Serial.println("[Time] Performing secondary time sync for accuracy...");
-    updateTimeAndDate();
-    
-    // Fetch weather data
-    drawConnectingScreen("Fetching", "weather data");
-    bool weatherSuccess = Weather::fetchWeatherData();
-    if (!weatherSuccess) {
-      Serial.println("[Weather] Initial weather update failed, will retry later");
-    }
-  } else {
-    Serial.println("WiFi not connected after initialization");
-  }
+  drawConnectingScreen("WiFi configuration", "found");
   
-  Serial.println("\n----- Setup Complete -----");
+  LOG_INFO("Boot", "Setup complete");
 }
 
-void loop() {
-  // Get current WiFi mode
+// True while the config portal owns the display: AP mode with a client, or
+// AP(+STA) mode without a station connection
+static bool inPortalMode() {
   WiFiMode_t currentMode = WiFi.getMode();
   bool isAPActive = (currentMode == WIFI_AP || currentMode == WIFI_AP_STA) && WiFi.softAPgetStationNum() > 0;
-  
-  // Handle DNS requests if in AP mode
+  return isAPActive || currentMode == WIFI_AP ||
+         (currentMode == WIFI_AP_STA && WiFi.status() != WL_CONNECTED);
+}
+
+// Serve the web interface and, in AP mode, the captive portal DNS
+static void webTask() {
+  WiFiMode_t currentMode = WiFi.getMode();
   if (currentMode == WIFI_AP || currentMode == WIFI_AP_STA) {
-    dnsServer.processNextRequest();
+    // Someone may be setting the device up; answer at full speed
+    Power::stayAwake();
+    servicePortalDns();
   }
-  
-  // Handle web server requests
-  server.handleClient();
-  
-  // AP mode with active connections - focus on serving the portal
-  if (isAPActive) {
-    static unsigned long lastRefresh = 0;
-    if (millis() - lastRefresh >= 5000) {
+  WifiScan::service();
+  Metrics::ScopedTimer timer(METRIC_HANDLE_CLIENT);
+  serviceWebClients();
+}
+
+// Refresh the setup instructions while the config portal is active. A
+// redraw takes tens of milliseconds, so it waits while a phone is busy
+// loading the setup page.
+static void portalDisplayTask() {
+  if (inPortalMode()) {
+    Power::serviceDisplay(true);
+    if (!webClientActive()) {
       drawConfigMode();
-      lastRefresh = millis();
     }
-    delay(10);
+  }
+}
+
+// Advance the software clock from millis(); it keeps running while WiFi reconnects
+static void clockTask() {
+  if (inPortalMode()) {
     return;
   }
-  
-  // AP mode without connections OR STA+AP mode without active clients
-  if (currentMode == WIFI_AP || 
-     (currentMode == WIFI_AP_STA && WiFi.status() != WL_CONNECTED && !isAPActive)) {
-    // If we're in AP mode only (or AP+STA but not connected), periodically refresh the display
-    static unsigned long lastRefresh = 0;
-    if (millis() - lastRefresh >= 5000) {
-      drawConfigMode();
-      lastRefresh = millis();
-    }
-    delay(10);
+  updateCurrentTime();
+  Solar::service();
+}
+
+// Advance a running weather update or firmware download by one bounded time slice
+static void weatherFetchTask() {
+  Weather::serviceWeatherUpdate();
+  Ota::service();
+}
+
+// Start a weather update when the data is due; runs every 30 seconds, which
+// is also the retry interval after a failed attempt
+static void weatherTask() {
+  if (inPortalMode() || WiFi.status() != WL_CONNECTED || Weather::isUpdating() || Ota::isBusy()) {
     return;
   }
   
-  // STA mode or AP+STA mode with active connection - handle normal operation
+  bool due = weatherWanted || lastWeatherUpdate == 0 ||
+             millis() - lastWeatherUpdate >= WEATHER_UPDATE_INTERVAL;
+  if (!due) {
+    return;
+  }
   
-  // Check WiFi connection status periodically (every 30 seconds)
-  static unsigned long lastWifiCheck = 0;
-  static unsigned long lastTimeUpdate = 0;
-  static bool initialSetupDone = false;
+  LOG_INFO("Weather", "Weather update initiated");
+  if (Weather::startWeatherUpdate()) {
+    weatherWanted = false;
+  } else {
+    LOG_WARN("Weather", "Weather update failed, will retry later");
+  }
+}
+
+// Check for new firmware, or resume a download, between weather updates;
+// both go through the one HTTP client
+static void otaTask() {
+  if (inPortalMode() || WiFi.status() != WL_CONNECTED || Weather::isUpdating()) {
+    return;
+  }
+  Ota::startIfDue();
+}
+
+// Bring up the services that need the network; NTP and the web server are
+// only set up on the first connection
+static void onWifiConnected() {
+  static bool servicesStarted = false;
+  invalidateDisplay();
   
-  // If we're connected, perform regular operations
-  if (WiFi.status() == WL_CONNECTED) {
+  if (!servicesStarted) {
+    servicesStarted = true;
     
-    // First-time setup after connection
-    if (!initialSetupDone) {
-      Serial.println("Connection established - performing initial setup");
-      
-      // Skip NTP setup and time update since it was already done in setup()
-      
-      // Get weather
-      drawConnectingScreen("Fetching", "weather data");
-      bool weatherSuccess = Weather::fetchWeatherData();
-      if (!weatherSuccess) {
-        Serial.println("[Weather] Initial weather update failed, will retry later");
-      }
-      
-      initialSetupDone = true;
-      // Initialize lastTimeUpdate to current time so we don't immediately trigger another update
-      lastTimeUpdate = millis();
-    }
+    server.stop(); // Stop any existing server
+    setupWebServer();
+    server.begin();
     
-    // Clock updates
-    updateCurrentTime();
+    LOG_INFO("Time", "Time synchronization");
+    // SNTP syncs in the background; the clock task picks up the time
+    setupNTP();
+  }
+  
+  // Get weather in the background so the clock keeps running; with a
+  // snapshot on screen it replaces the stored data
+  weatherWanted = true;
+  scheduler.runSoon(weatherTaskId);
+}
+
+// WiFi supervision: follow the connection engine, which reconnects in the
+// background when the connection drops
+static void wifiTask() {
+  if (inPortalMode()) {
+    return;
+  }
+  
+  switch (WifiConnection::service()) {
+    case WifiConnection::EVENT_CONNECTED:
+      onWifiConnected();
+      break;
     
-    // Periodic NTP time update every 5 minutes (reduced from 10 minutes for better accuracy)
-    if (millis() - lastTimeUpdate >= 5 * 60 * 1000) {
-      Serial.println("[Time] Time update initiated...");
-      bool timeUpdateSuccess = updateTimeAndDate();
-      if (timeUpdateSuccess) {
-        Serial.println("[Time] Time update successful");
-        // Format time and date strings for display
-        char timeStr[16];
-        formatTimeString(timeStr, hours, minutes, use12HourFormat);
-        
-        char dateStr[32]; // Increased from 20 to 32 to prevent buffer overflow
-        sprintf(dateStr, "%s %s %d, %d", dayOfWeekStr.c_str(), monthStr.c_str(), dayOfMonth, year);
-        
-        Serial.print("[Time] Current time: ");
-        Serial.print(timeStr);
-        Serial.print(" ");
-        Serial.println(dateStr);
-      } else {
-        Serial.println("[Time] Time update failed");
-      }
-      lastTimeUpdate = millis();
-    }
+    case WifiConnection::EVENT_GAVE_UP:
+      drawConnectingScreen("Connection failed", "Starting portal...");
+      startConfigPortal();
+      break;
     
-    // Weather update when needed
-    if (millis() - lastWeatherUpdate >= WEATHER_UPDATE_INTERVAL) {
-      Serial.println("[Weather] Weather update initiated...");
-      bool weatherUpdateSuccess = Weather::fetchWeatherData();
-      if (weatherUpdateSuccess) {
-        Serial.println("[Weather] Weather update successful");
-        Serial.println("[Weather] Fetched weather data");
-        Serial.println("[Weather] Current temp: " + String(currentTemp) + (useMetricUnits ? "°C" : "°F") + ", Condition: " + currentCondition);
-      } else {
-        Serial.println("[Weather] Weather update failed");
-      }
+    default:
+      break;
+  }
+}
+
+// Cycle through the screens: the time, current weather and forecast for
+// each location that has weather, then the hours
+static void screenRotationTask() {
+  if (currentScreen == SCREEN_CURRENT_WEATHER) {
+    currentScreen = SCREEN_FORECAST;
+  } else if (currentScreen == SCREEN_FORECAST) {
+    uint8_t next = currentLocation + 1;
+    while (next < Locations::count() && !Locations::hasWeather(next)) {
+      next++;
     }
-    
-    // Periodic WiFi check
-    if (millis() - lastWifiCheck >= 30000) {
-      // Just update the timestamp - connection is good
-      lastWifiCheck = millis();
-      Serial.println("[WiFi] Connection check: Connected to " + WiFi.SSID() + " (" + WiFi.localIP().toString() + ")");
+    if (next < Locations::count()) {
+      currentLocation = next;
+      currentScreen = SCREEN_CURRENT_WEATHER;
+    } else {
+      currentScreen = SCREEN_HOURLY;
     }
+  } else {
+    currentScreen = (currentScreen + 1) % SCREEN_COUNT;
+    currentLocation = 0;
+  }
+  if (currentScreen == SCREEN_HOURLY) {
+    // Start the sparkline at the period we are in
+    HourlyForecast::expire(getEpochTime());
+  }
+}
+
+// Update display; only redraws and sends what changed. Until the first
+// connection there is only progress to show.
+static void displayTask() {
+  if (inPortalMode()) {
+    return;
   }
-  // Not connected - try to reconnect
-  else {
-    // Only attempt reconnection every 30 seconds
-    if (millis() - lastWifiCheck >= 30000) {
-      lastWifiCheck = millis();
-      
-      Serial.println("WiFi disconnected - attempting reconnection");
-      initialSetupDone = false;
-      
-      // Try to reconnect
-      drawConnectingScreen("Reconnecting", "to WiFi");
-      
-      // First try a simple reconnect
-      WiFi.reconnect();
-      
-      // Give it 10 seconds to quickly reconnect
-      unsigned long reconnectStart = millis();
-      bool quickReconnected = false;
-      
-      while (millis() - reconnectStart < 10000) {
-        if (WiFi.status() == WL_CONNECTED) {
-          Serial.println("Quick reconnection successful");
-          quickReconnected = true;
-          break;
-        }
-        // Visual feedback
-        if ((millis() - reconnectStart) % 250 < 50) {
-          String dots = String((millis() - reconnectStart) / 250 % 4, '.');
-          drawConnectingScreen("Reconnecting", dots);
-        }
-        delay(100);
-      }
-      
-      // If quick reconnect failed, try a full reconnect
-      if (!quickReconnected) {
-        Serial.println("Quick reconnect failed, trying full reconnect");
-        drawConnectingScreen("Quick reconnect failed", "Trying full reconnect");
-        delay(1000);
-        connectToWifi(); // This handles portal startup if needed
-      }
+  if (!WifiConnection::everConnected()) {
+    static const char* const DOTS[] = { "", ".", "..", "..." };
+    byte dots = millis() / 250 % 4;
+    if (dots != connectingDots) {
+      connectingDots = dots;
+      drawConnectingScreen("Connecting to WiFi", DOTS[dots]);
     }
+    return;
   }
-  
-  // Display update (regardless of connection status)
-  
-  // Check if it's time to switch screens
-  static unsigned long lastScreenChange = 0;
-  static byte currentScreen = 0; // 0 = time, 1 = current weather, 2 = forecast
-  
-  if (millis() - lastScreenChange >= SCREEN_SWITCH_INTERVAL) {
-    currentScreen = (currentScreen + 1) % 3; // Cycle through 3 screens
-    lastScreenChange = millis();
+  // Until the first sync the clock cannot tell day from night
+  if (!Power::serviceDisplay(clockStats().syncs == 0 || isDaytimeNow())) {
+    return;
   }
-  
-  // Update display
-  u8g2.clearBuffer();
-  
-  switch (currentScreen) {
-    case 0:
-      drawTimeScreen();
-      break;
-    case 1:
-      drawCurrentWeatherScreen();
-      break;
-    case 2:
-      drawForecastScreen();
-      break;
+  if (Weather::serviceErrorScreen()) {
+    return;
   }
-  
-  u8g2.sendBuffer();
-  
-  // Short delay
-  delay(50);
-}
\ No newline at end of file
+  // Another location's weather is swapped into the globals while drawing
+  bool locationScreen = currentScreen == SCREEN_CURRENT_WEATHER || currentScreen == SCREEN_FORECAST;
+  Locations::Scope location(locationScreen ? currentLocation : 0);
+  // Transitions need the display tick; a power saving pace just switches
+  renderScreen(currentScreen, Power::atFullSpeed());
+}
+
+// Register the loop() work with the scheduler. Priorities: serving requests
+// first, then the fetch in progress, the clock and display, and the
+// periodic checks last. Budgets are what each run is expected to stay under.
+// While power saving is idle the frequent tasks drop to the one-second
+// display tick.
+static void setupTasks() {
+  Power::registerTask(scheduler.addTask("web", webTask, 10, 5, 20000), 10, 1000);
+  weatherTaskId = scheduler.addTask("weather", weatherTask, 30000, 1, 50000);
+  Power::registerTask(scheduler.addTask("weather-fetch", weatherFetchTask, 10, 4, 10000), 10, 1000);
+  Power::registerTask(scheduler.addTask("clock", clockTask, 200, 3, 1000), 200, 1000);
+  Power::registerTask(scheduler.addTask("display", displayTask, 50, 3, 40000), 50, 1000);
+  scheduler.addTask("screen-rotation", screenRotationTask, SCREEN_SWITCH_INTERVAL, 2, 100, SCREEN_SWITCH_INTERVAL);
+  scheduler.addTask("portal-display", portalDisplayTask, 5000, 2, 40000);
+  Power::registerTask(scheduler.addTask("wifi", wifiTask, 50, 4, 10000), 50, 1000);
+  scheduler.addTask("metrics", Metrics::sample, 1000, 1, 2000);
+  // The first check waits for the first weather update to go out
+  scheduler.addTask("ota", otaTask, 60000, 1, 20000, 60000);
+}
+
+void loop() {
+  // Run whatever is due, then sleep until the next task needs the CPU
+  unsigned long idleMs = scheduler.run();
+  Log::service();
+  Power::idle(idleMs, Weather::isUpdating() || Ota::isBusy());
+}
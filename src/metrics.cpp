@@ -0,0 +1,158 @@
+/*
+ * Implementation of the runtime metrics
+ */
+
+#include "metrics.h"
+#include <ESP8266WiFi.h>
+#include <stdarg.h>
+#include "scheduler.h"
+
+// Every metric name starts with this
+#define METRIC_PREFIX "wificlock_"
+
+namespace Metrics {
+    struct Histogram {
+        uint32_t buckets[METRIC_BUCKETS];  // Not cumulative; write() adds them up
+        uint32_t count;
+        uint64_t sumUs;
+        uint32_t maxUs;
+    };
+
+    // Path labels, indexed by METRIC_*
+    static const char* const PATHS[METRIC_COUNT] = {
+        "weather_update", "weather_slice", "time_update",
+        "draw_time", "draw_current", "draw_forecast", "draw_hourly",
+        "display_send", "handle_client"
+    };
+
+    // Upper bucket bounds in microseconds, and as the le label in seconds
+    static const uint32_t BOUNDS_US[METRIC_BUCKETS - 1] = {
+        100, 500, 1000, 5000, 10000, 50000, 100000, 500000, 1000000, 5000000, 10000000
+    };
+    static const char* const BOUND_LABELS[METRIC_BUCKETS] = {
+        "0.0001", "0.0005", "0.001", "0.005", "0.01", "0.05", "0.1", "0.5", "1", "5", "10", "+Inf"
+    };
+
+    static Histogram histograms[METRIC_COUNT];
+
+    static uint32_t lowestFreeHeap = UINT32_MAX;
+    static uint32_t lowestMaxFreeBlock = UINT32_MAX;
+    static uint8_t highestFragmentation = 0;
+
+    void observe(uint8_t metric, uint32_t micros) {
+        if (metric >= METRIC_COUNT) {
+            return;
+        }
+        Histogram& histogram = histograms[metric];
+        uint8_t bucket = 0;
+        while (bucket < METRIC_BUCKETS - 1 && micros > BOUNDS_US[bucket]) {
+            bucket++;
+        }
+        histogram.buckets[bucket]++;
+        histogram.count++;
+        histogram.sumUs += micros;
+        if (micros > histogram.maxUs) {
+            histogram.maxUs = micros;
+        }
+    }
+
+    void sample() {
+        uint32_t freeHeap;
+        uint16_t maxFreeBlock;
+        uint8_t fragmentation;
+        ESP.getHeapStats(&freeHeap, &maxFreeBlock, &fragmentation);
+        lowestFreeHeap = min(lowestFreeHeap, freeHeap);
+        lowestMaxFreeBlock = min(lowestMaxFreeBlock, (uint32_t)maxFreeBlock);
+        highestFragmentation = max(highestFragmentation, fragmentation);
+    }
+
+    // Format one line into the response
+    static void line(TemplateWriter& out, const char* format, ...) {
+        char text[192];
+        va_list args;
+        va_start(args, format);
+        vsnprintf(text, sizeof(text), format, args);
+        va_end(args);
+        out.print(text);
+    }
+
+    // A duration in microseconds as seconds
+    static void formatSeconds(uint64_t micros, char* buffer, size_t size) {
+        snprintf(buffer, size, "%lu.%06lu", (unsigned long)(micros / 1000000), (unsigned long)(micros % 1000000));
+    }
+
+    static void header(TemplateWriter& out, const char* name, const char* type, const char* help) {
+        line(out, "# HELP " METRIC_PREFIX "%s %s\n# TYPE " METRIC_PREFIX "%s %s\n", name, help, name, type);
+    }
+
+    static void gauge(TemplateWriter& out, const char* name, const char* help, long value) {
+        header(out, name, "gauge", help);
+        line(out, METRIC_PREFIX "%s %ld\n", name, value);
+    }
+
+    static void writeHistograms(TemplateWriter& out) {
+        char seconds[24];
+        header(out, "duration_seconds", "histogram", "Time spent in instrumented code paths");
+        for (uint8_t i = 0; i < METRIC_COUNT; i++) {
+            const Histogram& histogram = histograms[i];
+            uint32_t cumulative = 0;
+            for (uint8_t bucket = 0; bucket < METRIC_BUCKETS; bucket++) {
+                cumulative += histogram.buckets[bucket];
+                line(out, METRIC_PREFIX "duration_seconds_bucket{path=\"%s\",le=\"%s\"} %lu\n",
+                     PATHS[i], BOUND_LABELS[bucket], (unsigned long)cumulative);
+            }
+            formatSeconds(histogram.sumUs, seconds, sizeof(seconds));
+            line(out, METRIC_PREFIX "duration_seconds_sum{path=\"%s\"} %s\n", PATHS[i], seconds);
+            line(out, METRIC_PREFIX "duration_seconds_count{path=\"%s\"} %lu\n", PATHS[i], (unsigned long)histogram.count);
+        }
+
+        header(out, "duration_max_seconds", "gauge", "Longest time spent in a code path since boot");
+        for (uint8_t i = 0; i < METRIC_COUNT; i++) {
+            formatSeconds(histograms[i].maxUs, seconds, sizeof(seconds));
+            line(out, METRIC_PREFIX "duration_max_seconds{path=\"%s\"} %s\n", PATHS[i], seconds);
+        }
+    }
+
+    static void writeTasks(TemplateWriter& out) {
+        char seconds[24];
+        header(out, "task_runs_total", "counter", "Scheduler task runs");
+        for (uint8_t i = 0; i < scheduler.taskCount(); i++) {
+            const Scheduler::Task& task = scheduler.task(i);
+            line(out, METRIC_PREFIX "task_runs_total{task=\"%s\"} %lu\n", task.name, (unsigned long)task.runs);
+        }
+        header(out, "task_seconds_total", "counter", "CPU time spent in scheduler tasks");
+        for (uint8_t i = 0; i < scheduler.taskCount(); i++) {
+            const Scheduler::Task& task = scheduler.task(i);
+            formatSeconds(task.totalUs, seconds, sizeof(seconds));
+            line(out, METRIC_PREFIX "task_seconds_total{task=\"%s\"} %s\n", task.name, seconds);
+        }
+        header(out, "task_missed_deadlines_total", "counter", "Task runs that started after their next period had begun");
+        for (uint8_t i = 0; i < scheduler.taskCount(); i++) {
+            const Scheduler::Task& task = scheduler.task(i);
+            line(out, METRIC_PREFIX "task_missed_deadlines_total{task=\"%s\"} %lu\n", task.name, (unsigned long)task.missedDeadlines);
+        }
+    }
+
+    void write(TemplateWriter& out) {
+        // The scrape itself is a fresh sample
+        sample();
+        uint32_t freeHeap;
+        uint16_t maxFreeBlock;
+        uint8_t fragmentation;
+        ESP.getHeapStats(&freeHeap, &maxFreeBlock, &fragmentation);
+
+        gauge(out, "uptime_seconds", "Seconds since boot", (long)(millis() / 1000));
+        gauge(out, "heap_free_bytes", "Free heap", (long)freeHeap);
+        gauge(out, "heap_free_low_water_bytes", "Lowest free heap seen since boot", (long)lowestFreeHeap);
+        gauge(out, "heap_max_free_block_bytes", "Largest allocatable block", (long)maxFreeBlock);
+        gauge(out, "heap_max_free_block_low_water_bytes", "Smallest largest block seen since boot", (long)lowestMaxFreeBlock);
+        gauge(out, "heap_fragmentation_percent", "Heap fragmentation", (long)fragmentation);
+        gauge(out, "heap_fragmentation_high_water_percent", "Highest heap fragmentation seen since boot", (long)highestFragmentation);
+        if (WiFi.status() == WL_CONNECTED) {
+            gauge(out, "wifi_rssi_dbm", "Signal strength of the access point", (long)WiFi.RSSI());
+        }
+
+        writeHistograms(out);
+        writeTasks(out);
+    }
+}
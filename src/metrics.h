@@ -0,0 +1,52 @@
+/*
+ * Runtime metrics for ESP-01 Weather Display
+ * Hot paths are timed with the CPU cycle counter into fixed-bucket latency
+ * histograms; heap and signal gauges are sampled once a second. /metrics
+ * streams everything in the Prometheus text format.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+#include "html_template.h"
+
+// Timed code paths; the order is that of the path labels in metrics.cpp
+#define METRIC_WEATHER_UPDATE 0     // A whole weather update, first request to last
+#define METRIC_WEATHER_SLICE 1      // One serviceWeatherUpdate() time slice
+#define METRIC_TIME_UPDATE 2        // updateTimeAndDate()
+#define METRIC_DRAW_TIME 3
+#define METRIC_DRAW_CURRENT 4
+#define METRIC_DRAW_FORECAST 5
+#define METRIC_DRAW_HOURLY 6
+#define METRIC_DISPLAY_SEND 7       // Full or partial frame push to the panel
+#define METRIC_HANDLE_CLIENT 8      // server.handleClient()
+#define METRIC_COUNT 9
+
+// Histogram buckets, 100 us to 10 s plus +Inf
+#define METRIC_BUCKETS 12
+
+namespace Metrics {
+    // Add one duration to a path's histogram
+    void observe(uint8_t metric, uint32_t micros);
+
+    // Times its own lifetime into a histogram. The cycle counter wraps after
+    // 26 s at 160 MHz, so longer paths use observe() with millis().
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(uint8_t metric) : metric(metric), start(ESP.getCycleCount()) {}
+        ~ScopedTimer() { observe(metric, (ESP.getCycleCount() - start) / ESP.getCpuFreqMHz()); }
+
+    private:
+        uint8_t metric;
+        uint32_t start;
+    };
+
+    // Update the heap and signal gauges. Call about once a second.
+    void sample();
+
+    // Write all metrics in the Prometheus text format
+    void write(TemplateWriter& out);
+}
+
+#endif // METRICS_H
@@ -0,0 +1,366 @@
+/*
+ * Implementation of over-the-air firmware updates
+ */
+
+#include "ota.h"
+#include "http_fetch.h"
+#include "weather_provider.h"
+#include "logging.h"
+#include <ArduinoJson.h>
+#include <Updater.h>
+
+// Longest manifest accepted, the example in ota.h is about 140 bytes
+#define OTA_MANIFEST_MAX_SIZE 320
+
+// Longest time a single service() call may spend on the request. Writing a
+// flash sector can take longer on its own; the device reboots soon after.
+#define OTA_SLICE_MS 8
+
+// Limit for one image request; a 500 KB image takes about 10 s on a fair link
+#define OTA_DOWNLOAD_TIMEOUT_MS 120000
+
+// Pause between the verified image and the reboot, so the log gets out
+#define OTA_RESTART_DELAY_MS 1000
+
+namespace Ota {
+    static State currentState = IDLE;
+    static Stats counters = {0, 0, 0, 0, 0};
+    static char error[48] = "";
+
+    // Manifest check; the validators are kept only once the manifest says
+    // this build is current, so after a failed update the next check reads it again
+    static bool checkWanted = false;
+    static bool checkedOnce = false;
+    static unsigned long lastCheckAt = 0;
+    static char manifestEtag[48] = "";
+    static char manifestLastModified[32] = "";
+    static char manifestBody[OTA_MANIFEST_MAX_SIZE + 1];
+    static size_t manifestLength = 0;
+    static bool manifestOverflow = false;
+    static char latestVersion[16] = "";
+
+    // The image being installed
+    static char imageHost[48];
+    static uint16_t imagePort = 80;
+    static String imagePath;
+    static uint32_t imageSize = 0;
+    static char imageMd5[33];
+    static uint32_t written = 0;
+    static uint8_t attempts = 0;
+    static uint8_t loggedDecile = 0;
+    static bool firstChunk = true;
+    static bool writeFailed = false;
+    static unsigned long restartAt = 0;
+
+    // Split "http://host[:port]/path"; false for anything else
+    static bool parseUrl(const char* url, char* host, size_t hostSize, uint16_t& port, String& path) {
+        if (strncmp(url, "http://", 7) != 0) {
+            return false;
+        }
+        const char* start = url + 7;
+        const char* slash = strchr(start, '/');
+        const char* end = slash ? slash : start + strlen(start);
+        const char* colon = (const char*)memchr(start, ':', end - start);
+        size_t hostLength = (colon ? colon : end) - start;
+        if (hostLength == 0 || hostLength >= hostSize) {
+            return false;
+        }
+        memcpy(host, start, hostLength);
+        host[hostLength] = '\0';
+        port = colon ? (uint16_t)atoi(colon + 1) : 80;
+        path = slash ? slash : "/";
+        return port != 0;
+    }
+
+    static void fail(const char* reason) {
+        strncpy(error, reason, sizeof(error) - 1);
+        error[sizeof(error) - 1] = '\0';
+        counters.failures++;
+        HttpFetch::reset();
+        currentState = IDLE;
+        LOG_WARN("OTA", "%s", reason);
+    }
+
+    // Give up on the image; the running firmware stays as it is
+    static void abortDownload(const char* reason) {
+        if (Update.isRunning()) {
+            Update.end(); // Unfinished, so this discards it
+        }
+        fail(reason);
+    }
+
+    static void onManifestBody(const char* data, size_t len, void* context) {
+        if (HttpFetch::statusCode() != 200) {
+            return;
+        }
+        if (manifestLength + len > OTA_MANIFEST_MAX_SIZE) {
+            manifestOverflow = true;
+            return;
+        }
+        memcpy(manifestBody + manifestLength, data, len);
+        manifestLength += len;
+    }
+
+    // Flash image bytes as they arrive; Updater collects them into sectors
+    static void onImageBody(const char* data, size_t len, void* context) {
+        int code = HttpFetch::statusCode();
+        if (writeFailed || (code != 200 && code != 206)) {
+            return;
+        }
+
+        if (firstChunk) {
+            firstChunk = false;
+            if (code == 200 && written > 0) {
+                // The server ignored the Range; start the image over
+                LOG_INFO("OTA", "No range support, restarting download");
+                Update.end();
+                if (!Update.begin(imageSize) || !Update.setMD5(imageMd5)) {
+                    writeFailed = true;
+                    return;
+                }
+                written = 0;
+                loggedDecile = 0;
+            }
+        }
+
+        if (written + len > imageSize || Update.write((uint8_t*)data, len) != len) {
+            writeFailed = true;
+            return;
+        }
+        written += len;
+
+        uint8_t decile = (uint8_t)((uint64_t)written * 10 / imageSize);
+        if (decile != loggedDecile) {
+            loggedDecile = decile;
+            LOG_INFO("OTA", "%u of %u bytes written", (unsigned)written, (unsigned)imageSize);
+        }
+    }
+
+    static bool beginDownload() {
+        attempts++;
+        counters.downloads++;
+        if (written > 0) {
+            counters.resumes++;
+        }
+        firstChunk = true;
+        writeFailed = false;
+
+        if (!HttpFetch::begin(imageHost, imagePort, imagePath, onImageBody, nullptr)) {
+            // Try again at the next attempt
+            currentState = RESUME_PENDING;
+            return false;
+        }
+        if (written > 0) {
+            LOG_INFO("OTA", "Resuming download at byte %u", (unsigned)written);
+            HttpFetch::setRangeStart(written);
+        }
+        HttpFetch::setTimeout(OTA_DOWNLOAD_TIMEOUT_MS);
+        currentState = DOWNLOADING;
+        return true;
+    }
+
+    static bool beginCheck() {
+        char host[48];
+        uint16_t port;
+        String path;
+        checkWanted = false;
+        checkedOnce = true;
+        lastCheckAt = millis();
+        if (!parseUrl(OTA_MANIFEST_URL, host, sizeof(host), port, path)) {
+            fail("manifest URL is not http://host/path");
+            return false;
+        }
+
+        counters.checks++;
+        manifestLength = 0;
+        manifestOverflow = false;
+        if (!HttpFetch::begin(host, port, path, onManifestBody, nullptr, manifestEtag, manifestLastModified)) {
+            fail("manifest request could not start");
+            return false;
+        }
+        currentState = CHECKING;
+        return true;
+    }
+
+    // Act on the finished manifest request: nothing to do, or start the image
+    static void finishCheck(HttpFetch::State state) {
+        if (state == HttpFetch::FAILED) {
+            fail("manifest request failed");
+            return;
+        }
+        int code = HttpFetch::statusCode();
+        HttpFetch::reset();
+        if (code == 304) {
+            counters.notModified++;
+            error[0] = '\0';
+            currentState = IDLE;
+            LOG_DEBUG("OTA", "Manifest unchanged");
+            return;
+        }
+        if (code != 200 || manifestOverflow) {
+            fail(manifestOverflow ? "manifest too large" : "manifest request refused");
+            return;
+        }
+
+        JsonDocument doc(&Weather::parseAllocator);
+        if (deserializeJson(doc, manifestBody, manifestLength)) {
+            fail("manifest is not valid JSON");
+            return;
+        }
+        const char* version = doc["version"] | "";
+        const char* url = doc["url"] | "";
+        const char* md5 = doc["md5"] | "";
+        uint32_t size = doc["size"] | 0;
+        if (!version[0] || strlen(version) >= sizeof(latestVersion)) {
+            fail("manifest has no usable version");
+            return;
+        }
+        strcpy(latestVersion, version);
+
+        // Any other version is installed, older ones too, so republishing
+        // the previous image rolls units back
+        if (strcmp(version, FIRMWARE_VERSION) == 0) {
+            strcpy(manifestEtag, HttpFetch::etag());
+            strcpy(manifestLastModified, HttpFetch::lastModified());
+            error[0] = '\0';
+            currentState = IDLE;
+            LOG_INFO("OTA", "Firmware %s is current", FIRMWARE_VERSION);
+            return;
+        }
+
+        if (strlen(md5) != 32 || size == 0 || !parseUrl(url, imageHost, sizeof(imageHost), imagePort, imagePath)) {
+            fail("manifest needs http url, size and md5");
+            return;
+        }
+        if (size > ESP.getFreeSketchSpace()) {
+            fail("image does not fit the free flash");
+            return;
+        }
+        if (Update.isRunning()) {
+            Update.end();
+        }
+        strcpy(imageMd5, md5);
+        imageSize = size;
+        if (!Update.begin(imageSize) || !Update.setMD5(imageMd5)) {
+            abortDownload(Update.getErrorString().c_str());
+            return;
+        }
+
+        LOG_INFO("OTA", "Updating %s to %s, %u bytes", FIRMWARE_VERSION, version, (unsigned)size);
+        written = 0;
+        attempts = 0;
+        loggedDecile = 0;
+        beginDownload();
+    }
+
+    static void finishDownload(HttpFetch::State state) {
+        int code = HttpFetch::statusCode();
+        HttpFetch::reset();
+
+        if (writeFailed) {
+            abortDownload(Update.hasError() ? Update.getErrorString().c_str() : "image larger than announced");
+            return;
+        }
+        if (state == HttpFetch::DONE && code != 200 && code != 206) {
+            abortDownload("image request refused");
+            return;
+        }
+
+        if (written == imageSize) {
+            // end() checks the MD5 and only then marks the image for the bootloader
+            if (!Update.end()) {
+                abortDownload(Update.getErrorString().c_str());
+                return;
+            }
+            LOG_INFO("OTA", "Image verified, restarting into %s", latestVersion);
+            restartAt = millis() + OTA_RESTART_DELAY_MS;
+            currentState = RESTARTING;
+            return;
+        }
+
+        // The connection broke off; keep what was written and resume later
+        if (attempts >= OTA_MAX_ATTEMPTS) {
+            abortDownload("image download kept breaking off");
+            return;
+        }
+        currentState = RESUME_PENDING;
+        LOG_WARN("OTA", "Download stopped at %u of %u bytes, will resume", (unsigned)written, (unsigned)imageSize);
+    }
+
+    bool enabled() {
+        return OTA_MANIFEST_URL[0] != '\0';
+    }
+
+    bool startIfDue() {
+        if (!enabled() || isBusy() || currentState == RESTARTING) {
+            return false;
+        }
+        if (currentState == RESUME_PENDING) {
+            return beginDownload();
+        }
+        bool due = checkWanted || !checkedOnce || millis() - lastCheckAt >= OTA_CHECK_INTERVAL_MS;
+        return due && beginCheck();
+    }
+
+    void requestCheck() {
+        checkWanted = true;
+    }
+
+    void service() {
+        if (currentState == RESTARTING) {
+            if ((long)(millis() - restartAt) >= 0) {
+                Log::flush();
+                ESP.restart();
+            }
+            return;
+        }
+        if (!isBusy()) {
+            return;
+        }
+
+        HttpFetch::State fetchState = HttpFetch::service(OTA_SLICE_MS);
+        if (fetchState != HttpFetch::DONE && fetchState != HttpFetch::FAILED) {
+            return;
+        }
+        if (currentState == CHECKING) {
+            finishCheck(fetchState);
+        } else {
+            finishDownload(fetchState);
+        }
+    }
+
+    bool isBusy() {
+        return currentState == CHECKING || currentState == DOWNLOADING;
+    }
+
+    State state() {
+        return currentState;
+    }
+
+    const char* stateName() {
+        switch (currentState) {
+            case IDLE: return "idle";
+            case CHECKING: return "checking";
+            case DOWNLOADING: return "downloading";
+            case RESUME_PENDING: return "waiting to resume";
+            case RESTARTING: return "restarting";
+            default: return "unknown";
+        }
+    }
+
+    const char* lastError() {
+        return error;
+    }
+
+    const char* availableVersion() {
+        return latestVersion;
+    }
+
+    uint32_t bytesWritten() {
+        return written;
+    }
+
+    Stats stats() {
+        return counters;
+    }
+}
@@ -0,0 +1,85 @@
+/*
+ * Firmware updates over the air for ESP-01 Weather Display
+ * Now and then a small version manifest is fetched with a conditional GET,
+ * so a check that finds nothing new costs one 304. When the manifest names
+ * a version other than the running one, the image is streamed to the free
+ * half of the flash in the background, resumed with a Range request if the
+ * download breaks off, and booted only if its size and MD5 match.
+ *
+ * Manifest, served as JSON:
+ *   {"version":"1.1.0","url":"http://host/wificlock-1.1.0.bin",
+ *    "size":412768,"md5":"0123456789abcdef0123456789abcdef"}
+ */
+
+#ifndef OTA_H
+#define OTA_H
+
+#include <Arduino.h>
+
+// Version of this build, compared with the manifest's; set with
+// -DFIRMWARE_VERSION=\"...\"
+#ifndef FIRMWARE_VERSION
+#define FIRMWARE_VERSION "1.0.0"
+#endif
+
+// Where units check for updates; set with -DOTA_MANIFEST_URL=\"http://...\".
+// Empty turns updates off.
+#ifndef OTA_MANIFEST_URL
+#define OTA_MANIFEST_URL ""
+#endif
+
+// Time between manifest checks
+#define OTA_CHECK_INTERVAL_MS (6UL * 60UL * 60UL * 1000UL)
+
+// Download attempts for one image; every attempt after the first resumes
+#define OTA_MAX_ATTEMPTS 5
+
+namespace Ota {
+    enum State {
+        IDLE,
+        CHECKING,       // Manifest request running
+        DOWNLOADING,    // Image request running
+        RESUME_PENDING, // Image partly written, waiting for the next attempt
+        RESTARTING      // Image verified; rebooting into it
+    };
+
+    // True if a manifest URL was built in
+    bool enabled();
+
+    // Check the manifest if a check is due, or resume a broken-off download.
+    // Call with WiFi up and no weather update running; HttpFetch runs one
+    // request at a time. Returns true if a request was started.
+    bool startIfDue();
+
+    // Check the manifest now, whether or not a check is due
+    void requestCheck();
+
+    // Advance the running request by one bounded time slice
+    void service();
+
+    // True while a request of ours holds HttpFetch
+    bool isBusy();
+
+    State state();
+    const char* stateName();
+
+    // Result of the last check or download ("" if none failed)
+    const char* lastError();
+
+    // Version the manifest named at the last full check ("" until then)
+    const char* availableVersion();
+
+    // Image bytes flashed so far for the running update
+    uint32_t bytesWritten();
+
+    struct Stats {
+        uint32_t checks;
+        uint32_t notModified; // Checks the server answered with 304
+        uint32_t downloads;   // Image requests, resumes included
+        uint32_t resumes;     // Image requests starting past byte 0
+        uint32_t failures;
+    };
+    Stats stats();
+}
+
+#endif // OTA_H
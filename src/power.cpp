@@ -0,0 +1,180 @@
+/*
+ * Implementation of power management
+ */
+
+#include "power.h"
+#include "scheduler.h"
+#include "display.h"
+#include "logging.h"
+
+#define PANEL_ON 0
+#define PANEL_DIM 1
+#define PANEL_OFF 2
+
+namespace Power {
+    struct TaskPeriods {
+        int id;
+        unsigned long fullMs;
+        unsigned long savingMs;
+    };
+
+    static TaskPeriods tasks[SCHEDULER_MAX_TASKS];
+    static uint8_t taskCount = 0;
+
+    static uint8_t currentMode = POWER_MODE_FULL;
+    static uint8_t nightSetting = NIGHT_DISPLAY_ON;
+    static bool fullSpeed = true;
+    static unsigned long awakeUntil = 0;
+    static uint8_t panel = PANEL_ON;
+
+    // Duty cycle accounting; micros() wraps after 71 minutes, so only
+    // differences are taken and summed in 64 bits
+    static uint32_t lastMarkUs = 0;
+    static uint64_t totalUs = 0;
+    static uint64_t activeUs = 0;
+    static uint64_t fetchUs = 0;
+    static uint64_t fullSpeedUs = 0;
+    static uint64_t panelOnUs = 0;
+    static uint64_t panelDimUs = 0;
+
+    static void applyPeriods() {
+        for (uint8_t i = 0; i < taskCount; i++) {
+            scheduler.setPeriod(tasks[i].id, fullSpeed ? tasks[i].fullMs : tasks[i].savingMs);
+        }
+        scheduler.setMaxSleep(fullSpeed ? SCHEDULER_MAX_SLEEP_MS : POWER_MAX_SLEEP_MS);
+    }
+
+    void setMode(uint8_t mode) {
+        if (mode != POWER_MODE_MODEM_SLEEP && mode != POWER_MODE_LIGHT_SLEEP) {
+            mode = POWER_MODE_FULL;
+        }
+        currentMode = mode;
+        WiFi.setSleepMode(wifiSleepType(), mode == POWER_MODE_FULL ? 0 : POWER_LISTEN_INTERVAL);
+
+        // A saving mode starts awake and slows down at the next idle()
+        fullSpeed = true;
+        applyPeriods();
+        LOG_INFO("Power", "Mode %s", mode == POWER_MODE_LIGHT_SLEEP ? "light sleep" :
+                                     mode == POWER_MODE_MODEM_SLEEP ? "modem sleep" : "full power");
+    }
+
+    uint8_t mode() {
+        return currentMode;
+    }
+
+    void setNightDisplay(uint8_t setting) {
+        nightSetting = setting <= NIGHT_DISPLAY_OFF ? setting : NIGHT_DISPLAY_ON;
+    }
+
+    uint8_t nightDisplay() {
+        return nightSetting;
+    }
+
+    WiFiSleepType_t wifiSleepType() {
+        switch (currentMode) {
+            case POWER_MODE_MODEM_SLEEP: return WIFI_MODEM_SLEEP;
+            case POWER_MODE_LIGHT_SLEEP: return WIFI_LIGHT_SLEEP;
+            default: return WIFI_NONE_SLEEP;
+        }
+    }
+
+    void registerTask(int id, unsigned long fullMs, unsigned long savingMs) {
+        if (id < 0 || taskCount >= SCHEDULER_MAX_TASKS) {
+            return;
+        }
+        tasks[taskCount].id = id;
+        tasks[taskCount].fullMs = fullMs;
+        tasks[taskCount].savingMs = savingMs;
+        taskCount++;
+    }
+
+    bool atFullSpeed() {
+        return fullSpeed;
+    }
+
+    void stayAwake() {
+        awakeUntil = millis() + POWER_INTERACTIVE_MS;
+        if (awakeUntil == 0) {
+            awakeUntil = 1; // 0 means never
+        }
+    }
+
+    // Add one loop() pass, active part included, to the duty cycle
+    static void account(uint32_t passUs, uint32_t activePartUs, bool fetching) {
+        totalUs += passUs;
+        activeUs += activePartUs;
+        if (fetching) {
+            fetchUs += passUs;
+        }
+        if (fullSpeed) {
+            fullSpeedUs += passUs;
+        }
+        if (panel == PANEL_ON) {
+            panelOnUs += passUs;
+        } else if (panel == PANEL_DIM) {
+            panelDimUs += passUs;
+        }
+    }
+
+    void idle(unsigned long ms, bool fetching) {
+        uint32_t start = micros();
+        uint32_t activePartUs = start - lastMarkUs;
+
+        if (awakeUntil != 0 && (long)(millis() - awakeUntil) >= 0) {
+            awakeUntil = 0;
+        }
+        bool wantFull = currentMode == POWER_MODE_FULL || fetching || awakeUntil != 0;
+        if (wantFull != fullSpeed) {
+            fullSpeed = wantFull;
+            applyPeriods();
+            // ms was worked out for the old periods; let the scheduler look again
+            ms = 0;
+        }
+
+        if (ms > 0) {
+            delay(ms);
+        }
+
+        lastMarkUs = micros();
+        account(lastMarkUs - start + activePartUs, activePartUs, fetching);
+    }
+
+    bool serviceDisplay(bool daytime) {
+        uint8_t wanted = PANEL_ON;
+        if (!daytime && nightSetting == NIGHT_DISPLAY_DIM) {
+            wanted = PANEL_DIM;
+        } else if (!daytime && nightSetting == NIGHT_DISPLAY_OFF) {
+            wanted = PANEL_OFF;
+        }
+        if (wanted == panel) {
+            return panel != PANEL_OFF;
+        }
+
+        if (panel == PANEL_OFF) {
+            u8g2.setPowerSave(0);
+            invalidateDisplay();
+        }
+        if (wanted == PANEL_OFF) {
+            u8g2.setPowerSave(1);
+        } else {
+            u8g2.setContrast(wanted == PANEL_DIM ? POWER_CONTRAST_NIGHT : POWER_CONTRAST_DAY);
+        }
+        panel = wanted;
+        LOG_INFO("Power", "Display %s", wanted == PANEL_OFF ? "off" : wanted == PANEL_DIM ? "dimmed" : "on");
+        return panel != PANEL_OFF;
+    }
+
+    static uint8_t percentOf(uint64_t part, uint64_t whole) {
+        return whole > 0 ? (uint8_t)((part * 100 + whole / 2) / whole) : 0;
+    }
+
+    DutyCycle dutyCycle() {
+        DutyCycle duty;
+        duty.cpuActivePct = percentOf(activeUs, totalUs);
+        duty.fetchPct = percentOf(fetchUs, totalUs);
+        duty.fullSpeedPct = percentOf(fullSpeedUs, totalUs);
+        duty.displayOnPct = percentOf(panelOnUs, totalUs);
+        duty.displayDimPct = percentOf(panelDimUs, totalUs);
+        return duty;
+    }
+}
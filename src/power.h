@@ -0,0 +1,83 @@
+/*
+ * Power management for ESP-01 Weather Display
+ * In a saving mode the radio sleeps between beacons, the loop() tasks slow
+ * down to the once-a-second display tick and the CPU idles in between; a
+ * weather fetch or a browser on the web interface brings everything back to
+ * full speed until it is done. The panel can be dimmed or switched off
+ * between sunset and sunrise.
+ */
+
+#ifndef POWER_H
+#define POWER_H
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include "config.h"
+
+// Stored in Settings::powerMode
+#define POWER_MODE_FULL 0          // Radio and CPU always on, as older firmware ran
+#define POWER_MODE_MODEM_SLEEP 1   // Radio off between beacons
+#define POWER_MODE_LIGHT_SLEEP 2   // Radio and CPU off while loop() waits
+
+// Stored in Settings::nightDisplay
+#define NIGHT_DISPLAY_ON 0
+#define NIGHT_DISPLAY_DIM 1
+#define NIGHT_DISPLAY_OFF 2
+
+// Beacon intervals the radio sleeps through in a saving mode; at the usual
+// 102.4 ms beacon interval a request waits up to about 300 ms longer
+#define POWER_LISTEN_INTERVAL 3
+
+// Longest loop() sleeps in a saving mode while nothing is going on
+#define POWER_MAX_SLEEP_MS 1000
+
+// Full speed is kept this long after the last web request
+#define POWER_INTERACTIVE_MS 30000
+
+// SSD1306 contrast by day (the controller's reset value) and dimmed at night
+#define POWER_CONTRAST_DAY 0xCF
+#define POWER_CONTRAST_NIGHT 0x01
+
+namespace Power {
+    // Duty cycle since boot, in percent of the uptime
+    struct DutyCycle {
+        uint8_t cpuActivePct;       // Running tasks, i.e. not waiting in delay()
+        uint8_t fetchPct;           // A weather fetch in progress
+        uint8_t fullSpeedPct;       // Tasks at full rate: fetches, web use, or power saving off
+        uint8_t displayOnPct;       // Panel at full contrast
+        uint8_t displayDimPct;
+    };
+
+    // Apply a POWER_MODE_* to the radio and the registered tasks; an unknown
+    // value means POWER_MODE_FULL
+    void setMode(uint8_t mode);
+    uint8_t mode();
+
+    // NIGHT_DISPLAY_*, applied by the next serviceDisplay()
+    void setNightDisplay(uint8_t nightDisplay);
+    uint8_t nightDisplay();
+
+    // Radio sleep type for the current mode
+    WiFiSleepType_t wifiSleepType();
+
+    // Give a scheduler task a slower period while power saving is idle
+    void registerTask(int id, unsigned long fullMs, unsigned long savingMs);
+
+    // True while the registered tasks run at their full rate
+    bool atFullSpeed();
+
+    // Keep full speed for POWER_INTERACTIVE_MS, e.g. on a web request
+    void stayAwake();
+
+    // Sleep the idle time scheduler.run() returned and account for it.
+    // fetching is true while a weather fetch runs, which keeps full speed.
+    void idle(unsigned long ms, bool fetching);
+
+    // Switch the panel for the time of day. Returns false while it is off,
+    // then nothing needs to be drawn.
+    bool serviceDisplay(bool daytime);
+
+    DutyCycle dutyCycle();
+}
+
+#endif // POWER_H
@@ -0,0 +1,128 @@
+/*
+ * Implementation of the cooperative task scheduler
+ */
+
+#include "scheduler.h"
+#include "logging.h"
+
+Scheduler scheduler;
+
+// True once the unsigned millis() value a has reached b, across rollover
+static bool timeReached(unsigned long a, unsigned long b) {
+  return (long)(a - b) >= 0;
+}
+
+Scheduler::Scheduler() : count(0), maxSleepMs(SCHEDULER_MAX_SLEEP_MS) {
+  memset(tasks, 0, sizeof(tasks));
+}
+
+int Scheduler::addTask(const char* name, TaskFunction function, unsigned long periodMs,
+                       uint8_t priority, uint32_t budgetUs, unsigned long firstDelayMs) {
+  if (count >= SCHEDULER_MAX_TASKS) {
+    LOG_ERROR("Scheduler", "Task table full, cannot add %s", name);
+    return -1;
+  }
+
+  Task& task = tasks[count];
+  memset(&task, 0, sizeof(task));
+  task.name = name;
+  task.function = function;
+  task.periodMs = max(periodMs, 1UL);
+  task.priority = priority;
+  task.budgetUs = budgetUs;
+  task.enabled = true;
+  task.nextRunMs = millis() + firstDelayMs;
+  return count++;
+}
+
+void Scheduler::setPeriod(int id, unsigned long periodMs) {
+  if (id < 0 || id >= count) {
+    return;
+  }
+  tasks[id].periodMs = max(periodMs, 1UL);
+  tasks[id].nextRunMs = millis() + tasks[id].periodMs;
+}
+
+void Scheduler::runSoon(int id) {
+  if (id < 0 || id >= count) {
+    return;
+  }
+  tasks[id].nextRunMs = millis();
+}
+
+void Scheduler::setEnabled(int id, bool enabled) {
+  if (id < 0 || id >= count) {
+    return;
+  }
+  if (enabled && !tasks[id].enabled) {
+    tasks[id].nextRunMs = millis();
+  }
+  tasks[id].enabled = enabled;
+}
+
+// The due task with the highest priority, among equals the most overdue;
+// tasks whose bit is set in skipMask are left out
+int Scheduler::nextDueTask(unsigned long now, uint16_t skipMask) const {
+  int best = -1;
+  for (uint8_t i = 0; i < count; i++) {
+    const Task& task = tasks[i];
+    if (!task.enabled || (skipMask & (1 << i)) || !timeReached(now, task.nextRunMs)) {
+      continue;
+    }
+    if (best < 0 || task.priority > tasks[best].priority ||
+        (task.priority == tasks[best].priority && !timeReached(task.nextRunMs, tasks[best].nextRunMs))) {
+      best = i;
+    }
+  }
+  return best;
+}
+
+void Scheduler::runTask(Task& task, unsigned long now) {
+  // Each run's deadline is the start of the next period
+  if (!timeReached(task.nextRunMs + task.periodMs, now)) {
+    task.missedDeadlines++;
+  }
+
+  uint32_t start = micros();
+  task.function();
+  uint32_t elapsed = micros() - start;
+
+  task.runs++;
+  task.totalUs += elapsed;
+  if (elapsed > task.maxUs) {
+    task.maxUs = elapsed;
+  }
+  if (task.budgetUs > 0 && elapsed > task.budgetUs) {
+    task.overBudget++;
+  }
+
+  // Keep the period grid, but do not try to catch up on periods already lost
+  task.nextRunMs += task.periodMs;
+  if (timeReached(millis(), task.nextRunMs)) {
+    task.nextRunMs = millis() + task.periodMs;
+  }
+}
+
+unsigned long Scheduler::run() {
+  // Every task runs at most once per call, so a slow one cannot starve loop()
+  uint16_t ranMask = 0;
+  int id;
+  while ((id = nextDueTask(millis(), ranMask)) >= 0) {
+    ranMask |= 1 << id;
+    runTask(tasks[id], millis());
+    yield();
+  }
+
+  unsigned long now = millis();
+  unsigned long sleepMs = maxSleepMs;
+  for (uint8_t i = 0; i < count; i++) {
+    if (!tasks[i].enabled) {
+      continue;
+    }
+    if (timeReached(now, tasks[i].nextRunMs)) {
+      return 0;
+    }
+    sleepMs = min(sleepMs, tasks[i].nextRunMs - now);
+  }
+  return sleepMs;
+}
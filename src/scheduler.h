@@ -0,0 +1,77 @@
+/*
+ * Cooperative task scheduler for ESP-01 Weather Display
+ * Runs periodic tasks from loop() by deadline and priority and keeps
+ * per-task timing statistics
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+
+// Size of the task table
+#define SCHEDULER_MAX_TASKS 10
+
+// Longest loop() may sleep between two run() calls by default, so the WiFi
+// stack and anything polled outside the scheduler still get serviced
+#define SCHEDULER_MAX_SLEEP_MS 20
+
+class Scheduler {
+public:
+  typedef void (*TaskFunction)();
+
+  // Statistics and settings of one task
+  struct Task {
+    const char* name;
+    TaskFunction function;
+    unsigned long periodMs;
+    uint8_t priority;          // Higher runs first when several tasks are due
+    uint32_t budgetUs;         // Expected maximum run time, 0 = unlimited
+    bool enabled;
+    unsigned long nextRunMs;   // Release time of the next run
+
+    uint32_t runs;
+    uint64_t totalUs;          // 64 bits: the web task alone would wrap 32 bits within weeks
+    uint32_t maxUs;
+    uint32_t missedDeadlines;  // Started after the next period had already begun
+    uint32_t overBudget;       // Took longer than budgetUs
+  };
+
+  Scheduler();
+
+  // Add a task; returns its id, or -1 if the table is full.
+  // The first run is released firstDelayMs from now.
+  int addTask(const char* name, TaskFunction function, unsigned long periodMs,
+              uint8_t priority, uint32_t budgetUs, unsigned long firstDelayMs = 0);
+
+  // Change a task's period; the next run is rescheduled from now
+  void setPeriod(int id, unsigned long periodMs);
+
+  // Release a task right away, e.g. after an event it waits for
+  void runSoon(int id);
+
+  void setEnabled(int id, bool enabled);
+
+  // Cap on what run() returns; power saving raises it so loop() can sleep longer
+  void setMaxSleep(unsigned long ms) { maxSleepMs = max(ms, 1UL); }
+
+  // Run every task that is due, highest priority first.
+  // Returns the milliseconds until the next task is due.
+  unsigned long run();
+
+  // Task table, for reporting
+  uint8_t taskCount() const { return count; }
+  const Task& task(uint8_t id) const { return tasks[id]; }
+
+private:
+  int nextDueTask(unsigned long now, uint16_t skipMask) const;
+  void runTask(Task& task, unsigned long now);
+
+  Task tasks[SCHEDULER_MAX_TASKS];
+  uint8_t count;
+  unsigned long maxSleepMs;
+};
+
+extern Scheduler scheduler;
+
+#endif // SCHEDULER_H
@@ -0,0 +1,288 @@
+/*
+ * Implementation of the settings record
+ */
+
+#include "settings.h"
+#include <coredecls.h> // crc32()
+#include <EEPROM.h>
+#include "logging.h"
+
+#define SETTINGS_MAGIC 0xA5
+
+// Bump when the record layout changes; add a migration for the old version
+#define SETTINGS_VERSION 4
+
+// Byte offsets of the layout used before the record, only read to migrate
+#define LEGACY_WIFI_SSID_OFFSET 0
+#define LEGACY_WIFI_PASS_OFFSET 32
+#define LEGACY_CONFIG_FLAG_OFFSET 128  // 1 when credentials are stored, +1 and +2 hold their lengths
+#define LEGACY_CITY_OFFSET 132
+#define LEGACY_STATE_OFFSET 182
+#define LEGACY_UPDATE_INTERVAL_OFFSET 200
+#define LEGACY_TIMEZONE_OFFSET 210
+#define LEGACY_API_KEY_OFFSET 220
+#define LEGACY_USE_DST_OFFSET 255      // Inside the API key field; written after it, so it won
+#define LEGACY_TIME_FORMAT_OFFSET 270
+#define LEGACY_TEMP_UNIT_OFFSET 271
+#define LEGACY_WEATHER_PROVIDER_OFFSET 272
+
+// Version 1 record: the time zone was an offset in hours and a DST flag
+struct SettingsV1 {
+    uint8_t magic;
+    uint8_t version;
+    uint16_t length;
+
+    char ssid[33];
+    char password[65];
+    char city[50];
+    char state[3];
+    char apiKey[50];
+
+    uint32_t updateIntervalMs;
+    float timezone;
+    uint8_t useDST;
+    uint8_t use12HourFormat;
+    uint8_t useMetricUnits;
+    uint8_t weatherProvider;
+
+    uint32_t crc;
+};
+
+// Version 2 record: the current layout up to weatherProvider
+struct SettingsV2 {
+    uint8_t magic;
+    uint8_t version;
+    uint16_t length;
+
+    char ssid[33];
+    char password[65];
+    char city[50];
+    char state[3];
+    char apiKey[50];
+    char timeZone[TZ_MAX_LENGTH + 1];
+
+    uint32_t updateIntervalMs;
+    uint8_t use12HourFormat;
+    uint8_t useMetricUnits;
+    uint8_t weatherProvider;
+
+    uint32_t crc;
+};
+
+// Version 3 record: the current layout up to nightDisplay
+struct SettingsV3 {
+    uint8_t magic;
+    uint8_t version;
+    uint16_t length;
+
+    char ssid[33];
+    char password[65];
+    char city[50];
+    char state[3];
+    char apiKey[50];
+    char timeZone[TZ_MAX_LENGTH + 1];
+
+    uint32_t updateIntervalMs;
+    uint8_t use12HourFormat;
+    uint8_t useMetricUnits;
+    uint8_t weatherProvider;
+    uint8_t powerMode;
+    uint8_t nightDisplay;
+
+    uint32_t crc;
+};
+
+static_assert(offsetof(SettingsV2, weatherProvider) == offsetof(Settings, weatherProvider), "version 2 must be a prefix of the record");
+static_assert(offsetof(SettingsV3, nightDisplay) == offsetof(Settings, nightDisplay), "version 3 must be a prefix of the record");
+
+static_assert(SETTINGS_OFFSET + sizeof(Settings) <= WEATHER_SNAPSHOT_OFFSET, "settings record overlaps the weather snapshot");
+
+namespace SettingsStore {
+    static Settings working;
+    static Settings stored;         // What is on flash, to skip commits that change nothing
+    static uint32_t commits = 0;
+    static uint32_t skipped = 0;
+    static unsigned long loadUs = 0;
+
+    static uint32_t recordCrc(const Settings& record) {
+        return crc32(&record, offsetof(Settings, crc));
+    }
+
+    static bool isValid(const Settings& record) {
+        return record.magic == SETTINGS_MAGIC && record.version == SETTINGS_VERSION &&
+               record.length == sizeof(Settings) && record.crc == recordCrc(record);
+    }
+
+    // Read a version 3 record; the coordinates stay unknown until the city is
+    // geocoded again. False if EEPROM does not hold one. The EEPROM buffer must be open.
+    static bool migrateV3(Settings& record) {
+        SettingsV3 old;
+        EEPROM.get(SETTINGS_OFFSET, old);
+        if (old.magic != SETTINGS_MAGIC || old.version != 3 || old.length != sizeof(SettingsV3) ||
+            old.crc != crc32(&old, offsetof(SettingsV3, crc))) {
+            return false;
+        }
+        memcpy(&record, &old, offsetof(SettingsV3, nightDisplay) + sizeof(old.nightDisplay));
+        return true;
+    }
+
+    // Read a version 2 record; the fields added since keep their zero
+    // defaults. False if EEPROM does not hold one. The EEPROM buffer must be open.
+    static bool migrateV2(Settings& record) {
+        SettingsV2 old;
+        EEPROM.get(SETTINGS_OFFSET, old);
+        if (old.magic != SETTINGS_MAGIC || old.version != 2 || old.length != sizeof(SettingsV2) ||
+            old.crc != crc32(&old, offsetof(SettingsV2, crc))) {
+            return false;
+        }
+        memcpy(&record, &old, offsetof(SettingsV2, weatherProvider) + sizeof(old.weatherProvider));
+        return true;
+    }
+
+    // Rebuild a version 1 record in the current layout; false if EEPROM does
+    // not hold one. The EEPROM buffer must be open.
+    static bool migrateV1(Settings& record) {
+        SettingsV1 old;
+        EEPROM.get(SETTINGS_OFFSET, old);
+        if (old.magic != SETTINGS_MAGIC || old.version != 1 || old.length != sizeof(SettingsV1) ||
+            old.crc != crc32(&old, offsetof(SettingsV1, crc))) {
+            return false;
+        }
+
+        memcpy(record.ssid, old.ssid, sizeof(record.ssid));
+        memcpy(record.password, old.password, sizeof(record.password));
+        memcpy(record.city, old.city, sizeof(record.city));
+        memcpy(record.state, old.state, sizeof(record.state));
+        memcpy(record.apiKey, old.apiKey, sizeof(record.apiKey));
+        TimeZone::fromLegacy(old.timezone, old.useDST == 1, record.timeZone, sizeof(record.timeZone));
+        record.updateIntervalMs = old.updateIntervalMs;
+        record.use12HourFormat = old.use12HourFormat;
+        record.useMetricUnits = old.useMetricUnits;
+        record.weatherProvider = old.weatherProvider;
+        return true;
+    }
+
+    // Copy a NUL or length terminated string field out of the EEPROM buffer.
+    // Erased flash reads 0xFF, which leaves the field empty.
+    static void readLegacyString(int offset, size_t length, char* out, size_t outSize) {
+        size_t n = 0;
+        while (n < length && n < outSize - 1) {
+            uint8_t c = EEPROM.read(offset + n);
+            if (c == 0 || c == 0xFF) {
+                break;
+            }
+            out[n++] = (char)c;
+        }
+        out[n] = '\0';
+    }
+
+    // Build the record from the old layout; the EEPROM buffer must be open
+    static void migrateLegacy(Settings& record) {
+        if (EEPROM.read(LEGACY_CONFIG_FLAG_OFFSET) == 1) {
+            uint8_t ssidLen = EEPROM.read(LEGACY_CONFIG_FLAG_OFFSET + 1);
+            uint8_t passLen = EEPROM.read(LEGACY_CONFIG_FLAG_OFFSET + 2);
+            if (ssidLen > 0 && ssidLen <= 32 && passLen <= 64) {
+                readLegacyString(LEGACY_WIFI_SSID_OFFSET, ssidLen, record.ssid, sizeof(record.ssid));
+                readLegacyString(LEGACY_WIFI_PASS_OFFSET, passLen, record.password, sizeof(record.password));
+            }
+        }
+
+        readLegacyString(LEGACY_CITY_OFFSET, 50, record.city, sizeof(record.city));
+        readLegacyString(LEGACY_STATE_OFFSET, 2, record.state, sizeof(record.state));
+        // Keys longer than 35 characters were cut by the DST byte at 255
+        readLegacyString(LEGACY_API_KEY_OFFSET, LEGACY_USE_DST_OFFSET - LEGACY_API_KEY_OFFSET, record.apiKey, sizeof(record.apiKey));
+
+        EEPROM.get(LEGACY_UPDATE_INTERVAL_OFFSET, record.updateIntervalMs);
+        float timezone;
+        EEPROM.get(LEGACY_TIMEZONE_OFFSET, timezone);
+        if (!(timezone >= -12 && timezone <= 14)) {
+            timezone = -5; // Erased flash
+        }
+        TimeZone::fromLegacy(timezone, EEPROM.read(LEGACY_USE_DST_OFFSET) == 1, record.timeZone, sizeof(record.timeZone));
+        record.use12HourFormat = EEPROM.read(LEGACY_TIME_FORMAT_OFFSET) == 1;
+        record.useMetricUnits = EEPROM.read(LEGACY_TEMP_UNIT_OFFSET) == 1;
+        record.weatherProvider = EEPROM.read(LEGACY_WEATHER_PROVIDER_OFFSET) == WEATHER_PROVIDER_OPENMETEO
+                                 ? WEATHER_PROVIDER_OPENMETEO : WEATHER_PROVIDER_OPENWEATHERMAP;
+    }
+
+    void begin() {
+        unsigned long start = micros();
+        bool migrated = false;
+
+        EEPROM.begin(EEPROM_SIZE);
+        EEPROM.get(SETTINGS_OFFSET, working);
+        if (isValid(working)) {
+            stored = working;
+        } else {
+            // Nothing matches the stored bytes, so the migrated record is written below
+            memset(&working, 0, sizeof(working));
+            memset(&stored, 0, sizeof(stored));
+            if (migrateV3(working)) {
+                LOG_INFO("Settings", "Migrating version 3 settings record");
+            } else if (migrateV2(working)) {
+                LOG_INFO("Settings", "Migrating version 2 settings record");
+            } else if (migrateV1(working)) {
+                LOG_INFO("Settings", "Migrating version 1 settings record");
+            } else {
+                migrateLegacy(working);
+            }
+            migrated = true;
+        }
+        EEPROM.end();
+
+        loadUs = micros() - start;
+        LOG_INFO("Settings", "Loaded in %lu us", loadUs);
+
+        if (migrated) {
+            LOG_INFO("Settings", "No current settings record found, storing the migrated settings");
+            save();
+        }
+    }
+
+    Settings& get() {
+        return working;
+    }
+
+    bool hasCredentials() {
+        return working.ssid[0] != '\0';
+    }
+
+    bool save() {
+        working.magic = SETTINGS_MAGIC;
+        working.version = SETTINGS_VERSION;
+        working.length = sizeof(Settings);
+        working.crc = recordCrc(working);
+
+        if (memcmp(&working, &stored, sizeof(Settings)) == 0) {
+            skipped++;
+            return true;
+        }
+
+        EEPROM.begin(EEPROM_SIZE);
+        EEPROM.put(SETTINGS_OFFSET, working);
+        bool ok = EEPROM.commit();
+        EEPROM.end();
+
+        if (!ok) {
+            LOG_ERROR("Settings", "EEPROM commit failed");
+            return false;
+        }
+
+        stored = working;
+        commits++;
+        LOG_INFO("Settings", "Settings saved");
+        return true;
+    }
+
+    uint32_t commitCount() {
+        return commits;
+    }
+
+    uint32_t skippedCount() {
+        return skipped;
+    }
+
+    unsigned long loadMicros() {
+        return loadUs;
+    }
+}
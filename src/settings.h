@@ -0,0 +1,65 @@
+/*
+ * Settings record for ESP-01 Weather Display
+ * All user settings live in one versioned, CRC-checked record that is read
+ * and written with a single EEPROM.get()/put(). Settings stored in the old
+ * byte-by-byte layout are migrated on first boot.
+ */
+
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "time_zone.h"
+
+// Stored form of the settings. Strings are NUL terminated.
+struct Settings {
+    uint8_t magic;             // SETTINGS_MAGIC, tells the record from the old layout
+    uint8_t version;
+    uint16_t length;           // sizeof(Settings) when written
+
+    char ssid[33];
+    char password[65];
+    char city[50];
+    char state[3];
+    char apiKey[50];
+
+    char timeZone[TZ_MAX_LENGTH + 1];  // POSIX TZ string, see time_zone.h
+
+    uint32_t updateIntervalMs;
+    uint8_t use12HourFormat;
+    uint8_t useMetricUnits;
+    uint8_t weatherProvider;   // WEATHER_PROVIDER_*
+    uint8_t powerMode;         // POWER_MODE_*, see power.h
+    uint8_t nightDisplay;      // NIGHT_DISPLAY_*
+
+    // Where city and state were geocoded to; valid when coordinatesKnown is 1
+    float latitude;
+    float longitude;
+    uint8_t coordinatesKnown;
+
+    uint32_t crc;              // Core crc32() of everything above
+};
+
+namespace SettingsStore {
+    // Read the record, migrating the old layout if that is what EEPROM holds.
+    // Call once at boot, before anything uses get().
+    void begin();
+
+    // Working copy; change it, then save()
+    Settings& get();
+
+    // True if WiFi credentials are stored
+    bool hasCredentials();
+
+    // Write the working copy. Flash is only committed when the bytes differ
+    // from what is stored. Returns false if the commit failed.
+    bool save();
+
+    // Statistics since boot
+    uint32_t commitCount();         // Commits that rewrote the flash sector
+    uint32_t skippedCount();        // Saves that found nothing changed
+    unsigned long loadMicros();     // Time begin() took
+}
+
+#endif // SETTINGS_H
@@ -0,0 +1,181 @@
+/*
+ * Implementation of the solar ephemeris
+ * The equations are those of the NOAA solar calculator spreadsheet, in
+ * float. Over a day the declination and the equation of time barely move,
+ * so they are worked out once, for local noon; the results are within a
+ * minute or two of the NOAA tables.
+ */
+
+#include "solar.h"
+#include "time_manager.h"
+#include "time_zone.h"
+#include "logging.h"
+#include <math.h>
+
+// 2000-01-01 12:00 UTC, the J2000.0 epoch the equations count from
+#define SOLAR_J2000_UTC 946728000L
+
+// Zenith of the sun's centre at sunrise and sunset: 90 degrees plus
+// refraction and the sun's radius
+#define SOLAR_ZENITH_DEG 90.833f
+
+#define MINUTES_PER_DAY 1440
+
+namespace Solar {
+    static bool haveDay = false;
+    static long computedDay = -1;       // Local days since 1970-01-01
+    static long computedOffset = 0;     // UTC offset the day was computed with (s)
+    static float computedLat = 0;
+    static float computedLon = 0;
+    static bool sunNeverSets = false;
+    static bool sunNeverRises = false;
+    static time_t lastCheckedMinute = 0;
+
+    // Of the computed day, for elevationAt()
+    static float declination = 0;       // Radians
+    static float equationOfTime = 0;    // Minutes
+
+    static float toRadians(float angle) {
+        return angle * (float)M_PI / 180.0f;
+    }
+
+    static float toDegrees(float angle) {
+        return angle * 180.0f / (float)M_PI;
+    }
+
+    // Set the sunrise or sunset globals from a UTC moment
+    static void setLocalTime(time_t utc, long offset, int& hour, int& minute) {
+        long localSeconds = (long)((utc + offset) % 86400);
+        if (localSeconds < 0) {
+            localSeconds += 86400;
+        }
+        hour = localSeconds / 3600;
+        minute = localSeconds / 60 % 60;
+    }
+
+    // Work out the sun for the local day and store sunrise and sunset
+    static void computeDay(long localDay, long offset) {
+        time_t noonUtc = (time_t)localDay * 86400 + 43200 - offset;
+        time_t utcMidnight = noonUtc - ((noonUtc % 86400) + 86400) % 86400;
+
+        // Julian centuries since J2000.0
+        float t = (float)(long)(noonUtc - SOLAR_J2000_UTC) / 86400.0f / 36525.0f;
+
+        float meanLongitude = fmodf(280.46646f + t * (36000.76983f + t * 0.0003032f), 360.0f);
+        float meanAnomaly = 357.52911f + t * (35999.05029f - 0.0001537f * t);
+        float eccentricity = 0.016708634f - t * (0.000042037f + 0.0000001267f * t);
+        float m = toRadians(meanAnomaly);
+        float centre = sinf(m) * (1.914602f - t * (0.004817f + 0.000014f * t)) +
+                       sinf(2 * m) * (0.019993f - 0.000101f * t) + sinf(3 * m) * 0.000289f;
+        float omega = toRadians(125.04f - 1934.136f * t);
+        float apparentLongitude = toRadians(meanLongitude + centre - 0.00569f - 0.00478f * sinf(omega));
+        float meanObliquity = 23.0f + (26.0f + (21.448f - t * (46.815f + t * (0.00059f - t * 0.001813f))) / 60.0f) / 60.0f;
+        float obliquity = toRadians(meanObliquity + 0.00256f * cosf(omega));
+
+        declination = asinf(sinf(obliquity) * sinf(apparentLongitude));
+
+        float y = tanf(obliquity / 2) * tanf(obliquity / 2);
+        float l0 = toRadians(meanLongitude);
+        equationOfTime = 4.0f * toDegrees(y * sinf(2 * l0) - 2 * eccentricity * sinf(m) +
+                                          4 * eccentricity * y * sinf(m) * cosf(2 * l0) -
+                                          0.5f * y * y * sinf(4 * l0) - 1.25f * eccentricity * eccentricity * sinf(2 * m));
+
+        float latitude = toRadians(cityLatitude);
+        float cosHourAngle = cosf(toRadians(SOLAR_ZENITH_DEG)) / (cosf(latitude) * cosf(declination)) -
+                             tanf(latitude) * tanf(declination);
+        sunNeverRises = cosHourAngle > 1.0f;
+        sunNeverSets = cosHourAngle < -1.0f;
+
+        if (sunNeverSets) {
+            sunriseHour = 0;
+            sunriseMinute = 0;
+            sunsetHour = 23;
+            sunsetMinute = 59;
+        } else if (sunNeverRises) {
+            sunriseHour = sunsetHour = 12;
+            sunriseMinute = sunsetMinute = 0;
+        } else {
+            // Minutes after UTC midnight
+            float solarNoon = 720.0f - 4.0f * cityLongitude - equationOfTime;
+            float halfDay = 4.0f * toDegrees(acosf(cosHourAngle));
+            setLocalTime(utcMidnight + lroundf((solarNoon - halfDay) * 60.0f), offset, sunriseHour, sunriseMinute);
+            setLocalTime(utcMidnight + lroundf((solarNoon + halfDay) * 60.0f), offset, sunsetHour, sunsetMinute);
+        }
+
+        haveDay = true;
+        computedDay = localDay;
+        computedOffset = offset;
+        computedLat = cityLatitude;
+        computedLon = cityLongitude;
+        LOG_INFO("Solar", "Sunrise %02d:%02d, sunset %02d:%02d%s", sunriseHour, sunriseMinute, sunsetHour, sunsetMinute,
+                 sunNeverSets ? " (polar day)" : sunNeverRises ? " (polar night)" : "");
+    }
+
+    void service() {
+        // The globals hold the first location's city here; nothing is swapped in
+        if (!timeInitialized || !cityCoordinatesKnown) {
+            return;
+        }
+        time_t now = getEpochTime();
+        if (now / 60 == lastCheckedMinute) {
+            return;
+        }
+        lastCheckedMinute = now / 60;
+
+        long offset = (long)(TimeZone::toLocal(now) - now);
+        long localDay = (long)((now + offset) / 86400);
+        if (haveDay && localDay == computedDay && offset == computedOffset &&
+            cityLatitude == computedLat && cityLongitude == computedLon) {
+            return;
+        }
+        computeDay(localDay, offset);
+    }
+
+    Phase phaseAt(int minuteOfDay) {
+        Phase phase;
+        if (haveDay && (sunNeverSets || sunNeverRises)) {
+            phase.daytime = sunNeverSets;
+            phase.progress = (uint8_t)(minuteOfDay * 255L / MINUTES_PER_DAY);
+            return phase;
+        }
+
+        // Modular minutes, so a day or night across midnight needs no special case
+        int sunrise = sunriseHour * 60 + sunriseMinute;
+        int sunset = sunsetHour * 60 + sunsetMinute;
+        int dayLength = (sunset - sunrise + MINUTES_PER_DAY) % MINUTES_PER_DAY;
+        int sinceSunrise = (minuteOfDay - sunrise + MINUTES_PER_DAY) % MINUTES_PER_DAY;
+
+        phase.daytime = sinceSunrise < dayLength;
+        if (phase.daytime) {
+            phase.progress = (uint8_t)(sinceSunrise * 255L / dayLength);
+        } else {
+            int sinceSunset = (minuteOfDay - sunset + MINUTES_PER_DAY) % MINUTES_PER_DAY;
+            phase.progress = (uint8_t)(sinceSunset * 255L / (MINUTES_PER_DAY - dayLength));
+        }
+        return phase;
+    }
+
+    float elevationAt(time_t utc) {
+        if (!haveDay) {
+            return NAN;
+        }
+        float minutesUtc = (float)(((utc % 86400) + 86400) % 86400) / 60.0f;
+        float trueSolarTime = fmodf(minutesUtc + equationOfTime + 4.0f * computedLon, (float)MINUTES_PER_DAY);
+        float hourAngle = toRadians(trueSolarTime / 4.0f - 180.0f);
+        float latitude = toRadians(computedLat);
+        float cosZenith = sinf(latitude) * sinf(declination) + cosf(latitude) * cosf(declination) * cosf(hourAngle);
+        return 90.0f - toDegrees(acosf(constrain(cosZenith, -1.0f, 1.0f)));
+    }
+
+    bool computed() {
+        return haveDay;
+    }
+
+    bool polarDay() {
+        return haveDay && sunNeverSets;
+    }
+
+    bool polarNight() {
+        return haveDay && sunNeverRises;
+    }
+}
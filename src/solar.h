@@ -0,0 +1,42 @@
+/*
+ * Solar ephemeris for ESP-01 Weather Display
+ * Sunrise, sunset and the sun's elevation from the NOAA solar calculator
+ * equations, for the coordinates the city was geocoded to. Worked out once
+ * per local day, so the time screen knows day from night without a weather
+ * fetch and keeps doing so offline.
+ */
+
+#ifndef SOLAR_H
+#define SOLAR_H
+
+#include <Arduino.h>
+#include <time.h>
+#include "config.h"
+
+namespace Solar {
+    // Recompute sunriseHour/Minute and sunsetHour/Minute when the local day,
+    // the time zone offset or the city's coordinates changed. Cheap when
+    // nothing did; call from the clock task.
+    void service();
+
+    // Where a local minute of the day falls between sunrise and sunset
+    struct Phase {
+        bool daytime;
+        uint8_t progress; // 0 at sunrise (sunset at night) .. 255 at the next sunset (sunrise)
+    };
+    Phase phaseAt(int minuteOfDay);
+
+    // Degrees of the sun above the horizon at a moment of the day computed
+    // last; NAN until a day was computed
+    float elevationAt(time_t utc);
+
+    // True once sunrise and sunset came from the ephemeris rather than the
+    // defaults or the boot snapshot
+    bool computed();
+
+    // No sunrise or sunset on the computed day (polar day or night)
+    bool polarDay();
+    bool polarNight();
+}
+
+#endif // SOLAR_H
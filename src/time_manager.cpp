@@ -3,216 +3,200 @@
  */
 
 #include "time_manager.h"
+#include "time_zone.h"
+#include "metrics.h"
+#include "logging.h"
 #include <time.h>
+#include <sys/time.h>
+#include <coredecls.h> // settimeofday_cb(), sntp_update_delay_MS_rfc_not_less_than_15000()
 
-// Setup NTP client
-void setupNTP() {
-  // Configure time zone and DST settings
-  configTime(0, 0, "pool.ntp.org", "time.nist.gov");
-  
-  // Initialize NTP client
-  timeClient.begin();
-  timeClient.setTimeOffset(0); // Set to UTC, we'll handle timezone later
-  
-  Serial.println("NTP client initialized");
+// SNTP poll interval: it starts short so the drift is learned quickly and
+// is lengthened while the corrected clock keeps matching NTP
+#define NTP_MIN_INTERVAL_MS (5UL * 60 * 1000)
+#define NTP_MAX_INTERVAL_MS (4UL * 60 * 60 * 1000)
+
+// Offset found at a sync below which the interval is doubled, and above
+// which it is halved again
+#define NTP_GOOD_OFFSET_MS 100
+#define NTP_BAD_OFFSET_MS 500
+
+// Shorter sync spacings are dominated by network jitter rather than drift
+#define NTP_MIN_DRIFT_SAMPLE_MS (60UL * 1000)
+
+// A rate error beyond this means the clock was stepped, not that it drifted
+#define NTP_MAX_DRIFT_PPM 1000.0f
+
+// Time over which drift samples are averaged, so the estimate can still
+// follow temperature changes
+#define NTP_DRIFT_WINDOW_MS (24UL * 60 * 60 * 1000)
+
+// Disciplined clock: UTC at the last sync plus millis() since, corrected
+// by the measured rate error of the oscillator
+static int64_t syncUtcMs = 0;
+static unsigned long syncMillis = 0;
+static float driftPpm = 0;           // Positive: millis() runs slow
+static float driftWeightMs = 0;      // Sample time behind driftPpm, capped at NTP_DRIFT_WINDOW_MS
+static long lastOffsetMs = 0;        // Corrected clock minus NTP at the last sync
+static uint32_t syncIntervalMs = NTP_MIN_INTERVAL_MS;
+static uint32_t syncs = 0;
+static int lastLoggedMinute = -1;
+
+// Filled in by the SNTP callback, consumed by updateCurrentTime()
+static volatile bool syncPending = false;
+static int64_t pendingUtcMs = 0;
+static unsigned long pendingMillis = 0;
+
+static int64_t clockUtcMs(unsigned long nowMillis) {
+  unsigned long elapsed = nowMillis - syncMillis;
+  return syncUtcMs + elapsed + (int64_t)(elapsed * driftPpm / 1e6f);
 }
 
-// Function to check if DST should be applied based on US rules
-bool shouldApplyDST(const struct tm* timeinfo) {
-    int month = timeinfo->tm_mon + 1;  // tm_mon is 0-based
-    int day = timeinfo->tm_mday;
-    
-    // April through October are definitely DST
-    if (month > 3 && month < 11) {
-        return true;
-    }
-    // March: DST starts on the second Sunday
-    else if (month == 3) {
-        // Calculate the day of the second Sunday
-        int weekday = timeinfo->tm_wday;
-        int secondSunday = 8 + (7 - ((weekday + 8 - 1) % 7));
-        return day >= secondSunday;
+// Runs from the SNTP stack when it has set the system time; only note the
+// moment, the work is done in the loop
+static void onTimeSet(bool fromSntp) {
+  if (!fromSntp) {
+    return;
+  }
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  pendingUtcMs = (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+  pendingMillis = millis();
+  syncPending = true;
+}
+
+// Fold a sync into the drift estimate and choose the next interval
+static void applySync() {
+  syncPending = false;
+  int64_t ntpMs = pendingUtcMs;
+  unsigned long nowMillis = pendingMillis;
+
+  if (timeInitialized) {
+    unsigned long elapsed = nowMillis - syncMillis;
+    lastOffsetMs = (long)(clockUtcMs(nowMillis) - ntpMs);
+
+    if (elapsed >= NTP_MIN_DRIFT_SAMPLE_MS) {
+      float sample = (float)((ntpMs - syncUtcMs) - (int64_t)elapsed) * 1e6f / elapsed;
+      if (fabsf(sample) < NTP_MAX_DRIFT_PPM) {
+        // Longer spacings give proportionally better samples
+        driftPpm = (driftPpm * driftWeightMs + sample * elapsed) / (driftWeightMs + elapsed);
+        driftWeightMs = min(driftWeightMs + elapsed, (float)NTP_DRIFT_WINDOW_MS);
+      } else {
+        LOG_WARN("Time", "Ignoring drift sample of %.0f ppm, clock was stepped", sample);
+      }
     }
-    // November: DST ends on the first Sunday
-    else if (month == 11) {
-        // Calculate the day of the first Sunday
-        int weekday = timeinfo->tm_wday;
-        int firstSunday = 1 + (7 - ((weekday + 1 - 1) % 7));
-        return day < firstSunday;
+
+    // Only stretch the interval once drift is known; back off fast when
+    // the clock was off
+    long offset = labs(lastOffsetMs);
+    if (offset > NTP_BAD_OFFSET_MS) {
+      syncIntervalMs = max(syncIntervalMs / 2, (uint32_t)NTP_MIN_INTERVAL_MS);
+    } else if (offset < NTP_GOOD_OFFSET_MS && driftWeightMs > 0) {
+      syncIntervalMs = min(syncIntervalMs * 2, (uint32_t)NTP_MAX_INTERVAL_MS);
     }
-    return false;
+  }
+
+  syncUtcMs = ntpMs;
+  syncMillis = nowMillis;
+  syncs++;
+
+  LOG_INFO("Time", "NTP sync %u: offset %ld ms, drift %.1f ppm, next sync in %u s",
+           syncs, lastOffsetMs, driftPpm, syncIntervalMs / 1000);
 }
 
-// Update time and date from NTP
-bool updateTimeAndDate() {
-  if (WiFi.status() != WL_CONNECTED) {
-    Serial.println("Cannot update time - WiFi not connected");
-    return false;
-  }
-  
-  Serial.println("[Time] Attempting to update time from NTP server...");
-  
-  // Directly use configTime to get proper time 
-  configTime(timezone * 3600, useDST ? 3600 : 0, "pool.ntp.org", "time.nist.gov");
-  
-  // Wait for time to be set
-  time_t now = time(nullptr);
-  int retry = 0;
-  while (now < 24 * 3600 && retry < 10) {
-    delay(500);
-    now = time(nullptr);
-    retry++;
-  }
-  
-  if (now < 24 * 3600) {
-    Serial.println("NTP time sync failed");
-    return false;
-  }
-  
-  // Get the time components directly
+// Set the display time variables from a UTC time
+static void setLocalTime(time_t utc) {
+  time_t local = TimeZone::toLocal(utc);
   struct tm timeinfo;
-  if (!getLocalTime(&timeinfo)) {
-    Serial.println("Failed to obtain time");
-    return false;
-  }
-  
-  // Update our time variables directly from the system time
+  gmtime_r(&local, &timeinfo);
+
   hours = timeinfo.tm_hour;
   minutes = timeinfo.tm_min;
   seconds = timeinfo.tm_sec;
   dayOfMonth = timeinfo.tm_mday;
   month = timeinfo.tm_mon + 1; // tm_mon is 0-based
   year = timeinfo.tm_year + 1900;
-  
-  // Get day of week (0 = Sunday, 1 = Monday, etc.)
-  int dayOfWeek = timeinfo.tm_wday;
-  
-  // Convert to string representations
-  dayOfWeekStr = getDayOfWeekShort(dayOfWeek);
-  monthStr = getMonthShort(month);
-  
+  getDayOfWeekShort(timeinfo.tm_wday, dayOfWeekStr);
+  getMonthShort(month, monthStr);
   currentHour = hours;
-  
-  timeInitialized = true;
-  lastSecondUpdate = millis();
-  lastTimeUpdate = millis();
-  
-  // Log current time
-  Serial.printf("[Time] Time set: %02d:%02d:%02d %s %s %d, %d\n", 
-      hours, minutes, seconds, dayOfWeekStr.c_str(), monthStr.c_str(), dayOfMonth, year);
-  Serial.printf("[Time] Timezone: UTC%s%g%s\n", 
-      timezone >= 0 ? "+" : "", timezone, 
-      useDST && shouldApplyDST(&timeinfo) ? " (DST active)" : "");
-  
+}
+
+// Queried by the SNTP stack each time it schedules the next request
+uint32_t sntp_update_delay_MS_rfc_not_less_than_15000() {
+  return syncIntervalMs;
+}
+
+// Start SNTP. It runs in the background from here on; syncs arrive in
+// onTimeSet() and time zone changes need no new request.
+void setupNTP() {
+  settimeofday_cb(onTimeSet);
+  configTime(0, 0, "pool.ntp.org", "time.nist.gov");
+  LOG_INFO("Time", "SNTP started");
+}
+
+// Refresh the time variables from the disciplined clock. Returns false
+// until the first NTP sync arrived. Never waits for the network.
+bool updateTimeAndDate() {
+  Metrics::ScopedTimer timer(METRIC_TIME_UPDATE);
+  if (syncPending) {
+    applySync();
+    timeInitialized = true;
+  }
+  if (!timeInitialized) {
+    return false;
+  }
+
+  unsigned long now = millis();
+  setLocalTime((time_t)(clockUtcMs(now) / 1000));
+  lastSecondUpdate = now;
+  lastTimeUpdate = now;
   return true;
 }
 
-// Update current time based on the last NTP sync (internal clock)
+// Advance the clock between NTP syncs; cheap enough to call several times a second
 void updateCurrentTime() {
-  if (!timeInitialized) return;
-  
-  // Calculate how many milliseconds have passed since last update
-  unsigned long currentMillis = millis();
-  unsigned long elapsedMs;
-  
-  // Handle millis() rollover
-  if (currentMillis < lastSecondUpdate) {
-    elapsedMs = (UINT_MAX - lastSecondUpdate) + currentMillis + 1;
-    
-    // Force time resync after rollover
-    if (WiFi.status() == WL_CONNECTED) {
-      updateTimeAndDate();
-      return;
-    }
-  } else {
-    elapsedMs = currentMillis - lastSecondUpdate;
+  if (!updateTimeAndDate()) {
+    return;
   }
-  
-  // Only update if at least one second has passed
-  if (elapsedMs >= 1000) {
-    // Calculate number of seconds to add
-    int secondsToAdd = elapsedMs / 1000;
-    
-    // Update the last second update time
-    lastSecondUpdate = currentMillis - (elapsedMs % 1000);
-    
-    // Add seconds and handle minute/hour overflow
-    seconds += secondsToAdd;
-    
-    while (seconds >= 60) {
-      seconds -= 60;
-      minutes++;
-      
-      // Log each minute change
-      Serial.printf("[Time] Current time: %02d:%02d\n", hours, minutes);
-      
-      if (minutes >= 60) {
-        minutes = 0;
-        hours++;
-        
-        Serial.printf("[Time] Hour changed to: %02d\n", hours);
-        
-        if (hours >= 24) {
-          hours = 0;
-          Serial.println("[Time] Day changed - triggering NTP resync");
-          
-          // At midnight, sync with NTP to handle date changes
-          if (WiFi.status() == WL_CONNECTED) {
-            updateTimeAndDate();
-          }
-        }
-      }
-    }
-    
-    // Update current hour for display
-    currentHour = hours;
-    
-    // Force NTP resync every 30 minutes to avoid drift
-    if (minutes % 30 == 0 && seconds < 10 && WiFi.status() == WL_CONNECTED) {
-      Serial.println("[Time] Scheduled resync to prevent drift");
-      updateTimeAndDate();
-    }
+
+  if (minutes != lastLoggedMinute) {
+    lastLoggedMinute = minutes;
+    LOG_DEBUG("Time", "Current time: %02d:%02d", hours, minutes);
   }
 }
 
-// Helper function to get day of week short name
-String getDayOfWeekShort(int dayNum) {
-  switch (dayNum) {
-    case 0: return "SUN";
-    case 1: return "MON";
-    case 2: return "TUE";
-    case 3: return "WED";
-    case 4: return "THU";
-    case 5: return "FRI";
-    case 6: return "SAT";
-    default: return "???";
-  }
+// Short day and month names; the last entry is for out-of-range numbers
+static const char DAY_NAMES[8][4] PROGMEM = { "SUN", "MON", "TUE", "WED", "THU", "FRI", "SAT", "???" };
+static const char MONTH_NAMES[13][4] PROGMEM = { "JAN", "FEB", "MAR", "APR", "MAY", "JUN",
+                                                 "JUL", "AUG", "SEP", "OCT", "NOV", "DEC", "???" };
+
+// Copy the short name of a day of the week (0 = Sunday) into buffer
+void getDayOfWeekShort(int dayNum, char* buffer) {
+  strcpy_P(buffer, DAY_NAMES[(dayNum >= 0 && dayNum < 7) ? dayNum : 7]);
 }
 
-// Helper function to get month short name
-String getMonthShort(int monthNum) {
-  switch (monthNum) {
-    case 1: return "JAN";
-    case 2: return "FEB";
-    case 3: return "MAR";
-    case 4: return "APR";
-    case 5: return "MAY";
-    case 6: return "JUN";
-    case 7: return "JUL";
-    case 8: return "AUG";
-    case 9: return "SEP";
-    case 10: return "OCT";
-    case 11: return "NOV";
-    case 12: return "DEC";
-    default: return "???";
-  }
+// Copy the short name of a month (1 = January) into buffer
+void getMonthShort(int monthNum, char* buffer) {
+  strcpy_P(buffer, MONTH_NAMES[(monthNum >= 1 && monthNum <= 12) ? monthNum - 1 : 12]);
 }
 
-// Get current epoch time
+// Current UTC time from the disciplined clock, or the system time before
+// the first sync
 time_t getEpochTime() {
-  time_t now;
-  time(&now);
-  return now;
+  if (!timeInitialized) {
+    return time(nullptr);
+  }
+  return (time_t)(clockUtcMs(millis()) / 1000);
+}
+
+// Clock statistics for /debug
+ClockStats clockStats() {
+  ClockStats stats;
+  stats.syncs = syncs;
+  stats.driftPpm = driftPpm;
+  stats.lastOffsetMs = lastOffsetMs;
+  stats.syncIntervalMs = syncIntervalMs;
+  stats.sinceSyncMs = syncs > 0 ? millis() - syncMillis : 0;
+  return stats;
 }
 
 // Format time string in either 12-hour or 24-hour format
@@ -229,45 +213,9 @@ void formatTimeString(char* buffer, int hour, int minute, bool use12Hour) {
   }
 }
 
-// Reset time when timezone changes
+// Apply a new time zone. The clock itself runs in UTC, so this only
+// recomputes the local time.
 void resetTimeWithNewTimezone() {
-  // Reset the time initialization flag to force a full update
-  timeInitialized = false;
-  
-  // Force an immediate update if WiFi is connected
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println("Resetting time with new timezone: " + String(timezone));
-    
-    // Reset the NTP client
-    timeClient.end();
-    timeClient.begin();
-    timeClient.setTimeOffset(0); // We handle timezone manually
-    
-    // Force an update
-    bool success = updateTimeAndDate();
-    if (success) {
-      Serial.println("Time reset successful with new timezone");
-    } else {
-      Serial.println("Time reset failed with new timezone");
-    }
-  } else {
-    Serial.println("Cannot reset time - WiFi not connected");
-  }
-}
-
-// Get local time with retry logic
-bool getLocalTime(struct tm * info) {
-  // Try up to 10 times to get a valid time
-  for (int i = 0; i < 10; i++) {
-    time_t now = time(nullptr);
-    struct tm *timeinfo = localtime(&now);
-    if (timeinfo) {
-      // Copy the data into the provided struct
-      memcpy(info, timeinfo, sizeof(struct tm));
-      return true;
-    }
-    delay(10);
-  }
-  
-  return false;
+  LOG_INFO("Time", "Applying time zone %s", TimeZone::rule());
+  updateTimeAndDate();
 }
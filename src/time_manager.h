@@ -1,6 +1,8 @@
 /*
  * Time Manager functions for ESP-01 Weather Display
- * Handles NTP synchronization and time tracking
+ * Keeps a disciplined clock: SNTP runs in the background, the oscillator's
+ * drift is measured between syncs and corrected, and the sync interval grows
+ * from minutes to hours once the drift is known
  */
 
 #ifndef TIME_MANAGER_H
@@ -9,25 +11,33 @@
 #include <Arduino.h>
 #include "config.h"
 
-// Initialize NTP client
+// Clock statistics for /debug
+struct ClockStats {
+  uint32_t syncs;
+  float driftPpm;               // Measured rate error of millis(), corrected
+  long lastOffsetMs;            // Corrected clock minus NTP at the last sync
+  uint32_t syncIntervalMs;      // Current SNTP poll interval
+  unsigned long sinceSyncMs;
+};
+
+// Start SNTP; call once the network is up
 void setupNTP();
 
-// Update time from NTP server
+// Refresh the time variables from the clock; false until the first sync
 bool updateTimeAndDate();
 
-// Update internal clock between NTP syncs
+// Advance the time variables between NTP syncs
 void updateCurrentTime();
 
-// Reset time when timezone changes
+// Apply a changed time zone, see TimeZone::set()
 void resetTimeWithNewTimezone();
 
-// Helper functions for time display
-String getDayOfWeekShort(int dayNum);
-String getMonthShort(int monthNum);
-time_t getEpochTime();
+ClockStats clockStats();
 
-// Function to check if DST should be applied
-bool shouldApplyDST(const struct tm* timeinfo);
+// Helper functions for time display; buffer must hold 4 characters
+void getDayOfWeekShort(int dayNum, char* buffer);
+void getMonthShort(int monthNum, char* buffer);
+time_t getEpochTime();
 
 // Function to format time in 12-hour format with AM/PM
 void formatTimeString(char* buffer, int hour, int minute, bool use12Hour);
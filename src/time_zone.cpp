@@ -0,0 +1,451 @@
+/*
+ * Implementation of the time zone rules
+ */
+
+#include "time_zone.h"
+#include "logging.h"
+#include <time.h>
+
+// Longest abbreviation kept, without the NUL
+#define TZ_MAX_NAME 7
+
+namespace TimeZone {
+    // When in the year a change happens, as the POSIX rule spells it
+    struct DateRule {
+        enum Kind : uint8_t {
+            MONTH_WEEK_DAY,   // Mm.w.d: day d (0 = Sunday) of week w (5 = last) of month m
+            JULIAN_NO_LEAP,   // Jn: day 1..365, February 29 never counted
+            ZERO_BASED        // n: day 0..365, February 29 counted
+        };
+        Kind kind;
+        uint8_t month;
+        uint8_t week;
+        uint8_t weekday;
+        uint16_t yearDay;
+        long timeSeconds;     // Local wall clock time of the change, may be negative or past 24h
+    };
+
+    struct Zone {
+        char stdName[TZ_MAX_NAME + 1];
+        char dstName[TZ_MAX_NAME + 1];
+        long stdOffset;       // Seconds east of UTC
+        long dstOffset;
+        bool hasDst;
+        bool dstAllYear;      // Changes at the very start and end of the year, see parse()
+        DateRule start;       // Into daylight saving time
+        DateRule end;         // Back to standard time
+    };
+
+    static Zone zone = { "UTC", "", 0, 0, false, false, {}, {} };
+    static char ruleText[TZ_MAX_LENGTH + 1] = "UTC0";
+
+    // Offset cache: valid for UTC times in [cacheFrom, cacheUntil)
+    static bool cacheValid = false;
+    static time_t cacheFrom = 0;
+    static time_t cacheUntil = 0;
+    static long cacheOffset = 0;
+    static bool cacheDst = false;
+
+    // --- Parsing ---
+
+    static bool parseName(const char*& p, char* name) {
+        size_t n = 0;
+        if (*p == '<') {
+            // Quoted form, may hold digits and signs: <+0530>
+            p++;
+            while (*p && *p != '>') {
+                if (n == TZ_MAX_NAME || !(isalnum(*p) || *p == '+' || *p == '-')) {
+                    return false;
+                }
+                name[n++] = *p++;
+            }
+            if (*p != '>') {
+                return false;
+            }
+            p++;
+        } else {
+            while (isalpha(*p)) {
+                if (n == TZ_MAX_NAME) {
+                    return false;
+                }
+                name[n++] = *p++;
+            }
+        }
+        name[n] = '\0';
+        return n >= 3;
+    }
+
+    // [+-]hh[:mm[:ss]] in seconds
+    static bool parseTime(const char*& p, long& seconds, int maxHours) {
+        int sign = 1;
+        if (*p == '+' || *p == '-') {
+            sign = (*p == '-') ? -1 : 1;
+            p++;
+        }
+        if (!isdigit(*p)) {
+            return false;
+        }
+        long fields[3] = { 0, 0, 0 };
+        for (int field = 0; field < 3; field++) {
+            if (field > 0) {
+                if (*p != ':') {
+                    break;
+                }
+                p++;
+            }
+            if (!isdigit(*p)) {
+                return false;
+            }
+            long value = 0;
+            while (isdigit(*p)) {
+                value = value * 10 + (*p++ - '0');
+                if (value > 999) {
+                    return false;
+                }
+            }
+            fields[field] = value;
+        }
+        if (fields[0] > maxHours || fields[1] > 59 || fields[2] > 59) {
+            return false;
+        }
+        seconds = sign * (fields[0] * 3600 + fields[1] * 60 + fields[2]);
+        return true;
+    }
+
+    static bool parseNumber(const char*& p, long& value, long low, long high) {
+        if (!isdigit(*p)) {
+            return false;
+        }
+        value = 0;
+        while (isdigit(*p)) {
+            value = value * 10 + (*p++ - '0');
+            if (value > high) {
+                return false;
+            }
+        }
+        return value >= low;
+    }
+
+    static bool parseDateRule(const char*& p, DateRule& rule) {
+        long value;
+        if (*p == 'M') {
+            long week, weekday;
+            p++;
+            if (!parseNumber(p, value, 1, 12) || *p++ != '.' ||
+                !parseNumber(p, week, 1, 5) || *p++ != '.' ||
+                !parseNumber(p, weekday, 0, 6)) {
+                return false;
+            }
+            rule.kind = DateRule::MONTH_WEEK_DAY;
+            rule.month = value;
+            rule.week = week;
+            rule.weekday = weekday;
+        } else if (*p == 'J') {
+            p++;
+            if (!parseNumber(p, value, 1, 365)) {
+                return false;
+            }
+            rule.kind = DateRule::JULIAN_NO_LEAP;
+            rule.yearDay = value;
+        } else {
+            if (!parseNumber(p, value, 0, 365)) {
+                return false;
+            }
+            rule.kind = DateRule::ZERO_BASED;
+            rule.yearDay = value;
+        }
+
+        rule.timeSeconds = 2 * 3600; // POSIX default, 02:00
+        if (*p == '/') {
+            p++;
+            // Hours up to 167 and negative times are the RFC 8536 extension
+            if (!parseTime(p, rule.timeSeconds, 167)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // std offset [dst [offset] [,start[/time],end[/time]]]
+    static bool parse(const char* text, Zone& out) {
+        const char* p = text;
+        long offset;
+
+        memset(&out, 0, sizeof(out));
+        if (!parseName(p, out.stdName) || !parseTime(p, offset, 24)) {
+            return false;
+        }
+        out.stdOffset = -offset; // POSIX counts hours west of UTC
+
+        if (*p == '\0') {
+            return true;
+        }
+
+        if (!parseName(p, out.dstName)) {
+            return false;
+        }
+        out.hasDst = true;
+        out.dstOffset = out.stdOffset + 3600;
+        if (*p != ',' && *p != '\0') {
+            if (!parseTime(p, offset, 24)) {
+                return false;
+            }
+            out.dstOffset = -offset;
+        }
+
+        if (*p == '\0') {
+            // No rule given; POSIX leaves it to the implementation, glibc uses the US one
+            const char* usRule = ",M3.2.0,M11.1.0";
+            p = usRule;
+        }
+        if (*p++ != ',' || !parseDateRule(p, out.start) || *p++ != ',' || !parseDateRule(p, out.end)) {
+            return false;
+        }
+
+        // DST from January 1 00:00 to December 31 24:00 plus the DST shift,
+        // e.g. J1/0,J365/25, stands for DST all year (RFC 8536). The end then
+        // falls on or after the next start, which the year-by-year search
+        // cannot order, so it is kept as a fixed offset.
+        bool startsWithYear = (out.start.kind == DateRule::JULIAN_NO_LEAP && out.start.yearDay == 1) ||
+                              (out.start.kind == DateRule::ZERO_BASED && out.start.yearDay == 0);
+        bool endsWithYear = out.end.kind != DateRule::MONTH_WEEK_DAY && out.end.yearDay == 365;
+        out.dstAllYear = startsWithYear && endsWithYear &&
+                         out.end.timeSeconds - out.dstOffset >= 86400 + out.start.timeSeconds - out.stdOffset;
+        return *p == '\0';
+    }
+
+    // --- Calendar ---
+
+    static bool isLeapYear(int year) {
+        return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    }
+
+    static int daysInMonth(int year, int month) {
+        static const uint8_t DAYS[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+        return (month == 2 && isLeapYear(year)) ? 29 : DAYS[month - 1];
+    }
+
+    // Days from 1970-01-01 to a date of the proleptic Gregorian calendar
+    static long daysFromCivil(int year, int month, int day) {
+        year -= month <= 2;
+        long era = (year >= 0 ? year : year - 399) / 400;
+        long yearOfEra = year - era * 400;
+        long dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+        return era * 146097 + dayOfEra - 719468;
+    }
+
+    // Day of the week of a day number, 0 = Sunday; 1970-01-01 was a Thursday
+    static int weekdayOf(long days) {
+        return (int)((days % 7 + 11) % 7);
+    }
+
+    // Day number on which a rule falls in a year
+    static long ruleDay(const DateRule& rule, int year) {
+        switch (rule.kind) {
+            case DateRule::JULIAN_NO_LEAP: {
+                long day = daysFromCivil(year, 1, 1) + rule.yearDay - 1;
+                return (isLeapYear(year) && rule.yearDay >= 60) ? day + 1 : day;
+            }
+            case DateRule::ZERO_BASED:
+                return daysFromCivil(year, 1, 1) + rule.yearDay;
+            default: {
+                long first = daysFromCivil(year, rule.month, 1);
+                int dayOfMonth = 1 + (rule.weekday - weekdayOf(first) + 7) % 7 + (rule.week - 1) * 7;
+                // Week 5 means the last such day, which may be in week 4
+                while (dayOfMonth > daysInMonth(year, rule.month)) {
+                    dayOfMonth -= 7;
+                }
+                return first + dayOfMonth - 1;
+            }
+        }
+    }
+
+    // UTC instant of a change; the rule's time is on the clock that is
+    // in force just before it
+    static time_t transitionUtc(const DateRule& rule, int year, long offsetBefore) {
+        return (time_t)ruleDay(rule, year) * 86400 + rule.timeSeconds - offsetBefore;
+    }
+
+    // Fill the cache for the period that contains utc
+    static void refreshCache(time_t utc) {
+        struct tm utcTm;
+        gmtime_r(&utc, &utcTm);
+        int year = utcTm.tm_year + 1900;
+
+        // The changes of the previous, current and next year surround utc
+        // whichever hemisphere the zone is in
+        struct Change {
+            time_t at;
+            bool dst;
+        } changes[6];
+        int count = 0;
+        for (int y = year - 1; y <= year + 1; y++) {
+            changes[count++] = { transitionUtc(zone.start, y, zone.stdOffset), true };
+            changes[count++] = { transitionUtc(zone.end, y, zone.dstOffset), false };
+        }
+        for (int i = 1; i < count; i++) {
+            Change change = changes[i];
+            int j = i;
+            for (; j > 0 && changes[j - 1].at > change.at; j--) {
+                changes[j] = changes[j - 1];
+            }
+            changes[j] = change;
+        }
+
+        int current = 0;
+        while (current + 1 < count && changes[current + 1].at <= utc) {
+            current++;
+        }
+        cacheFrom = changes[current].at;
+        cacheUntil = changes[current + 1].at;
+        cacheDst = changes[current].dst;
+        cacheOffset = cacheDst ? zone.dstOffset : zone.stdOffset;
+        cacheValid = true;
+    }
+
+    static void lookup(time_t utc) {
+        if (!cacheValid || utc < cacheFrom || utc >= cacheUntil) {
+            refreshCache(utc);
+        }
+    }
+
+    // --- Interface ---
+
+    bool isValid(const char* rule) {
+        Zone parsed;
+        return rule != nullptr && strlen(rule) <= TZ_MAX_LENGTH && parse(rule, parsed);
+    }
+
+    bool set(const char* rule) {
+        Zone parsed;
+        if (rule == nullptr || strlen(rule) > TZ_MAX_LENGTH || !parse(rule, parsed)) {
+            LOG_WARN("TZ", "Rejected time zone \"%s\"", rule ? rule : "");
+            return false;
+        }
+        zone = parsed;
+        strcpy(ruleText, rule);
+        cacheValid = false;
+        LOG_INFO("TZ", "Time zone %s", ruleText);
+        return true;
+    }
+
+    const char* rule() {
+        return ruleText;
+    }
+
+    long offsetAt(time_t utc) {
+        if (!zone.hasDst) {
+            return zone.stdOffset;
+        }
+        if (zone.dstAllYear) {
+            return zone.dstOffset;
+        }
+        lookup(utc);
+        return cacheOffset;
+    }
+
+    time_t toLocal(time_t utc) {
+        return utc + offsetAt(utc);
+    }
+
+    long localDay(time_t utc) {
+        // Floor division, so times before 1970 land on the day they are in
+        time_t local = toLocal(utc);
+        return (long)(local / 86400 - (local % 86400 < 0));
+    }
+
+    bool isDst(time_t utc) {
+        if (!zone.hasDst || zone.dstAllYear) {
+            return zone.dstAllYear;
+        }
+        lookup(utc);
+        return cacheDst;
+    }
+
+    const char* abbreviation(time_t utc) {
+        return isDst(utc) ? zone.dstName : zone.stdName;
+    }
+
+    time_t nextTransition(time_t utc) {
+        if (!zone.hasDst || zone.dstAllYear) {
+            return 0;
+        }
+        lookup(utc);
+        return cacheUntil;
+    }
+
+    void formatOffset(long offsetSeconds, char* buffer) {
+        // Offsets stay within a day; the clamp also bounds the text for the compiler
+        unsigned minutes = (unsigned)(labs(offsetSeconds) / 60);
+        if (minutes > 24 * 60 - 1) {
+            minutes = 24 * 60 - 1;
+        }
+        snprintf(buffer, 10, "UTC%c%02u:%02u", offsetSeconds < 0 ? '-' : '+', minutes / 60, minutes % 60);
+    }
+
+    // Numeric abbreviation and POSIX offset of a zone without a name: <+0530>-5:30
+    static size_t writeNumericZone(char* buffer, size_t size, long offsetSeconds, bool withOffset) {
+        long minutes = labs(offsetSeconds) / 60;
+        char sign = offsetSeconds < 0 ? '-' : '+';
+        char posixSign = offsetSeconds < 0 ? '\0' : '-';
+        int n = (minutes % 60) ? snprintf(buffer, size, "<%c%02ld%02ld>", sign, minutes / 60, minutes % 60)
+                               : snprintf(buffer, size, "<%c%02ld>", sign, minutes / 60);
+        if (withOffset && n > 0 && (size_t)n < size) {
+            char posix[2] = { posixSign, '\0' };
+            n += (minutes % 60) ? snprintf(buffer + n, size - n, "%s%ld:%02ld", posix, minutes / 60, minutes % 60)
+                                : snprintf(buffer + n, size - n, "%s%ld", posix, minutes / 60);
+        }
+        return n > 0 ? (size_t)n : 0;
+    }
+
+    // Zones with daylight saving time that older firmware users are most
+    // likely in, by their offset in quarter hours
+    struct LegacyZone {
+        int8_t quarters;
+        const char* rule;
+    };
+    static const LegacyZone LEGACY_DST_ZONES[] = {
+        { -36, "AKST9AKDT,M3.2.0,M11.1.0" },
+        { -32, "PST8PDT,M3.2.0,M11.1.0" },
+        { -28, "MST7MDT,M3.2.0,M11.1.0" },
+        { -24, "CST6CDT,M3.2.0,M11.1.0" },
+        { -20, "EST5EDT,M3.2.0,M11.1.0" },
+        { -16, "AST4ADT,M3.2.0,M11.1.0" },
+        { -14, "NST3:30NDT,M3.2.0,M11.1.0" },
+        { 0, "GMT0BST,M3.5.0/1,M10.5.0" },
+        { 4, "CET-1CEST,M3.5.0,M10.5.0/3" },
+        { 8, "EET-2EEST,M3.5.0/3,M10.5.0/4" },
+        { 38, "ACST-9:30ACDT,M10.1.0,M4.1.0/3" },
+        { 40, "AEST-10AEDT,M10.1.0,M4.1.0/3" },
+        { 48, "NZST-12NZDT,M9.5.0,M4.1.0/3" },
+    };
+
+    void fromLegacy(float offsetHours, bool useDst, char* buffer, size_t size) {
+        long offsetSeconds = lroundf(offsetHours * 4) * 900;
+        if (useDst) {
+            for (const LegacyZone& legacy : LEGACY_DST_ZONES) {
+                if (legacy.quarters * 900L == offsetSeconds) {
+                    strncpy(buffer, legacy.rule, size - 1);
+                    buffer[size - 1] = '\0';
+                    return;
+                }
+            }
+        }
+
+        if (!useDst && offsetSeconds == 0) {
+            strncpy(buffer, "UTC0", size - 1);
+            buffer[size - 1] = '\0';
+            return;
+        }
+
+        size_t n = writeNumericZone(buffer, size, offsetSeconds, true);
+        if (useDst && n < size) {
+            n += writeNumericZone(buffer + n, size - n, offsetSeconds + 3600, false);
+            if (n < size) {
+                strncpy(buffer + n, ",M3.2.0,M11.1.0", size - n - 1);
+                buffer[size - 1] = '\0';
+            }
+        }
+    }
+}
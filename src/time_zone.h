@@ -0,0 +1,58 @@
+/*
+ * Time zone rules for ESP-01 Weather Display
+ * The zone is a POSIX TZ string such as "CET-1CEST,M3.5.0,M10.5.0/3". The
+ * offset in force and the instants where it last changed and next changes
+ * are cached, so converting a time is one offset add until a transition.
+ */
+
+#ifndef TIME_ZONE_H
+#define TIME_ZONE_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Longest TZ string kept, without the NUL
+#define TZ_MAX_LENGTH 47
+
+// Used when nothing valid is stored: US Eastern, what older firmware defaulted to
+#define TZ_DEFAULT "EST5EDT,M3.2.0,M11.1.0"
+
+namespace TimeZone {
+    // Check a TZ string without applying it
+    bool isValid(const char* rule);
+
+    // Apply a TZ string. Returns false and keeps the current zone if it does
+    // not parse.
+    bool set(const char* rule);
+
+    // The TZ string in use
+    const char* rule();
+
+    // Local time for a UTC time, and the offset that applies, in seconds east of UTC
+    time_t toLocal(time_t utc);
+    long offsetAt(time_t utc);
+
+    // Local day number (days since 1970-01-01) of a UTC time; a division
+    // instead of a gmtime()/localtime() call per forecast entry
+    long localDay(time_t utc);
+
+    // True if daylight saving time is in force at utc
+    bool isDst(time_t utc);
+
+    // Abbreviation in force at utc, e.g. "CEST"
+    const char* abbreviation(time_t utc);
+
+    // UTC instant of the next offset change after utc; 0 if the zone has none
+    time_t nextTransition(time_t utc);
+
+    // Write an offset as "UTC+05:30"; buffer must hold 10 characters. Offsets
+    // are clamped to 23:59.
+    void formatOffset(long offsetSeconds, char* buffer);
+
+    // Build a TZ string from the offset in hours and DST flag that older
+    // firmware stored. Zones whose DST rule is well known get it; any other
+    // zone with DST keeps the US rule, which is what it used to get.
+    void fromLegacy(float offsetHours, bool useDst, char* buffer, size_t size);
+}
+
+#endif // TIME_ZONE_H
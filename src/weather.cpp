@@ -1,434 +1,498 @@
 /*
  * Implementation of Weather functions
+ * Drives the requests of the active weather provider
  */
 
 #include "weather.h"
+#include "weather_provider.h"
 #include "time_manager.h"
-#include <ESP8266HTTPClient.h>
-#include <WiFiClient.h>
-#include <ArduinoJson.h>
+#include "http_fetch.h"
+#include "weather_snapshot.h"
+#include "locations.h"
+#include "settings.h"
+#include "display.h"
+#include "metrics.h"
+#include "logging.h"
 #include <time.h>
-#include <algorithm> // For std::min
 
-// Define the size for JSON documents - reduce these values to handle memory constraints
-// For ESP8266, we need to be careful with memory usage
-#define CURRENT_WEATHER_JSON_SIZE 1024
-#define FORECAST_JSON_SIZE 1024
+// Longest time a single serviceWeatherUpdate() call may spend on the fetch
+#define WEATHER_FETCH_SLICE_MS 8
+
+// How long an error message stays on the display
+#define ERROR_SCREEN_MS 3000
+
+// Endpoints whose cache validators are remembered (OpenWeatherMap uses two
+// per location)
+#define RESPONSE_CACHE_ENTRIES (LOCATIONS_MAX * 2)
 
 namespace Weather {
     // Function prototypes
-    static void trimString(String &str);
-    static bool isValidCityName(const String &city);
-
-    // Helper function to get weather icon type based on condition string
-    byte getWeatherIconType(const String& condition) {
-        if (condition.equalsIgnoreCase("Clear")) {
-            return 0; // Sunny
-        } else if (condition.equalsIgnoreCase("Clouds") || condition.indexOf("few") >= 0 || condition.indexOf("scattered") >= 0) {
-            return 1; // Partly cloudy
-        } else if (condition.indexOf("broken") >= 0 || condition.indexOf("overcast") >= 0) {
-            return 2; // Cloudy
-        } else if (condition.equalsIgnoreCase("Mist") || condition.equalsIgnoreCase("Fog") || condition.equalsIgnoreCase("Haze")) {
-            return 3; // Foggy
-        } else if (condition.equalsIgnoreCase("Rain") || condition.equalsIgnoreCase("Drizzle") || condition.indexOf("shower") >= 0) {
-            return 4; // Rainy
-        } else if (condition.equalsIgnoreCase("Snow") || condition.indexOf("snow") >= 0) {
-            return 5; // Snowy
-        } else {
-            return 0; // Default to sunny
+    static void finishUpdate(bool success);
+    static void beginNextRequest();
+
+    // Provider running the current update, nullptr when idle
+    static WeatherProvider* runningProvider = nullptr;
+    static bool lastUpdateOk = false;
+    static unsigned long updateStartedAt = 0;
+    static unsigned long longestStall = 0;
+
+    // Locations are fetched one after another; the next one starts on the
+    // following serviceWeatherUpdate() call, so a call starts one request at most
+    static uint8_t updateIndex = 0;
+    static bool locationPending = false;
+
+    // Largest free heap block before and after the last update (fragmentation check)
+    static uint32_t maxFreeBlockBefore = 0;
+    static uint32_t maxFreeBlockAfter = 0;
+
+    // Memory statistics for the last update
+    static size_t updatePeakDocBytes = 0;
+    static uint32_t updateMinFreeHeap = 0;
+
+    // Error message from showWeatherError(), waiting for the display task
+    // or on the panel since errorShownAt. 21 characters of 6x10 fill a line.
+    enum ErrorScreenState : uint8_t { ERROR_SCREEN_NONE, ERROR_SCREEN_PENDING, ERROR_SCREEN_SHOWN };
+    static ErrorScreenState errorScreen = ERROR_SCREEN_NONE;
+    static char errorLines[4][24];
+    static unsigned long errorShownAt = 0;
+
+    // Validators of the last full response per endpoint, so unchanged data is
+    // neither downloaded nor parsed again
+    struct CacheEntry {
+        uint32_t key;             // Hash of host and path, 0 = unused
+        char etag[48];
+        char lastModified[32];
+        unsigned long storedAt;   // millis() when the freshness lifetime started
+        unsigned long maxAgeMs;   // Freshness lifetime from Cache-Control, 0 = revalidate
+        unsigned long lastUsed;
+        long bodyBytes;           // Size of the last full body, counted as saved on a hit
+    };
+
+    static CacheEntry responseCache[RESPONSE_CACHE_ENTRIES];
+    static uint32_t pendingCacheKey = 0; // Key of the running request, 0 = not cached
+    static CacheStats cacheStats = {0, 0, 0, 0};
+
+    WeatherProvider& activeProvider() {
+        if (weatherProvider == WEATHER_PROVIDER_OPENMETEO) {
+            return openMeteoProvider();
         }
+        return openWeatherMapProvider();
+    }
+
+    const char* providerName() {
+        return activeProvider().name();
     }
 
-    // Helper function to trim whitespace from beginning and end of a string
-    static void trimString(String &str) {
-        while (str.length() > 0 && isSpace(str.charAt(0))) {
-            str.remove(0, 1);
+    void sampleHeap() {
+        uint32_t freeHeap = ESP.getFreeHeap();
+        if (freeHeap < updateMinFreeHeap) {
+            updateMinFreeHeap = freeHeap;
         }
-        while (str.length() > 0 && isSpace(str.charAt(str.length() - 1))) {
-            str.remove(str.length() - 1);
+    }
+
+    void showWeatherError(const char* line1, const char* line2, const char* line3, const char* line4) {
+        // Called from inside a provider step; the display task draws it
+        const char* lines[4] = { line1, line2, line3, line4 };
+        for (int i = 0; i < 4; i++) {
+            snprintf(errorLines[i], sizeof(errorLines[i]), "%s", lines[i]);
         }
+        errorScreen = ERROR_SCREEN_PENDING;
     }
 
-    // Helper function to check if city name is valid
-    static bool isValidCityName(const String &city) {
-        if (city.length() == 0 || city == "_") {
+    bool serviceErrorScreen() {
+        if (errorScreen == ERROR_SCREEN_NONE) {
             return false;
         }
-        
-        // Check if city contains at least one alphanumeric character
-        for (size_t i = 0; i < city.length(); i++) {
-            if (isAlphaNumeric(city.charAt(i))) {
-                return true;
-            }
+        if (errorScreen == ERROR_SCREEN_PENDING) {
+            // Drawn once per page in page buffer mode
+            u8g2.firstPage();
+            do {
+                u8g2.setFont(u8g2_font_6x10_tf);
+                u8g2.drawStr(0, 10, errorLines[0]);
+                u8g2.drawStr(0, 25, errorLines[1]);
+                u8g2.drawStr(0, 40, errorLines[2]);
+                u8g2.drawStr(0, 55, errorLines[3]);
+            } while (u8g2.nextPage());
+            errorScreen = ERROR_SCREEN_SHOWN;
+            errorShownAt = millis();
+            return true;
         }
-        
+        if (millis() - errorShownAt < ERROR_SCREEN_MS) {
+            return true;
+        }
+        errorScreen = ERROR_SCREEN_NONE;
+        invalidateDisplay();
         return false;
     }
 
-    // Fetch weather data from OpenWeatherMap
-    bool fetchWeatherData() {
-        if (WiFi.status() != WL_CONNECTED) {
-            Serial.println("Cannot fetch weather - WiFi not connected");
-            return false;
+    // Store the coordinates looked up during the update; flash is only
+    // written for the records that changed. The settings record is filled
+    // from the globals, so this only runs once the update is over and no
+    // other location is swapped in.
+    static void saveCoordinates() {
+        if (runningProvider || !geocodeMatcher.resolved) {
+            return;
         }
+        geocodeMatcher.resolved = false;
+        Settings& settings = SettingsStore::get();
+        settings.latitude = cityCoordinatesKnown ? cityLatitude : 0;
+        settings.longitude = cityCoordinatesKnown ? cityLongitude : 0;
+        settings.coordinatesKnown = cityCoordinatesKnown ? 1 : 0;
+        SettingsStore::save();
+        Locations::save();
+    }
+
+    // Log the freshly applied weather data
+    static void logWeather() {
+        const char* unit = useMetricUnits ? "°C" : "°F";
+        LOG_INFO("Weather", "Weather data successfully retrieved from %s", runningProvider->name());
+        LOG_INFO("Weather", "Now %d%s, %s, high %d%s, low %d%s",
+                 currentTemp, unit, currentCondition, highTemp, unit, lowTemp, unit);
         
-        // Check if API key is available
-        if (API_KEY.length() < 5) {
-            Serial.println("ERROR: No valid OpenWeatherMap API key found!");
-            
-            // Display error message on screen
-            u8g2.clearBuffer();
-            u8g2.setFont(u8g2_font_6x10_tf);
-            u8g2.drawStr(0, 10, "Missing API Key!");
-            u8g2.drawStr(0, 25, "Please set your own");
-            u8g2.drawStr(0, 40, "OpenWeatherMap API key");
-            u8g2.drawStr(0, 55, "in settings page");
-            u8g2.sendBuffer();
-            delay(3000);
-            return false;
+        // Log forecast data
+        for (int i = 0; i < 5; i++) {
+            if (forecast[i].temp > -999) {
+                LOG_DEBUG("Weather", "Forecast %s: high %d%s, low %d%s",
+                          forecast[i].day, forecast[i].temp, unit, forecast[i].lowTemp, unit);
+            }
         }
-        
-        // Trim whitespace from city and state names
-        trimString(cityName);
-        trimString(stateName);
-        
-        // Check if city name is valid
-        if (!isValidCityName(cityName)) {
-            Serial.println("ERROR: City name is empty or invalid, setting to default 'New York'");
-            cityName = "New York";
-            
-            // Display error message on screen
-            u8g2.clearBuffer();
-            u8g2.setFont(u8g2_font_6x10_tf);
-            u8g2.drawStr(0, 10, "Invalid city name!");
-            u8g2.drawStr(0, 25, "Please update settings");
-            u8g2.drawStr(0, 40, "at config portal");
-            u8g2.drawStr(0, 55, "Using: New York");
-            u8g2.sendBuffer();
-            delay(3000);
+    }
+
+    // FNV-1a over host and path; 0 is reserved for "not cached"
+    static uint32_t cacheKey(const char* host, const String& path) {
+        uint32_t hash = 2166136261u;
+        for (const char* p = host; *p; p++) {
+            hash = (hash ^ (uint8_t)*p) * 16777619u;
         }
-        
-        // Sanitize city and state names
-        String cleanCity = cityName;
-        String cleanState = stateName;
-        
-        // Remove any non-printable or problematic characters
-        for (size_t i = 0; i < cleanCity.length(); i++) {
-            if (!isprint(cleanCity[i]) || cleanCity[i] == ',' || cleanCity[i] == '&') {
-                cleanCity.setCharAt(i, '_');
-            }
+        for (size_t i = 0; i < path.length(); i++) {
+            hash = (hash ^ (uint8_t)path[i]) * 16777619u;
         }
-        
-        for (size_t i = 0; i < cleanState.length(); i++) {
-            if (!isprint(cleanState[i]) || cleanState[i] == ',' || cleanState[i] == '&') {
-                cleanState.setCharAt(i, '_');
+        return hash ? hash : 1;
+    }
+
+    static CacheEntry* findCacheEntry(uint32_t key) {
+        if (key == 0) {
+            return nullptr;
+        }
+        for (int i = 0; i < RESPONSE_CACHE_ENTRIES; i++) {
+            if (responseCache[i].key == key) {
+                return &responseCache[i];
             }
         }
-        
-        // If city is just underscores or empty after cleaning, use default
-        bool hasValidChar = false;
-        for (size_t i = 0; i < cleanCity.length(); i++) {
-            if (cleanCity[i] != '_') {
-                hasValidChar = true;
+        return nullptr;
+    }
+
+    // Matching entry, else an unused one, else the least recently used
+    static CacheEntry* claimCacheEntry(uint32_t key) {
+        CacheEntry* entry = findCacheEntry(key);
+        if (entry) {
+            return entry;
+        }
+        entry = &responseCache[0];
+        for (int i = 0; i < RESPONSE_CACHE_ENTRIES; i++) {
+            if (responseCache[i].key == 0) {
+                entry = &responseCache[i];
                 break;
             }
+            if (responseCache[i].lastUsed - entry->lastUsed > 0x80000000UL) {
+                entry = &responseCache[i];
+            }
         }
-        
-        if (!hasValidChar || cleanCity.length() == 0) {
-            Serial.println("WARNING: City name contains only underscores or is empty after sanitizing");
-            Serial.println("Using default city: New York");
-            cleanCity = "New York";
-            cityName = "New York"; // Update the global variable too
+        memset(entry, 0, sizeof(CacheEntry));
+        entry->key = key;
+        return entry;
+    }
+
+    static bool isFresh(const CacheEntry* entry) {
+        return entry->maxAgeMs > 0 && millis() - entry->storedAt < entry->maxAgeMs;
+    }
+
+    // Restart the freshness lifetime from the headers of the last response
+    static void refreshLifetime(CacheEntry* entry) {
+        long maxAge = HttpFetch::maxAgeSeconds();
+        entry->storedAt = millis();
+        entry->maxAgeMs = maxAge > 0 ? (unsigned long)maxAge * 1000UL : 0;
+    }
+
+    // Remember the validators of a finished request
+    static void recordResponse(int httpCode) {
+        if (httpCode == HTTP_CODE_OK) {
+            cacheStats.fullFetches++;
         }
-        
-        WiFiClient client;
-        HTTPClient http;
-        
-        // URL encode the city and state names to handle spaces and special characters
-        String encodedCity = "";
-        String encodedState = "";
-        
-        // Simple URL encoding for spaces and special characters
-        for (size_t i = 0; i < cleanCity.length(); i++) {
-            if (cleanCity[i] == ' ') {
-                encodedCity += "%20";
-            } else if (isAlphaNumeric(cleanCity[i]) || cleanCity[i] == '_' || cleanCity[i] == '.') {
-                encodedCity += cleanCity[i];
-            } else {
-                // Convert other special characters to percent encoding
-                char hex[4];
-                sprintf(hex, "%%%02X", (unsigned char)cleanCity[i]);
-                encodedCity += hex;
+        if (pendingCacheKey == 0) {
+            return;
+        }
+
+        if (httpCode == HTTP_CODE_NOT_MODIFIED) {
+            CacheEntry* entry = findCacheEntry(pendingCacheKey);
+            cacheStats.notModified++;
+            if (entry) {
+                cacheStats.bytesSaved += entry->bodyBytes;
+                entry->lastUsed = millis();
+                refreshLifetime(entry);
             }
+            return;
         }
-        
-        for (size_t i = 0; i < cleanState.length(); i++) {
-            if (cleanState[i] == ' ') {
-                encodedState += "%20";
-            } else if (isAlphaNumeric(cleanState[i]) || cleanState[i] == '_' || cleanState[i] == '.') {
-                encodedState += cleanState[i];
-            } else {
-                // Convert other special characters to percent encoding
-                char hex[4];
-                sprintf(hex, "%%%02X", (unsigned char)cleanState[i]);
-                encodedState += hex;
+
+        if (httpCode != HTTP_CODE_OK) {
+            return;
+        }
+
+        const char* etag = HttpFetch::etag();
+        const char* lastModified = HttpFetch::lastModified();
+        if (!etag[0] && !lastModified[0] && HttpFetch::maxAgeSeconds() <= 0) {
+            // Nothing to revalidate with; drop a stale entry for this endpoint
+            CacheEntry* stale = findCacheEntry(pendingCacheKey);
+            if (stale) {
+                stale->key = 0;
             }
+            return;
         }
-        
-        // Current weather endpoint - using city and state with proper URL encoding
-        String currentUrl = "http://api.openweathermap.org/data/2.5/weather?q=" + 
-                           encodedCity + "," + encodedState + ",US&units=" + UNITS + "&appid=" + API_KEY;
-        
-        http.begin(client, currentUrl);
-        int httpCode = http.GET();
-        
-        if (httpCode == 200) {
-            String payload = http.getString();
-            
-            // Parse JSON using ArduinoJson with specified capacity
-            JsonDocument doc;
-            DeserializationError error = deserializeJson(doc, payload);
-            
-            if (!error) {
-                // Parse current weather data
-                currentTemp = doc["main"]["temp"];
-                highTemp = doc["main"]["temp_max"];
-                lowTemp = doc["main"]["temp_min"];
-                humidity = doc["main"]["humidity"];
-                
-                // More detailed error handling for condition
-                if (doc["weather"].is<JsonArray>() && doc["weather"].size() > 0) {
-                    const char* condition = doc["weather"][0]["main"];
-                    currentCondition = String(condition);
-                } else {
-                    Serial.println("Warning: Could not find weather condition in response");
-                    currentCondition = "Unknown";
-                }
-                
-                // Get sunrise and sunset times
-                if (doc["sys"]["sunrise"].is<long>() && doc["sys"]["sunset"].is<long>()) {
-                    long sunriseTimestamp = doc["sys"]["sunrise"];
-                    long sunsetTimestamp = doc["sys"]["sunset"];
-                    
-                    // Convert to hours and minutes with timezone adjustment
-                    // The timestamps from API are in UTC, so we need to apply the timezone offset
-                    time_t sunriseTime = sunriseTimestamp + (timezone * 3600); // Apply timezone offset
-                    time_t sunsetTime = sunsetTimestamp + (timezone * 3600);   // Apply timezone offset
-                    
-                    // Check if we should apply DST (US rules)
-                    struct tm* stm = gmtime(&sunriseTime);
-                    bool shouldApplyDst = shouldApplyDST(stm);
-                        
-                    if (shouldApplyDst && timezone < 0) {  // Only apply to US timezones
-                        sunriseTime += 3600;  // Add an hour for DST
-                        sunsetTime += 3600;   // Add an hour for DST
-                    }
-                    
-                    // Convert to hours and minutes
-                    sunriseHour = (sunriseTime / 3600) % 24;
-                    sunriseMinute = (sunriseTime / 60) % 60;
-                    sunsetHour = (sunsetTime / 3600) % 24;
-                    sunsetMinute = (sunsetTime / 60) % 60;
-                    
-                } else {
-                    // Use defaults
-                    sunriseHour = 6;
-                    sunriseMinute = 0;
-                    sunsetHour = 18;
-                    sunsetMinute = 0;
-                }
-                
-                http.end();
-                
-                // Now fetch forecast data using a more memory-efficient approach
-                String forecastUrl = "http://api.openweathermap.org/data/2.5/forecast?q=" + 
-                                     encodedCity + "," + encodedState + ",US&units=" + UNITS + "&appid=" + API_KEY;
-                
-                http.begin(client, forecastUrl);
-                httpCode = http.GET();
-                
-                if (httpCode == 200) {
-                    // Get current day info with proper timezone adjustment
-                    time_t now = time(nullptr);
-                    time_t localNow = now + (timezone * 3600); // Apply timezone offset
-                    
-                    // Debug stream availability before we start
-                    WiFiClient* stream = http.getStreamPtr();
-                    
-                    // Create a document for parsing with appropriate size
-                    JsonDocument doc;
-                    
-                    // Use the JSON parser in stream mode
-                    DeserializationError error = deserializeJson(doc, *stream);
-                    
-                    if (error) {
-                        Serial.print("deserializeJson() failed: ");
-                        Serial.println(error.c_str());
-                        http.end();
-                        return false;
-                    }
-                    
-                    JsonArray list = doc["list"];
-                    
-                    // Get current day info for date calculations
-                    struct tm* currentTime = gmtime(&localNow);
-                    int todayDate = currentTime->tm_mday;
-                    int todayMonth = currentTime->tm_mon;
-                    int todayYear = currentTime->tm_year;
-                    int todayDayOfWeek = currentTime->tm_wday;
-                    
-                    // Initialize forecast array
-                    for (int i = 0; i < 5; i++) {
-                        int futureDayOfWeek = (todayDayOfWeek + (i + 1)) % 7;
-                        forecast[i].day = getDayOfWeekShort(futureDayOfWeek);
-                        forecast[i].temp = -999; // Initialize to NA
-                        forecast[i].lowTemp = -999;
-                        forecast[i].iconType = 0;
-                    }
-                    
-                    // Track highest and lowest temperature for each day
-                    float maxTempForDay[5] = {-999, -999, -999, -999, -999};
-                    float minTempForDay[5] = {999, 999, 999, 999, 999};
-                    String conditionForDay[5];
-                    
-                    // Process each forecast entry
-                    for (JsonVariant entry : list) {
-                        // Get timestamp and convert to local time
-                        long timestamp = entry["dt"].as<long>();
-                        time_t forecastTime = timestamp + (timezone * 3600);
-                        
-                        // Check if we should apply DST (US rules)
-                        struct tm* ftm = gmtime(&forecastTime);
-                        bool shouldApplyDst = shouldApplyDST(ftm);
-                            
-                        if (shouldApplyDst && timezone < 0) {  // Only apply to US timezones
-                            forecastTime += 3600;  // Add an hour for DST
-                        }
-                        
-                        struct tm* forecastTm = gmtime(&forecastTime);
-                        
-                        // Calculate days from today using proper date comparison
-                        int daysFromToday;
-                        if (forecastTm->tm_year == todayYear) {
-                            if (forecastTm->tm_mon == todayMonth) {
-                                daysFromToday = forecastTm->tm_mday - todayDate;
-                            } else {
-                                // Different month, same year
-                                int daysInMonth;
-                                switch (todayMonth) {
-                                    case 1: daysInMonth = 31; break;  // January
-                                    case 2: daysInMonth = ((todayYear % 4 == 0 && todayYear % 100 != 0) || todayYear % 400 == 0) ? 29 : 28; break;  // February
-                                    case 3: daysInMonth = 31; break;  // March
-                                    case 4: daysInMonth = 30; break;  // April
-                                    case 5: daysInMonth = 31; break;  // May
-                                    case 6: daysInMonth = 30; break;  // June
-                                    case 7: daysInMonth = 31; break;  // July
-                                    case 8: daysInMonth = 31; break;  // August
-                                    case 9: daysInMonth = 30; break;  // September
-                                    case 10: daysInMonth = 31; break; // October
-                                    case 11: daysInMonth = 30; break; // November
-                                    case 12: daysInMonth = 31; break; // December
-                                    default: daysInMonth = 30; break;
-                                }
-                                daysFromToday = (daysInMonth - todayDate) + forecastTm->tm_mday;
-                            }
-                        } else {
-                            // Different year
-                            daysFromToday = 31 - todayDate + forecastTm->tm_mday;  // Simplified calculation for year boundary
-                        }
-                        
-                        if (daysFromToday <= 0) continue; // Skip entries for today
-                        if (daysFromToday > 6) continue;  // Skip entries too far in the future
-                        
-                        int forecastIndex = daysFromToday - 1;
-                        
-                        // Get temperature
-                        float temp = entry["main"]["temp"].as<float>();
-                        
-                        // Update if this is the highest temperature we've seen for this day
-                        if (temp > maxTempForDay[forecastIndex]) {
-                            maxTempForDay[forecastIndex] = temp;
-                            if (entry["weather"][0]["main"]) {
-                                conditionForDay[forecastIndex] = entry["weather"][0]["main"].as<const char*>();
-                            }
-                        }
-                        
-                        // Update if this is the lowest temperature we've seen for this day
-                        if (temp < minTempForDay[forecastIndex]) {
-                            minTempForDay[forecastIndex] = temp;
-                        }
-                    }
-                    
-                    // Update forecast array with the highest and lowest temperatures
-                    for (int i = 0; i < 5; i++) {
-                        if (maxTempForDay[i] > -999) {
-                            forecast[i].temp = round(maxTempForDay[i]);
-                            forecast[i].iconType = getWeatherIconType(conditionForDay[i]);
-                            
-                            if (minTempForDay[i] < 999) {
-                                forecast[i].lowTemp = round(minTempForDay[i]);
-                            }
-                        }
-                    }
-                    
-                    lastWeatherUpdate = millis();
-                    http.end();
-                    
-                    // Log successful weather update with details
-                    Serial.println("[Weather] Weather data successfully retrieved");
-                    Serial.print("[Weather] Current temperature: ");
-                    Serial.print(currentTemp);
-                    Serial.println(useMetricUnits ? "°C" : "°F");
-                    Serial.print("[Weather] Condition: ");
-                    Serial.println(currentCondition);
-                    Serial.print("[Weather] High ");
-                    Serial.print(highTemp);
-                    Serial.print(useMetricUnits ? "°C" : "°F");
-                    Serial.print(", Low ");
-                    Serial.print(lowTemp);
-                    Serial.println(useMetricUnits ? "°C" : "°F");
-                    
-                    // Log forecast data
-                    Serial.println("[Weather] 5-day forecast:");
-                    for (int i = 0; i < 5; i++) {
-                        if (forecast[i].temp > -999) {
-                            Serial.print("  ");
-                            Serial.print(forecast[i].day);
-                            Serial.print(": High ");
-                            Serial.print(forecast[i].temp);
-                            Serial.print(useMetricUnits ? "°C" : "°F");
-                            Serial.print(", Low ");
-                            Serial.print(forecast[i].lowTemp);
-                            Serial.println(useMetricUnits ? "°C" : "°F");
-                        }
-                    }
-                    
-                    return true;
-                } else {
-                    Serial.print("Forecast HTTP error: ");
-                    Serial.println(httpCode);
+
+        CacheEntry* entry = claimCacheEntry(pendingCacheKey);
+        strcpy(entry->etag, etag);
+        strcpy(entry->lastModified, lastModified);
+        entry->bodyBytes = HttpFetch::bodyBytes();
+        entry->lastUsed = millis();
+        refreshLifetime(entry);
+    }
+
+    // Feed response bytes to the provider; error bodies are skipped
+    static void onResponseBody(const char* data, size_t len, void* context) {
+        if (HttpFetch::statusCode() != 200) {
+            return;
+        }
+        runningProvider->onBody(data, len);
+    }
+
+    static void finishUpdate(bool success) {
+        // Nothing else is due at the weather hosts until the next update
+        HttpFetch::reset();
+        HttpFetch::close();
+        lastUpdateOk = success;
+        locationPending = false;
+        Metrics::observe(METRIC_WEATHER_UPDATE, (millis() - updateStartedAt) * 1000UL);
+        maxFreeBlockAfter = ESP.getMaxFreeBlockSize();
+
+        if (success) {
+            updatePeakDocBytes = parseAllocator.peakBytes();
+            LOG_INFO("Weather", "Fetch took %lu ms, longest loop stall %lu ms",
+                     millis() - updateStartedAt, longestStall);
+            LOG_DEBUG("Weather", "Parse peak %u bytes (budget %u), lowest free heap %u bytes",
+                      (unsigned)updatePeakDocBytes, (unsigned)JSON_DOC_BUDGET, (unsigned)updateMinFreeHeap);
+            LOG_DEBUG("Weather", "Largest free block %u bytes before fetch, %u bytes after",
+                      (unsigned)maxFreeBlockBefore, (unsigned)maxFreeBlockAfter);
+        }
+        runningProvider = nullptr;
+    }
+
+    // The requests of the location swapped in are done. Without the first
+    // location there is nothing to show, so its failure ends the update; a
+    // failed extra location keeps its last weather.
+    static void finishLocation(bool success) {
+        if (updateIndex == 0) {
+            if (!success) {
+                finishUpdate(false);
+                return;
+            }
+            lastWeatherUpdate = millis();
+            weatherDataStale = false;
+            logWeather();
+            WeatherSnapshot::save();
+        } else if (success) {
+            Locations::markFetched(updateIndex);
+            LOG_INFO("Weather", "%s: now %d, high %d, low %d", cityName.c_str(), currentTemp, highTemp, lowTemp);
+        } else {
+            LOG_WARN("Weather", "No weather for %s, keeping the last", cityName.c_str());
+        }
+
+        HttpFetch::reset();
+        if (updateIndex + 1 < Locations::count()) {
+            updateIndex++;
+            locationPending = true;
+            return;
+        }
+        finishUpdate(true);
+    }
+
+    // Start the provider on the location swapped in
+    static void beginLocation() {
+        locationPending = false;
+        if (!runningProvider->begin()) {
+            finishLocation(false);
+            return;
+        }
+        beginNextRequest();
+    }
+
+    // Start the provider's next request, or finish the update when it needs none.
+    // Requests whose cached response is still fresh are answered without the network.
+    static void beginNextRequest() {
+        ProviderRequest request;
+        request.cacheable = true;
+
+        while (runningProvider->nextRequest(request)) {
+            pendingCacheKey = request.cacheable ? cacheKey(request.host, request.path) : 0;
+            CacheEntry* entry = findCacheEntry(pendingCacheKey);
+
+            if (entry && isFresh(entry)) {
+                cacheStats.hits++;
+                cacheStats.bytesSaved += entry->bodyBytes;
+                entry->lastUsed = millis();
+                if (!runningProvider->onComplete(HTTP_CODE_NOT_MODIFIED)) {
+                    finishLocation(false);
+                    return;
                 }
-            } else {
-                Serial.print("Failed to parse current weather JSON: ");
-                Serial.println(error.c_str());
+                request.cacheable = true;
+                continue;
+            }
+
+            if (!HttpFetch::begin(request.host, request.port, request.path, onResponseBody, nullptr,
+                                  entry ? entry->etag : nullptr, entry ? entry->lastModified : nullptr)) {
+                finishLocation(false);
             }
+            return;
+        }
+
+        finishLocation(true);
+    }
+
+    // A request has finished; hand the result to the provider and move on
+    static void finishRequest(HttpFetch::State state) {
+        if (state == HttpFetch::FAILED) {
+            LOG_WARN("Weather", "%s request failed", runningProvider->name());
+            finishLocation(false);
+            return;
+        }
+
+        int httpCode = HttpFetch::statusCode();
+        if (!runningProvider->onComplete(httpCode)) {
+            finishLocation(false);
+            return;
+        }
+
+        // Only responses the provider accepted are worth revalidating later
+        recordResponse(httpCode);
+        beginNextRequest();
+    }
+
+    // Start an asynchronous weather update
+    bool startWeatherUpdate() {
+        if (runningProvider) {
+            return false;
+        }
+
+        if (WiFi.status() != WL_CONNECTED) {
+            LOG_WARN("Weather", "Cannot fetch weather - WiFi not connected");
+            return false;
+        }
+
+        WeatherProvider& provider = activeProvider();
+        if (!provider.begin()) {
+            return false;
+        }
+
+        maxFreeBlockBefore = ESP.getMaxFreeBlockSize();
+        parseAllocator.resetPeak();
+        updateMinFreeHeap = ESP.getFreeHeap();
+        updateStartedAt = millis();
+
+        // The first location is the globals themselves, no swap needed
+        runningProvider = &provider;
+        updateIndex = 0;
+        locationPending = false;
+        beginNextRequest();
+        saveCoordinates();
+        return runningProvider != nullptr;
+    }
+
+    // Advance a running update by one bounded time slice
+    void serviceWeatherUpdate() {
+        if (!runningProvider) {
+            return;
+        }
+
+        Metrics::ScopedTimer timer(METRIC_WEATHER_SLICE);
+        unsigned long sliceStart = millis();
+
+        if (updateIndex >= Locations::count()) {
+            // The settings page removed the location being fetched
+            finishUpdate(true);
+        } else if (locationPending) {
+            Locations::Scope scope(updateIndex);
+            beginLocation();
         } else {
-            Serial.print("Current weather HTTP error: ");
-            Serial.println(httpCode);
-            
-            // Display error message if city not found (404)
-            if (httpCode == 404) {
-                u8g2.clearBuffer();
-                u8g2.setFont(u8g2_font_6x10_tf);
-                u8g2.drawStr(0, 10, "City not found!");
-                u8g2.drawStr(0, 25, "Please update settings");
-                u8g2.drawStr(0, 40, "at config portal");
-                u8g2.sendBuffer();
-                delay(3000);
+            HttpFetch::State state = HttpFetch::service(WEATHER_FETCH_SLICE_MS);
+            if (state == HttpFetch::DONE || state == HttpFetch::FAILED) {
+                Locations::Scope scope(updateIndex);
+                finishRequest(state);
             }
         }
-        
-        http.end();
-        return false;
+        // Outside the scopes above, with location 0 back in the globals
+        saveCoordinates();
+
+        unsigned long stall = millis() - sliceStart;
+        if (stall > longestStall) {
+            longestStall = stall;
+        }
+    }
+
+    bool isUpdating() {
+        return runningProvider != nullptr;
+    }
+
+    void cancelWeatherUpdate() {
+        if (!runningProvider) {
+            return;
+        }
+        LOG_INFO("Weather", "Cancelling the %s update", runningProvider->name());
+        HttpFetch::reset();
+        HttpFetch::close();
+        locationPending = false;
+        runningProvider = nullptr;
+        // Coordinates found so far are for the globals as they are now
+        saveCoordinates();
+    }
+
+    uint8_t updateLocation() {
+        return updateIndex;
+    }
+
+    unsigned long maxStallMs() {
+        return longestStall;
+    }
+
+    size_t peakParseBytes() {
+        return updatePeakDocBytes;
+    }
+
+    uint32_t lowestFreeHeap() {
+        return updateMinFreeHeap;
+    }
+
+    CacheStats responseCacheStats() {
+        return cacheStats;
+    }
+
+    uint32_t maxFreeBlockBeforeFetch() {
+        return maxFreeBlockBefore;
+    }
+
+    uint32_t maxFreeBlockAfterFetch() {
+        return maxFreeBlockAfter;
+    }
+
+    // Fetch weather data from the active provider, waiting until the update completes
+    bool fetchWeatherData() {
+        if (!startWeatherUpdate()) {
+            return false;
+        }
+
+        while (isUpdating()) {
+            serviceWeatherUpdate();
+            delay(1);
+        }
+
+        return lastUpdateOk;
     }
-}
\ No newline at end of file
+}
@@ -1,6 +1,6 @@
 /*
  * Weather functions for ESP-01 Weather Display
- * Handles OpenWeatherMap API calls and data processing
+ * Handles weather API calls and data processing
  */
 
 #ifndef WEATHER_H
@@ -17,7 +17,43 @@
 namespace Weather {
     // Function declarations
     bool fetchWeatherData(void);
-    byte getWeatherIconType(const String& condition);
+    byte getWeatherIconType(const char* condition);
+
+    // Asynchronous update: start it, then call serviceWeatherUpdate() from every loop()
+    bool startWeatherUpdate();
+    void serviceWeatherUpdate();
+    bool isUpdating();
+
+    // Drop the running update, e.g. because the settings it started from
+    // changed; the weather applied so far stays
+    void cancelWeatherUpdate();
+
+    // Draw the error message a provider raised, if any. True while it is
+    // on the display, so the caller leaves the panel alone until it expires.
+    bool serviceErrorScreen();
+
+    // Name of the provider selected on the settings page
+    const char* providerName();
+
+    // Longest time a single serviceWeatherUpdate() call has blocked (ms)
+    unsigned long maxStallMs();
+
+    // Memory used while parsing the last update: peak document size and lowest free heap (bytes)
+    size_t peakParseBytes();
+    uint32_t lowestFreeHeap();
+
+    // Response cache counters since boot
+    struct CacheStats {
+        uint32_t hits;        // Answered from a still-fresh response, no request sent
+        uint32_t notModified; // Server answered 304 to a conditional request
+        uint32_t fullFetches; // Full 200 responses downloaded and parsed
+        uint32_t bytesSaved;  // Body bytes not downloaded thanks to hits and 304s
+    };
+    CacheStats responseCacheStats();
+
+    // Largest free heap block around the last update, to watch fragmentation (bytes)
+    uint32_t maxFreeBlockBeforeFetch();
+    uint32_t maxFreeBlockAfterFetch();
 }
 
 #endif // WEATHER_H
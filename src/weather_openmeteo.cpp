@@ -0,0 +1,266 @@
+/*
+ * Open-Meteo weather provider
+ * Current conditions, daily high/low and the next 24 hours
+ * come from a single /v1/forecast request without an API key. The city is
+ * resolved to coordinates once through the Open-Meteo geocoding API; they
+ * are stored with the location. Only the first location asks for the hours.
+ */
+
+#include "weather_provider.h"
+#include "weather.h"
+#include "time_manager.h"
+#include "time_zone.h"
+#include "hourly_forecast.h"
+#include "logging.h"
+#include <time.h>
+
+#define OPENMETEO_GEOCODING_HOST "geocoding-api.open-meteo.com"
+#define OPENMETEO_FORECAST_HOST "api.open-meteo.com"
+#define OPENMETEO_PORT 80
+
+// Number of geocoding matches to choose from
+#define OPENMETEO_GEOCODING_RESULTS 10
+
+namespace Weather {
+    // Member names of the geocoding matches
+    static const GeocodeKeys GEOCODE_KEYS = { "latitude", "longitude", "country_code", "admin1" };
+
+    // Forecast values parsed from the response, applied once the request completes
+    static JsonDocument forecastFilter;
+    static bool currentParsed = false;
+    static bool dailyParsed = false;
+    static float parsedTemp = 0;
+    static int parsedHumidity = 0;
+    static int parsedCode = 0;
+    static float parsedHigh[6];
+    static float parsedLow[6];
+    static int parsedDailyCode[6];
+    static int parsedDays = 0;
+
+    // Map a WMO weather code to the OpenWeatherMap condition names used elsewhere
+    static const char* conditionForWmoCode(int code) {
+        if (code == 0) return "Clear";
+        if (code <= 3) return "Clouds";
+        if (code == 45 || code == 48) return "Fog";
+        if (code >= 51 && code <= 57) return "Drizzle";
+        if ((code >= 61 && code <= 67) || (code >= 80 && code <= 82)) return "Rain";
+        if ((code >= 71 && code <= 77) || code == 85 || code == 86) return "Snow";
+        if (code >= 95) return "Thunderstorm";
+        return "Unknown";
+    }
+
+    // Members of the geocoding "results" entries arrive one at a time
+    static void onGeocodingUnit(const char* topKey, const char* json, size_t len, void* context) {
+        if (strcmp(topKey, "results") == 0) {
+            geocodeMatcher.onMember(splitter.elementIndex, json, len);
+        }
+    }
+
+    // Root members "current" and "daily" of the forecast response
+    static void onForecastUnit(const char* topKey, const char* json, size_t len, void* context) {
+        bool isCurrent = strcmp(topKey, "current") == 0;
+        bool isDaily = strcmp(topKey, "daily") == 0;
+        bool isHourly = strcmp(topKey, "hourly") == 0;
+        if (!isCurrent && !isDaily && !isHourly) {
+            return;
+        }
+
+        JsonDocument doc(&parseAllocator);
+        DeserializationError error = deserializeJson(doc, json, len, DeserializationOption::Filter(forecastFilter));
+
+        if (error) {
+            LOG_WARN("Weather", "Failed to parse Open-Meteo JSON: %s", error.c_str());
+            return;
+        }
+
+        sampleHeap();
+
+        if (isCurrent) {
+            JsonObject current = doc["current"];
+            parsedTemp = current["temperature_2m"] | 0.0f;
+            parsedHumidity = current["relative_humidity_2m"] | 0;
+            parsedCode = current["weather_code"] | 0;
+            currentParsed = true;
+            return;
+        }
+
+        if (isHourly) {
+            // Hourly values, kept at the ring's 3 hour step; only the first
+            // location asks for them
+            JsonObject hourly = doc["hourly"];
+            JsonArray times = hourly["time"];
+            JsonArray temps = hourly["temperature_2m"];
+            JsonArray precip = hourly["precipitation_probability"];
+            JsonArray codes = hourly["weather_code"];
+            HourlyForecast::expire(getEpochTime());
+            for (size_t i = 0; i < times.size(); i += HOURLY_STEP_S / 3600) {
+                int probability = precip[i] | -1;
+                HourlyForecast::store(times[i] | 0L, temps[i] | 0.0f,
+                                      getWeatherIconType(conditionForWmoCode(codes[i] | 0)),
+                                      probability < 0 ? HOURLY_PRECIP_UNKNOWN : (uint8_t)probability);
+            }
+            return;
+        }
+
+        JsonObject daily = doc["daily"];
+        JsonArray highs = daily["temperature_2m_max"];
+        JsonArray lows = daily["temperature_2m_min"];
+        JsonArray codes = daily["weather_code"];
+
+        parsedDays = min((int)highs.size(), 6);
+        for (int i = 0; i < parsedDays; i++) {
+            parsedHigh[i] = highs[i] | 0.0f;
+            parsedLow[i] = lows[i] | 0.0f;
+            parsedDailyCode[i] = codes[i] | 0;
+        }
+        dailyParsed = parsedDays > 0;
+    }
+
+    // Copy the parsed values into the display globals
+    static void applyForecast() {
+        currentTemp = round(parsedTemp);
+        humidity = parsedHumidity;
+        strncpy(currentCondition, conditionForWmoCode(parsedCode), sizeof(currentCondition) - 1);
+
+        // Today's extremes come from the first daily entry
+        highTemp = round(parsedHigh[0]);
+        lowTemp = round(parsedLow[0]);
+
+        // Day names follow the local clock, like the OpenWeatherMap provider
+        time_t localNow = TimeZone::toLocal(getEpochTime());
+        int todayDayOfWeek = gmtime(&localNow)->tm_wday;
+
+        for (int i = 0; i < 5; i++) {
+            getDayOfWeekShort((todayDayOfWeek + i + 1) % 7, forecast[i].day);
+            if (i + 1 < parsedDays) {
+                forecast[i].temp = round(parsedHigh[i + 1]);
+                forecast[i].lowTemp = round(parsedLow[i + 1]);
+                forecast[i].iconType = getWeatherIconType(conditionForWmoCode(parsedDailyCode[i + 1]));
+            } else {
+                forecast[i].temp = -999;
+                forecast[i].lowTemp = -999;
+                forecast[i].iconType = 0;
+            }
+        }
+    }
+
+    class OpenMeteoProvider : public WeatherProvider {
+    public:
+        const char* name() const override {
+            return "Open-Meteo";
+        }
+
+        bool begin() override {
+            // Coordinates are only looked up again when the location changes
+            step = cityCoordinatesKnown ? STEP_FORECAST : STEP_GEOCODE;
+            return true;
+        }
+
+        bool nextRequest(ProviderRequest& request) override {
+            request.port = OPENMETEO_PORT;
+
+            if (step == STEP_GEOCODE) {
+                String encodedCity, encodedState;
+                encodeLocation(encodedCity, encodedState);
+                geocodeMatcher.begin(GEOCODE_KEYS);
+                splitter.begin(3, unitBuffer, CURRENT_WEATHER_JSON_SIZE, onGeocodingUnit, nullptr);
+
+                // Coordinates are stored on their own; a 304 would not restore them
+                request.cacheable = false;
+                request.host = OPENMETEO_GEOCODING_HOST;
+                request.path = "/v1/search?name=" + encodedCity + "&count=" + String(OPENMETEO_GEOCODING_RESULTS) + "&language=en&format=json";
+                return true;
+            }
+
+            if (step == STEP_FORECAST) {
+                // Build the filter once: the daily arrays and the current values we display
+                if (forecastFilter.isNull()) {
+                    forecastFilter["current"]["temperature_2m"] = true;
+                    forecastFilter["current"]["relative_humidity_2m"] = true;
+                    forecastFilter["current"]["weather_code"] = true;
+                    forecastFilter["daily"]["weather_code"] = true;
+                    forecastFilter["daily"]["temperature_2m_max"] = true;
+                    forecastFilter["daily"]["temperature_2m_min"] = true;
+                    forecastFilter["hourly"]["time"] = true;
+                    forecastFilter["hourly"]["temperature_2m"] = true;
+                    forecastFilter["hourly"]["precipitation_probability"] = true;
+                    forecastFilter["hourly"]["weather_code"] = true;
+                }
+
+                currentParsed = false;
+                dailyParsed = false;
+                parsedDays = 0;
+                splitter.begin(1, unitBuffer, FORECAST_JSON_SIZE, onForecastUnit, nullptr);
+
+                // The whole path in one go, from the stored coordinates
+                char path[320];
+                snprintf(path, sizeof(path),
+                         "/v1/forecast?latitude=%.4f&longitude=%.4f"
+                         "&current=temperature_2m,relative_humidity_2m,weather_code"
+                         "&daily=weather_code,temperature_2m_max,temperature_2m_min%s"
+                         "&timeformat=unixtime&timezone=auto&forecast_days=6%s",
+                         cityLatitude, cityLongitude,
+                         updateLocation() == 0 ? "&hourly=temperature_2m,precipitation_probability,weather_code&forecast_hours=24" : "",
+                         useMetricUnits ? "" : "&temperature_unit=fahrenheit");
+
+                request.host = OPENMETEO_FORECAST_HOST;
+                request.path = path;
+                return true;
+            }
+
+            return false;
+        }
+
+        void onBody(const char* data, size_t len) override {
+            splitter.feed(data, len);
+        }
+
+        bool onComplete(int httpCode) override {
+            splitter.finish();
+
+            // Unchanged since the last fetch: the values on screen still apply
+            if (httpCode == HTTP_CODE_NOT_MODIFIED && step == STEP_FORECAST) {
+                step = STEP_DONE;
+                return true;
+            }
+
+            if (httpCode != 200) {
+                LOG_WARN("Weather", "Open-Meteo %s HTTP error: %d", step == STEP_GEOCODE ? "geocoding" : "forecast", httpCode);
+                return false;
+            }
+
+            if (step == STEP_GEOCODE) {
+                if (!geocodeMatcher.finish()) {
+                    LOG_WARN("Weather", "Open-Meteo geocoding found no match for %s", cityName.c_str());
+                    showWeatherError("City not found!", "Please update settings", "at config portal", "");
+                    return false;
+                }
+                step = STEP_FORECAST;
+                return true;
+            }
+
+            if (!currentParsed || !dailyParsed) {
+                LOG_WARN("Weather", "Open-Meteo response incomplete");
+                return false;
+            }
+
+            applyForecast();
+            step = STEP_DONE;
+            return true;
+        }
+
+    private:
+        enum Step {
+            STEP_GEOCODE,
+            STEP_FORECAST,
+            STEP_DONE
+        };
+
+        Step step = STEP_GEOCODE;
+    };
+
+    WeatherProvider& openMeteoProvider() {
+        static OpenMeteoProvider provider;
+        return provider;
+    }
+}
@@ -0,0 +1,348 @@
+/*
+ * OpenWeatherMap weather provider
+ * Two requests per update: /data/2.5/weather for current conditions and
+ * /data/2.5/forecast for the 5-day forecast, both by coordinates. The city
+ * is resolved to those once through /geo/1.0/direct; they are stored with
+ * the location.
+ */
+
+#include "weather_provider.h"
+#include "weather.h"
+#include "time_manager.h"
+#include "time_zone.h"
+#include "hourly_forecast.h"
+#include "logging.h"
+#include <time.h>
+
+// OpenWeatherMap API server
+#define OWM_API_HOST "api.openweathermap.org"
+#define OWM_API_PORT 80
+
+// Number of geocoding matches to choose from
+#define OWM_GEOCODING_RESULTS 5
+
+namespace Weather {
+    // "lat=..&lon=..&units=..&appid=.." part shared by both requests
+    static char locationQuery[128];
+
+    // Member names of the geocoding matches
+    static const GeocodeKeys GEOCODE_KEYS = { "lat", "lon", "country", "state" };
+
+    // Only the fields the display needs are kept from each parsed piece
+    static JsonDocument currentFilter;
+    static JsonDocument forecastFilter;
+
+    // Current conditions parsed from the response, applied once the request completes
+    static bool currentParsed = false;
+    static int parsedTemp = 0;
+    static int parsedHigh = 0;
+    static int parsedLow = 0;
+    static int parsedHumidity = 0;
+    static char parsedCondition[16];
+
+    // Forecast accumulators, filled entry by entry while the response streams in
+    static int forecastEntries = 0;
+    static long todayEpochDay = 0;     // Local days since 1970-01-01
+    static int todayDayOfWeek = 0;
+    static float maxTempForDay[5];
+    static float minTempForDay[5];
+    static char conditionForDay[5][16];
+
+    // Members of the geocoding matches, elements of the root array, arrive one at a time
+    static void onGeocodingUnit(const char* topKey, const char* json, size_t len, void* context) {
+        geocodeMatcher.onMember(splitter.elementIndex, json, len);
+    }
+
+    // Parse one root member of the current-weather response; only "main" and
+    // "weather" carry fields we display. Sunrise and sunset come from the ephemeris.
+    static void onCurrentUnit(const char* topKey, const char* json, size_t len, void* context) {
+        bool isMain = strcmp(topKey, "main") == 0;
+        bool isWeather = strcmp(topKey, "weather") == 0;
+        if (!isMain && !isWeather) {
+            return;
+        }
+
+        JsonDocument doc(&parseAllocator);
+        DeserializationError error = deserializeJson(doc, json, len, DeserializationOption::Filter(currentFilter));
+
+        if (error) {
+            LOG_WARN("Weather", "Failed to parse current weather JSON: %s", error.c_str());
+            return;
+        }
+
+        if (isMain) {
+            // Parse current weather data
+            parsedTemp = doc["main"]["temp"];
+            parsedHigh = doc["main"]["temp_max"];
+            parsedLow = doc["main"]["temp_min"];
+            parsedHumidity = doc["main"]["humidity"];
+            currentParsed = true;
+        } else if (doc["weather"].is<JsonArray>() && doc["weather"].size() > 0) {
+            const char* condition = doc["weather"][0]["main"] | "Unknown";
+            strncpy(parsedCondition, condition, sizeof(parsedCondition) - 1);
+            parsedCondition[sizeof(parsedCondition) - 1] = '\0';
+        }
+    }
+
+    // Copy the parsed current conditions into the display globals
+    static void applyCurrentWeather() {
+        currentTemp = parsedTemp;
+        highTemp = parsedHigh;
+        lowTemp = parsedLow;
+        humidity = parsedHumidity;
+        strcpy(currentCondition, parsedCondition);
+    }
+
+    // Fold one forecast entry into the per-day high/low accumulators
+    static void foldForecastEntry(time_t timestamp, float temp, const char* condition) {
+        // DST changes inside the forecast are honoured, the offset is looked up per entry
+        long daysFromToday = TimeZone::localDay(timestamp) - todayEpochDay;
+
+        if (daysFromToday <= 0) return; // Skip entries for today
+        if (daysFromToday > 5) return;  // Skip entries too far in the future
+
+        int forecastIndex = daysFromToday - 1;
+
+        // Update if this is the highest temperature we've seen for this day
+        if (temp > maxTempForDay[forecastIndex]) {
+            maxTempForDay[forecastIndex] = temp;
+            if (condition) {
+                strncpy(conditionForDay[forecastIndex], condition, sizeof(conditionForDay[forecastIndex]) - 1);
+                conditionForDay[forecastIndex][sizeof(conditionForDay[forecastIndex]) - 1] = '\0';
+            }
+        }
+
+        // Update if this is the lowest temperature we've seen for this day
+        if (temp < minTempForDay[forecastIndex]) {
+            minTempForDay[forecastIndex] = temp;
+        }
+    }
+
+    // Parse a single entry of the forecast "list" array
+    static void onForecastUnit(const char* topKey, const char* json, size_t len, void* context) {
+        if (strcmp(topKey, "list") != 0) {
+            return;
+        }
+
+        JsonDocument doc(&parseAllocator);
+        DeserializationError error = deserializeJson(doc, json, len, DeserializationOption::Filter(forecastFilter));
+
+        if (error) {
+            LOG_WARN("Weather", "Failed to parse forecast entry: %s", error.c_str());
+            return;
+        }
+
+        // Sample the heap while the entry's document is still alive
+        sampleHeap();
+
+        // 64 bits, so forecasts past January 2038 still bucket correctly
+        time_t timestamp = (time_t)doc["dt"].as<int64_t>();
+        float temp = doc["main"]["temp"].as<float>();
+        const char* condition = doc["weather"][0]["main"];
+
+        foldForecastEntry(timestamp, temp, condition);
+        if (updateLocation() == 0) {
+            float pop = doc["pop"] | -1.0f;
+            HourlyForecast::store(timestamp, temp, getWeatherIconType(condition ? condition : ""),
+                                  pop < 0 ? HOURLY_PRECIP_UNKNOWN : (uint8_t)lroundf(pop * 100));
+        }
+        forecastEntries++;
+    }
+
+    // Copy the accumulated forecast into the display globals
+    static void applyForecast() {
+        // Initialize forecast array
+        for (int i = 0; i < 5; i++) {
+            int futureDayOfWeek = (todayDayOfWeek + (i + 1)) % 7;
+            getDayOfWeekShort(futureDayOfWeek, forecast[i].day);
+            forecast[i].temp = -999; // Initialize to NA
+            forecast[i].lowTemp = -999;
+            forecast[i].iconType = 0;
+        }
+
+        // Update forecast array with the highest and lowest temperatures
+        for (int i = 0; i < 5; i++) {
+            if (maxTempForDay[i] > -999) {
+                forecast[i].temp = round(maxTempForDay[i]);
+                forecast[i].iconType = getWeatherIconType(conditionForDay[i]);
+
+                if (minTempForDay[i] < 999) {
+                    forecast[i].lowTemp = round(minTempForDay[i]);
+                }
+            }
+        }
+    }
+
+    static void beginCurrent() {
+        // Build the filter once; it is applied to each root member in turn
+        if (currentFilter.isNull()) {
+            currentFilter["main"]["temp"] = true;
+            currentFilter["main"]["temp_max"] = true;
+            currentFilter["main"]["temp_min"] = true;
+            currentFilter["main"]["humidity"] = true;
+            currentFilter["weather"][0]["main"] = true;
+        }
+
+        currentParsed = false;
+        strcpy(parsedCondition, "Unknown");
+        splitter.begin(1, unitBuffer, CURRENT_WEATHER_JSON_SIZE, onCurrentUnit, nullptr);
+    }
+
+    static void beginForecast() {
+        // Entries are bucketed by local day number relative to today
+        todayEpochDay = TimeZone::localDay(getEpochTime());
+        todayDayOfWeek = (int)((todayEpochDay + 4) % 7); // 1970-01-01 was a Thursday
+
+        // Track highest and lowest temperature for each day
+        for (int i = 0; i < 5; i++) {
+            maxTempForDay[i] = -999;
+            minTempForDay[i] = 999;
+            conditionForDay[i][0] = '\0';
+        }
+        forecastEntries = 0;
+
+        if (updateLocation() == 0) {
+            HourlyForecast::expire(getEpochTime());
+        }
+
+        // Build the filter once: dt, main.temp, weather[0].main and pop
+        if (forecastFilter.isNull()) {
+            forecastFilter["dt"] = true;
+            forecastFilter["pop"] = true;
+            forecastFilter["main"]["temp"] = true;
+            forecastFilter["weather"][0]["main"] = true;
+        }
+
+        splitter.begin(2, unitBuffer, FORECAST_JSON_SIZE, onForecastUnit, nullptr);
+    }
+
+    class OpenWeatherMapProvider : public WeatherProvider {
+    public:
+        const char* name() const override {
+            return "OpenWeatherMap";
+        }
+
+        bool begin() override {
+            // Check if API key is available
+            if (API_KEY.length() < 5) {
+                LOG_ERROR("Weather", "No valid OpenWeatherMap API key found");
+                showWeatherError("Missing API Key!", "Please set your own", "OpenWeatherMap API key", "in settings page");
+                return false;
+            }
+
+            // Coordinates are only looked up again when the location changes
+            step = cityCoordinatesKnown ? STEP_CURRENT : STEP_GEOCODE;
+            formatQuery();
+            return true;
+        }
+
+        bool nextRequest(ProviderRequest& request) override {
+            request.host = OWM_API_HOST;
+            request.port = OWM_API_PORT;
+
+            if (step == STEP_GEOCODE) {
+                String encodedCity, encodedState;
+                encodeLocation(encodedCity, encodedState);
+                geocodeMatcher.begin(GEOCODE_KEYS);
+                splitter.begin(2, unitBuffer, CURRENT_WEATHER_JSON_SIZE, onGeocodingUnit, nullptr);
+
+                // Coordinates are stored on their own; a 304 would not restore them
+                request.cacheable = false;
+                request.path = "/geo/1.0/direct?q=" + encodedCity + "," + encodedState + ",US&limit=" +
+                               String(OWM_GEOCODING_RESULTS) + "&appid=" + API_KEY;
+            } else if (step == STEP_CURRENT) {
+                beginCurrent();
+                request.path = "/data/2.5/weather?";
+                request.path += locationQuery;
+            } else if (step == STEP_FORECAST) {
+                beginForecast();
+                request.path = "/data/2.5/forecast?";
+                request.path += locationQuery;
+            } else {
+                return false;
+            }
+            return true;
+        }
+
+        void onBody(const char* data, size_t len) override {
+            splitter.feed(data, len);
+        }
+
+        bool onComplete(int httpCode) override {
+            splitter.finish();
+
+            // Unchanged since the last fetch: the values on screen still apply
+            if (httpCode == HTTP_CODE_NOT_MODIFIED && step != STEP_GEOCODE) {
+                step++;
+                return true;
+            }
+
+            if (step == STEP_GEOCODE) {
+                if (httpCode != 200) {
+                    LOG_WARN("Weather", "Geocoding HTTP error: %d", httpCode);
+                    return false;
+                }
+                if (!geocodeMatcher.finish()) {
+                    LOG_WARN("Weather", "OpenWeatherMap geocoding found no match for %s", cityName.c_str());
+                    showWeatherError("City not found!", "Please update settings", "at config portal", "");
+                    return false;
+                }
+                formatQuery();
+            } else if (step == STEP_CURRENT) {
+                if (httpCode != 200) {
+                    LOG_WARN("Weather", "Current weather HTTP error: %d", httpCode);
+                    return false;
+                }
+
+                if (!currentParsed) {
+                    LOG_WARN("Weather", "Could not find main conditions in current weather response");
+                    return false;
+                }
+
+                applyCurrentWeather();
+            } else {
+                if (httpCode != 200) {
+                    LOG_WARN("Weather", "Forecast HTTP error: %d", httpCode);
+                    return false;
+                }
+
+                if (forecastEntries == 0) {
+                    LOG_WARN("Weather", "Forecast response contained no usable entries");
+                    return false;
+                }
+
+                if (splitter.droppedUnits > 0) {
+                    LOG_WARN("Weather", "Skipped %u forecast entries larger than %u bytes",
+                             splitter.droppedUnits, (unsigned)FORECAST_JSON_SIZE);
+                }
+
+                applyForecast();
+            }
+
+            step++;
+            return true;
+        }
+
+    private:
+        // In request order; a 304 moves on to the next
+        enum Step : uint8_t {
+            STEP_GEOCODE,
+            STEP_CURRENT,
+            STEP_FORECAST,
+            STEP_DONE
+        };
+
+        // Format the query of both weather requests, once per location and update
+        static void formatQuery() {
+            snprintf(locationQuery, sizeof(locationQuery), "lat=%.4f&lon=%.4f&units=%s&appid=%s",
+                     cityLatitude, cityLongitude, UNITS.c_str(), API_KEY.c_str());
+        }
+
+        uint8_t step = STEP_GEOCODE;
+    };
+
+    WeatherProvider& openWeatherMapProvider() {
+        static OpenWeatherMapProvider provider;
+        return provider;
+    }
+}
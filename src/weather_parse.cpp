@@ -0,0 +1,281 @@
+/*
+ * Parse helpers shared by the weather providers
+ * The buffers and allocator the responses are parsed with, the condition to
+ * icon mapping and the geocoding match picker. Nothing here touches the
+ * network or the display, so it builds for the native tests as well.
+ */
+
+#include "weather_provider.h"
+#include "weather.h"
+#include "logging.h"
+
+// State codes and names, "AL" + name + '|', used to pick the right geocoding match
+static const char US_STATE_NAMES[] PROGMEM =
+  "ALAlabama|AKAlaska|AZArizona|ARArkansas|CACalifornia|COColorado|CTConnecticut|"
+  "DEDelaware|DCDistrict of Columbia|FLFlorida|GAGeorgia|HIHawaii|IDIdaho|ILIllinois|"
+  "INIndiana|IAIowa|KSKansas|KYKentucky|LALouisiana|MEMaine|MDMaryland|MAMassachusetts|"
+  "MIMichigan|MNMinnesota|MSMississippi|MOMissouri|MTMontana|NENebraska|NVNevada|"
+  "NHNew Hampshire|NJNew Jersey|NMNew Mexico|NYNew York|NCNorth Carolina|NDNorth Dakota|"
+  "OHOhio|OKOklahoma|OROregon|PAPennsylvania|RIRhode Island|SCSouth Carolina|"
+  "SDSouth Dakota|TNTennessee|TXTexas|UTUtah|VTVermont|VAVirginia|WAWashington|"
+  "WVWest Virginia|WIWisconsin|WYWyoming|";
+
+namespace Weather {
+    // Function prototypes
+    static void trimString(String &str);
+    static bool isValidCityName(const String &city);
+
+    // Shared parse resources: the splitter cuts each response into pieces small
+    // enough to parse from a fixed buffer, so the raw payload is never held in memory
+    BudgetAllocator parseAllocator(JSON_DOC_BUDGET);
+    JsonSplitter splitter;
+    char unitBuffer[CURRENT_WEATHER_JSON_SIZE > FORECAST_JSON_SIZE ? CURRENT_WEATHER_JSON_SIZE : FORECAST_JSON_SIZE];
+
+    GeocodeMatcher geocodeMatcher;
+
+    // Condition to icon rules, tried in order; the first match wins
+    enum IconMatch : uint8_t {
+        MATCH_NAME,       // Whole condition name, any case
+        MATCH_CONTAINS    // Substring of a description
+    };
+
+    struct IconRule {
+        char text[10];
+        IconMatch match;
+        uint8_t iconType;
+    };
+
+    static const IconRule ICON_RULES[] PROGMEM = {
+        { "Clear",     MATCH_NAME,     0 }, // Sunny
+        { "Clouds",    MATCH_NAME,     1 }, // Partly cloudy
+        { "few",       MATCH_CONTAINS, 1 },
+        { "scattered", MATCH_CONTAINS, 1 },
+        { "broken",    MATCH_CONTAINS, 2 }, // Cloudy
+        { "overcast",  MATCH_CONTAINS, 2 },
+        { "Mist",      MATCH_NAME,     3 }, // Foggy
+        { "Fog",       MATCH_NAME,     3 },
+        { "Haze",      MATCH_NAME,     3 },
+        { "Rain",      MATCH_NAME,     4 }, // Rainy
+        { "Drizzle",   MATCH_NAME,     4 },
+        { "shower",    MATCH_CONTAINS, 4 },
+        { "Snow",      MATCH_NAME,     5 }, // Snowy
+        { "snow",      MATCH_CONTAINS, 5 }
+    };
+
+    // Map a condition name or description to its icon type
+    byte getWeatherIconType(const char* condition) {
+        for (size_t i = 0; i < sizeof(ICON_RULES) / sizeof(ICON_RULES[0]); i++) {
+            IconRule rule;
+            memcpy_P(&rule, &ICON_RULES[i], sizeof(rule));
+            bool matches = (rule.match == MATCH_NAME) ? strcasecmp(condition, rule.text) == 0
+                                                      : strstr(condition, rule.text) != nullptr;
+            if (matches) {
+                return rule.iconType;
+            }
+        }
+        return 0; // Default to sunny
+    }
+
+    // Helper function to trim whitespace from beginning and end of a string
+    static void trimString(String &str) {
+        while (str.length() > 0 && isSpace(str.charAt(0))) {
+            str.remove(0, 1);
+        }
+        while (str.length() > 0 && isSpace(str.charAt(str.length() - 1))) {
+            str.remove(str.length() - 1);
+        }
+    }
+
+    // Helper function to check if city name is valid
+    static bool isValidCityName(const String &city) {
+        if (city.length() == 0 || city == "_") {
+            return false;
+        }
+        
+        // Check if city contains at least one alphanumeric character
+        for (size_t i = 0; i < city.length(); i++) {
+            if (isAlphaNumeric(city.charAt(i))) {
+                return true;
+            }
+        }
+        
+        return false;
+    }
+
+    // Prepare city and state for a query string, falling back to defaults when invalid
+    void encodeLocation(String& encodedCity, String& encodedState) {
+        // Trim whitespace from city and state names
+        trimString(cityName);
+        trimString(stateName);
+        
+        // Check if city name is valid
+        if (!isValidCityName(cityName)) {
+            LOG_WARN("Weather", "City name is empty or invalid, setting to default 'New York'");
+            cityName = "New York";
+            
+            // Display error message on screen
+            showWeatherError("Invalid city name!", "Please update settings", "at config portal", "Using: New York");
+        }
+        
+        // Sanitize city and state names
+        String cleanCity = cityName;
+        String cleanState = stateName;
+        
+        // Remove any non-printable or problematic characters
+        for (size_t i = 0; i < cleanCity.length(); i++) {
+            if (!isprint(cleanCity[i]) || cleanCity[i] == ',' || cleanCity[i] == '&') {
+                cleanCity.setCharAt(i, '_');
+            }
+        }
+        
+        for (size_t i = 0; i < cleanState.length(); i++) {
+            if (!isprint(cleanState[i]) || cleanState[i] == ',' || cleanState[i] == '&') {
+                cleanState.setCharAt(i, '_');
+            }
+        }
+        
+        // If city is just underscores or empty after cleaning, use default
+        bool hasValidChar = false;
+        for (size_t i = 0; i < cleanCity.length(); i++) {
+            if (cleanCity[i] != '_') {
+                hasValidChar = true;
+                break;
+            }
+        }
+        
+        if (!hasValidChar || cleanCity.length() == 0) {
+            LOG_WARN("Weather", "City name contains only underscores or is empty after sanitizing, using New York");
+            cleanCity = "New York";
+            cityName = "New York"; // Update the global variable too
+        }
+        
+        // URL encode the city and state names to handle spaces and special characters
+        encodedCity = "";
+        encodedState = "";
+        
+        // Simple URL encoding for spaces and special characters
+        for (size_t i = 0; i < cleanCity.length(); i++) {
+            if (cleanCity[i] == ' ') {
+                encodedCity += "%20";
+            } else if (isAlphaNumeric(cleanCity[i]) || cleanCity[i] == '_' || cleanCity[i] == '.') {
+                encodedCity += cleanCity[i];
+            } else {
+                // Convert other special characters to percent encoding
+                char hex[4];
+                sprintf(hex, "%%%02X", (unsigned char)cleanCity[i]);
+                encodedCity += hex;
+            }
+        }
+        
+        for (size_t i = 0; i < cleanState.length(); i++) {
+            if (cleanState[i] == ' ') {
+                encodedState += "%20";
+            } else if (isAlphaNumeric(cleanState[i]) || cleanState[i] == '_' || cleanState[i] == '.') {
+                encodedState += cleanState[i];
+            } else {
+                // Convert other special characters to percent encoding
+                char hex[4];
+                sprintf(hex, "%%%02X", (unsigned char)cleanState[i]);
+                encodedState += hex;
+            }
+        }
+    }
+
+    // Look up the full name of a two-letter state code
+    static void stateNameForCode(const String& code, char* name, size_t size) {
+        name[0] = '\0';
+        if (code.length() != 2) {
+            return;
+        }
+
+        const char* p = US_STATE_NAMES;
+        while (pgm_read_byte(p)) {
+            bool matches = pgm_read_byte(p) == code[0] && pgm_read_byte(p + 1) == code[1];
+            p += 2;
+
+            size_t len = 0;
+            char c;
+            while ((c = pgm_read_byte(p++)) != '|') {
+                if (matches && len < size - 1) {
+                    name[len++] = c;
+                }
+            }
+            if (matches) {
+                name[len] = '\0';
+                return;
+            }
+        }
+    }
+
+    // True if json is the object {"key": ...}
+    static bool isMember(const char* json, const char* key) {
+        size_t keyLength = strlen(key);
+        return json[0] == '{' && json[1] == '"' && strncmp(json + 2, key, keyLength) == 0 && json[2 + keyLength] == '"';
+    }
+
+    void GeocodeMatcher::begin(const GeocodeKeys& matchKeys) {
+        keys = &matchKeys;
+        stateNameForCode(stateName, wantedStateName, sizeof(wantedStateName));
+        candidateIndex = -1;
+        bestScore = -1;
+    }
+
+    // Score the finished candidate: US match with the right state wins, then any US match
+    void GeocodeMatcher::scoreCandidate() {
+        if (candidateIndex < 0) {
+            return;
+        }
+        int score = candidateStateMatches ? 2 : (candidateIsUS ? 1 : 0);
+        if (score > bestScore) {
+            bestScore = score;
+            bestLat = candidateLat;
+            bestLon = candidateLon;
+        }
+    }
+
+    void GeocodeMatcher::onMember(uint16_t index, const char* json, size_t len) {
+        // A new match started: settle the previous one
+        if ((int)index != candidateIndex) {
+            scoreCandidate();
+            candidateIndex = index;
+            candidateLat = 0;
+            candidateLon = 0;
+            candidateIsUS = false;
+            candidateStateMatches = false;
+        }
+
+        // Skip members we do not need (postcode and local name lists can be long)
+        if (!isMember(json, keys->latitude) && !isMember(json, keys->longitude) &&
+            !isMember(json, keys->countryCode) && !isMember(json, keys->region)) {
+            return;
+        }
+
+        JsonDocument doc(&parseAllocator);
+        if (deserializeJson(doc, json, len)) {
+            return;
+        }
+
+        if (doc[keys->latitude].is<float>()) {
+            candidateLat = doc[keys->latitude];
+        } else if (doc[keys->longitude].is<float>()) {
+            candidateLon = doc[keys->longitude];
+        } else if (doc[keys->countryCode].is<const char*>()) {
+            candidateIsUS = strcmp(doc[keys->countryCode], "US") == 0;
+        } else if (doc[keys->region].is<const char*>()) {
+            candidateStateMatches = wantedStateName[0] && strcasecmp(doc[keys->region], wantedStateName) == 0;
+        }
+    }
+
+    bool GeocodeMatcher::finish() {
+        scoreCandidate();
+        if (bestScore < 0) {
+            return false;
+        }
+        cityLatitude = bestLat;
+        cityLongitude = bestLon;
+        cityCoordinatesKnown = true;
+        resolved = true;
+        LOG_INFO("Weather", "%s, %s resolved to %.4f, %.4f", cityName.c_str(), stateName.c_str(), bestLat, bestLon);
+        return true;
+    }
+}
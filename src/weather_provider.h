@@ -0,0 +1,202 @@
+/*
+ * Weather data providers for ESP-01 Weather Display
+ * Each backend describes the HTTP requests an update needs and parses their
+ * responses as they stream in; weather.cpp drives the requests
+ */
+
+#ifndef WEATHER_PROVIDER_H
+#define WEATHER_PROVIDER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ESP8266HTTPClient.h> // HTTP_CODE_* status values
+#include "config.h"
+#include "json_splitter.h"
+
+// Responses are parsed piece by piece: the current-weather buffer holds one root
+// member ("main", "sys", ...), the forecast buffer one larger piece such as an
+// entry of the forecast "list" array
+#define CURRENT_WEATHER_JSON_SIZE 256
+#define FORECAST_JSON_SIZE 1024
+
+// Heap the document for a single parsed piece may use. ArduinoJson grabs its
+// first slot pool (about 1 KB on the ESP8266) up front, the filtered values
+// themselves take only a few dozen bytes.
+#define JSON_DOC_BUDGET 2048
+
+namespace Weather {
+    // One HTTP GET an update needs
+    struct ProviderRequest {
+        const char* host;
+        uint16_t port;
+        String path;
+        bool cacheable; // Use the response cache (preset to true)
+    };
+
+    // A weather backend. An update calls begin(), then for every request that
+    // nextRequest() hands out streams its body to onBody() and reports the
+    // status to onComplete(). Providers write the display globals themselves
+    // once a response has been parsed completely. With several locations the
+    // same calls run once per location.
+    class WeatherProvider {
+    public:
+        virtual ~WeatherProvider() {}
+
+        // Name shown in logs and on the settings page
+        virtual const char* name() const = 0;
+
+        // Prepare a new update; false if it cannot run (e.g. missing API key)
+        virtual bool begin() = 0;
+
+        // Describe the next request; false once the update needs no more
+        virtual bool nextRequest(ProviderRequest& request) = 0;
+
+        // Body bytes of the running request (only called for HTTP 200)
+        virtual void onBody(const char* data, size_t len) = 0;
+
+        // The running request finished; false aborts the update. httpCode is
+        // HTTP_CODE_NOT_MODIFIED (304) when the response cache says the data
+        // applied last time is still current, in which case onBody() was not
+        // called and the display globals should be left as they are.
+        virtual bool onComplete(int httpCode) = 0;
+    };
+
+    // Backends
+    WeatherProvider& openWeatherMapProvider(); // Two calls: /weather and /forecast
+    WeatherProvider& openMeteoProvider();      // One call, no API key needed
+
+    // Backend chosen on the settings page
+    WeatherProvider& activeProvider();
+
+    // Heap allocator for ArduinoJson that enforces a fixed budget and records the
+    // peak, so an oversized piece fails on its own instead of exhausting the heap
+    class BudgetAllocator : public ArduinoJson::Allocator {
+    public:
+        explicit BudgetAllocator(size_t budget) : limit(budget), used(0), peak(0) {}
+
+        void* allocate(size_t size) override {
+            if (used + size > limit) {
+                return nullptr;
+            }
+            BlockHeader* block = (BlockHeader*)malloc(sizeof(BlockHeader) + size);
+            if (!block) {
+                return nullptr;
+            }
+            block->size = size;
+            track(size, 0);
+            return block + 1;
+        }
+
+        void deallocate(void* ptr) override {
+            if (!ptr) {
+                return;
+            }
+            BlockHeader* block = (BlockHeader*)ptr - 1;
+            used -= block->size;
+            free(block);
+        }
+
+        void* reallocate(void* ptr, size_t newSize) override {
+            if (!ptr) {
+                return allocate(newSize);
+            }
+            BlockHeader* block = (BlockHeader*)ptr - 1;
+            size_t oldSize = block->size;
+            if (newSize > oldSize && used + newSize - oldSize > limit) {
+                return nullptr;
+            }
+            BlockHeader* resized = (BlockHeader*)realloc(block, sizeof(BlockHeader) + newSize);
+            if (!resized) {
+                return nullptr;
+            }
+            resized->size = newSize;
+            track(newSize, oldSize);
+            return resized + 1;
+        }
+
+        size_t usedBytes() const { return used; }
+        size_t peakBytes() const { return peak; }
+        void resetPeak() { peak = used; }
+
+    private:
+        struct alignas(8) BlockHeader {
+            size_t size;
+        };
+
+        void track(size_t added, size_t removed) {
+            used = used + added - removed;
+            if (used > peak) {
+                peak = used;
+            }
+        }
+
+        size_t limit;
+        size_t used;
+        size_t peak;
+    };
+
+    // Parse resources shared by all providers (defined in weather_parse.cpp)
+    extern BudgetAllocator parseAllocator;
+    extern JsonSplitter splitter;
+    extern char unitBuffer[];
+
+    // Record the free heap while a parsed document is alive
+    void sampleHeap();
+
+    // Location the running update is on, see locations.h. Its weather is
+    // swapped into the globals during begin(), nextRequest() and onComplete();
+    // only location 0 fills the hourly forecast.
+    uint8_t updateLocation();
+
+    // Trim, validate and URL-encode cityName and stateName; only needed to
+    // geocode them, the weather requests go by the stored coordinates
+    void encodeLocation(String& encodedCity, String& encodedState);
+
+    // Member names a geocoding API reports its matches with
+    struct GeocodeKeys {
+        const char* latitude;
+        const char* longitude;
+        const char* countryCode; // "US" for a match in the US
+        const char* region;      // Full state name
+    };
+
+    // Picks the best geocoding match as its members stream in: one in the US
+    // and in stateName's state, else one in the US, else the first
+    class GeocodeMatcher {
+    public:
+        void begin(const GeocodeKeys& keys);
+
+        // One member of match number index, wrapped in braces
+        void onMember(uint16_t index, const char* json, size_t len);
+
+        // Store the best match as the location's coordinates, to be saved
+        // when the update ends; false if there was none
+        bool finish();
+
+        // Set by finish(); the update clears it once the coordinates are saved
+        bool resolved = false;
+
+    private:
+        void scoreCandidate();
+
+        const GeocodeKeys* keys;
+        char wantedStateName[24];
+        int candidateIndex;
+        float candidateLat;
+        float candidateLon;
+        bool candidateIsUS;
+        bool candidateStateMatches;
+        int bestScore;
+        float bestLat;
+        float bestLon;
+    };
+
+    // Shared by the providers (defined in weather_parse.cpp)
+    extern GeocodeMatcher geocodeMatcher;
+
+    // Show a full-screen error message for a few seconds. Returns at once;
+    // the display task draws it on its next run (see serviceErrorScreen()).
+    void showWeatherError(const char* line1, const char* line2, const char* line3, const char* line4);
+}
+
+#endif // WEATHER_PROVIDER_H
@@ -0,0 +1,174 @@
+/*
+ * Implementation of the weather snapshot
+ */
+
+#include "weather_snapshot.h"
+#include "logging.h"
+#include <coredecls.h> // crc32()
+#include <EEPROM.h>
+#include <time.h>
+
+// Bump when the record layout changes; older snapshots are then ignored
+#define SNAPSHOT_VERSION 1
+
+// Shortest time between two flash writes. The emulated EEPROM rewrites a whole
+// flash sector on every commit, so temperatures that change with nearly every
+// 5-minute fetch would otherwise wear it out within a few years.
+#define SNAPSHOT_MIN_WRITE_INTERVAL_MS (30UL * 60UL * 1000UL)
+
+namespace WeatherSnapshot {
+    struct SnapshotDay {
+        char day[4];
+        int16_t temp;
+        int16_t lowTemp;
+        uint8_t iconType;
+    };
+
+    // Fixed-size record written as-is to EEPROM
+    struct Snapshot {
+        uint8_t version;
+        uint8_t metric;         // Unit the temperatures are in
+        uint32_t fetchedAt;     // Unix time of the fetch, 0 if the clock was not set
+        int16_t currentTemp;
+        int16_t lowTemp;
+        int16_t highTemp;
+        uint8_t humidity;
+        uint8_t sunriseHour;
+        uint8_t sunriseMinute;
+        uint8_t sunsetHour;
+        uint8_t sunsetMinute;
+        char condition[16];
+        SnapshotDay days[5];
+        uint32_t crc;           // Core crc32() of everything above
+    };
+
+    static_assert(WEATHER_SNAPSHOT_OFFSET + sizeof(Snapshot) <= WIFI_CACHE_OFFSET, "weather snapshot overlaps the access point cache");
+
+    // Checksum of the data last written, ignoring the timestamp, so a fetch
+    // that returns the same weather does not touch flash
+    static uint32_t writtenDataCrc = 0;
+    static bool haveWritten = false;
+    static unsigned long lastWriteMillis = 0;
+    static uint32_t writes = 0;
+    static uint32_t skipped = 0;
+
+    static uint32_t recordCrc(const Snapshot& snap) {
+        return crc32(&snap, offsetof(Snapshot, crc));
+    }
+
+    static uint32_t dataCrc(const Snapshot& snap) {
+        Snapshot copy = snap;
+        copy.fetchedAt = 0;
+        return recordCrc(copy);
+    }
+
+    // Build a record from the weather globals
+    static void capture(Snapshot& snap) {
+        memset(&snap, 0, sizeof(snap));
+        snap.version = SNAPSHOT_VERSION;
+        snap.metric = useMetricUnits ? 1 : 0;
+        time_t now = time(nullptr);
+        snap.fetchedAt = now > 1000000000 ? (uint32_t)now : 0;
+        snap.currentTemp = currentTemp;
+        snap.lowTemp = lowTemp;
+        snap.highTemp = highTemp;
+        snap.humidity = humidity;
+        snap.sunriseHour = sunriseHour;
+        snap.sunriseMinute = sunriseMinute;
+        snap.sunsetHour = sunsetHour;
+        snap.sunsetMinute = sunsetMinute;
+        strncpy(snap.condition, currentCondition, sizeof(snap.condition) - 1);
+
+        for (int i = 0; i < 5; i++) {
+            strncpy(snap.days[i].day, forecast[i].day, sizeof(snap.days[i].day) - 1);
+            snap.days[i].temp = forecast[i].temp;
+            snap.days[i].lowTemp = forecast[i].lowTemp;
+            snap.days[i].iconType = forecast[i].iconType;
+        }
+        snap.crc = recordCrc(snap);
+    }
+
+    bool load() {
+        Snapshot snap;
+        EEPROM.begin(EEPROM_SIZE);
+        EEPROM.get(WEATHER_SNAPSHOT_OFFSET, snap);
+        EEPROM.end();
+
+        if (snap.version != SNAPSHOT_VERSION || snap.crc != recordCrc(snap)) {
+            LOG_INFO("Snapshot", "No valid weather snapshot stored");
+            return false;
+        }
+
+        // Remember what is on flash even if we cannot use it, to avoid rewriting it
+        writtenDataCrc = dataCrc(snap);
+        haveWritten = true;
+
+        if (snap.metric != (useMetricUnits ? 1 : 0)) {
+            LOG_INFO("Snapshot", "Stored weather is in the other temperature unit, ignoring it");
+            return false;
+        }
+
+        currentTemp = snap.currentTemp;
+        lowTemp = snap.lowTemp;
+        highTemp = snap.highTemp;
+        humidity = snap.humidity;
+        sunriseHour = snap.sunriseHour;
+        sunriseMinute = snap.sunriseMinute;
+        sunsetHour = snap.sunsetHour;
+        sunsetMinute = snap.sunsetMinute;
+        snap.condition[sizeof(snap.condition) - 1] = '\0';
+        strcpy(currentCondition, snap.condition);
+
+        for (int i = 0; i < 5; i++) {
+            snap.days[i].day[sizeof(snap.days[i].day) - 1] = '\0';
+            strcpy(forecast[i].day, snap.days[i].day);
+            forecast[i].temp = snap.days[i].temp;
+            forecast[i].lowTemp = snap.days[i].lowTemp;
+            forecast[i].iconType = snap.days[i].iconType;
+        }
+
+        weatherDataStale = true;
+        LOG_INFO("Snapshot", "Restored weather fetched at %lu (unix time), marked stale", (unsigned long)snap.fetchedAt);
+        return true;
+    }
+
+    void save() {
+        Snapshot snap;
+        capture(snap);
+        uint32_t crc = dataCrc(snap);
+
+        if (haveWritten && crc == writtenDataCrc) {
+            skipped++;
+            return;
+        }
+        // Changed data that arrives too soon is written by a later fetch
+        if (haveWritten && lastWriteMillis != 0 && millis() - lastWriteMillis < SNAPSHOT_MIN_WRITE_INTERVAL_MS) {
+            skipped++;
+            return;
+        }
+
+        EEPROM.begin(EEPROM_SIZE);
+        EEPROM.put(WEATHER_SNAPSHOT_OFFSET, snap);
+        bool ok = EEPROM.commit();
+        EEPROM.end();
+
+        if (!ok) {
+            LOG_ERROR("Snapshot", "EEPROM commit failed");
+            return;
+        }
+
+        writtenDataCrc = crc;
+        haveWritten = true;
+        lastWriteMillis = millis();
+        writes++;
+        LOG_INFO("Snapshot", "Weather snapshot saved");
+    }
+
+    uint32_t writeCount() {
+        return writes;
+    }
+
+    uint32_t skippedCount() {
+        return skipped;
+    }
+}
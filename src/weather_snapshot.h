@@ -0,0 +1,28 @@
+/*
+ * Weather snapshot for ESP-01 Weather Display
+ * Keeps the last good weather data in EEPROM so the screens have something to
+ * show right after a reboot, before WiFi and the first fetch are done
+ */
+
+#ifndef WEATHER_SNAPSHOT_H
+#define WEATHER_SNAPSHOT_H
+
+#include <Arduino.h>
+#include "config.h"
+
+namespace WeatherSnapshot {
+    // Restore the weather globals from the stored snapshot and mark them stale.
+    // Returns false if there is no valid snapshot for the current unit setting.
+    bool load();
+
+    // Store the current weather globals after a successful fetch. The flash
+    // sector is only rewritten when the data changed, and not more often than
+    // every half hour.
+    void save();
+
+    // Statistics since boot
+    uint32_t writeCount();   // Snapshots written to flash
+    uint32_t skippedCount(); // Saves skipped because nothing changed or too soon
+}
+
+#endif // WEATHER_SNAPSHOT_H
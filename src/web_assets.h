@@ -0,0 +1,168 @@
+/*
+ * Gzipped static assets of the web portal
+ * Generated by tools/gzip_assets.py from web/ - do not edit, edit web/ instead
+ */
+
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <Arduino.h>
+
+struct WebAsset {
+  const char* path;
+  const char* contentType;
+  const uint8_t* data;   // Gzip stream in PROGMEM
+  size_t length;
+  const char* etag;      // Quoted, from the uncompressed content
+};
+
+// style.css: 916 bytes, 451 gzipped
+const uint8_t STYLE_CSS_GZ[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x6d, 0x52, 0xd1, 0x8e, 0x9b, 0x30,
+  0x10, 0x7c, 0xe7, 0x2b, 0x56, 0x8a, 0x2a, 0xb5, 0xa7, 0xf8, 0x0e, 0x42, 0x91, 0x12, 0xf2, 0xd4,
+  0x6f, 0xe8, 0x17, 0x18, 0xbc, 0x60, 0x2b, 0x8e, 0x17, 0xd9, 0xe6, 0x20, 0x3a, 0xe5, 0xdf, 0x6b,
+  0x73, 0x84, 0x83, 0x6b, 0xe4, 0x27, 0x8f, 0xd7, 0x33, 0xb3, 0xb3, 0xfb, 0xf6, 0x02, 0x7f, 0x25,
+  0xb7, 0x28, 0xc0, 0xf9, 0x9b, 0x46, 0x27, 0x11, 0x3d, 0x50, 0x03, 0x5e, 0x22, 0x74, 0x64, 0x3d,
+  0xd7, 0xd0, 0xf1, 0x16, 0x1d, 0xbc, 0xbc, 0x25, 0x15, 0x89, 0x1b, 0x7c, 0x24, 0x00, 0x0d, 0x19,
+  0xcf, 0x1a, 0x7e, 0x55, 0xfa, 0x56, 0xc2, 0x1f, 0xab, 0xb8, 0xde, 0x83, 0xe3, 0xc6, 0x31, 0x87,
+  0x56, 0x35, 0xe7, 0x50, 0x71, 0xe5, 0xb6, 0x55, 0xa6, 0x84, 0x34, 0x5e, 0x3a, 0x2e, 0x84, 0x32,
+  0x6d, 0x09, 0x87, 0xb4, 0x1b, 0x23, 0x50, 0xf1, 0xfa, 0xd2, 0x5a, 0xea, 0x8d, 0x28, 0x61, 0xd7,
+  0x14, 0xf1, 0x44, 0xb8, 0x26, 0x4d, 0x36, 0x20, 0x79, 0x9e, 0x9f, 0x93, 0x7b, 0x22, 0x33, 0xf8,
+  0x58, 0xb0, 0x43, 0x9d, 0x63, 0x91, 0x9e, 0xe1, 0x9e, 0xbc, 0xd6, 0x41, 0x9d, 0x2b, 0x83, 0x76,
+  0xf2, 0x72, 0xe5, 0x23, 0x1b, 0x94, 0xf0, 0xb2, 0x84, 0x22, 0x9d, 0xf9, 0x17, 0x75, 0xe0, 0xbd,
+  0xa7, 0xef, 0x8a, 0x83, 0x54, 0x1e, 0x9f, 0xfb, 0x22, 0x2b, 0xd0, 0x32, 0xcb, 0x85, 0xea, 0x5d,
+  0xe0, 0x7b, 0xa0, 0x23, 0x73, 0x92, 0x0b, 0x1a, 0x22, 0xe3, 0xa1, 0x1b, 0xe3, 0x03, 0xd8, 0xb6,
+  0xe2, 0x3f, 0xd3, 0xfd, 0x74, 0x5e, 0xb3, 0x5f, 0xd1, 0xb0, 0xe6, 0x15, 0xea, 0xc9, 0x94, 0x50,
+  0xae, 0xd3, 0x3c, 0x84, 0x53, 0x69, 0xaa, 0x2f, 0x5f, 0x96, 0x98, 0xa7, 0xae, 0x84, 0x6c, 0x96,
+  0x9b, 0x62, 0x1c, 0x50, 0xb5, 0xd2, 0x87, 0x4a, 0xd2, 0x22, 0x92, 0x38, 0xd4, 0x58, 0xfb, 0x3d,
+  0x28, 0xd3, 0xf5, 0x7e, 0x22, 0x9b, 0xbb, 0xcb, 0xd2, 0xf4, 0xc7, 0xc6, 0xf5, 0x71, 0xdd, 0xec,
+  0x27, 0x73, 0xb1, 0x81, 0x2a, 0xf2, 0x9e, 0xae, 0xe1, 0x67, 0xb1, 0x6e, 0x2f, 0xdc, 0x83, 0x7d,
+  0x47, 0x5a, 0x09, 0xd8, 0x09, 0x21, 0x9e, 0x34, 0x9e, 0xc7, 0xfa, 0x7b, 0x52, 0xf5, 0xe1, 0xbf,
+  0x99, 0x3c, 0x6c, 0x26, 0x96, 0xff, 0x3e, 0x1d, 0x45, 0xb5, 0x9a, 0xd8, 0x92, 0xe8, 0x43, 0xc1,
+  0x90, 0xd9, 0x26, 0x1c, 0x5b, 0xfe, 0xe6, 0x63, 0xab, 0x16, 0xb8, 0x7a, 0xeb, 0x22, 0x59, 0x47,
+  0xca, 0x78, 0xb4, 0x5f, 0x06, 0x4a, 0x49, 0xef, 0xf3, 0xb0, 0x37, 0x36, 0x0e, 0xa7, 0x63, 0x5a,
+  0x9d, 0x62, 0xdd, 0xce, 0xa0, 0x1f, 0xc8, 0x5e, 0xdc, 0xb2, 0x11, 0x72, 0x4e, 0x35, 0x2b, 0xe6,
+  0xac, 0x23, 0x45, 0xa3, 0x69, 0x60, 0x61, 0x28, 0x9f, 0x4b, 0x11, 0x36, 0xc9, 0xf0, 0x77, 0xa6,
+  0x95, 0xb9, 0x6c, 0x67, 0xa6, 0x4c, 0xc0, 0x90, 0x3d, 0x1d, 0xdd, 0x63, 0x53, 0x96, 0x55, 0x5d,
+  0xa2, 0xf0, 0x38, 0x7a, 0x26, 0xb0, 0x26, 0xcb, 0xbd, 0x0a, 0xa6, 0xe7, 0x0c, 0x56, 0x2a, 0xab,
+  0x3e, 0xfe, 0x2b, 0x0e, 0x1d, 0xa1, 0x8d, 0xb2, 0xf1, 0xc7, 0x3f, 0x89, 0x79, 0xba, 0x4f, 0x94,
+  0x03, 0x00, 0x00
+};
+
+// settings.js: 5008 bytes, 1668 gzipped
+const uint8_t SETTINGS_JS_GZ[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xad, 0x58, 0x4d, 0x73, 0xe2, 0x38,
+  0x10, 0xbd, 0xe7, 0x57, 0x68, 0x2f, 0x0b, 0xa9, 0x00, 0xb1, 0x03, 0xe4, 0x73, 0xc2, 0x96, 0x03,
+  0xec, 0x84, 0x21, 0x26, 0x54, 0xec, 0x0c, 0x3b, 0xb3, 0xb5, 0x07, 0x81, 0x05, 0x68, 0x63, 0x24,
+  0xca, 0x96, 0x93, 0x21, 0x53, 0xf9, 0xef, 0xdb, 0x92, 0x6c, 0x27, 0xd8, 0xca, 0x90, 0xc3, 0x5e,
+  0xba, 0x6c, 0x59, 0xef, 0xf5, 0x53, 0x4b, 0x6a, 0xa9, 0x7d, 0x78, 0x88, 0x3c, 0x22, 0x04, 0x65,
+  0x8b, 0x18, 0xad, 0xf1, 0x82, 0x9c, 0xa3, 0x39, 0x0d, 0xc3, 0x18, 0x89, 0x25, 0x41, 0xb1, 0xc0,
+  0x82, 0x20, 0xcc, 0x02, 0x24, 0xe8, 0x8a, 0x3c, 0x73, 0x46, 0x50, 0x48, 0x63, 0x11, 0x37, 0xd0,
+  0x2c, 0x89, 0x22, 0xc2, 0x84, 0x97, 0x75, 0xd8, 0x3b, 0x3c, 0xcc, 0xda, 0xfc, 0x67, 0x84, 0x23,
+  0xc0, 0x12, 0x81, 0xa6, 0x1b, 0x45, 0x23, 0x69, 0x11, 0x15, 0x31, 0x09, 0xe7, 0x8d, 0xbd, 0x79,
+  0xc2, 0x66, 0x82, 0x72, 0x86, 0xd6, 0x7c, 0x9d, 0x84, 0x00, 0x57, 0x1c, 0x71, 0x75, 0x1f, 0xfd,
+  0xdc, 0x43, 0x68, 0xc6, 0x59, 0x2c, 0xb4, 0xdf, 0x18, 0x5d, 0xa2, 0xbf, 0xa1, 0x09, 0xa1, 0x8a,
+  0x73, 0x53, 0xa9, 0x81, 0x1d, 0x2a, 0xfb, 0x5d, 0xd9, 0x3b, 0x69, 0xbb, 0x8e, 0xb2, 0xb7, 0xca,
+  0xfa, 0xd2, 0xf6, 0xfa, 0xd2, 0xfe, 0xa9, 0xfa, 0x7f, 0x86, 0xaf, 0x1a, 0x7f, 0x3d, 0x90, 0xef,
+  0x83, 0x9e, 0xb2, 0xea, 0xdb, 0x60, 0xa4, 0xac, 0xc2, 0x0f, 0x3d, 0x65, 0xbf, 0x49, 0x7b, 0xa3,
+  0x5a, 0x5c, 0xc5, 0xe2, 0xf6, 0x32, 0xbc, 0xab, 0x5b, 0x15, 0x8b, 0xab, 0x90, 0xae, 0xc2, 0xb8,
+  0xca, 0xb3, 0xab, 0x3c, 0x8f, 0x14, 0x66, 0xf4, 0x55, 0xd9, 0x6b, 0x65, 0xbf, 0x64, 0xf8, 0x91,
+  0xab, 0xde, 0x95, 0x87, 0x51, 0x57, 0x59, 0xa5, 0xe5, 0x56, 0xf5, 0xbb, 0x55, 0xe3, 0xba, 0x55,
+  0x23, 0x1a, 0x2b, 0x4f, 0x77, 0xca, 0x93, 0xd7, 0xcd, 0xf0, 0x9e, 0xea, 0xed, 0x2b, 0xcf, 0xfe,
+  0x5f, 0xd2, 0xde, 0x2b, 0x9f, 0x5f, 0xb5, 0x55, 0x98, 0x89, 0xb6, 0xca, 0xff, 0x44, 0xe1, 0x27,
+  0xdf, 0x2a, 0x00, 0xff, 0xe7, 0x62, 0x3b, 0xac, 0x1e, 0x09, 0xc9, 0x4c, 0x40, 0x6c, 0x03, 0x3e,
+  0x4b, 0x56, 0x30, 0x5f, 0x8d, 0x05, 0x11, 0xfd, 0x90, 0xc8, 0xc7, 0xab, 0xcd, 0x20, 0xa8, 0x56,
+  0x54, 0xb7, 0xca, 0xbe, 0xc4, 0xe9, 0x89, 0x68, 0xcc, 0x79, 0xd4, 0xc7, 0xb3, 0x65, 0x55, 0xaf,
+  0x87, 0xcb, 0x8e, 0x9a, 0xaa, 0x8c, 0x95, 0xaf, 0xd5, 0x74, 0xbe, 0x21, 0x9c, 0x45, 0x04, 0xfa,
+  0xa5, 0x9c, 0xd5, 0x8a, 0xee, 0xa0, 0x09, 0x51, 0xda, 0xbd, 0xf1, 0x88, 0xc3, 0x04, 0xa8, 0xb4,
+  0x87, 0xad, 0x2f, 0x82, 0xfc, 0x10, 0xdb, 0x1f, 0xe8, 0x1c, 0x65, 0xae, 0x2f, 0x2f, 0xb7, 0x96,
+  0xde, 0x7e, 0xaa, 0x24, 0x07, 0xc7, 0x6a, 0x74, 0x24, 0x00, 0x02, 0x11, 0x25, 0x29, 0xfe, 0x45,
+  0xd9, 0x37, 0xa3, 0x6f, 0xe0, 0xf5, 0x9a, 0xb0, 0xa0, 0xbb, 0xa4, 0x61, 0x50, 0xd5, 0x48, 0xa5,
+  0xee, 0x05, 0xec, 0xcb, 0x9e, 0x5c, 0xcb, 0xe3, 0x88, 0xc8, 0x05, 0x2c, 0x97, 0x7c, 0x7c, 0xa1,
+  0x16, 0xb1, 0x16, 0x4c, 0xf5, 0xc6, 0x18, 0xdf, 0x7a, 0x83, 0xbf, 0x90, 0xff, 0x1d, 0x45, 0x49,
+  0x48, 0x6a, 0xe8, 0x69, 0x49, 0x67, 0x4b, 0x84, 0xc3, 0x98, 0xa3, 0x19, 0x8e, 0x22, 0x4a, 0x54,
+  0x2f, 0xc9, 0x13, 0xe0, 0x4d, 0x48, 0x17, 0x4b, 0x88, 0x3d, 0x7e, 0x84, 0x2d, 0x06, 0xef, 0x32,
+  0x9e, 0xc8, 0x61, 0x1b, 0xc4, 0xa1, 0x4b, 0xa4, 0x08, 0x00, 0xc4, 0xd0, 0x94, 0x20, 0xb1, 0x59,
+  0x83, 0x72, 0xca, 0x04, 0x57, 0x4e, 0x54, 0x20, 0xe6, 0x94, 0x84, 0x81, 0x61, 0xd7, 0xf8, 0xe9,
+  0x86, 0xdc, 0xde, 0x38, 0xd9, 0x36, 0x7d, 0xdd, 0x3b, 0x3f, 0x95, 0xee, 0x73, 0x54, 0xf9, 0x54,
+  0xb7, 0x8f, 0x3a, 0xf6, 0x11, 0x2c, 0x0c, 0xc9, 0x0b, 0x0d, 0xd5, 0x7b, 0xbf, 0x0b, 0x6d, 0xe7,
+  0x96, 0xb5, 0x8f, 0x06, 0x4c, 0x90, 0x88, 0x61, 0xe9, 0x01, 0x87, 0xa8, 0x27, 0x43, 0x7d, 0x43,
+  0x61, 0xb7, 0x4f, 0x48, 0x2c, 0x2a, 0x2f, 0xb5, 0x12, 0x93, 0xdd, 0xb1, 0xed, 0x22, 0x93, 0xad,
+  0x98, 0xba, 0x9c, 0x47, 0x01, 0x05, 0x2a, 0x18, 0xc9, 0x3d, 0xa3, 0x8f, 0x24, 0x8a, 0x81, 0x51,
+  0xaa, 0x85, 0x1e, 0x25, 0xaa, 0x6b, 0xcf, 0xb7, 0xad, 0x22, 0x91, 0xa5, 0x88, 0xae, 0xf1, 0x13,
+  0xa6, 0xb4, 0x84, 0x70, 0x86, 0x9e, 0x7f, 0xe6, 0x0c, 0x7b, 0x7e, 0xcd, 0x6d, 0x36, 0x8e, 0x1a,
+  0x56, 0xcd, 0xb5, 0xed, 0x86, 0xdd, 0x28, 0x92, 0x58, 0x67, 0x8a, 0xc4, 0x09, 0x71, 0xfc, 0x80,
+  0x4b, 0x24, 0x63, 0xcf, 0x3f, 0x1d, 0xef, 0xa4, 0x38, 0x55, 0x14, 0x63, 0x3c, 0xa3, 0x73, 0x3a,
+  0x53, 0x43, 0x40, 0xd5, 0x7b, 0x0f, 0xfd, 0x8e, 0xba, 0x98, 0xe1, 0x00, 0xef, 0x97, 0x68, 0x5d,
+  0xcf, 0x3f, 0x29, 0x92, 0x9c, 0x68, 0x1d, 0x11, 0x85, 0x69, 0xc1, 0x46, 0x84, 0xbb, 0x53, 0x88,
+  0xe6, 0x70, 0x79, 0xc2, 0x04, 0xa6, 0xec, 0x23, 0x4a, 0xba, 0x9e, 0x7f, 0xdc, 0xdd, 0xc9, 0x7b,
+  0xac, 0x67, 0x0c, 0x36, 0x53, 0x94, 0xce, 0xd1, 0x07, 0x68, 0xcd, 0x24, 0x2e, 0xf9, 0x41, 0x67,
+  0x1c, 0x75, 0xa9, 0xd8, 0x94, 0x50, 0x7d, 0xcf, 0x6f, 0xf7, 0x77, 0x8a, 0x69, 0x2b, 0x9e, 0x3e,
+  0x8e, 0xe5, 0x4a, 0xfc, 0x88, 0x98, 0x4f, 0x80, 0xe9, 0xb4, 0xcd, 0x34, 0x57, 0x7c, 0xc1, 0x05,
+  0xae, 0xc1, 0x22, 0x5e, 0x95, 0x83, 0xee, 0x78, 0x7e, 0xcb, 0xd9, 0xa9, 0xa7, 0xa5, 0x27, 0x4e,
+  0x84, 0x98, 0x89, 0x7c, 0xfa, 0x7f, 0xa1, 0xa5, 0xd5, 0x69, 0x81, 0x6d, 0x76, 0x6a, 0xee, 0x19,
+  0xd0, 0x1d, 0x1f, 0x1e, 0xb5, 0x6a, 0x6e, 0x2b, 0x7d, 0x32, 0x73, 0x7b, 0x92, 0x19, 0x2f, 0x78,
+  0x89, 0x6d, 0xe4, 0xf9, 0xcd, 0xf3, 0xa6, 0x35, 0xda, 0xa9, 0x51, 0xf6, 0xda, 0x47, 0x23, 0xf2,
+  0x34, 0x87, 0xb5, 0x11, 0x80, 0xd2, 0xc0, 0xa4, 0xac, 0xd9, 0x69, 0x96, 0x81, 0x2a, 0x4a, 0x11,
+  0x8e, 0x69, 0x48, 0x21, 0x4e, 0x57, 0x09, 0x61, 0x3c, 0x46, 0x0e, 0x85, 0xb4, 0x67, 0xa2, 0x38,
+  0xea, 0x14, 0x13, 0x87, 0xa5, 0x13, 0x87, 0x4b, 0x83, 0x7a, 0x16, 0x23, 0x13, 0x10, 0x12, 0xc5,
+  0xa7, 0x03, 0xcb, 0xea, 0xc8, 0x81, 0xb4, 0x1b, 0xd6, 0xa1, 0x1c, 0x8a, 0xa5, 0x9e, 0x8a, 0xf9,
+  0xc3, 0xd2, 0xf9, 0xc3, 0x79, 0xe6, 0x26, 0x0d, 0xd0, 0xa3, 0x30, 0x7a, 0x60, 0xdd, 0x91, 0x70,
+  0x4a, 0x24, 0x9f, 0x5d, 0xdf, 0xba, 0xf2, 0xfc, 0x4c, 0x8b, 0x9d, 0x69, 0x31, 0x13, 0xdf, 0x70,
+  0x16, 0xc0, 0xb1, 0x55, 0x24, 0x19, 0x78, 0x7e, 0xdd, 0x96, 0x4c, 0x19, 0x3a, 0xa7, 0x33, 0xd3,
+  0xf4, 0x92, 0x69, 0x48, 0xcb, 0x34, 0x93, 0xbe, 0x6f, 0x4d, 0xfa, 0x1f, 0x17, 0x43, 0xe3, 0xa9,
+  0x41, 0x4c, 0xb7, 0x0f, 0x62, 0xba, 0xaf, 0x34, 0x79, 0x74, 0x9b, 0x45, 0x1a, 0x3b, 0x4d, 0x66,
+  0x11, 0x8d, 0x61, 0xba, 0x49, 0x04, 0x9a, 0x6a, 0xe8, 0x8e, 0xaf, 0xe0, 0xf4, 0x72, 0x71, 0x10,
+  0xd1, 0xf2, 0xca, 0x99, 0x38, 0xc0, 0x6d, 0xa6, 0xb9, 0x81, 0x55, 0x5b, 0x9e, 0xa3, 0x3e, 0x88,
+  0x39, 0xea, 0xbf, 0x19, 0x53, 0x33, 0x97, 0xd3, 0x2a, 0xf2, 0x1c, 0xa5, 0xbb, 0x6b, 0x49, 0x18,
+  0xe8, 0xb9, 0x26, 0x61, 0x4c, 0xd9, 0x03, 0xad, 0xa1, 0xe1, 0x86, 0x3e, 0x9a, 0x89, 0xcd, 0x0c,
+  0x5d, 0x4c, 0xa3, 0xf2, 0x06, 0xf2, 0x60, 0x8b, 0xbf, 0x87, 0xf8, 0xc2, 0x97, 0x98, 0xc1, 0x09,
+  0x39, 0x4d, 0xa2, 0x45, 0x79, 0xc5, 0x1e, 0xc0, 0x6e, 0xa9, 0x97, 0x82, 0xa7, 0xb7, 0xcb, 0x00,
+  0x6e, 0x10, 0x6c, 0x9a, 0x84, 0x86, 0x2c, 0x3e, 0x7c, 0x0f, 0xe3, 0xf2, 0x78, 0xc6, 0x9f, 0x8c,
+  0x7e, 0x9a, 0x16, 0x78, 0x82, 0x0d, 0x5c, 0x06, 0xca, 0x4d, 0xed, 0x93, 0x65, 0x84, 0x99, 0x09,
+  0xd8, 0xea, 0xd4, 0x4b, 0xe1, 0x6c, 0x65, 0x4b, 0x0d, 0x53, 0x23, 0x44, 0xfa, 0x6a, 0x19, 0x7c,
+  0xb5, 0x94, 0xaf, 0x21, 0x36, 0x8d, 0x6a, 0x3c, 0xf4, 0xeb, 0xed, 0x22, 0x40, 0xa7, 0xd7, 0x21,
+  0x8e, 0xe0, 0x3a, 0x48, 0x8d, 0x7b, 0xa3, 0x6d, 0x70, 0xd3, 0xce, 0xf2, 0x14, 0xea, 0x91, 0x70,
+  0x69, 0x94, 0xd8, 0x6e, 0xb5, 0x3b, 0x80, 0x6d, 0x19, 0x3c, 0xb6, 0xda, 0xd2, 0xa3, 0x58, 0xae,
+  0x20, 0xbf, 0x25, 0x26, 0xec, 0x71, 0xa7, 0x7e, 0x5c, 0x84, 0xe9, 0x63, 0xa9, 0xb7, 0xc4, 0x86,
+  0xe3, 0x5f, 0x42, 0x64, 0x44, 0x8e, 0x0d, 0x52, 0x8f, 0x95, 0xd4, 0x6f, 0x98, 0x2d, 0xb8, 0x31,
+  0xfa, 0x27, 0x9d, 0xfa, 0x49, 0x11, 0xa3, 0xcf, 0xe7, 0x2b, 0xc0, 0x3c, 0xf0, 0x07, 0xd3, 0xa1,
+  0x59, 0x3f, 0x2d, 0x42, 0xf4, 0xdd, 0xe2, 0x8a, 0xd0, 0x7f, 0xe1, 0x56, 0x68, 0xf2, 0x73, 0xda,
+  0x79, 0x0f, 0xe4, 0x01, 0x02, 0xaf, 0x21, 0x4b, 0x96, 0x0f, 0xb6, 0xc9, 0xfb, 0xae, 0xc6, 0x24,
+  0x12, 0xcb, 0x12, 0xe2, 0x0b, 0x00, 0xce, 0x8a, 0x00, 0x7d, 0x75, 0xf2, 0xf9, 0xc3, 0xa6, 0xbc,
+  0xb3, 0x1c, 0x39, 0x9a, 0x33, 0x43, 0xdc, 0xce, 0x54, 0xdc, 0x7a, 0x38, 0x7a, 0x32, 0x24, 0xbb,
+  0x1c, 0xe5, 0xa8, 0x4b, 0x09, 0x24, 0x05, 0x5b, 0xe6, 0x2a, 0x79, 0x3c, 0x1a, 0x52, 0x95, 0xa6,
+  0x72, 0x02, 0x12, 0x62, 0x1a, 0x18, 0x46, 0xd9, 0x97, 0x19, 0xb8, 0x28, 0x20, 0xbd, 0x35, 0x5e,
+  0x41, 0x7e, 0x9b, 0x62, 0xf6, 0x2e, 0xca, 0xe9, 0xef, 0x16, 0x90, 0x52, 0x79, 0x9b, 0x80, 0x91,
+  0x0d, 0xa4, 0x47, 0x12, 0x4e, 0x79, 0x12, 0x31, 0xc8, 0x94, 0xd7, 0x7c, 0x8a, 0x23, 0xc3, 0x85,
+  0xf8, 0x00, 0x2e, 0xc4, 0xf5, 0xe2, 0x8d, 0xf8, 0x20, 0xbd, 0x11, 0x7b, 0x3c, 0xe4, 0x2b, 0xb8,
+  0xb9, 0x0f, 0x62, 0x79, 0x40, 0x97, 0xd3, 0xe6, 0xe8, 0xbb, 0x54, 0x76, 0x34, 0xfa, 0x2e, 0x95,
+  0x9d, 0xe9, 0x2c, 0xfe, 0x8e, 0xb0, 0x34, 0x6b, 0x26, 0xb3, 0x07, 0xf3, 0x59, 0x7f, 0x60, 0x43,
+  0xf6, 0xb2, 0x4b, 0xb0, 0x66, 0x7a, 0xdd, 0x58, 0x71, 0xd3, 0x5e, 0xb0, 0x21, 0xa1, 0xd8, 0xc5,
+  0x8c, 0x62, 0xb7, 0xd2, 0x63, 0x07, 0x8a, 0x80, 0x5c, 0xb8, 0xae, 0x26, 0x5f, 0x8b, 0x8d, 0xe7,
+  0xdd, 0xb5, 0xa4, 0x78, 0xd6, 0x95, 0x94, 0xae, 0xfe, 0x32, 0xdc, 0x80, 0xad, 0x93, 0x5f, 0xc3,
+  0xd2, 0x3a, 0x46, 0xc2, 0x00, 0x07, 0x85, 0x94, 0xa3, 0x2b, 0x25, 0xb1, 0xc4, 0x42, 0x16, 0x61,
+  0x8c, 0x0b, 0x84, 0xd1, 0x5a, 0x57, 0x69, 0xf1, 0x92, 0x3f, 0xc5, 0x08, 0xc7, 0x50, 0x1a, 0xc6,
+  0x82, 0xaf, 0x72, 0x47, 0xfa, 0xf5, 0x83, 0x95, 0xa9, 0xee, 0x9c, 0xd7, 0xa5, 0x95, 0xca, 0x9b,
+  0xc6, 0xb4, 0x24, 0xad, 0x74, 0x35, 0xa1, 0x54, 0xa2, 0x3e, 0x67, 0x11, 0xd8, 0xaa, 0x27, 0x35,
+  0x46, 0x0b, 0xcf, 0xeb, 0xb1, 0xbc, 0x84, 0x16, 0xcf, 0xff, 0x6f, 0xfd, 0x2c, 0x9e, 0xf5, 0xa3,
+  0xa9, 0x84, 0x86, 0x6f, 0xf2, 0x49, 0x7f, 0x32, 0x6a, 0x2d, 0xd4, 0xbe, 0xaf, 0x7f, 0x0a, 0x20,
+  0xa2, 0x77, 0x32, 0xde, 0x97, 0x08, 0xea, 0xcb, 0x5c, 0x70, 0xce, 0x91, 0x7b, 0xcf, 0xc7, 0x17,
+  0xc3, 0x55, 0x22, 0x1d, 0x5c, 0x26, 0x49, 0x55, 0xeb, 0xe9, 0x64, 0xeb, 0x96, 0x7d, 0xf4, 0xc7,
+  0x76, 0x03, 0x3a, 0x4f, 0x03, 0xfd, 0xb2, 0x15, 0x4e, 0xce, 0x66, 0x70, 0x48, 0x2f, 0x8a, 0xee,
+  0xe5, 0x7f, 0x80, 0x82, 0x84, 0xdf, 0x2e, 0xe5, 0x54, 0xbd, 0xfe, 0x06, 0xd8, 0x66, 0xbf, 0x2c,
+  0x28, 0x7e, 0xfd, 0x1d, 0x90, 0xfa, 0xd3, 0x9d, 0x39, 0xa3, 0xe9, 0x82, 0xcc, 0xc6, 0xfd, 0xf6,
+  0x6b, 0x46, 0x95, 0xff, 0xde, 0x52, 0x3f, 0x46, 0xd2, 0x8e, 0x55, 0xfd, 0xc7, 0x00, 0x92, 0x5e,
+  0xc0, 0x9f, 0x80, 0x28, 0xe4, 0x58, 0xfe, 0x7b, 0xc8, 0xca, 0xf5, 0xb4, 0x38, 0x2f, 0xfe, 0xea,
+  0xba, 0x78, 0xd3, 0xf6, 0xa6, 0x90, 0x07, 0xaa, 0x8b, 0xbd, 0xff, 0x00, 0x73, 0xd8, 0x67, 0x4c,
+  0x90, 0x13, 0x00, 0x00
+};
+
+const WebAsset WEB_ASSETS[] = {
+  { "/style.css", "text/css", STYLE_CSS_GZ, sizeof(STYLE_CSS_GZ), "\"00b5d43f5dd79329\"" },
+  { "/settings.js", "application/javascript", SETTINGS_JS_GZ, sizeof(SETTINGS_JS_GZ), "\"42dc4333d5462e7a\"" }
+};
+
+#define WEB_ASSET_COUNT (sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]))
+
+#endif // WEB_ASSETS_H
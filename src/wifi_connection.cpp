@@ -0,0 +1,374 @@
+/*
+ * Implementation of the station connection engine
+ */
+
+#include "wifi_connection.h"
+#include "power.h"
+#include "logging.h"
+#include <ESP8266WiFi.h>
+#include <coredecls.h> // crc32()
+#include <EEPROM.h>
+
+// Bump when the record layout changes; older records are then ignored
+#define AP_CACHE_VERSION 1
+
+// How long one attempt may take before it counts as failed. An attempt on
+// the cached BSSID and channel either associates within a second or the
+// access point has moved, so it gets much less time than a scanning one.
+#define WIFI_FAST_ATTEMPT_TIMEOUT_MS 3000
+#define WIFI_ATTEMPT_TIMEOUT_MS 20000
+
+// Wait after a failed scanning attempt, doubled on every failure in a row
+#define WIFI_BACKOFF_MIN_MS 500
+#define WIFI_BACKOFF_MAX_MS 60000
+
+// Scanning attempts before a connection that never came up gives up
+#define WIFI_FIRST_CONNECT_ATTEMPTS 3
+
+// A reconnect reuses the DHCP lease as a static address for this long after
+// it was handed out; home routers lease for a day or more
+#define WIFI_LEASE_REUSE_MS (60UL * 60UL * 1000UL)
+
+// A connection that came up on the reused lease goes back to DHCP this long
+// after, so it does not keep a static address once the lease runs out
+#define WIFI_DHCP_RETURN_MS 5000
+
+// Reason code of the disconnect event that WiFi.begin() itself causes when
+// it leaves the previous association
+#define DISCONNECT_REASON_ASSOC_LEAVE 8
+
+namespace WifiConnection {
+    enum State {
+        STATE_IDLE,
+        STATE_CONNECTING,
+        STATE_CONNECTED,
+        STATE_BACKOFF
+    };
+
+    // Access point of the last connection, written as-is to EEPROM
+    struct AccessPointCache {
+        uint8_t version;
+        uint8_t channel;
+        uint8_t bssid[6];
+        uint32_t ssidCrc;       // Network the access point belongs to
+        uint32_t crc;           // Core crc32() of everything above
+    };
+
+    static_assert(WIFI_CACHE_OFFSET + sizeof(AccessPointCache) <= LOCATIONS_OFFSET, "access point cache overlaps the locations record");
+
+    static char ssid[33] = {0};
+    static char password[65] = {0};
+
+    static State state = STATE_IDLE;
+    static AccessPointCache apCache;
+    static bool apCacheValid = false;
+
+    // DHCP lease of the current session. It is not kept across reboots: there
+    // is no way to tell its age before the clock is set, and reusing an
+    // expired lease could collide with another device.
+    static bool haveLease = false;
+    static IPAddress leaseIp, leaseGateway, leaseMask, leaseDns;
+    static unsigned long leaseObtainedMs = 0;
+    static bool dhcpReturnDue = false;     // Connected on the lease, DHCP not back on yet
+    static unsigned long dhcpReturnAtMs = 0;
+    static bool dhcpRenewing = false;      // DHCP back on, waiting for its lease
+
+    // Current attempt
+    static bool attemptFast = false;      // On the cached BSSID and channel
+    static bool attemptOnLease = false;   // With the lease as static address
+    static unsigned long attemptStartMs = 0;
+    static unsigned long retryAtMs = 0;
+    static unsigned long backoffMs = WIFI_BACKOFF_MIN_MS;
+    static uint8_t scanFailures = 0;
+
+    static bool connectedOnce = false;
+    static unsigned long dropMs = 0;
+
+    // Set by the event callbacks, which run in the SDK's context; handled by service()
+    static volatile bool gotIpPending = false;
+    static volatile bool disconnectPending = false;
+    static volatile uint8_t disconnectReason = 0;
+    static WiFiEventHandler gotIpHandler;
+    static WiFiEventHandler disconnectedHandler;
+
+    // Statistics
+    static unsigned long bootToIpMs = 0;
+    static unsigned long reconnectMs = 0;
+    static uint32_t reconnects = 0;
+    static uint32_t failedAttempts = 0;
+    static bool lastFast = false;
+
+    static uint32_t ssidCrc() {
+        return crc32(ssid, strlen(ssid));
+    }
+
+    static uint32_t recordCrc(const AccessPointCache& cache) {
+        return crc32(&cache, offsetof(AccessPointCache, crc));
+    }
+
+    static void loadCache() {
+        EEPROM.begin(EEPROM_SIZE);
+        EEPROM.get(WIFI_CACHE_OFFSET, apCache);
+        EEPROM.end();
+
+        apCacheValid = apCache.version == AP_CACHE_VERSION && apCache.crc == recordCrc(apCache) &&
+                       apCache.ssidCrc == ssidCrc() && apCache.channel >= 1 && apCache.channel <= 14;
+        if (!apCacheValid) {
+            LOG_INFO("WiFi", "No cached access point for this network, first connect scans");
+        }
+    }
+
+    // Remember the access point we are associated with; flash is only written
+    // when it differs from the stored one
+    static void rememberAccessPoint() {
+        const uint8_t* bssid = WiFi.BSSID();
+        int32_t channel = WiFi.channel();
+        if (bssid == nullptr || channel < 1 || channel > 14) {
+            return;
+        }
+
+        uint32_t networkCrc = ssidCrc();
+        if (apCacheValid && apCache.channel == channel && apCache.ssidCrc == networkCrc &&
+            memcmp(apCache.bssid, bssid, sizeof(apCache.bssid)) == 0) {
+            return;
+        }
+
+        memset(&apCache, 0, sizeof(apCache));
+        apCache.version = AP_CACHE_VERSION;
+        apCache.channel = (uint8_t)channel;
+        memcpy(apCache.bssid, bssid, sizeof(apCache.bssid));
+        apCache.ssidCrc = networkCrc;
+        apCache.crc = recordCrc(apCache);
+        apCacheValid = true;
+
+        EEPROM.begin(EEPROM_SIZE);
+        EEPROM.put(WIFI_CACHE_OFFSET, apCache);
+        bool ok = EEPROM.commit();
+        EEPROM.end();
+
+        if (ok) {
+            LOG_INFO("WiFi", "Cached access point %s on channel %d", WiFi.BSSIDstr().c_str(), (int)channel);
+        } else {
+            LOG_ERROR("WiFi", "EEPROM commit failed, access point not cached");
+        }
+    }
+
+    // Fast attempts go straight to the cached access point, and on a
+    // reconnect also skip DHCP by reusing the lease
+    static void startAttempt(bool fast) {
+        attemptFast = fast && apCacheValid;
+        attemptOnLease = attemptFast && haveLease && millis() - leaseObtainedMs < WIFI_LEASE_REUSE_MS;
+
+        if (attemptOnLease) {
+            WiFi.config(leaseIp, leaseGateway, leaseMask, leaseDns);
+        } else {
+            // All zero addresses switch the station back to DHCP
+            WiFi.config(IPAddress(0, 0, 0, 0), IPAddress(0, 0, 0, 0), IPAddress(0, 0, 0, 0));
+        }
+
+        if (attemptFast) {
+            WiFi.begin(ssid, password, apCache.channel, apCache.bssid);
+        } else {
+            WiFi.begin(ssid, password);
+        }
+
+        state = STATE_CONNECTING;
+        attemptStartMs = millis();
+        LOG_INFO("WiFi", "Connecting to %s (%s%s)", ssid,
+                 attemptFast ? "cached access point" : "scanning",
+                 attemptOnLease ? ", reusing lease" : "");
+    }
+
+    static Event attemptFailed(const char* why) {
+        failedAttempts++;
+        LOG_WARN("WiFi", "Connect attempt failed: %s", why);
+
+        // The cached access point may have moved to another channel or been
+        // replaced; scan for the network right away
+        if (attemptFast) {
+            startAttempt(false);
+            return EVENT_NONE;
+        }
+
+        if (!connectedOnce && ++scanFailures >= WIFI_FIRST_CONNECT_ATTEMPTS) {
+            LOG_ERROR("WiFi", "All connection attempts failed");
+            state = STATE_IDLE;
+            return EVENT_GAVE_UP;
+        }
+
+        LOG_INFO("WiFi", "Retrying in %lu ms", backoffMs);
+        state = STATE_BACKOFF;
+        retryAtMs = millis() + backoffMs;
+        backoffMs = min(backoffMs * 2, (unsigned long)WIFI_BACKOFF_MAX_MS);
+        return EVENT_NONE;
+    }
+
+    static void recordLease(unsigned long now) {
+        leaseIp = WiFi.localIP();
+        leaseGateway = WiFi.gatewayIP();
+        leaseMask = WiFi.subnetMask();
+        leaseDns = WiFi.dnsIP(0);
+        leaseObtainedMs = now;
+        haveLease = true;
+    }
+
+    // Switch a connection made on the lease back to DHCP. The station keeps
+    // its address meanwhile, and the router normally hands out the same one.
+    static void returnToDhcp() {
+        dhcpReturnDue = false;
+        dhcpRenewing = true;
+        gotIpPending = false;
+        WiFi.config(IPAddress(0, 0, 0, 0), IPAddress(0, 0, 0, 0), IPAddress(0, 0, 0, 0));
+        LOG_INFO("WiFi", "Renewing the lease over DHCP");
+    }
+
+    static Event connected() {
+        unsigned long now = millis();
+        if (connectedOnce) {
+            reconnectMs = now - dropMs;
+            reconnects++;
+            LOG_INFO("WiFi", "Got IP %s %lu ms after the drop", WiFi.localIP().toString().c_str(), reconnectMs);
+        } else {
+            bootToIpMs = now;
+            LOG_INFO("WiFi", "Got IP %s %lu ms after boot", WiFi.localIP().toString().c_str(), bootToIpMs);
+        }
+
+        if (!attemptOnLease) {
+            recordLease(now);
+        }
+        dhcpReturnDue = attemptOnLease;
+        dhcpReturnAtMs = now + WIFI_DHCP_RETURN_MS;
+        dhcpRenewing = false;
+        rememberAccessPoint();
+
+        lastFast = attemptFast;
+        connectedOnce = true;
+        scanFailures = 0;
+        backoffMs = WIFI_BACKOFF_MIN_MS;
+        state = STATE_CONNECTED;
+        return EVENT_CONNECTED;
+    }
+
+    void begin(const char* newSsid, const char* newPassword) {
+        strncpy(ssid, newSsid, sizeof(ssid) - 1);
+        ssid[sizeof(ssid) - 1] = '\0';
+        strncpy(password, newPassword, sizeof(password) - 1);
+        password[sizeof(password) - 1] = '\0';
+
+        if (!gotIpHandler) {
+            gotIpHandler = WiFi.onStationModeGotIP([](const WiFiEventStationModeGotIP&) {
+                gotIpPending = true;
+            });
+            disconnectedHandler = WiFi.onStationModeDisconnected([](const WiFiEventStationModeDisconnected& event) {
+                disconnectReason = event.reason;
+                disconnectPending = true;
+            });
+        }
+
+        // Reconnects are ours to time, the SDK must not retry on its own
+        WiFi.persistent(false);  // Prevent credentials from being written to flash
+        WiFi.setAutoReconnect(false);
+        WiFi.mode(WIFI_STA);
+        // The radio sleeps between beacons only in a power saving mode
+        WiFi.setSleepMode(Power::wifiSleepType(), Power::mode() == POWER_MODE_FULL ? 0 : POWER_LISTEN_INTERVAL);
+
+        // A new network invalidates the lease, and the access point unless it matches
+        loadCache();
+        haveLease = false;
+        connectedOnce = false;
+        scanFailures = 0;
+        backoffMs = WIFI_BACKOFF_MIN_MS;
+        gotIpPending = false;
+        disconnectPending = false;
+        startAttempt(true);
+    }
+
+    Event service() {
+        if (state == STATE_IDLE) {
+            return EVENT_NONE;
+        }
+
+        if (disconnectPending) {
+            disconnectPending = false;
+            uint8_t reason = disconnectReason;
+
+            if (state == STATE_CONNECTED) {
+                LOG_WARN("WiFi", "Connection lost (reason %u), reconnecting", reason);
+                dropMs = millis();
+                gotIpPending = false;
+                dhcpReturnDue = false;
+                dhcpRenewing = false;
+                startAttempt(true);
+                return EVENT_DISCONNECTED;
+            }
+            if (state == STATE_CONNECTING && reason != DISCONNECT_REASON_ASSOC_LEAVE) {
+                char why[24];
+                snprintf(why, sizeof(why), "reason %u", reason);
+                return attemptFailed(why);
+            }
+        }
+
+        switch (state) {
+            case STATE_CONNECTING:
+                // Polling the status as well covers an event that went missing
+                if (gotIpPending || WiFi.status() == WL_CONNECTED) {
+                    gotIpPending = false;
+                    return connected();
+                }
+                if (millis() - attemptStartMs >= (attemptFast ? WIFI_FAST_ATTEMPT_TIMEOUT_MS : WIFI_ATTEMPT_TIMEOUT_MS)) {
+                    return attemptFailed("timed out");
+                }
+                break;
+
+            case STATE_BACKOFF:
+                if ((long)(millis() - retryAtMs) >= 0) {
+                    startAttempt(false);
+                }
+                break;
+
+            case STATE_CONNECTED:
+                if (dhcpRenewing && gotIpPending) {
+                    dhcpRenewing = false;
+                    recordLease(millis());
+                    LOG_INFO("WiFi", "DHCP lease renewed, IP %s", leaseIp.toString().c_str());
+                } else if (dhcpReturnDue && (long)(millis() - dhcpReturnAtMs) >= 0) {
+                    returnToDhcp();
+                }
+                gotIpPending = false;
+                break;
+
+            default:
+                gotIpPending = false;
+                break;
+        }
+        return EVENT_NONE;
+    }
+
+    bool isConnected() {
+        return state == STATE_CONNECTED;
+    }
+
+    bool everConnected() {
+        return connectedOnce;
+    }
+
+    unsigned long bootTimeToIpMs() {
+        return bootToIpMs;
+    }
+
+    unsigned long lastReconnectMs() {
+        return reconnectMs;
+    }
+
+    uint32_t reconnectCount() {
+        return reconnects;
+    }
+
+    uint32_t failedAttemptCount() {
+        return failedAttempts;
+    }
+
+    bool lastConnectWasFast() {
+        return lastFast;
+    }
+}
@@ -0,0 +1,46 @@
+/*
+ * Station connection engine for ESP-01 Weather Display
+ * Connects and reconnects without blocking loop(), driven by the WiFi event
+ * callbacks, with exponential backoff between failed attempts. The access
+ * point's BSSID and channel are kept in EEPROM so a connect can skip the scan,
+ * and a reconnect reuses the DHCP lease so it can skip DHCP as well; DHCP
+ * takes over again in the background once it is up.
+ */
+
+#ifndef WIFI_CONNECTION_H
+#define WIFI_CONNECTION_H
+
+#include <Arduino.h>
+#include "config.h"
+
+namespace WifiConnection {
+    // What service() has to report to the caller
+    enum Event {
+        EVENT_NONE,
+        EVENT_CONNECTED,     // Got an IP address
+        EVENT_DISCONNECTED,  // Lost the connection; reconnecting in the background
+        EVENT_GAVE_UP        // Never connected since begin() and out of attempts
+    };
+
+    // Start connecting to the given network. Returns at once; the outcome is
+    // reported by service().
+    void begin(const char* ssid, const char* password);
+
+    // Advance the connection: start attempts, time them out, back off.
+    // Call every 100 ms or so.
+    Event service();
+
+    bool isConnected();
+
+    // True once the first connection since begin() came up
+    bool everConnected();
+
+    // Statistics for /debug
+    unsigned long bootTimeToIpMs();       // From boot to the first IP, 0 before that
+    unsigned long lastReconnectMs();      // From the last drop to the IP again, 0 if none yet
+    uint32_t reconnectCount();
+    uint32_t failedAttemptCount();
+    bool lastConnectWasFast();            // Last IP came from the cached BSSID and channel
+}
+
+#endif // WIFI_CONNECTION_H
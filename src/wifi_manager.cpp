@@ -3,124 +3,95 @@
  */
 
 #include "wifi_manager.h"
-#include <EEPROM.h>
 #include <U8g2lib.h>
 #include "html_content.h"
+#include "html_template.h"
+#include "web_assets.h"
 #include "time_manager.h"
+#include "http_fetch.h"
+#include "weather_snapshot.h"
+#include "display.h"
+#include "scheduler.h"
+#include "wifi_connection.h"
+#include "wifi_scan.h"
+#include "settings.h"
+#include "time_zone.h"
+#include "power.h"
+#include "metrics.h"
+#include "logging.h"
+#include "ota.h"
+#include "locations.h"
+#include "solar.h"
+#include <stdarg.h>
 
-// Read WiFi credentials directly from EEPROM
+// Most requests answered in one serviceWebClients() call
+#define WEB_DRAIN_MAX 8
+
+// Most queries answered in one servicePortalDns() call
+#define DNS_DRAIN_MAX 8
+
+// A client counts as active this long after its last request
+#define WEB_CLIENT_ACTIVE_MS 3000
+
+// Paths operating systems request to find out whether a network has a
+// captive portal: Android, Apple, Windows and Firefox
+static const char* const CONNECTIVITY_PROBES[] = {
+  "/generate_204", "/gen_204",
+  "/hotspot-detect.html", "/library/test/success.html",
+  "/connecttest.txt", "/ncsi.txt", "/redirect",
+  "/canonical.html", "/success.txt"
+};
+
+// Counted by the request hook
+static uint32_t requestsHandled = 0;
+static unsigned long lastRequestAt = 0;
+static uint32_t probesAnswered = 0;
+
+// Read WiFi credentials from the settings record
 WiFiCredentials readWiFiCredentialsFromEEPROM() {
   WiFiCredentials creds;
-  
-  EEPROM.begin(EEPROM_SIZE);
-  
-  // Read the stored lengths from the new locations
-  uint8_t ssidLen = EEPROM.read(CONFIG_FLAG_OFFSET + 1);
-  uint8_t passLen = EEPROM.read(CONFIG_FLAG_OFFSET + 2);
-  
-  Serial.println("Reading WiFi configuration...");
-  
-  // Read SSID
-  char ssid[33] = {0};  // One extra byte for null terminator
-  for (int i = 0; i < min(ssidLen, (uint8_t)32); i++) {
-    ssid[i] = EEPROM.read(WIFI_SSID_OFFSET + i);
-  }
-  ssid[min(ssidLen, (uint8_t)32)] = '\0';
-  
-  // Read password
-  char password[65] = {0};  // One extra byte for null terminator
-  for (int i = 0; i < min(passLen, (uint8_t)64); i++) {
-    password[i] = EEPROM.read(WIFI_PASS_OFFSET + i);
-  }
-  password[min(passLen, (uint8_t)64)] = '\0';
-  
-  creds.ssid = String(ssid);
-  creds.password = String(password);
-  
-  Serial.println("WiFi configuration read successfully");
-  
+  const Settings& settings = SettingsStore::get();
+  creds.ssid = String(settings.ssid);
+  creds.password = String(settings.password);
   return creds;
 }
 
-// Load WiFi configuration from EEPROM
+// Load WiFi configuration and start connecting
 bool loadWiFiConfig() {
-  Serial.println("\n\n============ LOADING WIFI CONFIG ============");
-  
-  EEPROM.begin(EEPROM_SIZE);
-  
-  // Check if configuration flag is set
-  bool isConfigured = (EEPROM.read(CONFIG_FLAG_OFFSET) == 1);
-  
-  if (!isConfigured) {
-    Serial.println("No configuration found in EEPROM");
-    EEPROM.end();
-    return false;
-  }
-  
-  // Read the stored lengths from the new locations
-  uint8_t ssidLen = EEPROM.read(CONFIG_FLAG_OFFSET + 1);
-  uint8_t passLen = EEPROM.read(CONFIG_FLAG_OFFSET + 2);
-  
-  // Validate lengths
-  if (ssidLen == 0 || ssidLen > 32 || passLen > 64) {
-    Serial.println("ERROR: Invalid configuration lengths");
+  if (!SettingsStore::hasCredentials()) {
+    LOG_INFO("WiFi", "No configuration found in EEPROM");
     return false;
   }
   
-  // Read SSID and password from EEPROM
-  char ssid[33] = {0};  // One extra byte for null terminator
-  char password[65] = {0};  // One extra byte for null terminator
-  
-  // Read the SSID
-  for (int i = 0; i < ssidLen; i++) {
-    ssid[i] = EEPROM.read(WIFI_SSID_OFFSET + i);
-  }
-  ssid[ssidLen] = '\0'; // Ensure null termination
-  
-  // Read the password
-  for (int i = 0; i < passLen; i++) {
-    password[i] = EEPROM.read(WIFI_PASS_OFFSET + i);
-  }
-  password[passLen] = '\0'; // Ensure null termination
-  
-  EEPROM.end();
-  
-  // Basic validation
-  if (strlen(ssid) == 0) {
-    Serial.println("ERROR: Empty SSID found, returning to setup mode");
-    return false;
-  }
+  const Settings& settings = SettingsStore::get();
   
   // Check if SSID contains non-printable characters
   bool hasNonPrintable = false;
-  for (size_t i = 0; i < strlen(ssid); i++) {
-    if (!isprint(ssid[i])) {
+  for (size_t i = 0; i < strlen(settings.ssid); i++) {
+    if (!isprint(settings.ssid[i])) {
       hasNonPrintable = true;
       break;
     }
   }
   
   if (hasNonPrintable) {
-    Serial.println("ERROR: SSID contains non-printable characters, returning to setup mode");
+    LOG_ERROR("WiFi", "SSID contains non-printable characters, returning to setup mode");
     return false;
   }
   
-  Serial.println("Attempting to connect to WiFi network...");
+  LOG_INFO("WiFi", "Attempting to connect to WiFi network");
   
-  // Connect to WiFi
-  WiFi.begin(ssid, password);
+  // Start connecting; the connection comes up in the background
+  WifiConnection::begin(settings.ssid, settings.password);
   
   return true;
 }
 
-// Save WiFi configuration to EEPROM (simple, reliable approach)
+// Save WiFi configuration to the settings record
 void saveWiFiConfig(const char* ssid, const char* password) {
-  EEPROM.begin(EEPROM_SIZE);
-  
   // Basic validation
   if (ssid == nullptr || password == nullptr) {
-    Serial.println("ERROR: Invalid parameters");
-    EEPROM.end();
+    LOG_ERROR("WiFi", "Invalid parameters");
     return;
   }
   
@@ -129,202 +100,55 @@ void saveWiFiConfig(const char* ssid, const char* password) {
   
   // Validate lengths
   if (ssidLen == 0 || ssidLen > 32) {
-    Serial.println("ERROR: Invalid SSID length");
-    EEPROM.end();
+    LOG_ERROR("WiFi", "Invalid SSID length");
     return;
   }
   
   if (passLen > 64) {
-    Serial.println("ERROR: Password too long");
-    EEPROM.end();
+    LOG_ERROR("WiFi", "Password too long");
     return;
   }
   
-  Serial.println("Saving WiFi configuration...");
-  
-  // Write the configuration flag and lengths
-  uint8_t ssidLenByte = (uint8_t)ssidLen;
-  uint8_t passLenByte = (uint8_t)passLen;
-  
-  EEPROM.write(CONFIG_FLAG_OFFSET, 1);  // Use 1 as the config flag value
-  EEPROM.write(CONFIG_FLAG_OFFSET + 1, ssidLenByte);
-  EEPROM.write(CONFIG_FLAG_OFFSET + 2, passLenByte);
-  
-  // Write SSID and password
-  for (size_t i = 0; i < ssidLen; i++) {
-    EEPROM.write(WIFI_SSID_OFFSET + i, ssid[i]);
-  }
-  
-  for (size_t i = 0; i < passLen; i++) {
-    EEPROM.write(WIFI_PASS_OFFSET + i, password[i]);
-  }
+  LOG_INFO("WiFi", "Saving WiFi configuration");
   
-  // Clear any remaining bytes
-  for (size_t i = ssidLen; i < 32; i++) {
-    EEPROM.write(WIFI_SSID_OFFSET + i, 0);
-  }
-  for (size_t i = passLen; i < 64; i++) {
-    EEPROM.write(WIFI_PASS_OFFSET + i, 0);
-  }
+  Settings& settings = SettingsStore::get();
+  memset(settings.ssid, 0, sizeof(settings.ssid));
+  memset(settings.password, 0, sizeof(settings.password));
+  memcpy(settings.ssid, ssid, ssidLen);
+  memcpy(settings.password, password, passLen);
   
-  if (EEPROM.commit()) {
-    Serial.println("WiFi configuration saved successfully");
+  if (SettingsStore::save()) {
+    LOG_INFO("WiFi", "WiFi configuration saved");
   } else {
-    Serial.println("ERROR: Failed to save configuration");
+    LOG_ERROR("WiFi", "Failed to save configuration");
   }
 }
 
-// Connect to WiFi using saved credentials
-void connectToWifi() {
-  // Clean WiFi state and prepare for connection
-  Serial.println("Preparing WiFi hardware...");
-  WiFi.persistent(false);  // Prevent credentials from being written to flash
-  WiFi.disconnect(true);
-  WiFi.mode(WIFI_OFF);
-  delay(200);  // Increased delay to ensure WiFi hardware resets
-  
-  WiFi.mode(WIFI_STA);
-  delay(200);  // Give hardware time to switch modes
-  
-  // Apply optimal settings for faster connection
-  wifi_set_sleep_type(NONE_SLEEP_T);
-  WiFi.setAutoReconnect(true);
-  
-  // Display connecting message
-  drawConnectingScreen("Connecting to WiFi", "");
-  
-  // Load WiFi configuration
-  Serial.println("Loading credentials from EEPROM...");
+// Start connecting to WiFi using saved credentials. Returns at once; the
+// wifi task follows the connection and opens the portal if it never comes up.
+// Returns false if there are no usable credentials and the portal was started.
+bool connectToWifi() {
   bool configured = loadWiFiConfig();
   
   if (!configured) {
-    Serial.println("No WiFi configured, starting portal");
-    startConfigPortal();
-    return;
-  }
-  
-  Serial.println("Attempting to connect...");
-  
-  // Connection attempt with multiple retries
-  const int MAX_RETRIES = 3;
-  const unsigned long ATTEMPT_TIMEOUT = 20000; // 20 seconds per attempt
-  bool connected = false;
-  
-  for (int attempt = 0; attempt < MAX_RETRIES; attempt++) {
-    if (attempt > 0) {
-      Serial.printf("\nRetry attempt %d of %d\n", attempt + 1, MAX_RETRIES);
-      drawConnectingScreen("Retrying connection", String(attempt + 1) + " of " + String(MAX_RETRIES));
-      delay(1000);
-      
-      // Reset WiFi connection for retry - with different approach for subsequent attempts
-      Serial.println("Resetting WiFi state for retry");
-      WiFi.disconnect(true);
-      delay(200);
-      
-      // For odd-numbered attempts, use saved credentials
-      // For even-numbered attempts, read from EEPROM again
-      // This gives us two different methods of retry
-      if (attempt % 2 == 0) {
-        WiFi.begin(); // Use stored credentials from previous attempt
-      } else {
-        loadWiFiConfig(); // Reload from EEPROM
-      }
-    }
-    
-    unsigned long startAttempt = millis();
-    int dotCount = 0;
-    
-    while (millis() - startAttempt < ATTEMPT_TIMEOUT) {
-      // Check connection status
-      wl_status_t status = WiFi.status();
-      
-      if (status == WL_CONNECTED) {
-        connected = true;
-        break;
-      }
-      
-      // Display connection status for debugging
-      if ((millis() - startAttempt) % 2000 < 100) {
-        // Status code to string conversion directly inline
-        const char* statusStr = "UNKNOWN";
-        switch (status) {
-          case WL_CONNECTED: statusStr = "CONNECTED"; break;
-          case WL_NO_SHIELD: statusStr = "NO SHIELD"; break;
-          case WL_IDLE_STATUS: statusStr = "IDLE"; break;
-          case WL_NO_SSID_AVAIL: statusStr = "NO SSID AVAIL"; break;
-          case WL_SCAN_COMPLETED: statusStr = "SCAN COMPLETED"; break;
-          case WL_CONNECT_FAILED: statusStr = "CONNECT FAILED"; break;
-          case WL_CONNECTION_LOST: statusStr = "CONNECTION LOST"; break;
-          case WL_DISCONNECTED: statusStr = "DISCONNECTED"; break;
-          case WL_WRONG_PASSWORD: statusStr = "WRONG PASSWORD"; break;
-        }
-        Serial.printf("Status: %d (%s)\n", status, statusStr);
-      }
-      
-      // Update dots every 250ms for visual feedback
-      if ((millis() - startAttempt) % 250 < 50) {
-        dotCount = (dotCount + 1) % 4;
-        String dots = "";
-        for (int i = 0; i < dotCount; i++) dots += ".";
-        drawConnectingScreen("Connecting to WiFi", dots);
-      }
-      
-      delay(100); // Slightly longer delay to prevent thrashing
-    }
-    
-    if (connected) break;
-  }
-  
-  // If connected successfully
-  if (connected) {
-    Serial.println("\nWiFi connected successfully!");
-    Serial.printf("IP address: %s\n", WiFi.localIP().toString().c_str());
-    
-    // Show successful connection on display
-    drawConnectingScreen("Connected!", "IP: " + WiFi.localIP().toString());
-    delay(1000);
-    
-    // Start web server
-    server.stop(); // Stop any existing server
-    setupWebServer();
-    server.begin();
-  } else {
-    Serial.println("\nAll connection attempts failed, starting portal");
-    drawConnectingScreen("Connection failed", "Starting portal...");
-    delay(1000);
+    LOG_INFO("WiFi", "No WiFi configured, starting portal");
     startConfigPortal();
+    return false;
   }
+  return true;
 }
 
 // Format/clear WiFi credentials in EEPROM 
 void formatCredentials() {
-  Serial.println("Formatting WiFi credentials in EEPROM...");
+  LOG_INFO("WiFi", "Formatting WiFi credentials in EEPROM");
   drawConnectingScreen("Formatting", "WiFi credentials");
   
-  EEPROM.begin(EEPROM_SIZE);
-  
-  // Clear config flag first
-  EEPROM.write(CONFIG_FLAG_OFFSET, 0);
-  
-  // Clear credential lengths in new locations
-  EEPROM.write(CONFIG_FLAG_OFFSET + 1, 0);
-  EEPROM.write(CONFIG_FLAG_OFFSET + 2, 0);
+  Settings& settings = SettingsStore::get();
+  memset(settings.ssid, 0, sizeof(settings.ssid));
+  memset(settings.password, 0, sizeof(settings.password));
+  SettingsStore::save();
   
-  // Clear SSID area
-  for (int i = WIFI_SSID_OFFSET; i < WIFI_PASS_OFFSET; i++) {
-    EEPROM.write(i, 0);
-  }
-  
-  // Clear password area
-  for (int i = WIFI_PASS_OFFSET; i < WIFI_PASS_OFFSET + 64; i++) {
-    EEPROM.write(i, 0);
-  }
-  
-  // Commit changes
-  EEPROM.commit();
-  EEPROM.end();
-  
-  Serial.println("Credentials formatted successfully");
+  LOG_INFO("WiFi", "Credentials formatted");
   delay(1000);
 }
 
@@ -333,7 +157,7 @@ void startConfigPortal() {
   // No automatic formatting - credentials should persist across portal sessions
   // formatCredentials();  // Removed automatic formatting
   
-  Serial.println("Starting configuration portal WITHOUT formatting credentials");
+  LOG_INFO("Portal", "Starting configuration portal, stored credentials are kept");
   
   // Ensure we're disconnected from any STA mode connection
   WiFi.disconnect(true);
@@ -351,37 +175,193 @@ void startConfigPortal() {
   // Configure DNS server to redirect all domains to AP IP
   dnsServer.start(DNS_PORT, "*", apIP);
   
+  // Have the network list ready by the time a client opens the page
+  WifiScan::request(true);
+  
   // Stop any existing server and start web server
   server.stop();
   setupWebServer();
   server.begin();
   
-  Serial.println("Configuration Portal Started");
-  Serial.printf("IP address: %s\n", apIP.toString().c_str());
+  LOG_INFO("Portal", "Configuration portal started at %s", apIP.toString().c_str());
   
   // Show configuration mode on display
   drawConfigMode();
 }
 
+// Send a gzipped static asset, or 304 if the client's copy is current.
+// Browsers cache it for a day and revalidate with the ETag after that.
+static void sendWebAsset(const WebAsset& asset) {
+  server.sendHeader("ETag", asset.etag);
+  server.sendHeader("Cache-Control", "max-age=86400");
+  if (server.header("If-None-Match") == asset.etag) {
+    server.send(304, asset.contentType, "");
+    return;
+  }
+  // Every browser accepts gzip, so there is no uncompressed copy
+  server.sendHeader("Content-Encoding", "gzip");
+  server.send_P(200, asset.contentType, (PGM_P)asset.data, asset.length);
+}
+
 // Setup the web server routes
+// One formatted line of the /debug page
+static void debugLine(TemplateWriter& out, const char* format, ...) {
+  char text[160];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+  out.print(text);
+}
+
+// Device status as plain text, streamed in chunks like /metrics
+static void sendDebugInfo() {
+  LOG_DEBUG("Web", "DEBUG endpoint accessed");
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "text/plain", "");
+  TemplateWriter out(server);
+  
+  out.print("ESP8266 Web Server Debug Info\n\n");
+  debugLine(out, "WiFi Mode: %s\n", WiFi.getMode() == WIFI_AP ? "Access Point" : "Station");
+  debugLine(out, "IP Address: %s\n", WiFi.localIP().toString().c_str());
+  debugLine(out, "MAC Address: %s\n", WiFi.macAddress().c_str());
+  debugLine(out, "Free Heap: %lu bytes\n", (unsigned long)ESP.getFreeHeap());
+  debugLine(out, "Uptime: %lu seconds\n", millis() / 1000);
+  debugLine(out, "Active Connections: %d\n", server.client().available());
+  debugLine(out, "Web Requests / Connectivity Probes Answered: %lu / %lu\n", (unsigned long)requestsHandled, (unsigned long)probesAnswered);
+  debugLine(out, "Weather Fetch Max Stall: %lu ms\n", Weather::maxStallMs());
+  debugLine(out, "Weather Fetch Last Duration: %lu ms\n", HttpFetch::lastDurationMs());
+  debugLine(out, "Weather Parse Peak: %lu bytes\n", (unsigned long)Weather::peakParseBytes());
+  debugLine(out, "Weather Lowest Free Heap: %lu bytes\n", (unsigned long)Weather::lowestFreeHeap());
+  Weather::CacheStats cacheStats = Weather::responseCacheStats();
+  debugLine(out, "Weather Cache Hits / 304s / Full Fetches: %lu / %lu / %lu\n",
+            (unsigned long)cacheStats.hits, (unsigned long)cacheStats.notModified, (unsigned long)cacheStats.fullFetches);
+  debugLine(out, "Weather Cache Bytes Saved: %lu bytes\n", (unsigned long)cacheStats.bytesSaved);
+  debugLine(out, "HTTP Connections Opened / Requests On A Reused One: %lu / %lu\n",
+            (unsigned long)HttpFetch::connectionCount(), (unsigned long)HttpFetch::reusedCount());
+  out.print("Weather Locations:");
+  for (uint8_t i = 0; i < Locations::count(); i++) {
+    debugLine(out, "%s %s%s", i > 0 ? "," : "", Locations::city(i).c_str(), Locations::hasWeather(i) ? "" : " (no data yet)");
+  }
+  out.print("\n");
+  debugLine(out, "Sunrise / Sunset / Sun Elevation: %02d:%02d / %02d:%02d / ", sunriseHour, sunriseMinute, sunsetHour, sunsetMinute);
+  if (Solar::computed()) {
+    debugLine(out, "%.1f deg", Solar::elevationAt(getEpochTime()));
+  } else {
+    out.print("-");
+  }
+  out.print(Solar::polarDay() ? " (polar day)\n" : Solar::polarNight() ? " (polar night)\n" :
+            Solar::computed() ? " (ephemeris)\n" : " (not computed yet)\n");
+  debugLine(out, "Weather Snapshot Writes / Skipped: %lu / %lu%s\n", (unsigned long)WeatherSnapshot::writeCount(),
+            (unsigned long)WeatherSnapshot::skippedCount(), weatherDataStale ? " (showing stale snapshot)" : "");
+  out.print("Display Transport / Buffer: " DISPLAY_TRANSPORT_NAME " / " DISPLAY_BUFFER_NAME "\n");
+  debugLine(out, "Display Frames / Tile Rows Pushed: %u / %u per minute\n", framesPushedPerMinute(), tileRowsPushedPerMinute());
+  debugLine(out, "WiFi Time To IP After Boot / Last Reconnect: %lu / %lu ms%s\n", WifiConnection::bootTimeToIpMs(),
+            WifiConnection::lastReconnectMs(), WifiConnection::lastConnectWasFast() ? " (cached access point)" : "");
+  debugLine(out, "WiFi Reconnects / Failed Attempts: %lu / %lu\n",
+            (unsigned long)WifiConnection::reconnectCount(), (unsigned long)WifiConnection::failedAttemptCount());
+  debugLine(out, "WiFi Scans / Last Scan / Networks Listed: %lu / %lu ms / %u\n",
+            (unsigned long)WifiScan::scanCount(), WifiScan::lastScanMs(), WifiScan::count());
+  ClockStats clock = clockStats();
+  debugLine(out, "NTP Syncs / Interval / Since Last: %lu / %lu s / %lu s\n",
+            (unsigned long)clock.syncs, (unsigned long)(clock.syncIntervalMs / 1000), clock.sinceSyncMs / 1000);
+  debugLine(out, "Clock Drift / Offset At Last Sync: %.1f ppm / %ld ms\n", clock.driftPpm, clock.lastOffsetMs);
+  Power::DutyCycle duty = Power::dutyCycle();
+  debugLine(out, "Power Mode / CPU Active / Full Speed / Fetching: %u / %u%% / %u%% / %u%%\n",
+            Power::mode(), duty.cpuActivePct, duty.fullSpeedPct, duty.fetchPct);
+  debugLine(out, "Display On / Dimmed: %u%% / %u%%\n", duty.displayOnPct, duty.displayDimPct);
+  Ota::Stats ota = Ota::stats();
+  debugLine(out, "Firmware / OTA State / Manifest Version: " FIRMWARE_VERSION " / %s / %s", Ota::enabled() ? Ota::stateName() : "off", Ota::availableVersion());
+  if (Ota::lastError()[0]) {
+    debugLine(out, " (%s)", Ota::lastError());
+  }
+  out.print("\n");
+  debugLine(out, "OTA Checks / 304s / Downloads / Resumes / Failures: %lu / %lu / %lu / %lu / %lu\n",
+            (unsigned long)ota.checks, (unsigned long)ota.notModified, (unsigned long)ota.downloads,
+            (unsigned long)ota.resumes, (unsigned long)ota.failures);
+  debugLine(out, "Log Bytes Written / Dropped Before UART: %lu / %lu\n", (unsigned long)Log::bytesLogged(), (unsigned long)Log::bytesDropped());
+  debugLine(out, "Settings Load / Commits / Unchanged Saves: %lu us / %lu / %lu\n", SettingsStore::loadMicros(),
+            (unsigned long)SettingsStore::commitCount(), (unsigned long)SettingsStore::skippedCount());
+  DisplayHeapStats heapStats = displayHeapStats();
+  debugLine(out, "Display Frames Drawn / Changing Heap: %lu / %lu\n", (unsigned long)heapStats.frames, (unsigned long)heapStats.framesChangingHeap);
+  debugLine(out, "Lowest Free Heap While Drawing: %lu bytes, fragmentation %u%%\n", (unsigned long)heapStats.minFreeHeap, heapStats.fragmentation);
+  debugLine(out, "Max Free Block Before/After Fetch: %lu / %lu bytes\n",
+            (unsigned long)Weather::maxFreeBlockBeforeFetch(), (unsigned long)Weather::maxFreeBlockAfterFetch());
+  
+  // Scheduler task statistics
+  out.print("\nTasks (runs, avg/max us, missed deadlines, over budget):\n");
+  for (uint8_t i = 0; i < scheduler.taskCount(); i++) {
+    const Scheduler::Task& task = scheduler.task(i);
+    uint32_t avgUs = task.runs > 0 ? (uint32_t)(task.totalUs / task.runs) : 0;
+    debugLine(out, "  %s: %lu, %lu/%lu us, %lu missed, %lu over %lu us\n", task.name, (unsigned long)task.runs,
+              (unsigned long)avgUs, (unsigned long)task.maxUs, (unsigned long)task.missedDeadlines,
+              (unsigned long)task.overBudget, (unsigned long)task.budgetUs);
+  }
+  
+  out.flush();
+  server.sendContent("");
+}
+
 void setupWebServer() {
+  // The server only keeps the request headers it is told to collect
+  static const char* collectedHeaders[] = { "If-None-Match" };
+  server.collectHeaders(collectedHeaders, 1);
+  
+  // Someone is using the web interface; leave the power saving pace until they stop
+  server.addHook([](const String&, const String&, WiFiClient*, ESP8266WebServer::ContentTypeFunction) {
+    requestsHandled++;
+    lastRequestAt = millis();
+    Power::stayAwake();
+    return ESP8266WebServer::CLIENT_REQUEST_CAN_CONTINUE;
+  });
+  
+  // Static assets, shared by all pages
+  for (size_t i = 0; i < WEB_ASSET_COUNT; i++) {
+    const WebAsset* asset = &WEB_ASSETS[i];
+    server.on(asset->path, HTTP_GET, [asset]() { sendWebAsset(*asset); });
+  }
+  
   // Add debug handler to test server connectivity
-  server.on("/debug", HTTP_GET, []() {
-    Serial.println("DEBUG endpoint accessed");
-    String debugInfo = "ESP8266 Web Server Debug Info\n\n";
-    debugInfo += "WiFi Mode: " + String(WiFi.getMode() == WIFI_AP ? "Access Point" : "Station") + "\n";
-    debugInfo += "IP Address: " + WiFi.localIP().toString() + "\n";
-    debugInfo += "MAC Address: " + WiFi.macAddress() + "\n";
-    debugInfo += "Free Heap: " + String(ESP.getFreeHeap()) + " bytes\n";
-    debugInfo += "Uptime: " + String(millis() / 1000) + " seconds\n";
-    debugInfo += "Active Connections: " + String(server.client().available()) + "\n";
-    
-    server.send(200, "text/plain", debugInfo);
+  server.on("/debug", HTTP_GET, sendDebugInfo);
+  
+  // Recent log messages, oldest first
+  server.on("/log", HTTP_GET, []() {
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "text/plain; charset=utf-8", "");
+    TemplateWriter out(server);
+    Log::read([](const char* data, size_t length, void* context) {
+      TemplateWriter& writer = *static_cast<TemplateWriter*>(context);
+      for (size_t i = 0; i < length; i++) {
+        writer.write(data[i]);
+      }
+    }, &out);
+    out.flush();
+    server.sendContent("");
+  });
+  
+  // Prometheus scrape target, streamed in chunks
+  server.on("/metrics", HTTP_GET, []() {
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "text/plain; version=0.0.4", "");
+    TemplateWriter out(server);
+    Metrics::write(out);
+    out.flush();
+    server.sendContent("");
+  });
+  
+  // Check the update manifest within the next minute instead of waiting hours
+  server.on("/ota/check", HTTP_POST, []() {
+    if (!Ota::enabled()) {
+      server.send(404, "text/plain", "Updates are not configured in this build");
+      return;
+    }
+    Ota::requestCheck();
+    server.send(202, "text/plain", "Update check requested");
   });
   
   // Add a simple test endpoint that just returns "OK"
   server.on("/test", HTTP_GET, []() {
-    Serial.println("TEST endpoint accessed");
+    LOG_DEBUG("Web", "TEST endpoint accessed");
     server.send(200, "text/plain", "OK - Web server is running!");
   });
   
@@ -391,45 +371,113 @@ void setupWebServer() {
   server.on("/settings", HTTP_GET, handleSettings);
   server.on("/settingssave", HTTP_POST, handleSettingsSave);
   
+  // Answer connectivity probes with an empty redirect to the setup page, so
+  // the phone opens its sign-in sheet at once; phones send these often, so
+  // they skip the not-found log
+  for (size_t i = 0; i < sizeof(CONNECTIVITY_PROBES) / sizeof(CONNECTIVITY_PROBES[0]); i++) {
+    server.on(CONNECTIVITY_PROBES[i], HTTP_ANY, []() {
+      probesAnswered++;
+      server.sendHeader("Location", String("http://") + apIP.toString() + "/", true);
+      server.sendHeader("Cache-Control", "no-store");
+      server.send(302, "text/plain", "");
+    });
+  }
+  
   // Handle not found (404) - redirect to root
   server.onNotFound([]() {
-    Serial.println("404 Not Found: " + server.uri());
+    LOG_INFO("Web", "404 Not Found: %s", server.uri().c_str());
     server.sendHeader("Location", "/", true);
     server.send(302, "text/plain", "");
   });
 }
 
+void serviceWebClients() {
+  // A request answered may have another waiting behind it
+  for (uint8_t i = 0; i < WEB_DRAIN_MAX; i++) {
+    uint32_t before = requestsHandled;
+    server.handleClient();
+    if (requestsHandled == before) {
+      break;
+    }
+  }
+}
+
+void servicePortalDns() {
+  // Each call answers at most one query; an idle call only polls the socket
+  for (uint8_t i = 0; i < DNS_DRAIN_MAX; i++) {
+    dnsServer.processNextRequest();
+  }
+}
+
+bool webClientActive() {
+  return requestsHandled > 0 && millis() - lastRequestAt < WEB_CLIENT_ACTIVE_MS;
+}
+
+// Selected attribute of a select option
+static const char* selectedIf(bool selected) {
+  return selected ? "selected" : "";
+}
+
+// Placeholders of the WiFi configuration page
+static const TemplateToken ROOT_TOKENS[] = {
+  { "CURRENT_SSID", [](TemplateWriter& out) {
+      // The current SSID if connected
+      if (WiFi.status() == WL_CONNECTED) {
+        out.print(WiFi.SSID().c_str());
+      }
+    } }
+};
+
 // Handle root page request
 void handleRoot() {
-  String html = FPSTR(HTML_HEADER);
-  html += FPSTR(WIFI_CONFIG_HTML);
-  
-  // Replace placeholder with current SSID if connected
-  if (WiFi.status() == WL_CONNECTED) {
-    html.replace("%CURRENT_SSID%", WiFi.SSID());
-  } else {
-    html.replace("%CURRENT_SSID%", "");
+  static const char* const parts[] = { HTML_HEADER, WIFI_CONFIG_HTML };
+  sendTemplate(server, 200, "text/html", parts, 2, ROOT_TOKENS, sizeof(ROOT_TOKENS) / sizeof(ROOT_TOKENS[0]));
+}
+
+// Write text as the inside of a JSON string
+static void printJsonString(TemplateWriter& out, const char* text) {
+  for (; *text; text++) {
+    char c = *text;
+    if (c == '"' || c == '\\') {
+      out.write('\\');
+      out.write(c);
+    } else if ((uint8_t)c < 0x20) {
+      char escaped[7];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      out.print(escaped);
+    } else {
+      out.write(c);
+    }
   }
-  
-  server.send(200, "text/html", html);
 }
 
-// Handle WiFi network scanning
+// Handle WiFi network scanning. Answers at once from the background scan's
+// table; ?refresh=1 asks for a new scan, which the page then polls for.
 void handleWifiScan() {
-  // Scan for WiFi networks
-  int numNetworks = WiFi.scanNetworks();
-  String jsonResponse = "[";
-  
-  for (int i = 0; i < numNetworks; i++) {
-    if (i > 0) jsonResponse += ",";
-    jsonResponse += "{\"ssid\":\"" + WiFi.SSID(i) + "\",\"rssi\":" + String(WiFi.RSSI(i)) + "}";
-  }
-  
-  jsonResponse += "]";
-  server.send(200, "application/json", jsonResponse);
-  
-  // Free memory by deleting scan results
-  WiFi.scanDelete();
+  WifiScan::request(server.hasArg("refresh"));
+  
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+  
+  TemplateWriter out(server);
+  out.print("{\"scanning\":");
+  out.print(WifiScan::isScanning() ? "true" : "false");
+  out.print(",\"ageMs\":");
+  out.print((long)WifiScan::ageMs());
+  out.print(",\"networks\":[");
+  for (uint8_t i = 0; i < WifiScan::count(); i++) {
+    const WifiScan::Network& network = WifiScan::network(i);
+    out.print(i > 0 ? ",{\"ssid\":\"" : "{\"ssid\":\"");
+    printJsonString(out, network.ssid);
+    out.print("\",\"rssi\":");
+    out.print((long)network.rssi);
+    out.print(network.open ? ",\"open\":true}" : ",\"open\":false}");
+  }
+  out.print("]}");
+  out.flush();
+  
+  // An empty chunk ends the response
+  server.sendContent("");
 }
 
 // Handle save configuration request
@@ -439,7 +487,7 @@ void handleSave() {
     String password = server.arg("password");
     
     // Debug info
-    Serial.println("\n=== Saving WiFi Credentials ===");
+    LOG_INFO("Portal", "Saving WiFi credentials");
     
     // Show saving on display
     drawConnectingScreen("Saving credentials", "Please wait...");
@@ -448,143 +496,104 @@ void handleSave() {
     saveWiFiConfig(ssid.c_str(), password.c_str());
     
     // Send success page to client
-    String html = FPSTR(HTML_HEADER);
-    html.replace("</head>", "<meta http-equiv='refresh' content='5;url=/'></head>");
-    
-    String successHtml = FPSTR(WIFI_SAVE_SUCCESS_HTML);
-    successHtml.replace("%SSID%", ssid);
-    successHtml.replace("%PASSWORD%", password);
-    successHtml.replace("%PASSLEN%", String(password.length()));
-    
-    html += successHtml;
-    server.send(200, "text/html", html);
+    static const TemplateToken saveTokens[] = {
+      { "SSID", [](TemplateWriter& out) { out.print(server.arg("ssid").c_str()); } },
+      { "PASSWORD", [](TemplateWriter& out) { out.print(server.arg("password").c_str()); } },
+      { "PASSLEN", [](TemplateWriter& out) { out.print((long)server.arg("password").length()); } }
+    };
+    static const char* const parts[] = { HTML_HEADER, WIFI_SAVE_SUCCESS_HTML };
+    sendTemplate(server, 200, "text/html", parts, 2, saveTokens, sizeof(saveTokens) / sizeof(saveTokens[0]));
     
     // Wait a moment to ensure page is sent
     delay(1000);
     
     // Prepare for connection attempt with the new credentials
-    Serial.println("Shutting down AP and attempting to connect with new credentials");
+    LOG_INFO("Portal", "Shutting down AP and attempting to connect with new credentials");
     
     // Properly shut down AP mode
     WiFi.softAPdisconnect(true);
     dnsServer.stop();
     
-    // Clear all WiFi settings to ensure a clean state
-    WiFi.disconnect(true);
-    WiFi.mode(WIFI_OFF);
-    delay(500);
-    
-    // Start fresh with new credentials in STA mode
-    WiFi.mode(WIFI_STA);
-    WiFi.begin(ssid.c_str(), password.c_str());
-    
-    // Display connecting screen
+    // Connect with the new credentials in the background; the wifi task
+    // brings the services up once connected, or reopens the portal
     drawConnectingScreen("Connecting", "with new credentials");
-    
-    // Connection attempt - 15 second timeout
-    unsigned long startAttempt = millis();
-    bool connected = false;
-    
-    // More robust connection attempt with visual feedback
-    while (millis() - startAttempt < 15000) {
-      if (WiFi.status() == WL_CONNECTED) {
-        connected = true;
-        break;
-      }
-      
-      // Visual feedback
-      int dots = ((millis() - startAttempt) / 500) % 4;
-      String dotStr = "";
-      for (int i = 0; i < dots; i++) dotStr += ".";
-      drawConnectingScreen("Connecting", dotStr);
-      
-      delay(100);
-    }
-    
-    if (connected) {
-      Serial.println("Connected successfully with new credentials!");
-      Serial.printf("IP: %s\n", WiFi.localIP().toString().c_str());
-      
-      // Show connection success
-      drawConnectingScreen("Connected!", "IP: " + WiFi.localIP().toString());
-      delay(1000);
-      
-      // Restart web server in STA mode
-      server.stop();
-      setupWebServer();
-      server.begin();
-    } else {
-      Serial.println("Failed to connect with new credentials, restarting device");
-      drawConnectingScreen("Connection failed", "Restarting device...");
-      delay(2000);
-      
-      // Force a complete restart as a last resort to get to a clean state
-      ESP.restart();
-    }
+    connectToWifi();
   } else {
     server.send(400, "text/plain", "Missing SSID or password");
   }
 }
 
-// Handle settings page request
-void handleSettings() {
-  String html = FPSTR(HTML_HEADER);
-  String settingsHtml = FPSTR(WEATHER_SETTINGS_HTML);
-  
-  // Get WiFi credentials from EEPROM
-  WiFiCredentials creds = readWiFiCredentialsFromEEPROM();
-  
-  Serial.println("\n=== Handling Settings Page Request ===");
-  Serial.printf("SSID to display: '%s'\n", creds.ssid.c_str());
-  
-  // Replace placeholders
-  settingsHtml.replace("%CITY%", cityName);
-  settingsHtml.replace("%STATE%", stateName);
-  settingsHtml.replace("%TIMEZONE%", String(timezone));
-  settingsHtml.replace("%API_KEY%", API_KEY);
-  settingsHtml.replace("%WIFI_SSID%", WiFi.SSID());
-  
-  // Set time format selection
-  settingsHtml.replace("%24HOUR_SELECTED%", use12HourFormat ? "" : "selected");
-  settingsHtml.replace("%12HOUR_SELECTED%", use12HourFormat ? "selected" : "");
-  
-  // Set DST selection
-  settingsHtml.replace("%DST_OFF_SELECTED%", useDST ? "" : "selected");
-  settingsHtml.replace("%DST_ON_SELECTED%", useDST ? "selected" : "");
+// Placeholders of the settings page
+static const TemplateToken SETTINGS_TOKENS[] = {
+  { "CITY", [](TemplateWriter& out) { out.print(cityName.c_str()); } },
+  { "STATE", [](TemplateWriter& out) { out.print(stateName.c_str()); } },
+  { "CITY2", [](TemplateWriter& out) { out.print(Locations::count() > 1 ? Locations::city(1).c_str() : ""); } },
+  { "STATE2", [](TemplateWriter& out) { out.print(Locations::count() > 1 ? Locations::state(1).c_str() : ""); } },
+  { "CITY3", [](TemplateWriter& out) { out.print(Locations::count() > 2 ? Locations::city(2).c_str() : ""); } },
+  { "STATE3", [](TemplateWriter& out) { out.print(Locations::count() > 2 ? Locations::state(2).c_str() : ""); } },
+  { "TIMEZONE", [](TemplateWriter& out) { out.print(TimeZone::rule()); } },
+  { "API_KEY", [](TemplateWriter& out) { out.print(API_KEY.c_str()); } },
+  { "WIFI_SSID", [](TemplateWriter& out) { out.print(WiFi.SSID().c_str()); } },
+  
+  // Time format selection
+  { "24HOUR_SELECTED", [](TemplateWriter& out) { out.print(selectedIf(!use12HourFormat)); } },
+  { "12HOUR_SELECTED", [](TemplateWriter& out) { out.print(selectedIf(use12HourFormat)); } },
   
   // Temperature unit selection
-  settingsHtml.replace("%FAHRENHEIT_SELECTED%", useMetricUnits ? "" : "selected");
-  settingsHtml.replace("%CELSIUS_SELECTED%", useMetricUnits ? "selected" : "");
-  
-  // Generate interval options
-  String intervalOptions = "";
-  int intervals[] = {1, 5, 10, 15, 30, 60};
-  int currentInterval = WEATHER_UPDATE_INTERVAL / 60000;
-  
-  for (int i = 0; i < 6; i++) {
-    intervalOptions += "<option value='" + String(intervals[i]) + "'";
-    if (intervals[i] == currentInterval) {
-      intervalOptions += " selected";
-    }
-    intervalOptions += ">" + String(intervals[i]) + " minute";
-    if (intervals[i] > 1) intervalOptions += "s";
-    intervalOptions += "</option>";
-  }
-  
-  settingsHtml.replace("%INTERVALS%", intervalOptions);
-  
-  Serial.println("Placeholders replaced in template");
-  Serial.println("================================\n");
-  
-  html += settingsHtml;
-  server.send(200, "text/html", html);
+  { "FAHRENHEIT_SELECTED", [](TemplateWriter& out) { out.print(selectedIf(!useMetricUnits)); } },
+  { "CELSIUS_SELECTED", [](TemplateWriter& out) { out.print(selectedIf(useMetricUnits)); } },
+  
+  // Weather provider selection
+  { "PROVIDER_OWM_SELECTED", [](TemplateWriter& out) { out.print(selectedIf(weatherProvider == WEATHER_PROVIDER_OPENWEATHERMAP)); } },
+  { "PROVIDER_OPENMETEO_SELECTED", [](TemplateWriter& out) { out.print(selectedIf(weatherProvider == WEATHER_PROVIDER_OPENMETEO)); } },
+  
+  // Power selections
+  { "POWER_FULL_SELECTED", [](TemplateWriter& out) { out.print(selectedIf(Power::mode() == POWER_MODE_FULL)); } },
+  { "POWER_MODEM_SELECTED", [](TemplateWriter& out) { out.print(selectedIf(Power::mode() == POWER_MODE_MODEM_SLEEP)); } },
+  { "POWER_LIGHT_SELECTED", [](TemplateWriter& out) { out.print(selectedIf(Power::mode() == POWER_MODE_LIGHT_SLEEP)); } },
+  { "NIGHT_ON_SELECTED", [](TemplateWriter& out) { out.print(selectedIf(Power::nightDisplay() == NIGHT_DISPLAY_ON)); } },
+  { "NIGHT_DIM_SELECTED", [](TemplateWriter& out) { out.print(selectedIf(Power::nightDisplay() == NIGHT_DISPLAY_DIM)); } },
+  { "NIGHT_OFF_SELECTED", [](TemplateWriter& out) { out.print(selectedIf(Power::nightDisplay() == NIGHT_DISPLAY_OFF)); } },
+  
+  // Update interval options
+  { "INTERVALS", [](TemplateWriter& out) {
+      static const int intervals[] = {1, 5, 10, 15, 30, 60};
+      int currentInterval = WEATHER_UPDATE_INTERVAL / 60000;
+      for (int i = 0; i < 6; i++) {
+        char option[64];
+        snprintf(option, sizeof(option), "<option value='%d'%s>%d minute%s</option>", intervals[i],
+                 intervals[i] == currentInterval ? " selected" : "", intervals[i], intervals[i] > 1 ? "s" : "");
+        out.print(option);
+      }
+    } }
+};
+
+// Handle settings page request
+void handleSettings() {
+  LOG_DEBUG("Web", "Handling settings page request");
+  static const char* const parts[] = { HTML_HEADER, WEATHER_SETTINGS_HTML };
+  sendTemplate(server, 200, "text/html", parts, 2, SETTINGS_TOKENS, sizeof(SETTINGS_TOKENS) / sizeof(SETTINGS_TOKENS[0]));
+}
+
+// Log the settings globals, after loading or saving them
+static void logSettings() {
+  LOG_INFO("Settings", "Location: %s, %s", cityName.c_str(), stateName.c_str());
+  for (uint8_t i = 1; i < Locations::count(); i++) {
+    LOG_INFO("Settings", "Location %u: %s, %s", i + 1, Locations::city(i).c_str(), Locations::state(i).c_str());
+  }
+  LOG_INFO("Settings", "Update interval: %lu minutes", (unsigned long)(WEATHER_UPDATE_INTERVAL / 60000));
+  LOG_INFO("Settings", "Timezone: %s", getTimezoneText().c_str());
+  LOG_INFO("Settings", "Time format: %s, temperature unit: %s",
+           use12HourFormat ? "12-hour" : "24-hour", useMetricUnits ? "Celsius" : "Fahrenheit");
 }
 
 // Handle settings save request
 void handleSettingsSave() {
-  Serial.println("[Settings] Processing settings form submission");
+  LOG_INFO("Settings", "Processing settings form submission");
   
   // Extract form values
+  String previousCity = cityName;
+  String previousState = stateName;
   cityName = server.arg("city");
   stateName = server.arg("state");
   
@@ -592,314 +601,245 @@ void handleSettingsSave() {
   useMetricUnits = (server.arg("tempUnit") == "1");
   UNITS = useMetricUnits ? "metric" : "imperial";
   
-  // Process timezone selection
-  String timezoneStr = server.arg("timezone");
-  timezone = timezoneStr.toFloat();
+  // Process weather provider selection
+  weatherProvider = (server.arg("provider") == "1") ? WEATHER_PROVIDER_OPENMETEO : WEATHER_PROVIDER_OPENWEATHERMAP;
   
-  // Process DST setting
-  useDST = (server.arg("dst") == "1");
+  // Process time zone; the rule carries its own DST dates. An invalid one
+  // keeps the current zone.
+  String timeZone = server.arg("timezone");
+  timeZone.trim();
+  if (!TimeZone::set(timeZone.c_str())) {
+    LOG_WARN("Settings", "Invalid time zone provided, keeping %s", TimeZone::rule());
+  }
   
   // Process time format selection
   use12HourFormat = (server.arg("timeFormat") == "1");
   
+  // Process power selections; they apply at once
+  Power::setMode(server.arg("powerMode").toInt());
+  Power::setNightDisplay(server.arg("nightDisplay").toInt());
+  
   // Get API key
   String apiKey = server.hasArg("apikey") ? server.arg("apikey") : API_KEY;
   
   // Validate city name
   if (cityName.length() == 0) {
     cityName = "New York"; // Default if empty
-    Serial.println("Empty city name provided, using default 'New York'");
+    LOG_WARN("Settings", "Empty city name provided, using default 'New York'");
   }
   
   // Validate state code
   if (stateName.length() != 2) {
     stateName = "NY"; // Default if invalid
-    Serial.println("Invalid state code provided, using default 'NY'");
+    LOG_WARN("Settings", "Invalid state code provided, using default 'NY'");
   }
   
   // Validate API key - must be at least 5 characters
   if (apiKey.length() < 5) {
     apiKey = API_KEY; // Keep using current key if invalid
-    Serial.println("Invalid API key provided, keeping current API key");
+    LOG_WARN("Settings", "Invalid API key provided, keeping current API key");
   }
   
-  // Log time format change
-  Serial.print("Time format: ");
-  Serial.println(use12HourFormat ? "12-hour" : "24-hour");
-  
-  // Log temperature unit change
-  Serial.print("Temperature unit: ");
-  Serial.println(useMetricUnits ? "Celsius" : "Fahrenheit");
-  
-  // Start EEPROM transaction
-  EEPROM.begin(EEPROM_SIZE);
-  
-  // Save city name
-  for (size_t i = 0; i < 50; i++) {
-    if (i < cityName.length()) {
-      EEPROM.write(CITY_OFFSET + i, cityName[i]);
-    } else {
-      EEPROM.write(CITY_OFFSET + i, 0);
-    }
+  // A new location is geocoded once, by the update started below
+  if (cityName != previousCity || stateName != previousState) {
+    cityCoordinatesKnown = false;
   }
   
-  // Save state code
-  for (size_t i = 0; i < 2; i++) {
-    if (i < stateName.length()) {
-      EEPROM.write(STATE_OFFSET + i, stateName[i]);
-    } else {
-      EEPROM.write(STATE_OFFSET + i, 0);
+  // Further locations; empty or unusable ones are left out
+  Locations::clear();
+  static const char* const extraFields[][2] = { { "city2", "state2" }, { "city3", "state3" } };
+  for (size_t i = 0; i < sizeof(extraFields) / sizeof(extraFields[0]); i++) {
+    String city = server.arg(extraFields[i][0]);
+    city.trim();
+    if (city.length() > 0 && !Locations::add(city, server.arg(extraFields[i][1]))) {
+      LOG_WARN("Settings", "Leaving out location '%s'", city.c_str());
     }
   }
+  Locations::save();
   
-  // Save update interval
-  byte intervalBytes[4];
-  memcpy(intervalBytes, &WEATHER_UPDATE_INTERVAL, 4);
-  for (int i = 0; i < 4; i++) {
-    EEPROM.write(UPDATE_INTERVAL_OFFSET + i, intervalBytes[i]);
-  }
-  
-  // Save timezone
-  byte timezoneBytes[4];
-  memcpy(timezoneBytes, &timezone, 4);
-  for (int i = 0; i < 4; i++) {
-    EEPROM.write(TIMEZONE_OFFSET + i, timezoneBytes[i]);
-  }
-  
-  // Save API key
-  for (size_t i = 0; i < 50; i++) {
-    if (i < apiKey.length()) {
-      EEPROM.write(API_KEY_OFFSET + i, apiKey[i]);
-    } else {
-      EEPROM.write(API_KEY_OFFSET + i, 0);
-    }
-  }
-  
-  // Save time format
-  EEPROM.write(TIME_FORMAT_OFFSET, use12HourFormat ? 1 : 0);
-  
-  // Save temperature unit
-  EEPROM.write(TEMP_UNIT_OFFSET, useMetricUnits ? 1 : 0);
+  // Update global variables before storing them
+  API_KEY = apiKey;
+  saveSettings();
   
-  // Save DST setting
-  EEPROM.write(USE_DST_OFFSET, useDST ? 1 : 0);
+  LOG_INFO("Settings", "Saved:");
+  logSettings();
+  LOG_INFO("Settings", "Weather provider: %s", Weather::providerName());
   
-  EEPROM.commit();
-  EEPROM.end();
+  // The clock runs in UTC, so the new time zone applies at once
+  resetTimeWithNewTimezone();
   
-  // Update global variables
-  WEATHER_UPDATE_INTERVAL = WEATHER_UPDATE_INTERVAL;
-  timezone = timezone;
-  API_KEY = apiKey;
-  use12HourFormat = use12HourFormat;
-  useMetricUnits = useMetricUnits;
-  useDST = useDST;
-  
-  Serial.println("Settings saved to EEPROM:");
-  Serial.println("City: " + cityName);
-  Serial.println("State: " + stateName);
-  Serial.println("Update interval: " + String(WEATHER_UPDATE_INTERVAL / 60000) + " minutes");
-  Serial.println("Timezone: " + String(timezone) + " (UTC" + (timezone >= 0 ? "+" : "") + String(timezone) + ")");
-  Serial.println("Time format: " + String(use12HourFormat ? "12-hour" : "24-hour"));
-  Serial.print("Temperature unit: ");
-  Serial.println(useMetricUnits ? "Celsius" : "Fahrenheit");
-  Serial.println("DST enabled: " + String(useDST ? "YES" : "NO"));
-  
-  // Immediately update the time with the new timezone
   if (WiFi.status() == WL_CONNECTED) {
-    // Reset and immediately update the time with new timezone and DST settings
-    resetTimeWithNewTimezone();
-    
-    // Always update weather data immediately when settings are saved
-    Serial.println("Settings changed - fetching weather data immediately");
-    drawConnectingScreen("Updating", "Weather data...");
-    Weather::fetchWeatherData();
-    
-    // Force time update with new settings
-    Serial.println("Settings changed - updating time immediately");
-    drawConnectingScreen("Updating", "Time data...");
-    updateTimeAndDate();
+    // Always update weather data immediately when settings are saved;
+    // the update runs in the background from loop()
+    LOG_INFO("Settings", "Settings changed - fetching weather data immediately");
+    // One that is already running started from the old settings
+    Weather::cancelWeatherUpdate();
+    Weather::startWeatherUpdate();
   }
   
   // Send success response
-  String successHtml = FPSTR(SETTINGS_SAVE_SUCCESS_HTML);
-  successHtml.replace("%CITY%", cityName);
-  successHtml.replace("%STATE%", stateName);
-  successHtml.replace("%INTERVAL%", String(WEATHER_UPDATE_INTERVAL / 60000));
-  successHtml.replace("%TIMEZONE_TEXT%", getTimezoneText(timezone));
-  successHtml.replace("%TIME_FORMAT%", use12HourFormat ? "12-hour" : "24-hour");
-  successHtml.replace("%TEMP_UNIT%", useMetricUnits ? "Celsius (°C)" : "Fahrenheit (°F)");
-  
-  // Mask API key for security - show first 4 and last 4 characters
-  String maskedApiKey;
-  if (apiKey.length() > 8) {
-    maskedApiKey = apiKey.substring(0, 4) + "********" + apiKey.substring(apiKey.length() - 4);
-  } else {
-    maskedApiKey = "********"; // If API key is too short to mask properly
-  }
-  successHtml.replace("%API_KEY_MASKED%", maskedApiKey);
-  
-  server.send(200, "text/html", successHtml);
+  static const TemplateToken savedTokens[] = {
+    { "CITY", [](TemplateWriter& out) { out.print(cityName.c_str()); } },
+    { "STATE", [](TemplateWriter& out) { out.print(stateName.c_str()); } },
+    { "MORE_LOCATIONS", [](TemplateWriter& out) {
+        for (uint8_t i = 1; i < Locations::count(); i++) {
+          out.print("; ");
+          out.print(Locations::city(i).c_str());
+          if (Locations::state(i).length() > 0) {
+            out.print(", ");
+            out.print(Locations::state(i).c_str());
+          }
+        }
+      } },
+    { "INTERVAL", [](TemplateWriter& out) { out.print((long)(WEATHER_UPDATE_INTERVAL / 60000)); } },
+    { "TIMEZONE_TEXT", [](TemplateWriter& out) { out.print(getTimezoneText().c_str()); } },
+    { "TIME_FORMAT", [](TemplateWriter& out) { out.print(use12HourFormat ? "12-hour" : "24-hour"); } },
+    { "TEMP_UNIT", [](TemplateWriter& out) { out.print(useMetricUnits ? "Celsius (°C)" : "Fahrenheit (°F)"); } },
+    { "PROVIDER", [](TemplateWriter& out) { out.print(Weather::providerName()); } },
+    { "POWER_MODE", [](TemplateWriter& out) {
+        out.print(Power::mode() == POWER_MODE_LIGHT_SLEEP ? "light sleep" : Power::mode() == POWER_MODE_MODEM_SLEEP ? "modem sleep" : "off");
+      } },
+    { "API_KEY_MASKED", [](TemplateWriter& out) {
+        // Mask API key for security - show first 4 and last 4 characters
+        size_t length = API_KEY.length();
+        if (length > 8) {
+          char masked[17];
+          snprintf(masked, sizeof(masked), "%.4s********%s", API_KEY.c_str(), API_KEY.c_str() + length - 4);
+          out.print(masked);
+        } else {
+          out.print("********"); // If API key is too short to mask properly
+        }
+      } }
+  };
+  static const char* const parts[] = { HTML_HEADER, SETTINGS_SAVE_SUCCESS_HTML };
+  sendTemplate(server, 200, "text/html", parts, 2, savedTokens, sizeof(savedTokens) / sizeof(savedTokens[0]));
 }
 
-// Helper function to get timezone text
-String getTimezoneText(float tz) {
-  String prefix = tz >= 0 ? "+" : "";
-  String hours = String(int(tz));
-  String minutes = "";
-  
-  // Handle fractional timezones (like India's UTC+5:30)
-  float fraction = abs(tz) - int(abs(tz));
-  if (fraction > 0) {
-    minutes = ":" + String(int(fraction * 60));
-  }
-  
-  return "UTC" + prefix + hours + minutes;
+// Time zone for display: the rule and the offset in force now
+String getTimezoneText() {
+  time_t now = getEpochTime();
+  char offset[10];
+  TimeZone::formatOffset(TimeZone::offsetAt(now), offset);
+  return String(TimeZone::rule()) + ", now " + offset + " " + TimeZone::abbreviation(now);
+}
+
+// Copy a String into a fixed settings field, cutting it to fit
+static void copySetting(char* field, size_t size, const String& value) {
+  memset(field, 0, size);
+  strncpy(field, value.c_str(), size - 1);
 }
 
-// Load settings from EEPROM
+// Store the settings globals; flash is only written if something changed
+void saveSettings() {
+  Settings& settings = SettingsStore::get();
+  copySetting(settings.city, sizeof(settings.city), cityName);
+  copySetting(settings.state, sizeof(settings.state), stateName);
+  settings.latitude = cityCoordinatesKnown ? cityLatitude : 0;
+  settings.longitude = cityCoordinatesKnown ? cityLongitude : 0;
+  settings.coordinatesKnown = cityCoordinatesKnown ? 1 : 0;
+  copySetting(settings.apiKey, sizeof(settings.apiKey), API_KEY);
+  settings.updateIntervalMs = WEATHER_UPDATE_INTERVAL;
+  copySetting(settings.timeZone, sizeof(settings.timeZone), TimeZone::rule());
+  settings.use12HourFormat = use12HourFormat ? 1 : 0;
+  settings.useMetricUnits = useMetricUnits ? 1 : 0;
+  settings.weatherProvider = weatherProvider;
+  settings.powerMode = Power::mode();
+  settings.nightDisplay = Power::nightDisplay();
+  SettingsStore::save();
+}
+
+// Load settings from the settings record into the globals
 void loadSettings() {
-  Serial.println("[Settings] Loading settings from EEPROM");
-  
-  EEPROM.begin(EEPROM_SIZE);
-  
-  // Load city name
-  char city[50] = {0};
-  for (int i = 0; i < 50; i++) {
-    city[i] = EEPROM.read(CITY_OFFSET + i);
-    if (city[i] == 0) break;
-  }
-  
-  // Load state code
-  char state[3] = {0};
-  for (int i = 0; i < 2; i++) {
-    state[i] = EEPROM.read(STATE_OFFSET + i);
-  }
-  
-  // Load update interval
-  byte intervalBytes[4];
-  for (int i = 0; i < 4; i++) {
-    intervalBytes[i] = EEPROM.read(UPDATE_INTERVAL_OFFSET + i);
-  }
-  
-  // Load timezone
-  byte timezoneBytes[4];
-  for (int i = 0; i < 4; i++) {
-    timezoneBytes[i] = EEPROM.read(TIMEZONE_OFFSET + i);
-  }
+  LOG_INFO("Settings", "Loading settings from EEPROM");
   
-  // Load API key
-  char apiKey[50] = {0};
-  for (int i = 0; i < 50; i++) {
-    apiKey[i] = EEPROM.read(API_KEY_OFFSET + i);
-    if (apiKey[i] == 0) break;
-  }
-  
-  // Load time format preference
-  byte timeFormatByte = EEPROM.read(TIME_FORMAT_OFFSET);
-  use12HourFormat = (timeFormatByte == 1);
+  const Settings& settings = SettingsStore::get();
+  const char* city = settings.city;
+  const char* state = settings.state;
+  const char* apiKey = settings.apiKey;
+  unsigned long interval = settings.updateIntervalMs;
   
-  // Load temperature unit preference
-  byte tempUnitByte = EEPROM.read(TEMP_UNIT_OFFSET);
-  useMetricUnits = (tempUnitByte == 1);
+  use12HourFormat = settings.use12HourFormat == 1;
+  useMetricUnits = settings.useMetricUnits == 1;
   
-  // Load DST setting
-  useDST = (EEPROM.read(USE_DST_OFFSET) == 1);
-  Serial.print("[Settings] DST enabled: ");
-  Serial.println(useDST ? "YES" : "NO");
+  weatherProvider = (settings.weatherProvider == WEATHER_PROVIDER_OPENMETEO) ? WEATHER_PROVIDER_OPENMETEO : WEATHER_PROVIDER_OPENWEATHERMAP;
   
   // Update UNITS string based on temperature preference
   UNITS = useMetricUnits ? "metric" : "imperial";
   
-  EEPROM.end();
-  
-  // Convert bytes to values
-  unsigned long interval = 0;
-  memcpy(&interval, intervalBytes, 4);
-  
-  float tz = 0;
-  memcpy(&tz, timezoneBytes, 4);
-  
   // Validate and set values
-  if (strlen(city) > 0 && city[0] != 255) {
+  if (strlen(city) > 0) {
     cityName = String(city);
   }
   
-  if (strlen(state) == 2 && state[0] != 255) {
+  if (strlen(state) == 2) {
     stateName = String(state);
   }
   
+  // Coordinates only count for the city they were looked up for
+  cityCoordinatesKnown = settings.coordinatesKnown == 1 && strlen(city) > 0 && strlen(state) == 2;
+  cityLatitude = settings.latitude;
+  cityLongitude = settings.longitude;
+  
   if (interval > 0 && interval < 24 * 60 * 60 * 1000) { // Less than 24 hours
     WEATHER_UPDATE_INTERVAL = interval;
   }
   
-  if (tz >= -12 && tz <= 14) {
-    timezone = tz;
+  if (!TimeZone::set(settings.timeZone)) {
+    TimeZone::set(TZ_DEFAULT);
   }
   
-  if (strlen(apiKey) >= 5 && apiKey[0] != 255) {
+  Power::setMode(settings.powerMode);
+  Power::setNightDisplay(settings.nightDisplay);
+  
+  if (strlen(apiKey) >= 5) {
     API_KEY = String(apiKey);
   }
   
-  // Set time format preference (default to 24-hour if invalid)
-  use12HourFormat = (timeFormatByte == 1);
-  
-  // Set temperature unit preference (default to metric if invalid)
-  useMetricUnits = (tempUnitByte == 1);
-  
-  // Update UNITS string based on temperature preference
-  UNITS = useMetricUnits ? "metric" : "imperial";
-  
-  Serial.println("Settings loaded from EEPROM:");
-  Serial.println("City: " + cityName);
-  Serial.println("State: " + stateName);
-  Serial.println("Update interval: " + String(WEATHER_UPDATE_INTERVAL / 60000) + " minutes");
-  Serial.println("Timezone: " + String(timezone) + " (UTC" + (timezone >= 0 ? "+" : "") + String(timezone) + ")");
-  Serial.println("Time format: " + String(use12HourFormat ? "12-hour" : "24-hour"));
-  Serial.print("Temperature unit: ");
-  Serial.println(useMetricUnits ? "Celsius" : "Fahrenheit");
-  Serial.println("DST enabled: " + String(useDST ? "YES" : "NO"));
+  LOG_INFO("Settings", "Loaded:");
+  logSettings();
 }
 
 // Draw the connecting screen with progress
-void drawConnectingScreen(String message, String submessage) {
-  u8g2.clearBuffer();
-  
-  // Draw main message
-  u8g2.setFont(u8g2_font_t0_11_tf);
-  int msgWidth = u8g2.getStrWidth(message.c_str());
-  u8g2.drawStr(64 - msgWidth / 2, 25, message.c_str());
-  
-  // Draw submessage on next line
-  if (submessage.length() > 0) {
-    int subWidth = u8g2.getStrWidth(submessage.c_str());
-    u8g2.drawStr(64 - subWidth / 2, 40, submessage.c_str());
-  }
-  
-  u8g2.sendBuffer();
+void drawConnectingScreen(const char* message, const char* submessage) {
+  // Drawn once per page in page buffer mode
+  u8g2.firstPage();
+  do {
+    // Draw main message
+    u8g2.setFont(u8g2_font_t0_11_tf);
+    int msgWidth = u8g2.getStrWidth(message);
+    u8g2.drawStr(64 - msgWidth / 2, 25, message);
+    
+    // Draw submessage on next line
+    if (submessage[0] != '\0') {
+      int subWidth = u8g2.getStrWidth(submessage);
+      u8g2.drawStr(64 - subWidth / 2, 40, submessage);
+    }
+  } while (u8g2.nextPage());
+  invalidateDisplay();
 }
 
 // Draw the configuration mode screen
 void drawConfigMode() {
-  u8g2.clearBuffer();
-  
-  // Draw title
-  u8g2.setFont(u8g2_font_t0_11_tf);
-  String title = "WiFi Setup Mode";
-  int titleWidth = u8g2.getStrWidth(title.c_str());
-  u8g2.drawStr(64 - titleWidth / 2, 12, title.c_str());
-  
-  // Draw instructions with smaller font to fit more text
-  u8g2.setFont(u8g2_font_tom_thumb_4x6_mf);
-  
-  u8g2.drawStr(5, 22, "Connect to WiFi:");
-  u8g2.drawStr(5, 30, AP_NAME);
-  
-  u8g2.drawStr(5, 38, "Password:");
-  u8g2.drawStr(5, 46, AP_PASSWORD);
-  
-  u8g2.drawStr(5, 54, "Then visit:");
-  u8g2.drawStr(5, 62, "192.168.4.1");
-  
-  u8g2.sendBuffer();
+  // Drawn once per page in page buffer mode
+  u8g2.firstPage();
+  do {
+    // Draw title
+    u8g2.setFont(u8g2_font_t0_11_tf);
+    const char* title = "WiFi Setup Mode";
+    int titleWidth = u8g2.getStrWidth(title);
+    u8g2.drawStr(64 - titleWidth / 2, 12, title);
+    
+    // Draw instructions with smaller font to fit more text
+    u8g2.setFont(u8g2_font_tom_thumb_4x6_mf);
+    
+    u8g2.drawStr(5, 22, "Connect to WiFi:");
+    u8g2.drawStr(5, 30, AP_NAME);
+    
+    u8g2.drawStr(5, 38, "Password:");
+    u8g2.drawStr(5, 46, AP_PASSWORD);
+    
+    u8g2.drawStr(5, 54, "Then visit:");
+    u8g2.drawStr(5, 62, "192.168.4.1");
+  } while (u8g2.nextPage());
+  invalidateDisplay();
 }
\ No newline at end of file
@@ -22,7 +22,7 @@ struct WiFiCredentials {
 // WiFi configuration functions
 bool loadWiFiConfig();
 void saveWiFiConfig(const char* ssid, const char* password);
-void connectToWifi();
+bool connectToWifi();
 void startConfigPortal();
 void formatCredentials(); // Format WiFi credentials area in EEPROM
 void dumpEEPROMContents();
@@ -35,13 +35,23 @@ void handleWifiScan();
 void handleSave();
 void handleNotFound();
 
+// Answer the web requests waiting, a few per call rather than one
+void serviceWebClients();
+
+// Answer the captive portal DNS queries waiting, a few per call
+void servicePortalDns();
+
+// True for a few seconds after a web request; the portal screen is not
+// redrawn meanwhile
+bool webClientActive();
+
 // Settings page handlers
 void handleSettings();
 void handleSettingsSave();
 void loadSettings();
-void saveSettings(String city, String state, unsigned long updateInterval, float timezone, String apiKey, bool is12Hour = false, bool isMetric = false);
-String getTimezoneText(float tz);
+void saveSettings(); // Store the settings globals
+String getTimezoneText(); // Rule and current offset, for display
 
 // Helper functions
-void drawConnectingScreen(String message, String submessage);
+void drawConnectingScreen(const char* message, const char* submessage);
 void drawConfigMode();
\ No newline at end of file
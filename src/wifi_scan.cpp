@@ -0,0 +1,133 @@
+/*
+ * Implementation of the background WiFi scan
+ */
+
+#include "wifi_scan.h"
+#include "logging.h"
+#include <ESP8266WiFi.h>
+
+// A request without force rescans once the table is this old
+#define WIFI_SCAN_REFRESH_MS 30000
+
+namespace WifiScan {
+    static Network networks[WIFI_SCAN_MAX_NETWORKS];
+    static uint8_t networkCount = 0;
+    static bool scanning = false;
+    static bool haveResults = false;
+    static unsigned long startedAt = 0;
+    static unsigned long finishedAt = 0;
+    static unsigned long lastDurationMs = 0;
+    static uint32_t scans = 0;
+
+    // Set by the scan callback, picked up by service(); -1 while nothing is pending
+    static volatile int pendingResults = -1;
+
+    static void onScanDone(int found) {
+        pendingResults = found;
+    }
+
+    // Put one result into the table: keep the strongest entry per SSID and
+    // the table sorted, strongest first
+    static void addNetwork(const char* ssid, int8_t rssi, bool open) {
+        for (uint8_t i = 0; i < networkCount; i++) {
+            if (strcmp(networks[i].ssid, ssid) == 0) {
+                if (rssi <= networks[i].rssi) {
+                    return;
+                }
+                // Stronger duplicate; drop the old entry and insert again
+                memmove(&networks[i], &networks[i + 1], (networkCount - i - 1) * sizeof(Network));
+                networkCount--;
+                break;
+            }
+        }
+
+        uint8_t pos = networkCount;
+        while (pos > 0 && networks[pos - 1].rssi < rssi) {
+            pos--;
+        }
+        if (pos >= WIFI_SCAN_MAX_NETWORKS) {
+            return; // Weaker than everything in a full table
+        }
+
+        uint8_t last = networkCount < WIFI_SCAN_MAX_NETWORKS ? networkCount : WIFI_SCAN_MAX_NETWORKS - 1;
+        memmove(&networks[pos + 1], &networks[pos], (last - pos) * sizeof(Network));
+        strncpy(networks[pos].ssid, ssid, sizeof(networks[pos].ssid) - 1);
+        networks[pos].ssid[sizeof(networks[pos].ssid) - 1] = '\0';
+        networks[pos].rssi = rssi;
+        networks[pos].open = open;
+        if (networkCount < WIFI_SCAN_MAX_NETWORKS) {
+            networkCount++;
+        }
+    }
+
+    void request(bool force) {
+        if (scanning) {
+            return;
+        }
+        if (!force && haveResults && millis() - finishedAt < WIFI_SCAN_REFRESH_MS) {
+            return;
+        }
+
+        scanning = true;
+        pendingResults = -1;
+        startedAt = millis();
+        WiFi.scanNetworksAsync(onScanDone);
+        LOG_DEBUG("WiFi", "Background scan started");
+    }
+
+    void service() {
+        if (!scanning || pendingResults < 0) {
+            return;
+        }
+        int found = pendingResults;
+        pendingResults = -1;
+        scanning = false;
+
+        // A failed scan keeps the previous table
+        if (found >= 0) {
+            networkCount = 0;
+            for (int i = 0; i < found; i++) {
+                String ssid = WiFi.SSID(i);
+                if (ssid.length() == 0) {
+                    continue; // Hidden network
+                }
+                addNetwork(ssid.c_str(), (int8_t)WiFi.RSSI(i), WiFi.encryptionType(i) == ENC_TYPE_NONE);
+            }
+            haveResults = true;
+        }
+        WiFi.scanDelete();
+
+        finishedAt = millis();
+        lastDurationMs = finishedAt - startedAt;
+        scans++;
+        LOG_INFO("WiFi", "Scan found %d networks, %u listed, in %lu ms", found, networkCount, lastDurationMs);
+    }
+
+    bool isScanning() {
+        return scanning;
+    }
+
+    uint8_t count() {
+        return networkCount;
+    }
+
+    const Network& network(uint8_t index) {
+        return networks[index];
+    }
+
+    unsigned long ageMs() {
+        return haveResults ? millis() - finishedAt : 0;
+    }
+
+    bool hasResults() {
+        return haveResults;
+    }
+
+    uint32_t scanCount() {
+        return scans;
+    }
+
+    unsigned long lastScanMs() {
+        return lastDurationMs;
+    }
+}
@@ -0,0 +1,46 @@
+/*
+ * Background WiFi scan for ESP-01 Weather Display
+ * Networks are scanned asynchronously and kept in a small table, one entry
+ * per SSID at its strongest signal, sorted by RSSI. The portal reads the
+ * table at once instead of blocking for a scan on every request.
+ */
+
+#ifndef WIFI_SCAN_H
+#define WIFI_SCAN_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Most networks kept; weaker ones beyond this are dropped
+#define WIFI_SCAN_MAX_NETWORKS 16
+
+namespace WifiScan {
+    struct Network {
+        char ssid[33];
+        int8_t rssi;        // dBm
+        bool open;          // No encryption
+    };
+
+    // Start a scan unless one is running. Without force, a table younger
+    // than the refresh interval is kept as it is.
+    void request(bool force);
+
+    // Collect the results of a finished scan. Call from the loop, often.
+    void service();
+
+    bool isScanning();
+
+    // Networks of the last finished scan, strongest first
+    uint8_t count();
+    const Network& network(uint8_t index);
+
+    // Milliseconds since the table was filled; 0 before the first scan finished
+    unsigned long ageMs();
+    bool hasResults();
+
+    // Statistics for /debug
+    uint32_t scanCount();
+    unsigned long lastScanMs();     // Duration of the last scan
+}
+
+#endif // WIFI_SCAN_H
@@ -0,0 +1,84 @@
+/*
+ * Host stand-in for the Arduino core, for the native tests
+ * Just enough of it for the modules the native environment builds: the
+ * integer types, PROGMEM access (plain memory here), String, a millis()
+ * the tests set themselves (see host_support.h), and an ESP object whose
+ * cycle counter is the host's clock.
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+#include <algorithm>
+#include <chrono>
+#include "WString.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+// Flash is ordinary memory on the host
+#define PROGMEM
+#define PGM_P const char*
+#define PSTR(s) (s)
+#define F(s) (s)
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define strcpy_P strcpy
+#define memcpy_P memcpy
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define strncpy_P strncpy
+#define vsnprintf_P vsnprintf
+
+using std::min;
+using std::max;
+
+#define constrain(x, low, high) ((x) < (low) ? (low) : ((x) > (high) ? (high) : (x)))
+
+inline bool isAlphaNumeric(int c) { return isalnum(c) != 0; }
+inline bool isSpace(int c) { return isspace(c) != 0; }
+inline bool isDigit(int c) { return isdigit(c) != 0; }
+
+// Set by the tests through hostMillis; defined in host_support.h
+unsigned long millis();
+inline void delay(unsigned long) {}
+inline void yield() {}
+
+// Real time, for the code that times itself
+inline unsigned long micros() {
+  using namespace std::chrono;
+  return (unsigned long)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// The host counts at 1 GHz, so a cycle is a nanosecond of steady_clock and
+// cycle counts convert to time as they do on the device. The heap reads as
+// a constant; nothing on the host can track it.
+class EspClass {
+public:
+  uint32_t getCycleCount() {
+    using namespace std::chrono;
+    return (uint32_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+  }
+  uint32_t getCpuFreqMHz() { return 1000; }
+  uint32_t getFreeHeap() { return 40000; }
+  uint8_t getHeapFragmentation() { return 0; }
+  void getHeapStats(uint32_t* free, uint16_t* maxBlock, uint8_t* fragmentation) {
+    *free = getFreeHeap();
+    *maxBlock = 40000;
+    *fragmentation = 0;
+  }
+};
+
+extern EspClass ESP; // Defined in host_support.h
+
+// SNTP is started by time_manager.cpp; the host clock comes from the tests
+inline void configTime(long, int, const char*, const char* = nullptr, const char* = nullptr) {}
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,11 @@
+/*
+ * Host stand-in for the ESP8266 core's DNSServer.h, for the native tests
+ * config.cpp defines the server; nothing natively built answers queries.
+ */
+
+#ifndef HOST_DNSSERVER_H
+#define HOST_DNSSERVER_H
+
+class DNSServer {};
+
+#endif // HOST_DNSSERVER_H
@@ -0,0 +1,44 @@
+/*
+ * Host stand-in for the ESP8266 emulated EEPROM, for the native tests
+ * The "flash" is a RAM array that keeps its contents across begin() and
+ * end(), like the real sector does across reboots. Defined in host_support.h.
+ */
+
+#ifndef HOST_EEPROM_H
+#define HOST_EEPROM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define HOST_EEPROM_SIZE 4096
+
+class EEPROMClass {
+public:
+  void begin(size_t size) { used = size < HOST_EEPROM_SIZE ? size : HOST_EEPROM_SIZE; }
+  void end() { used = 0; }
+  bool commit() { commits++; return used > 0; }
+
+  uint8_t read(int address) const { return flash[address]; }
+  void write(int address, uint8_t value) { flash[address] = value; }
+
+  template <typename T> T& get(int address, T& value) const {
+    memcpy(&value, flash + address, sizeof(T));
+    return value;
+  }
+  template <typename T> const T& put(int address, const T& value) {
+    memcpy(flash + address, &value, sizeof(T));
+    return value;
+  }
+
+  // Start over from erased flash
+  void erase() { memset(flash, 0xFF, sizeof(flash)); commits = 0; }
+
+  uint8_t flash[HOST_EEPROM_SIZE];
+  size_t used = 0;
+  uint32_t commits = 0;
+};
+
+extern EEPROMClass EEPROM;
+
+#endif // HOST_EEPROM_H
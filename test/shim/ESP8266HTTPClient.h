@@ -0,0 +1,14 @@
+/*
+ * Host stand-in for ESP8266HTTPClient.h, for the native tests
+ * Only the status codes the providers compare with
+ */
+
+#ifndef HOST_ESP8266HTTPCLIENT_H
+#define HOST_ESP8266HTTPCLIENT_H
+
+enum {
+  HTTP_CODE_OK = 200,
+  HTTP_CODE_NOT_MODIFIED = 304
+};
+
+#endif // HOST_ESP8266HTTPCLIENT_H
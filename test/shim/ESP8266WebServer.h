@@ -0,0 +1,19 @@
+/*
+ * Host stand-in for the ESP8266 core's ESP8266WebServer.h, for the native tests
+ * config.cpp defines the server; nothing natively built serves pages.
+ */
+
+#ifndef HOST_ESP8266WEBSERVER_H
+#define HOST_ESP8266WEBSERVER_H
+
+#include <stdint.h>
+
+class ESP8266WebServer {
+public:
+  explicit ESP8266WebServer(uint16_t port) : port(port) {}
+
+private:
+  uint16_t port;
+};
+
+#endif // HOST_ESP8266WEBSERVER_H
@@ -0,0 +1,22 @@
+/*
+ * Host stand-in for the ESP8266 WiFi headers, for the native tests
+ * Only what config.cpp needs to define its objects; nothing natively built
+ * talks to the network.
+ */
+
+#ifndef HOST_ESP8266WIFI_H
+#define HOST_ESP8266WIFI_H
+
+#include <Arduino.h>
+
+class IPAddress {
+public:
+  IPAddress() : address(0) {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+    : address((uint32_t)a << 24 | (uint32_t)b << 16 | (uint32_t)c << 8 | d) {}
+
+private:
+  uint32_t address;
+};
+
+#endif // HOST_ESP8266WIFI_H
@@ -0,0 +1,326 @@
+/*
+ * Host stand-in for U8g2lib.h, for the native tests
+ * A 128x64 SSD1306 in memory: the buffer has the real one's layout (tile
+ * rows of 128 column bytes, bit 0 the top line) and rotation, and
+ * sendBuffer() and updateDisplayArea() copy it into a panel the tests can
+ * read back. The shapes are drawn as u8g2 draws them. Font glyphs are
+ * stand-ins: each font's advances, ascent and character set are kept, so
+ * text lands where it would, but the pixels inside a glyph are a fixed
+ * pattern per character.
+ */
+
+#ifndef HOST_U8G2LIB_H
+#define HOST_U8G2LIB_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define U8X8_PIN_NONE 255
+
+// Display rotations; the firmware uses U8G2_R2, upside down
+#define U8G2_R0 0
+#define U8G2_R2 2
+
+#define U8G2_DRAW_UPPER_RIGHT 0x01
+#define U8G2_DRAW_UPPER_LEFT 0x02
+#define U8G2_DRAW_LOWER_LEFT 0x04
+#define U8G2_DRAW_LOWER_RIGHT 0x08
+#define U8G2_DRAW_ALL 0x0f
+
+#define HOST_DISPLAY_WIDTH 128
+#define HOST_DISPLAY_HEIGHT 64
+#define HOST_DISPLAY_TILE_ROWS (HOST_DISPLAY_HEIGHT / 8)
+
+struct HostFont {
+  uint8_t advance;        // Pixels from one glyph to the next
+  uint8_t narrowAdvance;  // For the characters in narrow
+  uint8_t ascent;         // Glyph height above the baseline
+  const char* charset;    // Characters the font has; nullptr for all printable ones
+  const char* narrow;
+};
+
+// The fonts the firmware uses, with their real metrics
+static const HostFont u8g2_font_4x6_tf[1] = { { 4, 4, 5, nullptr, "" } };
+static const HostFont u8g2_font_tom_thumb_4x6_mf[1] = { { 4, 4, 5, nullptr, "" } };
+static const HostFont u8g2_font_6x10_tf[1] = { { 6, 6, 7, nullptr, "" } };
+static const HostFont u8g2_font_6x10_tr[1] = { { 6, 6, 7, nullptr, "" } };
+static const HostFont u8g2_font_6x12_tf[1] = { { 6, 6, 8, nullptr, "" } };
+static const HostFont u8g2_font_t0_11_tf[1] = { { 6, 6, 8, nullptr, "" } };
+static const HostFont u8g2_font_logisoso24_tn[1] = { { 14, 6, 24, " +,-./0123456789:", " ,.:" } };
+
+class U8G2 {
+public:
+  U8G2(uint8_t rotation, uint8_t tileRows)
+    : rotation(rotation), tileRows(tileRows), currTileRow(0), font(u8g2_font_6x10_tf), frames(0) {
+    memset(buffer, 0, sizeof(buffer));
+    memset(panel, 0, sizeof(panel));
+  }
+
+  bool begin() { return true; }
+  void setPowerSave(uint8_t) {}
+  void setContrast(uint8_t) {}
+  void setBusClock(uint32_t) {}
+
+  uint8_t* getBufferPtr() { return buffer; }
+  uint8_t getBufferTileWidth() const { return HOST_DISPLAY_WIDTH / 8; }
+  uint8_t getBufferTileHeight() const { return tileRows; }
+  void setBufferCurrTileRow(uint8_t row) { currTileRow = row; }
+  void clearBuffer() { memset(buffer, 0, (size_t)tileRows * HOST_DISPLAY_WIDTH); }
+
+  // Copy the buffer to the panel rows it covers
+  void sendBuffer() {
+    updateDisplayArea(0, currTileRow, HOST_DISPLAY_WIDTH / 8, tileRows);
+    frames++;
+  }
+
+  void updateDisplayArea(uint8_t tx, uint8_t ty, uint8_t tw, uint8_t th) {
+    for (uint8_t row = ty; row < ty + th && row < HOST_DISPLAY_TILE_ROWS; row++) {
+      if (row < currTileRow || row >= currTileRow + tileRows) {
+        continue;
+      }
+      uint8_t* from = buffer + (row - currTileRow) * HOST_DISPLAY_WIDTH;
+      uint8_t* to = panel + row * HOST_DISPLAY_WIDTH;
+      for (int x = tx * 8; x < (tx + tw) * 8 && x < HOST_DISPLAY_WIDTH; x++) {
+        to[x] = from[x];
+      }
+    }
+  }
+
+  void firstPage() {
+    currTileRow = 0;
+    clearBuffer();
+  }
+
+  uint8_t nextPage() {
+    sendBuffer();
+    currTileRow += tileRows;
+    if (currTileRow >= HOST_DISPLAY_TILE_ROWS) {
+      currTileRow = 0;
+      return 0;
+    }
+    clearBuffer();
+    return 1;
+  }
+
+  void drawPixel(int x, int y) { setPixel(x, y, true); }
+
+  void drawHLine(int x, int y, int w) {
+    for (int i = 0; i < w; i++) {
+      drawPixel(x + i, y);
+    }
+  }
+
+  void drawVLine(int x, int y, int h) {
+    for (int i = 0; i < h; i++) {
+      drawPixel(x, y + i);
+    }
+  }
+
+  void drawBox(int x, int y, int w, int h) {
+    for (int i = 0; i < h; i++) {
+      drawHLine(x, y + i, w);
+    }
+  }
+
+  // Bresenham, both ends included, as u8g2_DrawLine()
+  void drawLine(int x1, int y1, int x2, int y2) {
+    int dx = x1 < x2 ? x2 - x1 : x1 - x2;
+    int dy = y1 < y2 ? y2 - y1 : y1 - y2;
+    bool steep = dy > dx;
+    if (steep) {
+      swap(dx, dy);
+      swap(x1, y1);
+      swap(x2, y2);
+    }
+    if (x1 > x2) {
+      swap(x1, x2);
+      swap(y1, y2);
+    }
+    int err = dx >> 1;
+    int step = y2 > y1 ? 1 : -1;
+    int y = y1;
+    for (int x = x1; x <= x2; x++) {
+      if (steep) {
+        drawPixel(y, x);
+      } else {
+        drawPixel(x, y);
+      }
+      err -= dy;
+      if (err < 0) {
+        y += step;
+        err += dx;
+      }
+    }
+  }
+
+  void drawCircle(int x0, int y0, int rad, uint8_t option = U8G2_DRAW_ALL) { circle(x0, y0, rad, option, false); }
+  void drawDisc(int x0, int y0, int rad, uint8_t option = U8G2_DRAW_ALL) { circle(x0, y0, rad, option, true); }
+
+  // Rows top to bottom, bit 0 the leftmost pixel; clear bits are drawn
+  // in the background colour, u8g2's default solid bitmap mode
+  void drawXBMP(int x, int y, int w, int h, const uint8_t* bits) {
+    int rowBytes = (w + 7) / 8;
+    for (int j = 0; j < h; j++) {
+      for (int i = 0; i < w; i++) {
+        setPixel(x + i, y + j, (bits[j * rowBytes + i / 8] >> (i % 8)) & 1);
+      }
+    }
+  }
+
+  void setFont(const HostFont* newFont) { font = newFont; }
+
+  int getStrWidth(const char* text) const {
+    int width = 0;
+    for (const char* c = text; *c; c++) {
+      width += advance(*c);
+    }
+    return width;
+  }
+
+  // y is the baseline; glyphs are drawn solid, background included
+  int drawStr(int x, int y, const char* text) {
+    int start = x;
+    for (const char* c = text; *c; c++) {
+      int width = advance(*c);
+      for (int gx = 0; gx < width; gx++) {
+        for (int gy = 0; gy < font->ascent; gy++) {
+          setPixel(x + gx, y - font->ascent + 1 + gy, glyphPixel(*c, gx, gy, width));
+        }
+      }
+      x += width;
+    }
+    return x - start;
+  }
+
+  // What the panel shows, in the buffer's layout: 8 tile rows of 128 bytes
+  const uint8_t* panelPtr() const { return panel; }
+  uint32_t framesSent() const { return frames; }
+
+private:
+  uint8_t rotation;
+  uint8_t tileRows;
+  uint8_t currTileRow;
+  const HostFont* font;
+  uint32_t frames;
+  uint8_t buffer[HOST_DISPLAY_TILE_ROWS * HOST_DISPLAY_WIDTH];
+  uint8_t panel[HOST_DISPLAY_TILE_ROWS * HOST_DISPLAY_WIDTH];
+
+  static void swap(int& a, int& b) {
+    int t = a;
+    a = b;
+    b = t;
+  }
+
+  // Pixels outside the panel, or outside the tile rows in the buffer, are dropped
+  void setPixel(int x, int y, bool on) {
+    if (x < 0 || x >= HOST_DISPLAY_WIDTH || y < 0 || y >= HOST_DISPLAY_HEIGHT) {
+      return;
+    }
+    if (rotation == U8G2_R2) {
+      x = HOST_DISPLAY_WIDTH - 1 - x;
+      y = HOST_DISPLAY_HEIGHT - 1 - y;
+    }
+    int row = y / 8 - currTileRow;
+    if (row < 0 || row >= tileRows) {
+      return;
+    }
+    uint8_t& column = buffer[row * HOST_DISPLAY_WIDTH + x];
+    uint8_t bit = 1 << (y % 8);
+    column = on ? (column | bit) : (column & ~bit);
+  }
+
+  int advance(char c) const {
+    if (font->charset && !strchr(font->charset, c)) {
+      return 0; // Missing glyphs take no room and draw nothing
+    }
+    return strchr(font->narrow, c) ? font->narrowAdvance : font->advance;
+  }
+
+  // Stand-in glyph: a fixed pattern per character, blank for the space and
+  // in the last column, which separates the glyphs
+  static bool glyphPixel(char c, int gx, int gy, int width) {
+    if (c == ' ' || gx == width - 1) {
+      return false;
+    }
+    uint32_t h = (uint8_t)c * 2654435761u + gx * 40503u + gy * 9973u;
+    return (h >> 13) & 1;
+  }
+
+  // u8g2's midpoint circle, one octant mirrored into the quadrants asked for
+  void circle(int x0, int y0, int rad, uint8_t option, bool fill) {
+    int f = 1 - rad;
+    int ddFx = 1;
+    int ddFy = -2 * rad;
+    int x = 0;
+    int y = rad;
+    circleSection(x, y, x0, y0, option, fill);
+    while (x < y) {
+      if (f >= 0) {
+        y--;
+        ddFy += 2;
+        f += ddFy;
+      }
+      x++;
+      ddFx += 2;
+      f += ddFx;
+      circleSection(x, y, x0, y0, option, fill);
+    }
+  }
+
+  void circleSection(int x, int y, int x0, int y0, uint8_t option, bool fill) {
+    if (fill) {
+      if (option & U8G2_DRAW_UPPER_RIGHT) {
+        drawVLine(x0 + x, y0 - y, y + 1);
+        drawVLine(x0 + y, y0 - x, x + 1);
+      }
+      if (option & U8G2_DRAW_UPPER_LEFT) {
+        drawVLine(x0 - x, y0 - y, y + 1);
+        drawVLine(x0 - y, y0 - x, x + 1);
+      }
+      if (option & U8G2_DRAW_LOWER_RIGHT) {
+        drawVLine(x0 + x, y0, y + 1);
+        drawVLine(x0 + y, y0, x + 1);
+      }
+      if (option & U8G2_DRAW_LOWER_LEFT) {
+        drawVLine(x0 - x, y0, y + 1);
+        drawVLine(x0 - y, y0, x + 1);
+      }
+      return;
+    }
+    if (option & U8G2_DRAW_UPPER_RIGHT) {
+      drawPixel(x0 + x, y0 - y);
+      drawPixel(x0 + y, y0 - x);
+    }
+    if (option & U8G2_DRAW_UPPER_LEFT) {
+      drawPixel(x0 - x, y0 - y);
+      drawPixel(x0 - y, y0 - x);
+    }
+    if (option & U8G2_DRAW_LOWER_RIGHT) {
+      drawPixel(x0 + x, y0 + y);
+      drawPixel(x0 + y, y0 + x);
+    }
+    if (option & U8G2_DRAW_LOWER_LEFT) {
+      drawPixel(x0 - x, y0 + y);
+      drawPixel(x0 - y, y0 + x);
+    }
+  }
+};
+
+// The drivers config.h may pick: full frame, or one or two tile rows.
+// The pin arguments are ignored.
+#define HOST_U8G2_DRIVER(name, rows) \
+  class name : public U8G2 { \
+  public: \
+    name(uint8_t rotation, uint8_t, uint8_t, uint8_t) : U8G2(rotation, rows) {} \
+  };
+
+HOST_U8G2_DRIVER(U8G2_SSD1306_128X64_NONAME_F_SW_I2C, 8)
+HOST_U8G2_DRIVER(U8G2_SSD1306_128X64_NONAME_1_SW_I2C, 1)
+HOST_U8G2_DRIVER(U8G2_SSD1306_128X64_NONAME_2_SW_I2C, 2)
+HOST_U8G2_DRIVER(U8G2_SSD1306_128X64_NONAME_F_HW_I2C, 8)
+HOST_U8G2_DRIVER(U8G2_SSD1306_128X64_NONAME_1_HW_I2C, 1)
+HOST_U8G2_DRIVER(U8G2_SSD1306_128X64_NONAME_2_HW_I2C, 2)
+
+#undef HOST_U8G2_DRIVER
+
+#endif // HOST_U8G2LIB_H
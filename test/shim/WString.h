@@ -0,0 +1,81 @@
+/*
+ * Host stand-in for the Arduino String, for the native tests
+ * The members the firmware uses, on top of std::string
+ */
+
+#ifndef HOST_WSTRING_H
+#define HOST_WSTRING_H
+
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+class String {
+public:
+  String() {}
+  String(const char* text) : s(text ? text : "") {}
+  String(const String& other) : s(other.s) {}
+  explicit String(char c) : s(1, c) {}
+  explicit String(int value) : s(std::to_string(value)) {}
+  explicit String(unsigned int value) : s(std::to_string(value)) {}
+  explicit String(long value) : s(std::to_string(value)) {}
+  explicit String(unsigned long value) : s(std::to_string(value)) {}
+  explicit String(double value, unsigned char decimals = 2) {
+    char text[32];
+    snprintf(text, sizeof(text), "%.*f", decimals, value);
+    s = text;
+  }
+
+  String& operator=(const String& other) { s = other.s; return *this; }
+  String& operator=(const char* text) { s = text ? text : ""; return *this; }
+
+  const char* c_str() const { return s.c_str(); }
+  size_t length() const { return s.length(); }
+  bool isEmpty() const { return s.empty(); }
+
+  char charAt(size_t index) const { return index < s.length() ? s[index] : '\0'; }
+  char operator[](size_t index) const { return charAt(index); }
+  char& operator[](size_t index) { return s[index]; }
+  void setCharAt(size_t index, char c) { if (index < s.length()) s[index] = c; }
+
+  String& operator+=(const String& other) { s += other.s; return *this; }
+  String& operator+=(const char* text) { s += text; return *this; }
+  String& operator+=(char c) { s += c; return *this; }
+  bool concat(const String& other) { s += other.s; return true; }
+
+  bool operator==(const String& other) const { return s == other.s; }
+  bool operator==(const char* text) const { return s == text; }
+  bool operator!=(const String& other) const { return s != other.s; }
+  bool operator!=(const char* text) const { return s != text; }
+  bool equals(const String& other) const { return s == other.s; }
+
+  void remove(size_t index) { if (index < s.length()) s.erase(index); }
+  void remove(size_t index, size_t count) { if (index < s.length()) s.erase(index, count); }
+  void trim() {
+    size_t first = 0;
+    while (first < s.length() && isspace((unsigned char)s[first])) first++;
+    size_t last = s.length();
+    while (last > first && isspace((unsigned char)s[last - 1])) last--;
+    s = s.substr(first, last - first);
+  }
+  void toUpperCase() { for (char& c : s) c = toupper((unsigned char)c); }
+  void toLowerCase() { for (char& c : s) c = tolower((unsigned char)c); }
+  int indexOf(char c) const { size_t at = s.find(c); return at == std::string::npos ? -1 : (int)at; }
+  String substring(size_t from) const { return from < s.length() ? String(s.substr(from).c_str()) : String(); }
+  String substring(size_t from, size_t to) const {
+    return from < s.length() && to > from ? String(s.substr(from, to - from).c_str()) : String();
+  }
+  bool startsWith(const String& prefix) const { return s.compare(0, prefix.s.length(), prefix.s) == 0; }
+  long toInt() const { return atol(s.c_str()); }
+
+  friend String operator+(const String& a, const String& b) { String r(a); r += b; return r; }
+  friend String operator+(const String& a, const char* b) { String r(a); r += b; return r; }
+  friend String operator+(const char* a, const String& b) { String r(a); r += b; return r; }
+  friend String operator+(const String& a, char b) { String r(a); r += b; return r; }
+
+private:
+  std::string s;
+};
+
+#endif // HOST_WSTRING_H
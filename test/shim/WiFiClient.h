@@ -0,0 +1,10 @@
+/*
+ * Host stand-in for the ESP8266 core's WiFiClient.h, for the native tests
+ */
+
+#ifndef HOST_WIFICLIENT_H
+#define HOST_WIFICLIENT_H
+
+class WiFiClient;
+
+#endif // HOST_WIFICLIENT_H
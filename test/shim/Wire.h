@@ -0,0 +1,8 @@
+/*
+ * Host stand-in for the ESP8266 core's Wire.h, for the native tests
+ */
+
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#endif // HOST_WIRE_H
@@ -0,0 +1,43 @@
+/*
+ * Host stand-in for the ESP8266 core's coredecls.h, for the native tests
+ */
+
+#ifndef HOST_COREDECLS_H
+#define HOST_COREDECLS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Same CRC as the core's: polynomial 0x04C11DB7, most significant bit
+// first, no final inversion
+inline uint32_t crc32(const void* data, size_t length, uint32_t crc = 0xffffffff) {
+  const uint8_t* p = (const uint8_t*)data;
+  while (length--) {
+    uint8_t c = *p++;
+    for (uint32_t i = 0x80; i > 0; i >>= 1) {
+      bool bit = crc & 0x80000000;
+      if (c & i) {
+        bit = !bit;
+      }
+      crc <<= 1;
+      if (bit) {
+        crc ^= 0x04c11db7;
+      }
+    }
+  }
+  return crc;
+}
+
+// The SNTP callback; host_support.h calls it when a test sets the clock
+typedef void (*HostTimeSetCallback)(bool fromSntp);
+
+inline HostTimeSetCallback& hostTimeSetCallback() {
+  static HostTimeSetCallback callback = nullptr;
+  return callback;
+}
+
+inline void settimeofday_cb(HostTimeSetCallback callback) {
+  hostTimeSetCallback() = callback;
+}
+
+#endif // HOST_COREDECLS_H
@@ -0,0 +1,92 @@
+/*
+ * Host side of the firmware, for the native tests
+ * Defines what the natively built modules need from the parts that stay on
+ * the device: the log (logging.cpp), the histograms (metrics.cpp) and the
+ * update driver's hooks (weather.cpp), plus the ESP object and a clock the
+ * tests set through the SNTP callback. Include it from exactly one file of
+ * each test program.
+ */
+
+#ifndef HOST_SUPPORT_H
+#define HOST_SUPPORT_H
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <coredecls.h>
+#include <sys/time.h>
+#include <stdarg.h>
+#include "config.h"
+#include "logging.h"
+#include "time_manager.h"
+#include "weather_provider.h"
+
+// Controlled by the tests
+unsigned long hostMillis = 0;
+uint8_t hostUpdateLocation = 0;
+unsigned hostWeatherErrors = 0;    // showWeatherError() calls
+bool hostLogToStdout = false;
+
+// UTC in milliseconds as the next SNTP sync reports it
+static int64_t hostSntpUtcMs = 0;
+
+unsigned long millis() {
+  return hostMillis;
+}
+
+EspClass ESP;
+EEPROMClass EEPROM;
+
+int hostGettimeofday(struct timeval* tv, void*) {
+  tv->tv_sec = (time_t)(hostSntpUtcMs / 1000);
+  tv->tv_usec = (suseconds_t)(hostSntpUtcMs % 1000 * 1000);
+  return 0;
+}
+
+// Deliver an SNTP sync for utc at the current hostMillis and apply it, so
+// getEpochTime() and the time variables follow from there
+void hostSetClock(time_t utc) {
+  if (!hostTimeSetCallback()) {
+    setupNTP();
+  }
+  hostSntpUtcMs = (int64_t)utc * 1000;
+  hostTimeSetCallback()(true);
+  updateTimeAndDate();
+}
+
+// logging.cpp; quiet unless a test asks for the messages
+namespace Log {
+    void write(uint8_t, PGM_P format, ...) {
+        if (!hostLogToStdout) {
+            return;
+        }
+        va_list args;
+        va_start(args, format);
+        vprintf(format, args);
+        va_end(args);
+        putchar('\n');
+    }
+
+    void flush() {
+        fflush(stdout);
+    }
+}
+
+// metrics.cpp; the timings are not kept
+namespace Metrics {
+    void observe(uint8_t, uint32_t) {}
+}
+
+// weather.cpp
+namespace Weather {
+    void sampleHeap() {}
+
+    uint8_t updateLocation() {
+        return hostUpdateLocation;
+    }
+
+    void showWeatherError(const char*, const char*, const char*, const char*) {
+        hostWeatherErrors++;
+    }
+}
+
+#endif // HOST_SUPPORT_H
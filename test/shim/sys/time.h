@@ -0,0 +1,15 @@
+/*
+ * Host stand-in for sys/time.h, for the native tests
+ * The system header, with gettimeofday() reading the time the tests set
+ * instead of the host's; see hostSetClock() in host_support.h.
+ */
+
+#ifndef HOST_SYS_TIME_H
+#define HOST_SYS_TIME_H
+
+#include_next <sys/time.h>
+
+int hostGettimeofday(struct timeval* tv, void* tz);
+#define gettimeofday hostGettimeofday
+
+#endif // HOST_SYS_TIME_H
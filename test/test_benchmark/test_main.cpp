@@ -0,0 +1,51 @@
+/*
+ * The logic benchmark on the host
+ * Runs the device's runLogicBenchmark() with the log on stdout: parse cost
+ * per byte and peak document allocation for the recorded OpenWeatherMap
+ * responses, the time and icon helpers, and the draw time of each screen,
+ * all timed by the host's steady clock. The numbers are the host's; this
+ * only checks that every stage ran and that the parse left nothing behind.
+ */
+
+#include <unity.h>
+#include "host_support.h"
+#include "benchmark.h"
+#include "display.h"
+#include "time_zone.h"
+
+void setUp() {
+  TimeZone::set(TZ_DEFAULT);
+  hostSetClock(1717236000); // 2024-06-01 10:00 UTC, when the fixtures were recorded
+  cityCoordinatesKnown = true;
+  strcpy(currentCondition, "Unknown");
+  u8g2.clearBuffer();
+}
+
+void tearDown() {}
+
+static void test_logic_benchmark() {
+  hostLogToStdout = true;
+  runLogicBenchmark();
+  hostLogToStdout = false;
+
+  // The fixture's weather was applied, within the document budget, and
+  // every document has been freed again
+  TEST_ASSERT_EQUAL_STRING("Clouds", currentCondition);
+  TEST_ASSERT_GREATER_THAN(0, Weather::parseAllocator.peakBytes());
+  TEST_ASSERT_LESS_OR_EQUAL(JSON_DOC_BUDGET, Weather::parseAllocator.peakBytes());
+  TEST_ASSERT_EQUAL(0, Weather::parseAllocator.usedBytes());
+
+  // The last screen drawn, the hourly one, is still in the buffer
+  const uint8_t* buffer = u8g2.getBufferPtr();
+  size_t lit = 0;
+  for (size_t i = 0; i < 1024; i++) {
+    lit += buffer[i] != 0;
+  }
+  TEST_ASSERT_GREATER_THAN(0, lit);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_logic_benchmark);
+  return UNITY_END();
+}
@@ -0,0 +1,221 @@
+/*
+ * Native tests of the clock and the screens
+ * The clock is set through the SNTP callback and the screens are drawn into
+ * the in-memory panel of test/shim/U8g2lib.h. Each screen's pixels are
+ * checked where they mean something, and the whole frame against a
+ * checksum, so a change to the draw code shows up as a changed CRC.
+ */
+
+#include <unity.h>
+#include "host_support.h"
+#include "display.h"
+#include "time_manager.h"
+#include "time_zone.h"
+#include "solar.h"
+#include "locations.h"
+#include "hourly_forecast.h"
+#include "weather.h"
+
+// 2024-06-01 10:00 UTC, a Saturday; 06:00 in New York
+#define CLOCK_UTC 1717236000
+
+// Whether the panel shows pixel (x, y) of the picture as drawn. The
+// display is mounted upside down, U8G2_R2.
+static bool lit(int x, int y) {
+  int column = 127 - x;
+  int line = 63 - y;
+  return (u8g2.panelPtr()[line / 8 * 128 + column] >> (line % 8)) & 1;
+}
+
+// Lit pixels in a rectangle of the picture, both corners included
+static int litIn(int x0, int y0, int x1, int y1) {
+  int count = 0;
+  for (int y = y0; y <= y1; y++) {
+    for (int x = x0; x <= x1; x++) {
+      count += lit(x, y);
+    }
+  }
+  return count;
+}
+
+static uint32_t panelCrc() {
+  return crc32(u8g2.panelPtr(), 1024);
+}
+
+// Draw a screen from scratch
+static void show(byte screen) {
+  invalidateDisplay();
+  renderScreen(screen);
+}
+
+void setUp() {
+  TimeZone::set(TZ_DEFAULT);
+  hostSetClock(CLOCK_UTC);
+  use12HourFormat = false;
+  cityName = "New York";
+  stateName = "NY";
+  Locations::clear();
+  currentTemp = 72;
+  highTemp = 79;
+  lowTemp = 61;
+  strcpy(currentCondition, "Clouds");
+  weatherDataStale = false;
+  sunriseHour = 6;
+  sunriseMinute = 0;
+  sunsetHour = 18;
+  sunsetMinute = 0;
+  static const char* const DAYS[5] = { "SAT", "SUN", "MON", "TUE", "WED" };
+  for (int i = 0; i < 5; i++) {
+    strcpy(forecast[i].day, DAYS[i]);
+    forecast[i].temp = 80 + i;
+    forecast[i].lowTemp = 60 + i;
+    forecast[i].iconType = i;
+  }
+  HourlyForecast::expire(CLOCK_UTC + 48 * 3600);
+}
+
+void tearDown() {}
+
+static void test_format_time_string() {
+  char text[10];
+  formatTimeString(text, 6, 5, false);
+  TEST_ASSERT_EQUAL_STRING("06:05", text);
+  formatTimeString(text, 23, 59, false);
+  TEST_ASSERT_EQUAL_STRING("23:59", text);
+  formatTimeString(text, 6, 5, true);
+  TEST_ASSERT_EQUAL_STRING(" 6:05 AM", text);
+  formatTimeString(text, 0, 30, true);
+  TEST_ASSERT_EQUAL_STRING("12:30 AM", text);
+  formatTimeString(text, 12, 0, true);
+  TEST_ASSERT_EQUAL_STRING("12:00 PM", text);
+}
+
+static void test_clock_follows_sntp() {
+  TEST_ASSERT_TRUE(timeInitialized);
+  TEST_ASSERT_EQUAL(6, hours);
+  TEST_ASSERT_EQUAL(0, minutes);
+  TEST_ASSERT_EQUAL_STRING("SAT", dayOfWeekStr);
+  TEST_ASSERT_EQUAL_STRING("JUN", monthStr);
+  TEST_ASSERT_EQUAL(1, dayOfMonth);
+
+  // Between syncs the clock runs on millis()
+  hostMillis += 90 * 1000UL;
+  TEST_ASSERT_TRUE(updateTimeAndDate());
+  TEST_ASSERT_EQUAL(1, minutes);
+  TEST_ASSERT_EQUAL(30, seconds);
+  TEST_ASSERT_EQUAL(CLOCK_UTC + 90, getEpochTime());
+}
+
+static void test_sunrise_and_sunset() {
+  cityLatitude = 40.7143f;
+  cityLongitude = -74.006f;
+  cityCoordinatesKnown = true;
+  Solar::service();
+  TEST_ASSERT_TRUE(Solar::computed());
+  // The NOAA spreadsheet gives 05:27 and 20:21 EDT that day
+  TEST_ASSERT_EQUAL(5, sunriseHour);
+  TEST_ASSERT_INT_WITHIN(1, 27, sunriseMinute);
+  TEST_ASSERT_EQUAL(20, sunsetHour);
+  TEST_ASSERT_INT_WITHIN(1, 21, sunsetMinute);
+  TEST_ASSERT_TRUE(Solar::phaseAt(6 * 60).daytime);
+  TEST_ASSERT_FALSE(Solar::phaseAt(21 * 60).daytime);
+}
+
+static void test_time_screen() {
+  show(SCREEN_TIME);
+  // AM: its disc filled, the PM circle only outlined
+  TEST_ASSERT_TRUE(lit(110, 7));
+  TEST_ASSERT_TRUE(lit(110, 16));
+  TEST_ASSERT_FALSE(lit(110, 19));
+  // Time digits above the date line, the date between them and the sun bar
+  TEST_ASSERT_GREATER_THAN(100, litIn(20, 9, 100, 32));
+  TEST_ASSERT_GREATER_THAN(20, litIn(20, 41, 100, 48));
+  TEST_ASSERT_EQUAL(0, litIn(0, 33, 127, 40));
+  // The dashed bar: two pixels on, two off; the sun sits at sunrise
+  TEST_ASSERT_TRUE(lit(64, 55) && lit(65, 55));
+  TEST_ASSERT_FALSE(lit(66, 55) || lit(67, 55));
+  TEST_ASSERT_TRUE(lit(24, 55));
+  TEST_ASSERT_EQUAL_HEX32(0x6ea58177, panelCrc());
+
+  hours = 18;
+  show(SCREEN_TIME);
+  TEST_ASSERT_FALSE(lit(110, 7));
+  TEST_ASSERT_TRUE(lit(110, 19));
+}
+
+static void test_current_weather_screen() {
+  show(SCREEN_CURRENT_WEATHER);
+  TEST_ASSERT_GREATER_THAN(20, litIn(40, 2, 88, 10));     // TODAY
+  TEST_ASSERT_GREATER_THAN(50, litIn(80, 16, 111, 47));   // The 32x32 icon
+  TEST_ASSERT_GREATER_THAN(50, litIn(10, 13, 40, 36));    // 72
+  TEST_ASSERT_EQUAL(0, litIn(0, 0, 12, 6));        // No OLD marker
+  TEST_ASSERT_EQUAL_HEX32(0x900004bb, panelCrc());
+
+  weatherDataStale = true;
+  show(SCREEN_CURRENT_WEATHER);
+  TEST_ASSERT_GREATER_THAN(0, litIn(0, 0, 12, 6));
+}
+
+static void test_forecast_screen() {
+  show(SCREEN_FORECAST);
+  // An icon in each of the three columns
+  for (int i = 0; i < 3; i++) {
+    int x = i * 42 + 21;
+    TEST_ASSERT_GREATER_THAN(10, litIn(x - 8, 22, x + 7, 37));
+  }
+  TEST_ASSERT_EQUAL_HEX32(0xa5cc5f89, panelCrc());
+
+  forecast[0].lowTemp = -999;
+  show(SCREEN_FORECAST);
+  TEST_ASSERT_NOT_EQUAL(0xa5cc5f89, panelCrc());
+}
+
+static void test_hourly_screen() {
+  show(SCREEN_HOURLY);
+  uint32_t empty = panelCrc();
+  TEST_ASSERT_GREATER_THAN(20, litIn(20, 30, 108, 36));   // No hourly data yet
+
+  // 60 to 80 and back at 5 a step, rain likely from the sixth point on
+  for (int i = 0; i < 9; i++) {
+    HourlyForecast::store(CLOCK_UTC + i * 3 * 3600, 80 - abs(i - 4) * 5, 0, i >= 5 ? 80 : 0);
+  }
+  show(SCREEN_HOURLY);
+  TEST_ASSERT_NOT_EQUAL(empty, panelCrc());
+  // Nine points over x 8..119, y 40 for the lowest and 20 for the highest
+  TEST_ASSERT_TRUE(lit(8, 40));
+  TEST_ASSERT_TRUE(lit(8 + 4 * 111 / 8, 20));
+  TEST_ASSERT_TRUE(lit(119, 40));
+  // No bar under the dry fifth point, 4 of 6 pixels (x 3 wide) under the sixth
+  TEST_ASSERT_EQUAL(0, litIn(8 + 4 * 111 / 8 - 1, 50, 8 + 4 * 111 / 8 + 1, 55));
+  TEST_ASSERT_EQUAL(12, litIn(8 + 5 * 111 / 8 - 1, 50, 8 + 5 * 111 / 8 + 1, 55));
+  TEST_ASSERT_EQUAL_HEX32(0xccea9738, panelCrc());
+}
+
+// Only the changed tile rows are sent, and they leave the panel as a full
+// redraw would
+static void test_partial_update_matches_full_frame() {
+  show(SCREEN_CURRENT_WEATHER);
+  uint32_t frames = u8g2.framesSent();
+  renderScreen(SCREEN_CURRENT_WEATHER);
+  TEST_ASSERT_EQUAL(frames, u8g2.framesSent());    // Nothing changed, nothing sent
+
+  currentTemp = 68;
+  lowTemp = 58;
+  renderScreen(SCREEN_CURRENT_WEATHER);
+  uint32_t updated = panelCrc();
+  show(SCREEN_CURRENT_WEATHER);
+  TEST_ASSERT_EQUAL_HEX32(panelCrc(), updated);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_format_time_string);
+  RUN_TEST(test_clock_follows_sntp);
+  RUN_TEST(test_sunrise_and_sunset);
+  RUN_TEST(test_time_screen);
+  RUN_TEST(test_current_weather_screen);
+  RUN_TEST(test_forecast_screen);
+  RUN_TEST(test_hourly_screen);
+  RUN_TEST(test_partial_update_matches_full_frame);
+  return UNITY_END();
+}
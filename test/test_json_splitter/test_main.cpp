@@ -0,0 +1,118 @@
+/*
+ * Native tests of the incremental JSON splitter
+ * The units handed out must not depend on how the stream is cut, and
+ * strings, nesting and oversized units must be handled at every depth.
+ */
+
+#include <unity.h>
+#include <string>
+#include <vector>
+#include "host_support.h"
+#include "json_splitter.h"
+#include "benchmark_fixtures.h"
+
+struct Unit {
+  std::string topKey;
+  std::string json;
+  uint16_t elementIndex;
+};
+
+static JsonSplitter splitter;
+static std::vector<Unit> units;
+
+static void collect(const char* topKey, const char* json, size_t len, void* context) {
+  Unit unit = { topKey, std::string(json, len), splitter.elementIndex };
+  units.push_back(unit);
+}
+
+// Split text at depth, fed chunkSize bytes at a time
+static void split(const char* text, uint8_t depth, size_t chunkSize, size_t capacity = 256) {
+  static char buffer[1024];
+  units.clear();
+  splitter.begin(depth, buffer, capacity, collect, nullptr);
+  size_t length = strlen(text);
+  for (size_t offset = 0; offset < length; offset += chunkSize) {
+    splitter.feed(text + offset, min(chunkSize, length - offset));
+  }
+  splitter.finish();
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_root_members_are_wrapped() {
+  split("{\"a\": 1, \"b\": {\"c\": [1, 2]}, \"s\": \"x}\\\"y\"}", 1, 1);
+  TEST_ASSERT_EQUAL(3, units.size());
+  TEST_ASSERT_EQUAL_STRING("a", units[0].topKey.c_str());
+  TEST_ASSERT_EQUAL_STRING("{\"a\":1}", units[0].json.c_str());
+  TEST_ASSERT_EQUAL_STRING("b", units[1].topKey.c_str());
+  TEST_ASSERT_EQUAL_STRING("{\"b\":{\"c\":[1,2]}}", units[1].json.c_str());
+  TEST_ASSERT_EQUAL_STRING("s", units[2].topKey.c_str());
+  // Brackets and escaped quotes inside strings are not structure
+  TEST_ASSERT_EQUAL_STRING("{\"s\":\"x}\\\"y\"}", units[2].json.c_str());
+}
+
+static void test_array_elements_and_their_members() {
+  const char* text = "{\"list\":[{\"dt\":1,\"v\":\"a\"},{\"dt\":2,\"v\":\"b\"}],\"n\":2}";
+
+  split(text, 2, 3);
+  TEST_ASSERT_EQUAL(2, units.size());
+  TEST_ASSERT_EQUAL_STRING("list", units[1].topKey.c_str());
+  TEST_ASSERT_EQUAL_STRING("{\"dt\":2,\"v\":\"b\"}", units[1].json.c_str());
+
+  // One level deeper: the members of each element, with the element's index
+  split(text, 3, 5);
+  TEST_ASSERT_EQUAL(4, units.size());
+  TEST_ASSERT_EQUAL_STRING("{\"dt\":1}", units[0].json.c_str());
+  TEST_ASSERT_EQUAL(0, units[0].elementIndex);
+  TEST_ASSERT_EQUAL_STRING("{\"v\":\"b\"}", units[3].json.c_str());
+  TEST_ASSERT_EQUAL(1, units[3].elementIndex);
+}
+
+static void test_whole_document() {
+  split(" { \"a\" : [ 1 , 2 ] } ", 0, 2);
+  TEST_ASSERT_EQUAL(1, units.size());
+  TEST_ASSERT_EQUAL_STRING("", units[0].topKey.c_str());
+  TEST_ASSERT_EQUAL_STRING("{\"a\":[1,2]}", units[0].json.c_str());
+}
+
+static void test_oversized_units_are_dropped() {
+  split("{\"big\":\"0123456789012345678901234567890123456789\",\"ok\":1}", 1, 7, 32);
+  TEST_ASSERT_EQUAL(1, splitter.droppedUnits);
+  TEST_ASSERT_EQUAL(1, units.size());
+  TEST_ASSERT_EQUAL_STRING("{\"ok\":1}", units[0].json.c_str());
+}
+
+// The recorded forecast gives the same units however the network cuts it
+static void test_fixture_independent_of_chunking() {
+  std::vector<Unit> reference;
+  split(OWM_FORECAST_FIXTURE, 2, strlen(OWM_FORECAST_FIXTURE), 1024);
+  reference = units;
+  TEST_ASSERT_EQUAL(0, splitter.droppedUnits);
+
+  size_t listEntries = 0;
+  for (const Unit& unit : reference) {
+    listEntries += unit.topKey == "list";
+  }
+  TEST_ASSERT_EQUAL(40, listEntries);
+
+  static const size_t CHUNKS[] = { 1, 2, 7, 64, 256, 1460 };
+  for (size_t chunk : CHUNKS) {
+    split(OWM_FORECAST_FIXTURE, 2, chunk, 1024);
+    TEST_ASSERT_EQUAL(reference.size(), units.size());
+    for (size_t i = 0; i < units.size(); i++) {
+      TEST_ASSERT_EQUAL_STRING(reference[i].topKey.c_str(), units[i].topKey.c_str());
+      TEST_ASSERT_EQUAL_STRING(reference[i].json.c_str(), units[i].json.c_str());
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_root_members_are_wrapped);
+  RUN_TEST(test_array_elements_and_their_members);
+  RUN_TEST(test_whole_document);
+  RUN_TEST(test_oversized_units_are_dropped);
+  RUN_TEST(test_fixture_independent_of_chunking);
+  return UNITY_END();
+}
@@ -0,0 +1,138 @@
+/*
+ * Native tests of the weather locations
+ * A rotation over every location, with the coordinates the update looks up,
+ * must come back from EEPROM unchanged, wherever during it the save ran.
+ */
+
+#include <unity.h>
+#include "host_support.h"
+#include "locations.h"
+
+struct Place {
+  const char* city;
+  const char* state;
+  float latitude;
+  float longitude;
+};
+
+static const Place PLACES[LOCATIONS_MAX] = {
+  { "New York", "NY", 40.7143f, -74.006f },
+  { "Boston", "MA", 42.3584f, -71.0598f },
+  { "Chicago", "IL", 41.85f, -87.65f }
+};
+
+// The table as a reboot finds it, rebuilt from EEPROM over stale entries
+static void reboot() {
+  Locations::clear();
+  Locations::add("Stale", "");
+  Locations::add("Stale", "");
+  Locations::begin();
+}
+
+// Configure the first count places without coordinates, as the settings page does
+static void configure(uint8_t count) {
+  cityName = PLACES[0].city;
+  stateName = PLACES[0].state;
+  cityCoordinatesKnown = false;
+  Locations::clear();
+  for (uint8_t i = 1; i < count; i++) {
+    TEST_ASSERT_TRUE(Locations::add(PLACES[i].city, PLACES[i].state));
+  }
+  TEST_ASSERT_TRUE(Locations::save());
+}
+
+// One update: each location swapped in turn and geocoded, then the table
+// saved. With saveInScope the last location is still swapped in for that.
+static void rotate(bool saveInScope) {
+  for (uint8_t i = 0; i < Locations::count(); i++) {
+    Locations::Scope scope(i);
+    TEST_ASSERT_EQUAL_STRING(PLACES[i].city, cityName.c_str());
+    cityLatitude = PLACES[i].latitude;
+    cityLongitude = PLACES[i].longitude;
+    cityCoordinatesKnown = true;
+    if (saveInScope && i + 1 == Locations::count()) {
+      TEST_ASSERT_TRUE(Locations::save());
+    }
+  }
+  if (!saveInScope) {
+    TEST_ASSERT_TRUE(Locations::save());
+  }
+}
+
+static void expectTable(uint8_t count) {
+  TEST_ASSERT_EQUAL(count, Locations::count());
+  TEST_ASSERT_EQUAL_STRING(PLACES[0].city, cityName.c_str());
+  for (uint8_t i = 0; i < count; i++) {
+    TEST_ASSERT_EQUAL_STRING(PLACES[i].city, Locations::city(i).c_str());
+    TEST_ASSERT_EQUAL_STRING(PLACES[i].state, Locations::state(i).c_str());
+    Locations::Scope scope(i);
+    TEST_ASSERT_EQUAL_STRING(PLACES[i].city, cityName.c_str());
+    TEST_ASSERT_TRUE(cityCoordinatesKnown);
+    TEST_ASSERT_EQUAL_FLOAT(PLACES[i].latitude, cityLatitude);
+    TEST_ASSERT_EQUAL_FLOAT(PLACES[i].longitude, cityLongitude);
+  }
+}
+
+void setUp() {
+  EEPROM.erase();
+  Locations::begin();
+}
+
+void tearDown() {}
+
+static void test_rotation_round_trips() {
+  for (uint8_t count = 2; count <= LOCATIONS_MAX; count++) {
+    configure(count);
+    rotate(false);
+    reboot();
+    // The globals are the settings record's; the test keeps them
+    cityLatitude = PLACES[0].latitude;
+    cityLongitude = PLACES[0].longitude;
+    cityCoordinatesKnown = true;
+    expectTable(count);
+  }
+}
+
+static void test_save_with_a_location_swapped_in() {
+  configure(LOCATIONS_MAX);
+  rotate(true);
+  // A save now, with nothing swapped in, finds nothing left to write
+  uint32_t commits = EEPROM.commits;
+  TEST_ASSERT_TRUE(Locations::save());
+  TEST_ASSERT_EQUAL(commits, EEPROM.commits);
+
+  expectTable(LOCATIONS_MAX);
+  reboot();
+  expectTable(LOCATIONS_MAX);
+}
+
+static void test_unchanged_table_is_not_written() {
+  configure(LOCATIONS_MAX);
+  rotate(false);
+  uint32_t commits = EEPROM.commits;
+  reboot();
+  TEST_ASSERT_TRUE(Locations::save());
+  {
+    Locations::Scope scope(1);
+    TEST_ASSERT_TRUE(Locations::save());
+  }
+  TEST_ASSERT_EQUAL(commits, EEPROM.commits);
+}
+
+static void test_corrupt_record_is_ignored() {
+  configure(LOCATIONS_MAX);
+  rotate(false);
+  EEPROM.flash[LOCATIONS_OFFSET + 5] ^= 0x01;
+  Locations::clear(); // As at boot
+  Locations::begin();
+  TEST_ASSERT_EQUAL(1, Locations::count());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_rotation_round_trips);
+  RUN_TEST(test_save_with_a_location_swapped_in);
+  RUN_TEST(test_unchanged_table_is_not_written);
+  RUN_TEST(test_corrupt_record_is_ignored);
+  return UNITY_END();
+}
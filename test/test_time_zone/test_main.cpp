@@ -0,0 +1,303 @@
+/*
+ * Native tests of the POSIX TZ rules
+ * Offsets around known transitions, and every rule below checked hour by
+ * hour against the host C library over several years.
+ */
+
+#include <unity.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "host_support.h"
+#include "time_zone.h"
+
+static time_t utcAt(int year, int month, int day, int hour, int minute) {
+  struct tm tm = {};
+  tm.tm_year = year - 1900;
+  tm.tm_mon = month - 1;
+  tm.tm_mday = day;
+  tm.tm_hour = hour;
+  tm.tm_min = minute;
+  return timegm(&tm);
+}
+
+// Offset the host C library gives for utc under a TZ string
+static long hostOffset(const char* rule, time_t utc) {
+  setenv("TZ", rule, 1);
+  tzset();
+  struct tm local;
+  localtime_r(&utc, &local);
+  return local.tm_gmtoff;
+}
+
+// Day number of a broken-down date, the way the forecast bucketing counts
+static long dayNumber(const struct tm& date) {
+  struct tm midnight = {};
+  midnight.tm_year = date.tm_year;
+  midnight.tm_mon = date.tm_mon;
+  midnight.tm_mday = date.tm_mday;
+  return (long)(timegm(&midnight) / 86400);
+}
+
+static long hostLocalDay(time_t utc) {
+  struct tm local;
+  localtime_r(&utc, &local);
+  return dayNumber(local);
+}
+
+void setUp() {
+  TimeZone::set("UTC0");
+}
+
+void tearDown() {}
+
+static void test_us_eastern_transitions() {
+  TEST_ASSERT_TRUE(TimeZone::set(TZ_DEFAULT));
+  // 2024: DST from March 10 02:00 EST to November 3 02:00 EDT
+  TEST_ASSERT_EQUAL(-5 * 3600, TimeZone::offsetAt(utcAt(2024, 3, 10, 6, 59)));
+  TEST_ASSERT_EQUAL(-4 * 3600, TimeZone::offsetAt(utcAt(2024, 3, 10, 7, 0)));
+  TEST_ASSERT_EQUAL(-4 * 3600, TimeZone::offsetAt(utcAt(2024, 11, 3, 5, 59)));
+  TEST_ASSERT_EQUAL(-5 * 3600, TimeZone::offsetAt(utcAt(2024, 11, 3, 6, 0)));
+  TEST_ASSERT_EQUAL_STRING("EDT", TimeZone::abbreviation(utcAt(2024, 7, 1, 12, 0)));
+  TEST_ASSERT_EQUAL_STRING("EST", TimeZone::abbreviation(utcAt(2024, 1, 1, 12, 0)));
+  TEST_ASSERT_EQUAL(utcAt(2024, 11, 3, 6, 0), TimeZone::nextTransition(utcAt(2024, 7, 1, 12, 0)));
+}
+
+static void test_southern_hemisphere() {
+  TEST_ASSERT_TRUE(TimeZone::set("AEST-10AEDT,M10.1.0,M4.1.0/3"));
+  TEST_ASSERT_EQUAL(11 * 3600, TimeZone::offsetAt(utcAt(2024, 1, 15, 0, 0)));
+  TEST_ASSERT_EQUAL(10 * 3600, TimeZone::offsetAt(utcAt(2024, 7, 15, 0, 0)));
+  TEST_ASSERT_TRUE(TimeZone::isDst(utcAt(2024, 12, 31, 23, 0)));
+}
+
+static void test_fixed_offsets() {
+  TEST_ASSERT_TRUE(TimeZone::set("<+0530>-5:30"));
+  TEST_ASSERT_EQUAL(19800, TimeZone::offsetAt(utcAt(2024, 6, 1, 0, 0)));
+  TEST_ASSERT_EQUAL(0, TimeZone::nextTransition(utcAt(2024, 6, 1, 0, 0)));
+  TEST_ASSERT_FALSE(TimeZone::isDst(utcAt(2024, 6, 1, 0, 0)));
+}
+
+static void test_invalid_rules_are_rejected() {
+  static const char* const INVALID[] = {
+    "", "E", "EST", "EST5EDT,M3.2.0", "EST5EDT,M13.2.0,M11.1.0", "EST5EDT,M3.6.0,M11.1.0",
+    "EST5EDT,J0,J300", "EST5EDT,366,300", "EST25", "EST5EDT,M3.2.0,M11.1.0x"
+  };
+  for (const char* rule : INVALID) {
+    TEST_ASSERT_FALSE_MESSAGE(TimeZone::isValid(rule), rule);
+  }
+  TEST_ASSERT_FALSE(TimeZone::set("garbage"));
+  TEST_ASSERT_EQUAL_STRING("UTC0", TimeZone::rule());
+}
+
+static void test_matches_host_library() {
+  static const char* const RULES[] = {
+    TZ_DEFAULT,
+    "PST8PDT,M3.2.0,M11.1.0",
+    "CET-1CEST,M3.5.0,M10.5.0/3",
+    "GMT0BST,M3.5.0/1,M10.5.0",
+    "AEST-10AEDT,M10.1.0,M4.1.0/3",
+    "NZST-12NZDT,M9.5.0,M4.1.0/3",
+    "NST3:30NDT,M3.2.0,M11.1.0",
+    "IST-2IDT,M3.4.4/26,M10.5.0",     // Time past 24h (RFC 8536)
+    "<-03>3<-02>,M3.5.0/-2,M10.5.0/-1", // Negative times
+    "EST5EDT,J60,J300",
+    "EST5EDT,59,299",
+    "<+0530>-5:30",
+    "UTC0"
+  };
+  // An odd step, so the instants drift across every time of day
+  const time_t step = 3607;
+  for (const char* rule : RULES) {
+    TEST_ASSERT_TRUE_MESSAGE(TimeZone::set(rule), rule);
+    for (time_t utc = utcAt(2019, 1, 1, 0, 0); utc < utcAt(2027, 1, 1, 0, 0); utc += step) {
+      long expected = hostOffset(rule, utc);
+      if (expected != TimeZone::offsetAt(utc)) {
+        char message[96];
+        snprintf(message, sizeof(message), "%s at %lld", rule, (long long)utc);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(expected, TimeZone::offsetAt(utc), message);
+      }
+    }
+  }
+}
+
+// The division the forecast buckets entries with against gmtime_r() and
+// localtime_r(), across DST changes and past the 32-bit time_t limit
+static void test_local_day_matches_host_library() {
+  static const char* const RULES[] = {
+    "UTC0",
+    TZ_DEFAULT,
+    "AEST-10AEDT,M10.1.0,M4.1.0/3",
+    "CST5CDT,M3.2.0/0,M11.1.0/1",      // Changes at midnight
+    "<-01>1<+00>-0,M3.5.0/0,M10.5.0/1",
+    "<+1245>-12:45<+1345>,M9.5.0/2:45,M4.1.0/3:45",
+    "<-11>11"
+  };
+  const time_t limit32 = INT32_MAX; // 2038-01-19 03:14:07 UTC
+  for (const char* rule : RULES) {
+    TEST_ASSERT_TRUE_MESSAGE(TimeZone::set(rule), rule);
+    setenv("TZ", rule, 1);
+    tzset();
+    char message[96];
+    // Every 1801 s drifts across each time of day, so every change is hit
+    for (time_t utc = utcAt(2020, 1, 1, 0, 0); utc < utcAt(2029, 1, 1, 0, 0); utc += 1801) {
+      if (hostLocalDay(utc) != TimeZone::localDay(utc)) {
+        snprintf(message, sizeof(message), "%s at %lld", rule, (long long)utc);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(hostLocalDay(utc), TimeZone::localDay(utc), message);
+      }
+    }
+    // Minute by minute around the 32-bit limit, and a few years on
+    for (time_t utc = limit32 - 2 * 86400; utc < limit32 + 2 * 86400; utc += 60) {
+      snprintf(message, sizeof(message), "%s at %lld", rule, (long long)utc);
+      TEST_ASSERT_EQUAL_INT_MESSAGE(hostLocalDay(utc), TimeZone::localDay(utc), message);
+    }
+    for (time_t utc = utcAt(2038, 1, 1, 0, 0); utc < utcAt(2042, 1, 1, 0, 0); utc += 3607) {
+      if (hostLocalDay(utc) != TimeZone::localDay(utc)) {
+        snprintf(message, sizeof(message), "%s at %lld", rule, (long long)utc);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(hostLocalDay(utc), TimeZone::localDay(utc), message);
+      }
+    }
+  }
+
+  // Under UTC it is plain gmtime_r(), also before 1970
+  TimeZone::set("UTC0");
+  static const time_t INSTANTS[] = { -86401, -86400, -1, 0, 86399, 86400, limit32, limit32 + 1, (time_t)UINT32_MAX + 1 };
+  for (time_t utc : INSTANTS) {
+    struct tm date;
+    gmtime_r(&utc, &date);
+    TEST_ASSERT_EQUAL_INT(dayNumber(date), TimeZone::localDay(utc));
+  }
+}
+
+// What bucketing a forecast costs each way, for a week of 3-hourly entries
+#define HOUR_STEP (3 * 3600)
+
+static void test_local_day_timing() {
+  TEST_ASSERT_TRUE(TimeZone::set(TZ_DEFAULT));
+  setenv("TZ", TZ_DEFAULT, 1);
+  tzset();
+  const time_t start = utcAt(2024, 10, 29, 0, 0); // Across the November change
+  const int rounds = 20000;
+  volatile long sink = 0;
+
+  clock_t begin = clock();
+  for (int round = 0; round < rounds; round++) {
+    for (time_t utc = start; utc < start + 7 * 86400; utc += HOUR_STEP) {
+      sink += TimeZone::localDay(utc);
+    }
+  }
+  clock_t division = clock() - begin;
+
+  begin = clock();
+  for (int round = 0; round < rounds; round++) {
+    for (time_t utc = start; utc < start + 7 * 86400; utc += HOUR_STEP) {
+      struct tm date;
+      localtime_r(&utc, &date);
+      sink += date.tm_yday;
+    }
+  }
+  clock_t local = clock() - begin;
+
+  begin = clock();
+  for (int round = 0; round < rounds; round++) {
+    for (time_t utc = start; utc < start + 7 * 86400; utc += HOUR_STEP) {
+      time_t shifted = utc + TimeZone::offsetAt(utc);
+      struct tm date;
+      gmtime_r(&shifted, &date);
+      sink += date.tm_yday;
+    }
+  }
+  clock_t gm = clock() - begin;
+
+  char message[128];
+  snprintf(message, sizeof(message), "%d forecasts: division %.1f ms, localtime_r %.1f ms, gmtime_r %.1f ms",
+           rounds, division * 1000.0 / CLOCKS_PER_SEC, local * 1000.0 / CLOCKS_PER_SEC, gm * 1000.0 / CLOCKS_PER_SEC);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_TRUE(sink != 0);
+}
+
+// J1/0,J365/25 and its variants are DST all year (RFC 8536)
+static void test_dst_all_year() {
+  static const char* const RULES[] = {
+    "EST5EDT,J1/0,J365/25",
+    "EST5EDT,0/0,J365/25",
+    "EST5EDT4,0/0,365/25",
+    "<+03>-3<+04>,J1/0,J365/25"
+  };
+  static const long DST_OFFSETS[] = { -4 * 3600, -4 * 3600, -4 * 3600, 4 * 3600 };
+  for (size_t i = 0; i < sizeof(RULES) / sizeof(RULES[0]); i++) {
+    TEST_ASSERT_TRUE_MESSAGE(TimeZone::set(RULES[i]), RULES[i]);
+    for (int year = 2019; year <= 2040; year++) {
+      // Either side of New Year, UTC and local
+      for (int hour = -6; hour <= 6; hour++) {
+        time_t utc = utcAt(year, 1, 1, 0, 0) + hour * 3600;
+        TEST_ASSERT_EQUAL_INT_MESSAGE(DST_OFFSETS[i], TimeZone::offsetAt(utc), RULES[i]);
+        TEST_ASSERT_TRUE(TimeZone::isDst(utc));
+      }
+      TEST_ASSERT_EQUAL_INT_MESSAGE(DST_OFFSETS[i], TimeZone::offsetAt(utcAt(year, 7, 1, 0, 0)), RULES[i]);
+    }
+    TEST_ASSERT_EQUAL(0, TimeZone::nextTransition(utcAt(2024, 6, 1, 0, 0)));
+
+    // glibc works out the changes per UTC year, so it shows standard time
+    // in the hours between UTC and local New Year; it agrees everywhere else
+    setenv("TZ", RULES[i], 1);
+    tzset();
+    for (time_t utc = utcAt(2019, 1, 1, 0, 0); utc < utcAt(2027, 1, 1, 0, 0); utc += 3607) {
+      struct tm date;
+      gmtime_r(&utc, &date);
+      bool nearNewYear = (date.tm_yday == 0 && date.tm_hour < 6) || (date.tm_mon == 11 && date.tm_mday == 31 && date.tm_hour >= 18);
+      if (!nearNewYear && hostOffset(RULES[i], utc) != TimeZone::offsetAt(utc)) {
+        char message[96];
+        snprintf(message, sizeof(message), "%s at %lld", RULES[i], (long long)utc);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(hostOffset(RULES[i], utc), TimeZone::offsetAt(utc), message);
+      }
+    }
+  }
+  TimeZone::set(RULES[0]);
+  TEST_ASSERT_EQUAL_STRING("EDT", TimeZone::abbreviation(utcAt(2024, 1, 1, 2, 0)));
+
+  // Ending an hour short of the year leaves one hour of standard time
+  TEST_ASSERT_TRUE(TimeZone::set("EST5EDT,J1/0,J365/24"));
+  TEST_ASSERT_EQUAL(-4 * 3600, TimeZone::offsetAt(utcAt(2025, 1, 1, 3, 59)));
+  TEST_ASSERT_EQUAL(-5 * 3600, TimeZone::offsetAt(utcAt(2025, 1, 1, 4, 0)));
+  TEST_ASSERT_EQUAL(-4 * 3600, TimeZone::offsetAt(utcAt(2025, 1, 1, 5, 0)));
+  TEST_ASSERT_EQUAL(utcAt(2025, 1, 1, 5, 0), TimeZone::nextTransition(utcAt(2025, 1, 1, 4, 0)));
+}
+
+static void test_format_offset() {
+  char text[10];
+  TimeZone::formatOffset(19800, text);
+  TEST_ASSERT_EQUAL_STRING("UTC+05:30", text);
+  TimeZone::formatOffset(-12600, text);
+  TEST_ASSERT_EQUAL_STRING("UTC-03:30", text);
+  TimeZone::formatOffset(0, text);
+  TEST_ASSERT_EQUAL_STRING("UTC+00:00", text);
+  TimeZone::formatOffset(-30 * 3600L, text);
+  TEST_ASSERT_EQUAL_STRING("UTC-23:59", text);
+}
+
+static void test_legacy_settings() {
+  char rule[TZ_MAX_LENGTH + 1];
+  TimeZone::fromLegacy(-5, true, rule, sizeof(rule));
+  TEST_ASSERT_EQUAL_STRING("EST5EDT,M3.2.0,M11.1.0", rule);
+  TimeZone::fromLegacy(1, true, rule, sizeof(rule));
+  TEST_ASSERT_EQUAL_STRING("CET-1CEST,M3.5.0,M10.5.0/3", rule);
+  TimeZone::fromLegacy(5.5f, false, rule, sizeof(rule));
+  TEST_ASSERT_EQUAL_STRING("<+0530>-5:30", rule);
+  TimeZone::fromLegacy(0, false, rule, sizeof(rule));
+  TEST_ASSERT_EQUAL_STRING("UTC0", rule);
+  TEST_ASSERT_TRUE(TimeZone::isValid(rule));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_us_eastern_transitions);
+  RUN_TEST(test_southern_hemisphere);
+  RUN_TEST(test_fixed_offsets);
+  RUN_TEST(test_invalid_rules_are_rejected);
+  RUN_TEST(test_matches_host_library);
+  RUN_TEST(test_dst_all_year);
+  RUN_TEST(test_local_day_matches_host_library);
+  RUN_TEST(test_local_day_timing);
+  RUN_TEST(test_format_offset);
+  RUN_TEST(test_legacy_settings);
+  return UNITY_END();
+}
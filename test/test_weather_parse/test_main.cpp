@@ -0,0 +1,266 @@
+/*
+ * Native tests of the weather providers against recorded responses
+ * The responses are streamed through the real providers in network-sized
+ * chunks, as HttpFetch delivers them, and the display globals, forecast
+ * buckets and hourly ring they leave are checked.
+ */
+
+#include <unity.h>
+#include "host_support.h"
+#include "weather.h"
+#include "weather_provider.h"
+#include "hourly_forecast.h"
+#include "time_zone.h"
+#include "benchmark_fixtures.h"
+
+// /geo/1.0/direct?q=Portland,ME,US: the Oregon match comes first
+static const char OWM_GEOCODING_FIXTURE[] =
+  R"json([{"name":"Portland","local_names":{"en":"Portland","ja":"ポートランド"},)json"
+  R"json("lat":45.5202471,"lon":-122.674194,"country":"US","state":"Oregon"},)json"
+  R"json({"name":"Portland","lat":43.6573605,"lon":-70.2586618,"country":"US","state":"Maine"},)json"
+  R"json({"name":"Portland","lat":-38.3443,"lon":141.6043,"country":"AU","state":"Victoria"}])json";
+
+// /v1/search?name=Portland
+static const char OPENMETEO_GEOCODING_FIXTURE[] =
+  R"json({"results":[{"id":5746545,"name":"Portland","latitude":45.52345,"longitude":-122.67621,)json"
+  R"json("country_code":"US","admin1":"Oregon","postcodes":["97201","97202","97203"]},)json"
+  R"json({"id":4975802,"name":"Portland","latitude":43.66147,"longitude":-70.25533,)json"
+  R"json("country_code":"US","admin1":"Maine"}],"generationtime_ms":0.93)json" "}";
+
+// /v1/forecast for New York in Fahrenheit, 2024-06-01 06:00 EDT
+static const char OPENMETEO_FORECAST_FIXTURE[] =
+  R"json({"latitude":40.710335,"longitude":-73.99307,"generationtime_ms":0.08,"utc_offset_seconds":-14400,)json"
+  R"json("timezone":"America/New_York","timezone_abbreviation":"EDT","elevation":32.0,)json"
+  R"json("current_units":{"time":"unixtime","interval":"seconds","temperature_2m":"°F",)json"
+  R"json("relative_humidity_2m":"%","weather_code":"wmo code"},)json"
+  R"json("current":{"time":1717236000,"interval":900,"temperature_2m":64.4,"relative_humidity_2m":71,"weather_code":3},)json"
+  R"json("hourly_units":{"time":"unixtime","temperature_2m":"°F","precipitation_probability":"%","weather_code":"wmo code"},)json"
+  R"json("hourly":{"time":[1717236000,1717239600,1717243200,1717246800,1717250400,1717254000,1717257600,1717261200,)json"
+  R"json(1717264800,1717268400,1717272000,1717275600,1717279200,1717282800,1717286400,1717290000,)json"
+  R"json(1717293600,1717297200,1717300800,1717304400,1717308000,1717311600,1717315200,1717318800],)json"
+  R"json("temperature_2m":[64.4,65.1,66.0,67.3,68.9,70.2,71.6,72.5,73.0,73.4,73.1,72.2,)json"
+  R"json(70.7,68.9,67.1,65.8,64.9,64.0,63.3,62.8,62.2,61.9,61.5,61.3],)json"
+  R"json("precipitation_probability":[5,5,10,10,15,20,35,40,55,60,45,30,20,15,10,5,5,0,0,0,0,0,0,0],)json"
+  R"json("weather_code":[3,3,3,2,2,61,61,80,80,61,3,3,2,2,1,1,0,0,0,0,0,0,1,1]},)json"
+  R"json("daily_units":{"time":"unixtime","weather_code":"wmo code","temperature_2m_max":"°F","temperature_2m_min":"°F"},)json"
+  R"json("daily":{"time":[1717214400,1717300800,1717387200,1717473600,1717560000,1717646400],)json"
+  R"json("weather_code":[3,61,80,2,0,95],"temperature_2m_max":[79.3,75.2,71.6,77.0,82.4,85.1],)json"
+  R"json("temperature_2m_min":[60.1,62.4,59.0,58.6,63.3,68.0]}})json";
+
+// What one TCP read usually delivers, and the worst case
+static const size_t CHUNK_SIZES[] = { 256, 1 };
+
+static size_t chunkSize = 256;
+
+// Run the provider's next request against a recorded response
+static bool runRequest(Weather::WeatherProvider& provider, const char* response, String* path = nullptr) {
+  Weather::ProviderRequest request;
+  request.cacheable = true;
+  if (!provider.nextRequest(request)) {
+    return false;
+  }
+  if (path) {
+    *path = request.path;
+  }
+  size_t length = strlen(response);
+  for (size_t offset = 0; offset < length; offset += chunkSize) {
+    provider.onBody(response + offset, min(chunkSize, length - offset));
+  }
+  return provider.onComplete(200);
+}
+
+static void expectDay(int index, const char* day, int high, int low, int iconType) {
+  TEST_ASSERT_EQUAL_STRING(day, forecast[index].day);
+  TEST_ASSERT_EQUAL(high, forecast[index].temp);
+  TEST_ASSERT_EQUAL(low, forecast[index].lowTemp);
+  TEST_ASSERT_EQUAL(iconType, forecast[index].iconType);
+}
+
+static void expectHour(uint8_t index, int temp, uint8_t iconType, uint8_t precipPct) {
+  const HourlyPoint& point = HourlyForecast::point(index);
+  TEST_ASSERT_EQUAL(temp, point.temp);
+  TEST_ASSERT_EQUAL(iconType, point.iconType);
+  TEST_ASSERT_EQUAL(precipPct, point.precipPct);
+}
+
+void setUp() {
+  TimeZone::set(TZ_DEFAULT);
+  hostSetClock(1717236000); // 2024-06-01 10:00 UTC, a Saturday
+  hostUpdateLocation = 0;
+  hostWeatherErrors = 0;
+  API_KEY = "0123456789abcdef";
+  UNITS = "imperial";
+  useMetricUnits = false;
+  cityName = "New York";
+  stateName = "NY";
+  cityLatitude = 40.7143f;
+  cityLongitude = -74.006f;
+  cityCoordinatesKnown = true;
+  Weather::geocodeMatcher.resolved = false;
+  HourlyForecast::expire(1717236000 + 48 * 3600);   // Each test fills the ring afresh
+}
+
+void tearDown() {}
+
+static void test_owm_current_and_forecast() {
+  for (size_t chunk : CHUNK_SIZES) {
+    chunkSize = chunk;
+    Weather::WeatherProvider& provider = Weather::openWeatherMapProvider();
+    TEST_ASSERT_TRUE(provider.begin());
+
+    String path;
+    TEST_ASSERT_TRUE(runRequest(provider, OWM_CURRENT_FIXTURE, &path));
+    TEST_ASSERT_EQUAL_STRING("/data/2.5/weather?lat=40.7143&lon=-74.0060&units=imperial&appid=0123456789abcdef", path.c_str());
+    // The current values are taken as ints, which truncates
+    TEST_ASSERT_EQUAL(21, currentTemp);
+    TEST_ASSERT_EQUAL(23, highTemp);
+    TEST_ASSERT_EQUAL(19, lowTemp);
+    TEST_ASSERT_EQUAL(61, humidity);
+    TEST_ASSERT_EQUAL_STRING("Clouds", currentCondition);
+
+    TEST_ASSERT_TRUE(runRequest(provider, OWM_FORECAST_FIXTURE));
+    // Bucketed by the local (EDT) day; today's entries are skipped
+    expectDay(0, "SUN", 29, 16, 4);
+    expectDay(1, "MON", 29, 17, 1);
+    expectDay(2, "TUE", 30, 17, 4);
+    expectDay(3, "WED", 31, 18, 0);
+    expectDay(4, "THU", 21, 19, 1);
+
+    // The ring keeps the first HOURLY_POINTS entries, from now on
+    TEST_ASSERT_EQUAL(HOURLY_POINTS, HourlyForecast::count());
+    TEST_ASSERT_EQUAL(1717236000, HourlyForecast::firstTime());
+    expectHour(0, 18, 0, 0);
+    expectHour(1, 22, 4, 17);
+    TEST_ASSERT_EQUAL(6, HourlyForecast::point(0).localHour);
+
+    Weather::ProviderRequest request;
+    TEST_ASSERT_FALSE(provider.nextRequest(request));
+  }
+}
+
+static void test_owm_not_modified_keeps_values() {
+  chunkSize = 256;
+  Weather::WeatherProvider& provider = Weather::openWeatherMapProvider();
+  TEST_ASSERT_TRUE(provider.begin());
+  TEST_ASSERT_TRUE(runRequest(provider, OWM_CURRENT_FIXTURE));
+  currentTemp = 99;
+
+  Weather::ProviderRequest request;
+  TEST_ASSERT_TRUE(provider.nextRequest(request));
+  TEST_ASSERT_TRUE(provider.onComplete(HTTP_CODE_NOT_MODIFIED));
+  TEST_ASSERT_EQUAL(99, currentTemp);
+  TEST_ASSERT_FALSE(provider.nextRequest(request));
+}
+
+static void test_owm_geocoding_picks_the_state() {
+  chunkSize = 7;
+  cityName = "Portland";
+  stateName = "ME";
+  cityCoordinatesKnown = false;
+  Weather::WeatherProvider& provider = Weather::openWeatherMapProvider();
+  TEST_ASSERT_TRUE(provider.begin());
+
+  String path;
+  TEST_ASSERT_TRUE(runRequest(provider, OWM_GEOCODING_FIXTURE, &path));
+  TEST_ASSERT_EQUAL_STRING("/geo/1.0/direct?q=Portland,ME,US&limit=5&appid=0123456789abcdef", path.c_str());
+  TEST_ASSERT_TRUE(cityCoordinatesKnown);
+  TEST_ASSERT_TRUE(Weather::geocodeMatcher.resolved);
+  TEST_ASSERT_FLOAT_WITHIN(0.0001f, 43.6573605f, cityLatitude);
+  TEST_ASSERT_FLOAT_WITHIN(0.0001f, -70.2586618f, cityLongitude);
+
+  // The weather requests then go by the coordinates just found
+  Weather::ProviderRequest request;
+  TEST_ASSERT_TRUE(provider.nextRequest(request));
+  TEST_ASSERT_EQUAL_STRING("/data/2.5/weather?lat=43.6574&lon=-70.2587&units=imperial&appid=0123456789abcdef",
+                           request.path.c_str());
+}
+
+static void test_owm_geocoding_without_match_fails() {
+  chunkSize = 256;
+  cityCoordinatesKnown = false;
+  Weather::WeatherProvider& provider = Weather::openWeatherMapProvider();
+  TEST_ASSERT_TRUE(provider.begin());
+  TEST_ASSERT_FALSE(runRequest(provider, "[]"));
+  TEST_ASSERT_FALSE(cityCoordinatesKnown);
+  TEST_ASSERT_EQUAL(1, hostWeatherErrors);
+}
+
+static void test_openmeteo_forecast() {
+  for (size_t chunk : CHUNK_SIZES) {
+    chunkSize = chunk;
+    Weather::WeatherProvider& provider = Weather::openMeteoProvider();
+    TEST_ASSERT_TRUE(provider.begin());
+
+    String path;
+    TEST_ASSERT_TRUE(runRequest(provider, OPENMETEO_FORECAST_FIXTURE, &path));
+    TEST_ASSERT_TRUE(strstr(path.c_str(), "latitude=40.7143&longitude=-74.0060") != nullptr);
+    TEST_ASSERT_TRUE(strstr(path.c_str(), "&hourly=") != nullptr);
+    TEST_ASSERT_TRUE(strstr(path.c_str(), "&temperature_unit=fahrenheit") != nullptr);
+
+    TEST_ASSERT_EQUAL(64, currentTemp);
+    TEST_ASSERT_EQUAL(71, humidity);
+    TEST_ASSERT_EQUAL_STRING("Clouds", currentCondition);
+    TEST_ASSERT_EQUAL(79, highTemp);
+    TEST_ASSERT_EQUAL(60, lowTemp);
+
+    expectDay(0, "SUN", 75, 62, 4);
+    expectDay(1, "MON", 72, 59, 4);
+    expectDay(2, "TUE", 77, 59, 1);
+    expectDay(3, "WED", 82, 63, 0);
+    expectDay(4, "THU", 85, 68, 0); // No icon for thunderstorms, so sunny
+
+    // Every third hour goes into the ring
+    TEST_ASSERT_EQUAL(1717236000, HourlyForecast::firstTime());
+    expectHour(0, 64, 1, 5);
+    expectHour(1, 67, 1, 10);
+    expectHour(2, 72, 4, 35);
+    expectHour(3, 73, 4, 60);
+    expectHour(7, 62, 0, 0);
+  }
+}
+
+static void test_openmeteo_extra_location_skips_hourly() {
+  chunkSize = 256;
+  hostUpdateLocation = 1;
+  Weather::WeatherProvider& provider = Weather::openMeteoProvider();
+  TEST_ASSERT_TRUE(provider.begin());
+  Weather::ProviderRequest request;
+  TEST_ASSERT_TRUE(provider.nextRequest(request));
+  TEST_ASSERT_TRUE(strstr(request.path.c_str(), "&hourly=") == nullptr);
+}
+
+static void test_openmeteo_geocoding_picks_the_state() {
+  chunkSize = 5;
+  cityName = "Portland";
+  stateName = "ME";
+  cityCoordinatesKnown = false;
+  Weather::WeatherProvider& provider = Weather::openMeteoProvider();
+  TEST_ASSERT_TRUE(provider.begin());
+  TEST_ASSERT_TRUE(runRequest(provider, OPENMETEO_GEOCODING_FIXTURE));
+  TEST_ASSERT_TRUE(cityCoordinatesKnown);
+  TEST_ASSERT_FLOAT_WITHIN(0.0001f, 43.66147f, cityLatitude);
+  TEST_ASSERT_FLOAT_WITHIN(0.0001f, -70.25533f, cityLongitude);
+}
+
+static void test_icon_types() {
+  TEST_ASSERT_EQUAL(0, Weather::getWeatherIconType("Clear"));
+  TEST_ASSERT_EQUAL(1, Weather::getWeatherIconType("clouds"));
+  TEST_ASSERT_EQUAL(2, Weather::getWeatherIconType("overcast clouds"));
+  TEST_ASSERT_EQUAL(3, Weather::getWeatherIconType("Haze"));
+  TEST_ASSERT_EQUAL(4, Weather::getWeatherIconType("light shower rain"));
+  TEST_ASSERT_EQUAL(5, Weather::getWeatherIconType("Snow"));
+  TEST_ASSERT_EQUAL(0, Weather::getWeatherIconType("Unknown"));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_owm_current_and_forecast);
+  RUN_TEST(test_owm_not_modified_keeps_values);
+  RUN_TEST(test_owm_geocoding_picks_the_state);
+  RUN_TEST(test_owm_geocoding_without_match_fails);
+  RUN_TEST(test_openmeteo_forecast);
+  RUN_TEST(test_openmeteo_extra_location_skips_hourly);
+  RUN_TEST(test_openmeteo_geocoding_picks_the_state);
+  RUN_TEST(test_icon_types);
+  return UNITY_END();
+}
@@ -0,0 +1,99 @@
+"""
+Gzip the static portal assets in web/ into PROGMEM arrays in src/web_assets.h.
+
+Runs before every PlatformIO build (extra_scripts = pre:tools/gzip_assets.py)
+and can also be run by hand: python3 tools/gzip_assets.py
+The header is only rewritten when its content changes, so an unchanged
+asset does not trigger a rebuild.
+"""
+
+import gzip
+import hashlib
+import os
+
+# Served path, source file in web/, content type
+ASSETS = [
+    ("/style.css", "style.css", "text/css"),
+    ("/settings.js", "settings.js", "application/javascript"),
+]
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO's SCons environment
+    PROJECT_DIR = env["PROJECT_DIR"]  # noqa: F821
+except NameError:
+    PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+WEB_DIR = os.path.join(PROJECT_DIR, "web")
+OUTPUT = os.path.join(PROJECT_DIR, "src", "web_assets.h")
+
+
+def symbol_for(source):
+    return source.upper().replace(".", "_").replace("-", "_") + "_GZ"
+
+
+def c_array(data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append("  " + ", ".join("0x%02x" % b for b in data[i:i + 16]))
+    return ",\n".join(lines)
+
+
+def generate():
+    out = [
+        "/*",
+        " * Gzipped static assets of the web portal",
+        " * Generated by tools/gzip_assets.py from web/ - do not edit, edit web/ instead",
+        " */",
+        "",
+        "#ifndef WEB_ASSETS_H",
+        "#define WEB_ASSETS_H",
+        "",
+        "#include <Arduino.h>",
+        "",
+        "struct WebAsset {",
+        "  const char* path;",
+        "  const char* contentType;",
+        "  const uint8_t* data;   // Gzip stream in PROGMEM",
+        "  size_t length;",
+        "  const char* etag;      // Quoted, from the uncompressed content",
+        "};",
+        "",
+    ]
+
+    table = []
+    for path, source, content_type in ASSETS:
+        with open(os.path.join(WEB_DIR, source), "rb") as f:
+            raw = f.read()
+        # mtime=0 keeps the output identical for identical input
+        packed = gzip.compress(raw, compresslevel=9, mtime=0)
+        etag = hashlib.sha1(raw).hexdigest()[:16]
+        symbol = symbol_for(source)
+
+        out.append("// %s: %d bytes, %d gzipped" % (source, len(raw), len(packed)))
+        out.append("const uint8_t %s[] PROGMEM = {" % symbol)
+        out.append(c_array(packed))
+        out.append("};")
+        out.append("")
+        table.append('  { "%s", "%s", %s, sizeof(%s), "\\"%s\\"" }' % (path, content_type, symbol, symbol, etag))
+
+    out.append("const WebAsset WEB_ASSETS[] = {")
+    out.append(",\n".join(table))
+    out.append("};")
+    out.append("")
+    out.append("#define WEB_ASSET_COUNT (sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]))")
+    out.append("")
+    out.append("#endif // WEB_ASSETS_H")
+    text = "\n".join(out) + "\n"
+
+    try:
+        with open(OUTPUT) as f:
+            if f.read() == text:
+                return
+    except IOError:
+        pass
+    with open(OUTPUT, "w") as f:
+        f.write(text)
+    print("gzip_assets: wrote %s" % os.path.relpath(OUTPUT, PROJECT_DIR))
+
+
+generate()
@@ -0,0 +1,110 @@
+// Settings page: fills the state and timezone lists. currentState and
+// currentTz are set by the page itself.
+function populateStates() {
+  const states = [
+    'AL', 'AK', 'AZ', 'AR', 'CA', 'CO', 'CT', 'DE', 'FL', 'GA',
+    'HI', 'ID', 'IL', 'IN', 'IA', 'KS', 'KY', 'LA', 'ME', 'MD',
+    'MA', 'MI', 'MN', 'MS', 'MO', 'MT', 'NE', 'NV', 'NH', 'NJ',
+    'NM', 'NY', 'NC', 'ND', 'OH', 'OK', 'OR', 'PA', 'RI', 'SC',
+    'SD', 'TN', 'TX', 'UT', 'VT', 'VA', 'WA', 'WV', 'WI', 'WY'
+  ];
+  const stateSelect = document.getElementById('state');
+  states.forEach(state => {
+    const option = document.createElement('option');
+    option.value = state;
+    option.text = state;
+    if (state === currentState) {
+      option.selected = true;
+    }
+    stateSelect.appendChild(option);
+  });
+}
+
+// Preset zones; the value is the POSIX TZ rule, which also carries the
+// daylight saving dates. Any other rule can be typed into the text field.
+function populateTimezones() {
+  const timezones = [
+    {value: '<-12>12', text: '(UTC-12:00) International Date Line West'},
+    {value: '<-11>11', text: '(UTC-11:00) Coordinated Universal Time-11'},
+    {value: 'HST10', text: '(UTC-10:00) Hawaii'},
+    {value: 'AKST9AKDT,M3.2.0,M11.1.0', text: '(UTC-09:00) Alaska'},
+    {value: 'PST8PDT,M3.2.0,M11.1.0', text: '(UTC-08:00) Pacific Time (US & Canada)'},
+    {value: 'MST7', text: '(UTC-07:00) Arizona'},
+    {value: 'MST7MDT,M3.2.0,M11.1.0', text: '(UTC-07:00) Mountain Time (US & Canada)'},
+    {value: 'CST6CDT,M3.2.0,M11.1.0', text: '(UTC-06:00) Central Time (US & Canada)'},
+    {value: 'CST6', text: '(UTC-06:00) Mexico City'},
+    {value: 'EST5EDT,M3.2.0,M11.1.0', text: '(UTC-05:00) Eastern Time (US & Canada)'},
+    {value: '<-05>5', text: '(UTC-05:00) Bogota, Lima'},
+    {value: 'AST4ADT,M3.2.0,M11.1.0', text: '(UTC-04:00) Atlantic Time (Canada)'},
+    {value: '<-04>4<-03>,M9.1.6/24,M4.1.6/24', text: '(UTC-04:00) Santiago'},
+    {value: 'NST3:30NDT,M3.2.0,M11.1.0', text: '(UTC-03:30) Newfoundland'},
+    {value: '<-03>3', text: '(UTC-03:00) Brasilia, Buenos Aires'},
+    {value: '<-02>2', text: '(UTC-02:00) Mid-Atlantic'},
+    {value: '<-01>1<+00>,M3.5.0/0,M10.5.0/1', text: '(UTC-01:00) Azores'},
+    {value: 'UTC0', text: '(UTC+00:00) Coordinated Universal Time'},
+    {value: 'GMT0BST,M3.5.0/1,M10.5.0', text: '(UTC+00:00) London'},
+    {value: 'IST-1GMT0,M10.5.0,M3.5.0/1', text: '(UTC+00:00) Dublin'},
+    {value: 'WET0WEST,M3.5.0/1,M10.5.0', text: '(UTC+00:00) Lisbon'},
+    {value: 'CET-1CEST,M3.5.0,M10.5.0/3', text: '(UTC+01:00) Paris, Berlin, Rome, Madrid'},
+    {value: 'WAT-1', text: '(UTC+01:00) Lagos'},
+    {value: 'EET-2EEST,M3.5.0/3,M10.5.0/4', text: '(UTC+02:00) Athens, Helsinki, Kyiv'},
+    {value: 'EET-2', text: '(UTC+02:00) Cairo'},
+    {value: 'SAST-2', text: '(UTC+02:00) Johannesburg'},
+    {value: '<+03>-3', text: '(UTC+03:00) Istanbul'},
+    {value: 'MSK-3', text: '(UTC+03:00) Moscow'},
+    {value: '<+0330>-3:30', text: '(UTC+03:30) Tehran'},
+    {value: '<+04>-4', text: '(UTC+04:00) Dubai'},
+    {value: '<+0430>-4:30', text: '(UTC+04:30) Kabul'},
+    {value: 'PKT-5', text: '(UTC+05:00) Karachi'},
+    {value: 'IST-5:30', text: '(UTC+05:30) New Delhi'},
+    {value: '<+0545>-5:45', text: '(UTC+05:45) Kathmandu'},
+    {value: '<+06>-6', text: '(UTC+06:00) Dhaka'},
+    {value: '<+0630>-6:30', text: '(UTC+06:30) Yangon'},
+    {value: '<+07>-7', text: '(UTC+07:00) Bangkok'},
+    {value: 'CST-8', text: '(UTC+08:00) Beijing'},
+    {value: '<+08>-8', text: '(UTC+08:00) Singapore'},
+    {value: 'AWST-8', text: '(UTC+08:00) Perth'},
+    {value: 'JST-9', text: '(UTC+09:00) Tokyo'},
+    {value: 'ACST-9:30', text: '(UTC+09:30) Darwin'},
+    {value: 'ACST-9:30ACDT,M10.1.0,M4.1.0/3', text: '(UTC+09:30) Adelaide'},
+    {value: 'AEST-10', text: '(UTC+10:00) Brisbane'},
+    {value: 'AEST-10AEDT,M10.1.0,M4.1.0/3', text: '(UTC+10:00) Sydney, Melbourne, Hobart'},
+    {value: '<+11>-11', text: '(UTC+11:00) Solomon Islands'},
+    {value: 'NZST-12NZDT,M9.5.0,M4.1.0/3', text: '(UTC+12:00) Auckland'},
+    {value: '<+13>-13', text: '(UTC+13:00) Samoa'},
+    {value: '<+14>-14', text: '(UTC+14:00) Line Islands'}
+  ];
+
+  const tzSelect = document.getElementById('tzPreset');
+  const tzInput = document.getElementById('timezone');
+
+  // A rule that is not a preset shows as custom
+  const custom = document.createElement('option');
+  custom.value = '';
+  custom.text = 'Custom rule';
+  tzSelect.appendChild(custom);
+
+  timezones.forEach(tz => {
+    const option = document.createElement('option');
+    option.value = tz.value;
+    option.text = tz.text;
+    tzSelect.appendChild(option);
+  });
+
+  const showRule = () => {
+    tzSelect.value = timezones.some(tz => tz.value === tzInput.value) ? tzInput.value : '';
+  };
+  tzSelect.onchange = () => {
+    if (tzSelect.value !== '') {
+      tzInput.value = tzSelect.value;
+    }
+  };
+  tzInput.oninput = showRule;
+  tzInput.value = currentTz;
+  showRule();
+}
+
+window.onload = function() {
+  populateStates();
+  populateTimezones();
+};